@@ -9,7 +9,6 @@
 #include "ResourceHelper.h"
 #include "../Helper/Helper.h"
 #include "../Helper/Macros.h"
-#include "../Helper/StringHelper.h"
 #include "../Helper/WindowHelper.h"
 #include "../Helper/XMLSettings.h"
 #include <wil/resource.h>
@@ -330,8 +329,10 @@ void ColorRuleDialogPersistentSettings::SaveExtraXMLSettings(
 
 void ColorRuleDialogPersistentSettings::LoadExtraXMLSettings(BSTR bstrName, BSTR bstrValue)
 {
-	if (CheckWildcardMatch(_T("r*"), bstrName, TRUE) || CheckWildcardMatch(_T("g*"), bstrName, TRUE)
-		|| CheckWildcardMatch(_T("b*"), bstrName, TRUE))
+	/* The custom colors are stored as r<index>, g<index> and b<index>. */
+	TCHAR colorComponent = bstrName[0];
+
+	if (colorComponent == 'r' || colorComponent == 'g' || colorComponent == 'b')
 	{
 		/* At the very least, the attribute name
 		should reference a color component and index. */
@@ -355,15 +356,15 @@ void ColorRuleDialogPersistentSettings::LoadExtraXMLSettings(BSTR bstrName, BSTR
 		COLORREF clr = m_cfCustomColors[iIndex];
 		BYTE c = static_cast<BYTE>(NXMLSettings::DecodeIntValue(bstrValue));
 
-		if (CheckWildcardMatch(_T("r*"), bstrName, TRUE))
+		if (colorComponent == 'r')
 		{
 			m_cfCustomColors[iIndex] = RGB(c, GetGValue(clr), GetBValue(clr));
 		}
-		else if (CheckWildcardMatch(_T("g*"), bstrName, TRUE))
+		else if (colorComponent == 'g')
 		{
 			m_cfCustomColors[iIndex] = RGB(GetRValue(clr), c, GetBValue(clr));
 		}
-		else if (CheckWildcardMatch(_T("b*"), bstrName, TRUE))
+		else if (colorComponent == 'b')
 		{
 			m_cfCustomColors[iIndex] = RGB(GetRValue(clr), GetGValue(clr), c);
 		}
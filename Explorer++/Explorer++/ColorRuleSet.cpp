@@ -0,0 +1,64 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "ColorRuleSet.h"
+
+void ColorRuleSet::SetRules(const std::vector<NColorRuleHelper::ColorRule> &colorRules)
+{
+	m_rules.clear();
+	m_rules.reserve(colorRules.size());
+
+	for (const auto &colorRule : colorRules)
+	{
+		CompiledRule compiledRule;
+
+		if (!colorRule.strFilterPattern.empty())
+		{
+			compiledRule.filenameMatcher.emplace(
+				colorRule.strFilterPattern, !colorRule.caseInsensitive);
+		}
+
+		compiledRule.attributes = colorRule.dwFilterAttributes;
+		compiledRule.color = colorRule.rgbColour;
+
+		m_rules.push_back(std::move(compiledRule));
+	}
+
+	m_rulesChangedSignal();
+}
+
+std::optional<int> ColorRuleSet::GetMatchingRuleIndex(
+	std::wstring_view fileName, DWORD attributes) const
+{
+	for (std::size_t i = 0; i < m_rules.size(); i++)
+	{
+		const auto &rule = m_rules[i];
+
+		if (rule.attributes != 0 && (rule.attributes & attributes) == 0)
+		{
+			continue;
+		}
+
+		if (rule.filenameMatcher && !rule.filenameMatcher->Matches(fileName))
+		{
+			continue;
+		}
+
+		return static_cast<int>(i);
+	}
+
+	return std::nullopt;
+}
+
+COLORREF ColorRuleSet::GetRuleColor(int index) const
+{
+	return m_rules.at(index).color;
+}
+
+boost::signals2::connection ColorRuleSet::AddRulesChangedObserver(
+	const RulesChangedSignal::slot_type &observer)
+{
+	return m_rulesChangedSignal.connect(observer);
+}
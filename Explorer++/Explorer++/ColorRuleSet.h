@@ -0,0 +1,51 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "ColorRuleHelper.h"
+#include "../Helper/WildcardMatcher.h"
+#include <boost/signals2.hpp>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Holds the compiled form of the color rules. Each rule's filename pattern is compiled once,
+// when the rules are set, so determining the color for an item doesn't involve any parsing.
+//
+// Items are expected to be matched when they're added or updated, with the resulting rule index
+// stored alongside the item. Drawing an item then only requires the color to be looked up. Since
+// any stored index is invalidated when the rules are replaced, observers are notified whenever
+// that happens.
+class ColorRuleSet
+{
+public:
+	using RulesChangedSignal = boost::signals2::signal<void()>;
+
+	void SetRules(const std::vector<NColorRuleHelper::ColorRule> &colorRules);
+
+	// Returns the index of the first rule that matches the item, if any.
+	std::optional<int> GetMatchingRuleIndex(std::wstring_view fileName, DWORD attributes) const;
+
+	COLORREF GetRuleColor(int index) const;
+
+	boost::signals2::connection AddRulesChangedObserver(
+		const RulesChangedSignal::slot_type &observer);
+
+private:
+	struct CompiledRule
+	{
+		// Empty if the rule matches every filename.
+		std::optional<WildcardMatcher> filenameMatcher;
+
+		// 0 if the rule matches every item, regardless of its attributes. Otherwise, the item
+		// needs to have at least one of these attributes set.
+		DWORD attributes;
+
+		COLORREF color;
+	};
+
+	std::vector<CompiledRule> m_rules;
+	RulesChangedSignal m_rulesChangedSignal;
+};
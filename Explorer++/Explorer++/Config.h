@@ -9,6 +9,7 @@
 #include "ShellBrowser/FolderSettings.h"
 #include "ShellBrowser/ViewModes.h"
 #include "ValueWrapper.h"
+#include "../Helper/IconClassRules.h"
 #include "../Helper/Macros.h"
 #include "../Helper/SetDefaultFileManager.h"
 #include "../Helper/ShellHelper.h"
@@ -86,6 +87,21 @@ struct Config
 		forceSameTabWidth.set(FALSE);
 		openTabsInForeground = false;
 
+		ownerDataListView = false;
+
+		columnConcurrencySolidState = 0;
+		columnConcurrencyRotational = 2;
+		columnConcurrencyRemovable = 1;
+		columnConcurrencyNetwork = 4;
+		columnConcurrencyOther = 2;
+
+		thumbnailMemoryLimit = 64;
+
+		shareIconsByType = true;
+		perFileIconExtensions = IconClassRules::DEFAULT_PER_FILE_EXTENSIONS;
+
+		itemCacheSizeLimit = 32;
+
 		displayWindowSurroundColor = Gdiplus::Color(0, 94, 138);
 		displayWindowCentreColor = Gdiplus::Color(255, 255, 255);
 		displayWindowTextColor = RGB(0, 0, 0);
@@ -195,6 +211,32 @@ struct Config
 	ValueWrapper<BOOL> forceSameTabWidth;
 	bool openTabsInForeground;
 
+	// Listview
+	bool ownerDataListView;
+
+	// The number of column tasks that can run at the same time for a folder, based on the type
+	// of volume the folder is on. A value of 0 means there's no limit, other than the number of
+	// worker threads.
+	int columnConcurrencySolidState;
+	int columnConcurrencyRotational;
+	int columnConcurrencyRemovable;
+	int columnConcurrencyNetwork;
+	int columnConcurrencyOther;
+
+	// The amount of memory (in MB) that can be used to hold the thumbnails for a tab in thumbnails
+	// view. A value of 0 means there's no limit.
+	int thumbnailMemoryLimit;
+
+	// Whether files whose icon is determined by their type (e.g. text files) share a single icon
+	// lookup. Files with one of the (semicolon-separated) per-file extensions always have their
+	// icons retrieved individually.
+	bool shareIconsByType;
+	std::wstring perFileIconExtensions;
+
+	// The maximum size (in MB) of the file used to store item values (such as file types and
+	// version information) between sessions. A value of 0 disables the file entirely.
+	int itemCacheSizeLimit;
+
 	// Display window
 	Gdiplus::Color displayWindowCentreColor;
 	Gdiplus::Color displayWindowSurroundColor;
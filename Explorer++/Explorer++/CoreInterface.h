@@ -36,13 +36,17 @@ using FocusChangedSignal = boost::signals2::signal<void(WindowFocusSource window
 using ApplicationShuttingDownSignal = boost::signals2::signal<void()>;
 
 class CachedIcons;
+class ColorRuleSet;
 struct Config;
+class IconRequestCoalescer;
 class IconResourceLoader;
+class PersistentItemCache;
 __interface IDirectoryMonitor;
 class ShellBrowser;
 class StatusBar;
 class TabContainer;
 class TabRestorer;
+class TaskExecutor;
 
 /* Basic interface between Explorerplusplus
 and some of the other components (such as the
@@ -63,6 +67,12 @@ __interface IExplorerplusplus
 
 	IconResourceLoader *GetIconResourceLoader() const;
 	CachedIcons *GetCachedIcons();
+	IconRequestCoalescer *GetIconRequestCoalescer();
+	ColorRuleSet *GetColorRuleSet();
+	TaskExecutor *GetTaskExecutor();
+
+	// May return null, if the persistent cache has been disabled.
+	PersistentItemCache *GetPersistentItemCache();
 
 	HWND GetTreeView() const;
 
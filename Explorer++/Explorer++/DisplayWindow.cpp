@@ -9,7 +9,7 @@
 #include "MainResource.h"
 #include "ShellBrowser/ShellBrowser.h"
 #include "TabContainer.h"
-#include "../Helper/FolderSize.h"
+#include "../Helper/FolderSizeThread.h"
 #include "../Helper/ShellHelper.h"
 
 void Explorerplusplus::UpdateDisplayWindow(const Tab &tab)
@@ -130,46 +130,45 @@ void Explorerplusplus::UpdateDisplayWindowForOneFile(const Tab &tab)
 				TCHAR szCalculating[64];
 				DWORD threadId;
 
-				pfs = (FolderSize_t *) malloc(sizeof(FolderSize_t));
+				pfsei = (FolderSizeExtraInfo *) malloc(sizeof(FolderSizeExtraInfo));
 
-				if (pfs != nullptr)
+				if (pfsei != nullptr)
 				{
-					pfsei = (FolderSizeExtraInfo *) malloc(sizeof(FolderSizeExtraInfo));
+					pfsei->pContainer = (void *) this;
+					pfsei->uId = m_iDWFolderSizeUniqueId;
 
-					if (pfsei != nullptr)
-					{
-						pfsei->pContainer = (void *) this;
-						pfsei->uId = m_iDWFolderSizeUniqueId;
-						pfs->pData = (LPVOID) pfsei;
+					pfs = new FolderSize_t();
+					pfs->pData = (LPVOID) pfsei;
 
-						pfs->pfnCallback = FolderSizeCallbackStub;
+					pfs->pfnCallback = FolderSizeCallbackStub;
+					pfs->pfnProgressCallback = FolderSizeProgressCallbackStub;
 
-						StringCchCopy(pfs->szPath, SIZEOF_ARRAY(pfs->szPath), fullItemName.c_str());
+					// Set once the selection changes, at which point the result is no longer
+					// needed.
+					pfs->cancelled = std::make_shared<std::atomic<bool>>(false);
 
-						LoadString(m_hLanguageModule, IDS_GENERAL_TOTALSIZE, szTotalSize,
-							SIZEOF_ARRAY(szTotalSize));
-						LoadString(m_hLanguageModule, IDS_GENERAL_CALCULATING, szCalculating,
-							SIZEOF_ARRAY(szCalculating));
-						StringCchPrintf(szDisplayText, SIZEOF_ARRAY(szDisplayText), _T("%s: %s"),
-							szTotalSize, szCalculating);
-						DisplayWindow_BufferText(m_hDisplayWindow, szDisplayText);
+					StringCchCopy(pfs->szPath, SIZEOF_ARRAY(pfs->szPath), fullItemName.c_str());
 
-						/* Maintain a global list of folder size operations. */
-						displayWindowFolderSize.uId = m_iDWFolderSizeUniqueId;
-						displayWindowFolderSize.iTabId = m_tabContainer->GetSelectedTab().GetId();
-						displayWindowFolderSize.bValid = TRUE;
-						m_DWFolderSizes.push_back(displayWindowFolderSize);
+					LoadString(m_hLanguageModule, IDS_GENERAL_TOTALSIZE, szTotalSize,
+						SIZEOF_ARRAY(szTotalSize));
+					LoadString(m_hLanguageModule, IDS_GENERAL_CALCULATING, szCalculating,
+						SIZEOF_ARRAY(szCalculating));
+					StringCchPrintf(szDisplayText, SIZEOF_ARRAY(szDisplayText), _T("%s: %s"),
+						szTotalSize, szCalculating);
+					DisplayWindow_BufferText(m_hDisplayWindow, szDisplayText);
 
-						HANDLE hThread = CreateThread(
-							nullptr, 0, Thread_CalculateFolderSize, (LPVOID) pfs, 0, &threadId);
-						CloseHandle(hThread);
+					/* Maintain a global list of folder size operations. */
+					displayWindowFolderSize.uId = m_iDWFolderSizeUniqueId;
+					displayWindowFolderSize.iTabId = m_tabContainer->GetSelectedTab().GetId();
+					displayWindowFolderSize.bValid = TRUE;
+					displayWindowFolderSize.cancelled = pfs->cancelled;
+					m_DWFolderSizes.push_back(displayWindowFolderSize);
 
-						m_iDWFolderSizeUniqueId++;
-					}
-					else
-					{
-						free(pfs);
-					}
+					HANDLE hThread = CreateThread(
+						nullptr, 0, Thread_CalculateFolderSize, (LPVOID) pfs, 0, &threadId);
+					CloseHandle(hThread);
+
+					m_iDWFolderSizeUniqueId++;
 				}
 			}
 			else
@@ -32,11 +32,12 @@ const std::vector<std::wstring> Explorerplusplus::BLACKLISTED_BACKGROUND_MENU_CL
 
 Explorerplusplus::Explorerplusplus(HWND hwnd) :
 	m_hContainer(hwnd),
+	m_taskExecutor(0, std::bind(CoInitializeEx, nullptr, COINIT_APARTMENTTHREADED), CoUninitialize),
 	m_cachedIcons(MAX_CACHED_ICONS),
 	m_pluginMenuManager(hwnd, MENU_PLUGIN_STARTID, MENU_PLUGIN_ENDID),
 	m_acceleratorUpdater(&g_hAccl),
 	m_pluginCommandManager(&g_hAccl, ACCELERATOR_PLUGIN_STARTID, ACCELERATOR_PLUGIN_ENDID),
-	m_bookmarkIconFetcher(hwnd, &m_cachedIcons),
+	m_bookmarkIconFetcher(hwnd, &m_cachedIcons, &m_iconRequestCoalescer, &m_taskExecutor),
 	m_tabBarBackgroundBrush(CreateSolidBrush(TAB_BAR_DARK_MODE_BACKGROUND_COLOR))
 {
 	m_hLanguageModule = nullptr;
@@ -67,6 +68,7 @@ Explorerplusplus::Explorerplusplus(HWND hwnd) :
 	m_blockNextListViewSelection = false;
 
 	m_ColorRules = NColorRuleHelper::GetDefaultColorRules();
+	m_colorRuleSet.SetRules(m_ColorRules);
 
 	m_iDWFolderSizeUniqueId = 0;
 }
@@ -6,6 +6,7 @@
 
 #include "AcceleratorUpdater.h"
 #include "Bookmarks/BookmarkTree.h"
+#include "ColorRuleSet.h"
 #include "CoreInterface.h"
 #include "Navigation.h"
 #include "PluginInterface.h"
@@ -21,13 +22,21 @@
 #include "../Helper/FileActionHandler.h"
 #include "../Helper/FileContextMenuManager.h"
 #include "../Helper/IconFetcher.h"
+#include "../Helper/PersistentItemCache.h"
+#include "../Helper/TaskExecutor.h"
 #include <boost/signals2.hpp>
 #include <wil/resource.h>
+#include <atomic>
+#include <memory>
 #include <optional>
 
 /* Sent when a folder size calculation has finished. */
 #define WM_APP_FOLDERSIZECOMPLETED WM_APP + 3
 
+/* Sent periodically while a folder size is being
+calculated. */
+#define WM_APP_FOLDERSIZEPROGRESS WM_APP + 4
+
 /* Private definitions. */
 #define FROM_LISTVIEW 0
 #define FROM_TREEVIEW 1
@@ -57,11 +66,6 @@ class TaskbarThumbnails;
 class UiTheming;
 class WindowSubclassWrapper;
 
-namespace NColorRuleHelper
-{
-	struct ColorRule;
-}
-
 namespace Plugins
 {
 	class PluginManager;
@@ -149,6 +153,9 @@ private:
 		int uId;
 		int iTabId;
 		BOOL bValid;
+
+		// Shared with the thread performing the calculation. Set when the entry is invalidated.
+		std::shared_ptr<std::atomic<bool>> cancelled;
 	};
 
 	struct FolderSizeExtraInfo
@@ -174,6 +181,7 @@ private:
 	std::optional<LRESULT> OnCtlColorStatic(HWND hwnd, HDC hdc);
 	int OnClose();
 	int OnDestroy();
+	void LogTaskExecutorStatistics();
 	void OnRightClick(NMHDR *nmhdr);
 	void OnSetFocus();
 	LRESULT OnDeviceChange(WPARAM wParam, LPARAM lParam);
@@ -474,6 +482,10 @@ private:
 	IDirectoryMonitor *GetDirectoryMonitor() const override;
 	IconResourceLoader *GetIconResourceLoader() const override;
 	CachedIcons *GetCachedIcons() override;
+	IconRequestCoalescer *GetIconRequestCoalescer() override;
+	ColorRuleSet *GetColorRuleSet() override;
+	TaskExecutor *GetTaskExecutor() override;
+	PersistentItemCache *GetPersistentItemCache() override;
 	BOOL GetSavePreferencesToXmlFile() const override;
 	void SetSavePreferencesToXmlFile(BOOL savePreferencesToXmlFile) override;
 	void FocusChanged(WindowFocusSource windowFocusSource) override;
@@ -501,6 +513,7 @@ private:
 
 	/* Miscellaneous. */
 	void InitializeDisplayWindow();
+	std::optional<std::wstring> GetItemCacheFilePath() const;
 	void ShowMainRebarBand(HWND hwnd, BOOL bShow);
 	BOOL OnMouseWheel(MousewheelSource mousewheelSource, WPARAM wParam, LPARAM lParam) override;
 	StatusBar *GetStatusBar() override;
@@ -511,6 +524,11 @@ private:
 		int nFolders, int nFiles, PULARGE_INTEGER lTotalFolderSize, LPVOID pData);
 	void FolderSizeCallback(
 		FolderSizeExtraInfo *pfsei, int nFolders, int nFiles, PULARGE_INTEGER lTotalFolderSize);
+	static void FolderSizeProgressCallbackStub(
+		int nFolders, int nFiles, PULARGE_INTEGER lTotalFolderSize, LPVOID pData);
+	void PostFolderSizeResult(
+		UINT message, FolderSizeExtraInfo *pfsei, PULARGE_INTEGER lTotalFolderSize);
+	void OnFolderSizeResult(DWFolderSizeCompletion *pDWFolderSizeCompletion, bool completed);
 
 	HWND m_hContainer;
 	HWND m_hStatusBar;
@@ -551,8 +569,19 @@ private:
 
 	std::unique_ptr<IconResourceLoader> m_iconResourceLoader;
 
+	// Values are retrieved from and stored in this cache from the worker threads, so it's declared
+	// before the task executor, to ensure it outlives them.
+	std::unique_ptr<PersistentItemCache> m_persistentItemCache;
+
+	// Shared by every tab, as well as the treeview and bookmark icons. This is declared before
+	// the components that create queues on it.
+	TaskExecutor m_taskExecutor;
+
 	CachedIcons m_cachedIcons;
 
+	// Shared by every icon fetcher. This is declared before the fetchers, so that it outlives them.
+	IconRequestCoalescer m_iconRequestCoalescer;
+
 	MainMenuPreShowSignal m_mainMenuPreShowSignal;
 	FocusChangedSignal m_focusChangedSignal;
 	ApplicationShuttingDownSignal m_applicationShuttingDownSignal;
@@ -613,6 +642,9 @@ private:
 	/* Customize colors. */
 	std::vector<NColorRuleHelper::ColorRule> m_ColorRules;
 
+	// The compiled form of m_ColorRules. This needs to be updated whenever the rules change.
+	ColorRuleSet m_colorRuleSet;
+
 	/* Undo support. */
 	FileActionHandler m_FileActionHandler;
 
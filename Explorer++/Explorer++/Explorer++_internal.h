@@ -23,6 +23,8 @@ namespace NExplorerplusplus
 
 	const TCHAR LOG_FILENAME[] = _T("Explorer++.log");
 
+	const TCHAR ITEM_CACHE_FILENAME[] = _T("Explorer++.cache");
+
 	// Internal command line arguments.
 	const TCHAR JUMPLIST_TASK_NEWTAB_ARGUMENT[] = _T("--open-new-tab");
 	const TCHAR APPLICATION_CRASHED_ARGUMENT[] = _T("--application-crashed");
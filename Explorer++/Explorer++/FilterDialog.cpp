@@ -141,12 +141,11 @@ void FilterDialog::OnOk()
 	m_pexpp->GetActiveShellBrowser()->SetFilterCaseSensitive(
 		IsDlgButtonChecked(m_hDlg, IDC_FILTERS_CASESENSITIVE) == BST_CHECKED);
 
+	// If filtering is already enabled, SetFilter() applies the new filter and SetFilterStatus()
+	// does nothing. Otherwise, SetFilter() only stores the filter and SetFilterStatus() applies
+	// it. Either way, the items are only filtered once.
 	m_pexpp->GetActiveShellBrowser()->SetFilter(filter);
-
-	if (!m_pexpp->GetActiveShellBrowser()->GetFilterStatus())
-	{
-		m_pexpp->GetActiveShellBrowser()->SetFilterStatus(TRUE);
-	}
+	m_pexpp->GetActiveShellBrowser()->SetFilterStatus(TRUE);
 
 	EndDialog(m_hDlg, 1);
 }
@@ -26,6 +26,7 @@
 #include "../Helper/CustomGripper.h"
 #include "../Helper/ImageHelper.h"
 #include "../Helper/Macros.h"
+#include "../Helper/ProcessHelper.h"
 #include "../Helper/iDirectoryMonitor.h"
 
 /*
@@ -41,8 +42,26 @@ void Explorerplusplus::OnCreate()
 	LoadAllSettings(&pLoadSave);
 	ApplyToolbarSettings();
 
+	m_colorRuleSet.SetRules(m_ColorRules);
+
 	m_config->registerForShellNotifications = g_registerForShellNotifications;
 
+	IconClassRules &iconClassRules = m_cachedIcons.getIconClassRules();
+	iconClassRules.SetEnabled(m_config->shareIconsByType);
+	iconClassRules.SetPerFileExtensions(
+		IconClassRules::ParseExtensionList(m_config->perFileIconExtensions));
+
+	if (m_config->itemCacheSizeLimit > 0)
+	{
+		auto itemCacheFile = GetItemCacheFilePath();
+
+		if (itemCacheFile)
+		{
+			m_persistentItemCache = std::make_unique<PersistentItemCache>(*itemCacheFile,
+				static_cast<std::uint64_t>(m_config->itemCacheSizeLimit) * 1024 * 1024);
+		}
+	}
+
 	m_iconResourceLoader = std::make_unique<IconResourceLoader>(m_config->iconTheme);
 
 	SetLanguageModule();
@@ -132,6 +151,41 @@ void Explorerplusplus::InitializeDisplayWindow()
 	ApplyDisplayWindowPosition();
 }
 
+// When settings are loaded from the config file (i.e. when running in portable mode), the cache is
+// stored alongside it, in the same directory as the executable. Otherwise, it's stored in the
+// local application data folder, since the directory containing the executable may not be
+// writable.
+std::optional<std::wstring> Explorerplusplus::GetItemCacheFilePath() const
+{
+	if (m_bLoadSettingsFromXML)
+	{
+		TCHAR itemCacheFile[MAX_PATH];
+		GetProcessImageName(GetCurrentProcessId(), itemCacheFile, SIZEOF_ARRAY(itemCacheFile));
+		PathRemoveFileSpec(itemCacheFile);
+		PathAppend(itemCacheFile, NExplorerplusplus::ITEM_CACHE_FILENAME);
+		return itemCacheFile;
+	}
+
+	wil::unique_cotaskmem_string localAppData;
+	HRESULT hr =
+		SHGetKnownFolderPath(FOLDERID_LocalAppData, KF_FLAG_CREATE, nullptr, &localAppData);
+
+	if (FAILED(hr))
+	{
+		return std::nullopt;
+	}
+
+	std::wstring directory =
+		std::wstring(localAppData.get()) + L"\\" + NExplorerplusplus::APP_NAME;
+
+	if (!CreateDirectory(directory.c_str(), nullptr) && GetLastError() != ERROR_ALREADY_EXISTS)
+	{
+		return std::nullopt;
+	}
+
+	return directory + L"\\" + NExplorerplusplus::ITEM_CACHE_FILENAME;
+}
+
 wil::unique_hmenu Explorerplusplus::BuildViewsMenu()
 {
 	wil::unique_hmenu viewsMenu(CreatePopupMenu());
@@ -121,9 +121,8 @@ void Explorerplusplus::OnCustomizeColors()
 		m_hLanguageModule, m_hContainer, this, &m_ColorRules);
 	customizeColorsDialog.ShowModalDialog();
 
-	/* Causes the active listview to redraw (therefore
-	applying any updated color schemes). */
-	InvalidateRect(m_hActiveListView, nullptr, FALSE);
+	// Each tab will recalculate the colors of its items and redraw its listview.
+	m_colorRuleSet.SetRules(m_ColorRules);
 }
 
 void Explorerplusplus::OnRunScript()
@@ -115,6 +115,11 @@ LRESULT CALLBACK Explorerplusplus::WindowProcedure(HWND hwnd,UINT Msg,WPARAM wPa
 		if (wParam == AUTOSAVE_TIMER_ID)
 		{
 			SaveAllSettings();
+
+			if (m_persistentItemCache)
+			{
+				m_persistentItemCache->Flush();
+			}
 		}
 		else if (wParam == LISTVIEW_ITEM_CHANGED_TIMER_ID)
 		{
@@ -165,54 +170,11 @@ LRESULT CALLBACK Explorerplusplus::WindowProcedure(HWND hwnd,UINT Msg,WPARAM wPa
 		break;
 
 	case WM_APP_FOLDERSIZECOMPLETED:
-		{
-			DWFolderSizeCompletion *pDWFolderSizeCompletion = nullptr;
-			TCHAR szFolderSize[32];
-			TCHAR szSizeString[64];
-			TCHAR szTotalSize[64];
-			BOOL bValid = FALSE;
-
-			pDWFolderSizeCompletion = (DWFolderSizeCompletion *)wParam;
-
-			std::list<DWFolderSize>::iterator itr;
-
-			/* First, make sure we should still display the
-			results (we won't if the listview selection has
-			changed, or this folder size was calculated for
-			a tab other than the current one). */
-			for(itr = m_DWFolderSizes.begin();itr != m_DWFolderSizes.end();itr++)
-			{
-				if(itr->uId == pDWFolderSizeCompletion->uId)
-				{
-					if(itr->iTabId == m_tabContainer->GetSelectedTab().GetId())
-					{
-						bValid = itr->bValid;
-					}
-
-					m_DWFolderSizes.erase(itr);
-
-					break;
-				}
-			}
-
-			if(bValid)
-			{
-				FormatSizeString(pDWFolderSizeCompletion->liFolderSize,szFolderSize,
-					SIZEOF_ARRAY(szFolderSize),m_config->globalFolderSettings.forceSize,
-					m_config->globalFolderSettings.sizeDisplayFormat);
-
-				LoadString(m_hLanguageModule,IDS_GENERAL_TOTALSIZE,
-					szTotalSize,SIZEOF_ARRAY(szTotalSize));
-
-				StringCchPrintf(szSizeString,SIZEOF_ARRAY(szSizeString),
-					_T("%s: %s"),szTotalSize,szFolderSize);
-
-				/* TODO: The line index should be stored in some other (variable) way. */
-				DisplayWindow_SetLine(m_hDisplayWindow,FOLDER_SIZE_LINE_INDEX,szSizeString);
-			}
+		OnFolderSizeResult(reinterpret_cast<DWFolderSizeCompletion *>(wParam), true);
+		break;
 
-			free(pDWFolderSizeCompletion);
-		}
+	case WM_APP_FOLDERSIZEPROGRESS:
+		OnFolderSizeResult(reinterpret_cast<DWFolderSizeCompletion *>(wParam), false);
 		break;
 
 	case WM_COPYDATA:
@@ -281,6 +243,70 @@ LRESULT CALLBACK Explorerplusplus::WindowProcedure(HWND hwnd,UINT Msg,WPARAM wPa
 	return DefWindowProc(hwnd,Msg,wParam,lParam);
 }
 
+// Called with both the final folder size and the running totals reported while the calculation
+// is still in progress.
+void Explorerplusplus::OnFolderSizeResult(
+	DWFolderSizeCompletion *pDWFolderSizeCompletion, bool completed)
+{
+	BOOL bValid = FALSE;
+
+	/* First, make sure we should still display the
+	results (we won't if the listview selection has
+	changed, or this folder size was calculated for
+	a tab other than the current one). */
+	for (auto itr = m_DWFolderSizes.begin(); itr != m_DWFolderSizes.end(); itr++)
+	{
+		if (itr->uId == pDWFolderSizeCompletion->uId)
+		{
+			if (itr->iTabId == m_tabContainer->GetSelectedTab().GetId())
+			{
+				bValid = itr->bValid;
+			}
+
+			if (completed)
+			{
+				m_DWFolderSizes.erase(itr);
+			}
+
+			break;
+		}
+	}
+
+	if (bValid)
+	{
+		TCHAR szFolderSize[32];
+		FormatSizeString(pDWFolderSizeCompletion->liFolderSize, szFolderSize,
+			SIZEOF_ARRAY(szFolderSize), m_config->globalFolderSettings.forceSize,
+			m_config->globalFolderSettings.sizeDisplayFormat);
+
+		TCHAR szTotalSize[64];
+		LoadString(
+			m_hLanguageModule, IDS_GENERAL_TOTALSIZE, szTotalSize, SIZEOF_ARRAY(szTotalSize));
+
+		TCHAR szSizeString[128];
+
+		if (completed)
+		{
+			StringCchPrintf(szSizeString, SIZEOF_ARRAY(szSizeString), _T("%s: %s"), szTotalSize,
+				szFolderSize);
+		}
+		else
+		{
+			TCHAR szCalculating[64];
+			LoadString(m_hLanguageModule, IDS_GENERAL_CALCULATING, szCalculating,
+				SIZEOF_ARRAY(szCalculating));
+
+			StringCchPrintf(szSizeString, SIZEOF_ARRAY(szSizeString), _T("%s: %s (%s)"),
+				szTotalSize, szFolderSize, szCalculating);
+		}
+
+		/* TODO: The line index should be stored in some other (variable) way. */
+		DisplayWindow_SetLine(m_hDisplayWindow, FOLDER_SIZE_LINE_INDEX, szSizeString);
+	}
+
+	free(pDWFolderSizeCompletion);
+}
+
 LRESULT CALLBACK Explorerplusplus::CommandHandler(HWND hwnd,WPARAM wParam)
 {
 	if (HIWORD(wParam) == 0 || HIWORD(wParam) == 1)
@@ -360,6 +360,23 @@ void Explorerplusplus::FolderSizeCallback(
 	UNREFERENCED_PARAMETER(nFolders);
 	UNREFERENCED_PARAMETER(nFiles);
 
+	PostFolderSizeResult(WM_APP_FOLDERSIZECOMPLETED, pfsei, lTotalFolderSize);
+}
+
+void Explorerplusplus::FolderSizeProgressCallbackStub(
+	int nFolders, int nFiles, PULARGE_INTEGER lTotalFolderSize, LPVOID pData)
+{
+	UNREFERENCED_PARAMETER(nFolders);
+	UNREFERENCED_PARAMETER(nFiles);
+
+	auto *pfsei = reinterpret_cast<Explorerplusplus::FolderSizeExtraInfo *>(pData);
+	reinterpret_cast<Explorerplusplus *>(pfsei->pContainer)
+		->PostFolderSizeResult(WM_APP_FOLDERSIZEPROGRESS, pfsei, lTotalFolderSize);
+}
+
+void Explorerplusplus::PostFolderSizeResult(
+	UINT message, FolderSizeExtraInfo *pfsei, PULARGE_INTEGER lTotalFolderSize)
+{
 	DWFolderSizeCompletion *pDWFolderSizeCompletion = nullptr;
 
 	pDWFolderSizeCompletion = (DWFolderSizeCompletion *) malloc(sizeof(DWFolderSizeCompletion));
@@ -371,7 +388,7 @@ void Explorerplusplus::FolderSizeCallback(
 	the folder size can be displayed. It is up to the main
 	thread to determine whether the folder size should actually
 	be shown. */
-	PostMessage(m_hContainer, WM_APP_FOLDERSIZECOMPLETED, (WPARAM) pDWFolderSizeCompletion, 0);
+	PostMessage(m_hContainer, message, (WPARAM) pDWFolderSizeCompletion, 0);
 }
 
 void Explorerplusplus::OnSelectColumns()
@@ -568,6 +568,8 @@ int Explorerplusplus::OnDestroy()
 {
 	m_applicationShuttingDownSignal();
 
+	LogTaskExecutorStatistics();
+
 	if (m_SHChangeNotifyID != 0)
 	{
 		SHChangeNotifyDeregister(m_SHChangeNotifyID);
@@ -580,6 +582,34 @@ int Explorerplusplus::OnDestroy()
 	return 0;
 }
 
+void Explorerplusplus::LogTaskExecutorStatistics()
+{
+	LOG(debug) << L"Task executor - " << m_taskExecutor.GetNumThreads() << L" threads";
+
+	for (const auto &statistics : m_taskExecutor.GetStatistics())
+	{
+		auto numStarted = statistics.numQueued - statistics.numDropped - statistics.queueDepth;
+		auto averageLatency = (numStarted == 0) ? 0 : statistics.totalLatency.count() / numStarted;
+		const wchar_t *priorityClass = L"background";
+
+		if (statistics.priorityClass == TaskPriorityClass::Interactive)
+		{
+			priorityClass = L"interactive";
+		}
+		else if (statistics.priorityClass == TaskPriorityClass::Foreground)
+		{
+			priorityClass = L"foreground";
+		}
+
+		LOG(debug) << L"Task queue \"" << statistics.name << L"\" (" << priorityClass
+				   << L"): " << statistics.numQueued << L" queued, " << statistics.numCompleted
+				   << L" completed, " << statistics.numDropped << L" dropped, "
+				   << statistics.numStolen << L" stolen, max queue depth "
+				   << statistics.maxQueueDepth << L", average latency " << averageLatency
+				   << L"us, max latency " << statistics.maxLatency.count() << L"us";
+	}
+}
+
 int Explorerplusplus::OnClose()
 {
 	if (m_config->confirmCloseTabs && (m_tabContainer->GetNumTabs() > 1))
@@ -610,6 +640,11 @@ int Explorerplusplus::OnClose()
 
 	SaveAllSettings();
 
+	if (m_persistentItemCache)
+	{
+		m_persistentItemCache->Flush();
+	}
+
 	DestroyWindow(m_hContainer);
 
 	return 0;
@@ -1239,56 +1274,15 @@ LRESULT Explorerplusplus::OnCustomDraw(LPARAM lParam)
 
 		case CDDS_ITEMPREPAINT:
 		{
-			DWORD dwAttributes =
-				m_pActiveShellBrowser->GetItemFileFindData(static_cast<int>(pnmcd->dwItemSpec))
-					.dwFileAttributes;
-
-			std::wstring fullFileName =
-				m_pActiveShellBrowser->GetItemFullName(static_cast<int>(pnmcd->dwItemSpec));
+			// The matching rule is determined when the item is added or updated, so there's no
+			// need to evaluate the rules here.
+			auto colorRuleIndex = m_pActiveShellBrowser->GetItemColorRuleIndex(
+				static_cast<int>(pnmcd->dwItemSpec));
 
-			TCHAR fileName[MAX_PATH];
-			StringCchCopy(fileName, SIZEOF_ARRAY(fileName), fullFileName.c_str());
-			PathStripPath(fileName);
-
-			/* Loop through each filter. Decide whether to change the font of the
-			current item based on its filename and/or attributes. */
-			for (const auto &colorRule : m_ColorRules)
+			if (colorRuleIndex)
 			{
-				BOOL bMatchFileName = FALSE;
-				BOOL bMatchAttributes = FALSE;
-
-				/* Only match against the filename if it's not empty. */
-				if (!colorRule.strFilterPattern.empty())
-				{
-					if (CheckWildcardMatch(colorRule.strFilterPattern.c_str(), fileName,
-							!colorRule.caseInsensitive)
-						== 1)
-					{
-						bMatchFileName = TRUE;
-					}
-				}
-				else
-				{
-					bMatchFileName = TRUE;
-				}
-
-				if (colorRule.dwFilterAttributes != 0)
-				{
-					if (colorRule.dwFilterAttributes & dwAttributes)
-					{
-						bMatchAttributes = TRUE;
-					}
-				}
-				else
-				{
-					bMatchAttributes = TRUE;
-				}
-
-				if (bMatchFileName && bMatchAttributes)
-				{
-					pnmlvcd->clrText = colorRule.rgbColour;
-					return CDRF_NEWFONT;
-				}
+				pnmlvcd->clrText = m_colorRuleSet.GetRuleColor(*colorRuleIndex);
+				return CDRF_NEWFONT;
 			}
 		}
 		break;
@@ -1333,6 +1327,17 @@ void Explorerplusplus::OnGroupBy(SortMode sortMode)
 	}
 	else if (!selectedTab.GetShellBrowser()->GetShowInGroups())
 	{
+		// Groups can't be shown in an owner data listview, so the tab is recreated instead, which
+		// will result in a regular listview being used.
+		if (selectedTab.GetShellBrowser()->IsOwnerDataListView())
+		{
+			FolderSettings folderSettings = selectedTab.GetShellBrowser()->GetFolderSettings();
+			folderSettings.showInGroups = TRUE;
+			folderSettings.sortMode = sortMode;
+			m_tabContainer->RecreateTab(selectedTab, folderSettings);
+			return;
+		}
+
 		selectedTab.GetShellBrowser()->SetShowInGroupsFlag(TRUE);
 	}
 
@@ -1422,6 +1427,26 @@ CachedIcons *Explorerplusplus::GetCachedIcons()
 	return &m_cachedIcons;
 }
 
+IconRequestCoalescer *Explorerplusplus::GetIconRequestCoalescer()
+{
+	return &m_iconRequestCoalescer;
+}
+
+ColorRuleSet *Explorerplusplus::GetColorRuleSet()
+{
+	return &m_colorRuleSet;
+}
+
+TaskExecutor *Explorerplusplus::GetTaskExecutor()
+{
+	return &m_taskExecutor;
+}
+
+PersistentItemCache *Explorerplusplus::GetPersistentItemCache()
+{
+	return m_persistentItemCache.get();
+}
+
 BOOL Explorerplusplus::GetSavePreferencesToXmlFile() const
 {
 	return m_bSavePreferencesToXMLFile;
@@ -31,7 +31,8 @@ private:
 	{
 		CheckSystemIsPinnedToNameSpaceTree,
 		EnableDarkMode,
-		OpenTabsInForeground
+		OpenTabsInForeground,
+		OwnerDataListView
 	};
 
 	enum class AdvancedOptionType
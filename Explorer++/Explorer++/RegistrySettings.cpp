@@ -184,6 +184,30 @@ LONG Explorerplusplus::SaveGenericSettingsToRegistry()
 		RegistrySettings::SaveDword(hSettingsKey, _T("Language"), m_config->language);
 		RegistrySettings::SaveDword(
 			hSettingsKey, _T("OpenTabsInForeground"), m_config->openTabsInForeground);
+		RegistrySettings::SaveDword(
+			hSettingsKey, _T("OwnerDataListView"), m_config->ownerDataListView);
+
+		RegistrySettings::SaveDword(hSettingsKey, _T("ColumnConcurrencySolidState"),
+			m_config->columnConcurrencySolidState);
+		RegistrySettings::SaveDword(hSettingsKey, _T("ColumnConcurrencyRotational"),
+			m_config->columnConcurrencyRotational);
+		RegistrySettings::SaveDword(
+			hSettingsKey, _T("ColumnConcurrencyRemovable"), m_config->columnConcurrencyRemovable);
+		RegistrySettings::SaveDword(
+			hSettingsKey, _T("ColumnConcurrencyNetwork"), m_config->columnConcurrencyNetwork);
+		RegistrySettings::SaveDword(
+			hSettingsKey, _T("ColumnConcurrencyOther"), m_config->columnConcurrencyOther);
+
+		RegistrySettings::SaveDword(
+			hSettingsKey, _T("ThumbnailMemoryLimit"), m_config->thumbnailMemoryLimit);
+
+		RegistrySettings::SaveDword(
+			hSettingsKey, _T("ShareIconsByType"), m_config->shareIconsByType);
+		RegistrySettings::SaveString(hSettingsKey, _T("PerFileIconExtensions"),
+			m_config->perFileIconExtensions.c_str());
+
+		RegistrySettings::SaveDword(
+			hSettingsKey, _T("ItemCacheSizeLimit"), m_config->itemCacheSizeLimit);
 
 		RegistrySettings::SaveDword(hSettingsKey, _T("DisplayMixedFilesAndFolders"),
 			m_config->globalFolderSettings.displayMixedFilesAndFolders);
@@ -418,6 +442,30 @@ LONG Explorerplusplus::LoadGenericSettingsFromRegistry()
 
 		RegistrySettings::Read32BitValueFromRegistry(
 			hSettingsKey, _T("OpenTabsInForeground"), m_config->openTabsInForeground);
+		RegistrySettings::Read32BitValueFromRegistry(
+			hSettingsKey, _T("OwnerDataListView"), m_config->ownerDataListView);
+
+		RegistrySettings::Read32BitValueFromRegistry(hSettingsKey,
+			_T("ColumnConcurrencySolidState"), m_config->columnConcurrencySolidState);
+		RegistrySettings::Read32BitValueFromRegistry(hSettingsKey,
+			_T("ColumnConcurrencyRotational"), m_config->columnConcurrencyRotational);
+		RegistrySettings::Read32BitValueFromRegistry(
+			hSettingsKey, _T("ColumnConcurrencyRemovable"), m_config->columnConcurrencyRemovable);
+		RegistrySettings::Read32BitValueFromRegistry(
+			hSettingsKey, _T("ColumnConcurrencyNetwork"), m_config->columnConcurrencyNetwork);
+		RegistrySettings::Read32BitValueFromRegistry(
+			hSettingsKey, _T("ColumnConcurrencyOther"), m_config->columnConcurrencyOther);
+
+		RegistrySettings::Read32BitValueFromRegistry(
+			hSettingsKey, _T("ThumbnailMemoryLimit"), m_config->thumbnailMemoryLimit);
+
+		RegistrySettings::Read32BitValueFromRegistry(
+			hSettingsKey, _T("ShareIconsByType"), m_config->shareIconsByType);
+		RegistrySettings::ReadString(
+			hSettingsKey, _T("PerFileIconExtensions"), m_config->perFileIconExtensions);
+
+		RegistrySettings::Read32BitValueFromRegistry(
+			hSettingsKey, _T("ItemCacheSizeLimit"), m_config->itemCacheSizeLimit);
 
 		RegistrySettings::Read32BitValueFromRegistry(hSettingsKey,
 			_T("DisplayMixedFilesAndFolders"),
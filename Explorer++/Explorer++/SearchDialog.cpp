@@ -1022,7 +1022,8 @@ DWORD WINAPI NSearchDialog::SearchThread(LPVOID pParam)
 }
 
 Search::Search(HWND hDlg, TCHAR *szBaseDirectory, TCHAR *szPattern, DWORD dwAttributes,
-	BOOL bUseRegularExpressions, BOOL bCaseInsensitive, BOOL bSearchSubFolders)
+	BOOL bUseRegularExpressions, BOOL bCaseInsensitive, BOOL bSearchSubFolders) :
+	m_filterExpression(szPattern, !bCaseInsensitive)
 {
 	m_hDlg = hDlg;
 	m_dwAttributes = dwAttributes;
@@ -1145,8 +1146,7 @@ void Search::SearchDirectoryInternal(
 					}
 					else
 					{
-						if (CheckWildcardMatch(
-								m_szSearchPattern, wfd.cFileName, !m_bCaseInsensitive))
+						if (m_filterExpression.Matches(wfd.cFileName, wfd))
 						{
 							bMatchFileName = TRUE;
 						}
@@ -8,6 +8,7 @@
 #include "../Helper/DialogSettings.h"
 #include "../Helper/FileContextMenuManager.h"
 #include "../Helper/ReferenceCount.h"
+#include "../Helper/FilterExpression.h"
 #include <boost/circular_buffer.hpp>
 #include <MsXml2.h>
 #include <objbase.h>
@@ -124,6 +125,7 @@ private:
 	BOOL m_bSearchSubFolders;
 
 	std::wregex m_rxPattern;
+	const FilterExpression m_filterExpression;
 
 	CRITICAL_SECTION m_csStop;
 	BOOL m_bStopSearching;
@@ -10,11 +10,14 @@
 #include "MainResource.h"
 #include "ShellNavigationController.h"
 #include "ViewModes.h"
+#include "../Helper/FileSystemItemSource.h"
 #include "../Helper/Helper.h"
 #include "../Helper/IconFetcher.h"
 #include "../Helper/ListViewHelper.h"
+#include "../Helper/Logging.h"
 #include "../Helper/Macros.h"
 #include "../Helper/ShellHelper.h"
+#include "../Helper/TimeHelper.h"
 #include <wil/com.h>
 #include <propkey.h>
 #include <propvarutil.h>
@@ -28,6 +31,13 @@ HRESULT ShellBrowser::BrowseFolder(const HistoryEntry &entry)
 	{
 		auto selectedItems = entry.GetSelectedItems();
 		SelectItems(ShallowCopyPidls(selectedItems));
+
+		// Some of the items may not have been enumerated yet. In that case, the selection will be
+		// reapplied once the enumeration has finished.
+		if (IsEnumerationInProgress())
+		{
+			m_directoryState.pendingSelection = std::move(selectedItems);
+		}
 	}
 
 	return hr;
@@ -43,6 +53,10 @@ HRESULT ShellBrowser::BrowseFolder(PCIDLIST_ABSOLUTE pidlDirectory, bool addHist
 
 	m_navigationStartedSignal(pidlDirectory);
 
+	// Relative times in the filter (e.g. modified<7d) are measured from the point at which the
+	// filter was compiled, so it's compiled again each time a folder is loaded or refreshed.
+	UpdateFilterExpression();
+
 	HRESULT hr = EnumerateFolder(pidlDirectory, addHistoryEntry);
 
 	if (FAILED(hr))
@@ -106,7 +120,15 @@ void ShellBrowser::PrepareToChangeFolders()
 
 	StoreCurrentlySelectedItems();
 
-	ListView_DeleteAllItems(m_hListView);
+	if (m_ownerDataListView)
+	{
+		SetOwnerDataItems({});
+	}
+	else
+	{
+		ListView_DeleteAllItems(m_hListView);
+		InvalidateItemPositions();
+	}
 
 	if (m_bFolderVisited)
 	{
@@ -116,16 +138,18 @@ void ShellBrowser::PrepareToChangeFolders()
 
 void ShellBrowser::ClearPendingResults()
 {
-	m_columnThreadPool.clear_queue();
-	m_columnResults.clear();
+	ClearColumnTasks();
 
 	m_iconFetcher->ClearQueue();
 
-	m_thumbnailThreadPool.clear_queue();
-	m_thumbnailResults.clear();
+	ClearThumbnailTasks();
 
-	m_infoTipsThreadPool.clear_queue();
+	m_infoTipsTaskQueue->Clear();
 	m_infoTipResults.clear();
+
+	CancelBackgroundSort();
+
+	CancelBackgroundGrouping();
 }
 
 void ShellBrowser::ResetFolderState()
@@ -139,8 +163,7 @@ void ShellBrowser::ResetFolderState()
 		int nItems = ListView_GetItemCount(m_hListView);
 
 		/* Create and set the new imagelist. */
-		HIMAGELIST himl = ImageList_Create(
-			THUMBNAIL_ITEM_WIDTH, THUMBNAIL_ITEM_HEIGHT, ILC_COLOR32, nItems, nItems + 100);
+		HIMAGELIST himl = CreateThumbnailImageList(nItems);
 		ListView_SetImageList(m_hListView, himl, LVSIL_NORMAL);
 
 		ImageList_Destroy(himlOld);
@@ -148,11 +171,19 @@ void ShellBrowser::ResetFolderState()
 
 	m_directoryState = DirectoryState();
 
+	m_lastFirstVisibleThumbnail = 0;
+	m_thumbnailScrollDirection = 1;
+	ResetThumbnailSlots();
+
 	EnterCriticalSection(&m_csDirectoryAltered);
 	m_AlteredList.clear();
 	LeaveCriticalSection(&m_csDirectoryAltered);
 
 	m_itemInfoMap.clear();
+
+	// Any column tasks still running will continue to use the previous cache, so a new cache is
+	// created, rather than clearing the existing one.
+	m_columnValueCache = std::make_shared<ColumnValueCache>(m_persistentItemCache);
 }
 
 void ShellBrowser::StoreCurrentlySelectedItems()
@@ -179,7 +210,7 @@ HRESULT ShellBrowser::EnumerateFolder(PCIDLIST_ABSOLUTE pidlDirectory, bool addH
 		return hr;
 	}
 
-	SFGAOF attr = SFGAO_FILESYSTEM;
+	SFGAOF attr = SFGAO_FILESYSTEM | SFGAO_FOLDER | SFGAO_STREAM;
 	hr = parent->GetAttributesOf(1, &child, &attr);
 
 	if (FAILED(hr))
@@ -195,26 +226,47 @@ HRESULT ShellBrowser::EnumerateFolder(PCIDLIST_ABSOLUTE pidlDirectory, bool addH
 		return hr;
 	}
 
-	wil::com_ptr_nothrow<IShellFolder> shellFolder;
-	hr = BindToIdl(pidlDirectory, IID_PPV_ARGS(&shellFolder));
+	SHCONTF enumFlags = SHCONTF_FOLDERS | SHCONTF_NONFOLDERS;
 
-	if (FAILED(hr))
+	if (m_folderSettings.showHidden)
 	{
-		return hr;
+		WI_SetAllFlags(enumFlags, SHCONTF_INCLUDEHIDDEN | SHCONTF_INCLUDESUPERHIDDEN);
 	}
 
-	SHCONTF enumFlags = SHCONTF_FOLDERS | SHCONTF_NONFOLDERS;
+	bool isRecycleBin = m_recycleBinPidl
+		&& m_desktopFolder->CompareIDs(SHCIDS_CANONICALONLY, pidlDirectory, m_recycleBinPidl.get())
+			== 0;
 
-	if (m_folderSettings.showHidden)
+	bool useItemSource = CanUseItemSource(pidlDirectory, attr, parsingPath, isRecycleBin);
+
+	auto enumerationState = std::make_shared<EnumerationState>(m_enumerationIdCounter++,
+		pidlDirectory, enumFlags, isRecycleBin, parsingPath, useItemSource);
+	hr = enumerationState->stateChanged.create();
+
+	if (FAILED(hr))
 	{
-		WI_SetAllFlags(enumFlags, SHCONTF_INCLUDEHIDDEN | SHCONTF_INCLUDESUPERHIDDEN);
+		return hr;
 	}
 
-	wil::com_ptr_nothrow<IEnumIDList> enumerator;
-	hr = shellFolder->EnumObjects(m_hOwner, enumFlags, &enumerator);
+	// Only a single folder is enumerated at a time, so any enumeration that's still running for
+	// the previous folder needs to be stopped.
+	CancelEnumeration();
 
-	if (FAILED(hr) || !enumerator)
+	// The UI thread waits (for a limited time) for this task to start (see
+	// WaitForInitialEnumerationResults()), which is why the enumeration queue uses the interactive
+	// priority class.
+	m_enumerationTaskQueue->PushTask(
+		[listView = m_hListView, owner = m_hOwner, enumerationState]() {
+			EnumerateFolderAsync(listView, owner, *enumerationState);
+		});
+
+	hr = WaitForInitialEnumerationResults(*enumerationState);
+
+	// Note that EnumObjects can return S_FALSE without returning an enumerator, in which case
+	// there are no items to show.
+	if (hr != S_OK)
 	{
+		enumerationState->cancelled = true;
 		return hr;
 	}
 
@@ -225,17 +277,381 @@ HRESULT ShellBrowser::EnumerateFolder(PCIDLIST_ABSOLUTE pidlDirectory, bool addH
 	m_directoryState.virtualFolder = WI_IsFlagClear(attr, SFGAO_FILESYSTEM);
 	m_uniqueFolderId++;
 
+	UpdateColumnConcurrencyLimit();
+
 	m_navigationCommittedSignal(pidlDirectory, addHistoryEntry);
 
+	m_enumerationState = enumerationState;
+	TakeEnumeratedItems();
+
+	return hr;
+}
+
+// Plain file system folders can be read in bulk, directly from the file system. Folders that have
+// a custom shell implementation (e.g. the desktop, which merges several locations, or system
+// folders such as Fonts) and zip files are still enumerated through the shell.
+bool ShellBrowser::CanUseItemSource(PCIDLIST_ABSOLUTE pidlDirectory, SFGAOF attributes,
+	const std::wstring &parsingPath, bool isRecycleBin) const
+{
+	if (WI_IsAnyFlagClear(attributes, SFGAO_FILESYSTEM | SFGAO_FOLDER)
+		|| WI_IsFlagSet(attributes, SFGAO_STREAM))
+	{
+		return false;
+	}
+
+	if (isRecycleBin || IsNamespaceRoot(pidlDirectory))
+	{
+		return false;
+	}
+
+	return !PathIsSystemFolder(parsingPath.c_str(), 0);
+}
+
+// Runs on a background thread. Each item is retrieved and stored in the shared state. The UI
+// thread is then periodically notified that a batch of items is available.
+void ShellBrowser::EnumerateFolderAsync(HWND listView, HWND owner, EnumerationState &state)
+{
+	wil::com_ptr_nothrow<IShellFolder> shellFolder;
+	HRESULT hr = BindToIdl(state.pidlDirectory.get(), IID_PPV_ARGS(&shellFolder));
+
+	if (FAILED(hr))
+	{
+		FinishEnumeration(listView, state, hr);
+		return;
+	}
+
+	if (state.useItemSource)
+	{
+		auto itemSource = CreateFileSystemItemSource(state.directory);
+
+		if (itemSource)
+		{
+			EnumerateFileSystemItems(listView, state, shellFolder.get(), *itemSource);
+			return;
+		}
+
+		// If the directory can't be opened directly, the shell enumerator will be used instead.
+		// That way, any error is reported in the same way it would be normally.
+	}
+
+	wil::com_ptr_nothrow<IEnumIDList> enumerator;
+	hr = shellFolder->EnumObjects(owner, state.enumFlags, &enumerator);
+
+	if (FAILED(hr) || !enumerator)
+	{
+		FinishEnumeration(listView, state, FAILED(hr) ? hr : S_FALSE);
+		return;
+	}
+
+	StartEnumeration(state);
+
+	ULONGLONG lastBatchTime = GetTickCount64();
 	ULONG numFetched = 1;
 	unique_pidl_child pidlItem;
 
-	while (enumerator->Next(1, wil::out_param(pidlItem), &numFetched) == S_OK && (numFetched == 1))
+	while (!state.cancelled
+		&& enumerator->Next(1, wil::out_param(pidlItem), &numFetched) == S_OK
+		&& (numFetched == 1))
 	{
-		AddItemInternal(shellFolder.get(), pidlDirectory, pidlItem.get(), -1, FALSE);
+		auto itemInfo = GetItemInformation(
+			shellFolder.get(), state.pidlDirectory.get(), pidlItem.get(), state.isRecycleBin);
+
+		if (!itemInfo)
+		{
+			continue;
+		}
+
+		AddEnumeratedItem(listView, state, std::move(*itemInfo), lastBatchTime);
 	}
 
-	return hr;
+	FinishEnumeration(listView, state, S_OK);
+}
+
+// Reads the folder contents in large batches. The name, attributes, size and times for each item
+// are all returned by the item source, so there's no need to query the shell for that information
+// one item at a time.
+void ShellBrowser::EnumerateFileSystemItems(
+	HWND listView, EnumerationState &state, IShellFolder *shellFolder, ItemSource &itemSource)
+{
+	StartEnumeration(state);
+
+	bool showHidden = WI_IsFlagSet(state.enumFlags, SHCONTF_INCLUDEHIDDEN);
+	bool showSuperHidden = WI_IsFlagSet(state.enumFlags, SHCONTF_INCLUDESUPERHIDDEN);
+
+	ULONGLONG lastBatchTime = GetTickCount64();
+	std::vector<FileSystemItem> items;
+	bool moreItems = true;
+
+	while (moreItems && !state.cancelled)
+	{
+		items.clear();
+		moreItems = itemSource.ReadBatch(items, ITEM_SOURCE_BATCH_SIZE);
+
+		for (const auto &item : items)
+		{
+			if (state.cancelled)
+			{
+				break;
+			}
+
+			bool hidden = WI_IsFlagSet(item.attributes, FileSystemItemAttributes::HIDDEN);
+
+			// Hidden system files are treated as "super hidden" by the shell.
+			if (hidden
+				&& (!showHidden
+					|| (!showSuperHidden
+						&& WI_IsFlagSet(item.attributes, FileSystemItemAttributes::SYSTEM))))
+			{
+				continue;
+			}
+
+			auto itemInfo = GetFileSystemItemInformation(shellFolder, state, item);
+
+			if (!itemInfo)
+			{
+				continue;
+			}
+
+			AddEnumeratedItem(listView, state, std::move(*itemInfo), lastBatchTime);
+		}
+	}
+
+	HRESULT result = S_OK;
+	std::error_code error = itemSource.GetError();
+
+	if (!state.cancelled && error)
+	{
+		result = HRESULT_FROM_WIN32(static_cast<DWORD>(error.value()));
+	}
+
+	FinishEnumeration(listView, state, result);
+}
+
+void ShellBrowser::StartEnumeration(EnumerationState &state)
+{
+	{
+		std::scoped_lock lock(state.mutex);
+		state.started = true;
+	}
+
+	state.stateChanged.SetEvent();
+}
+
+void ShellBrowser::AddEnumeratedItem(
+	HWND listView, EnumerationState &state, ItemInfo_t itemInfo, ULONGLONG &lastBatchTime)
+{
+	bool postBatch = false;
+
+	{
+		std::scoped_lock lock(state.mutex);
+		state.pendingItems.push_back(std::move(itemInfo));
+
+		ULONGLONG now = GetTickCount64();
+
+		if (!state.batchPosted && (now - lastBatchTime) >= ENUMERATION_BATCH_INTERVAL)
+		{
+			state.batchPosted = true;
+			postBatch = true;
+			lastBatchTime = now;
+		}
+	}
+
+	if (postBatch)
+	{
+		PostMessage(listView, WM_APP_ENUMERATION_BATCH_READY, state.enumerationId, 0);
+	}
+}
+
+void ShellBrowser::FinishEnumeration(HWND listView, EnumerationState &state, HRESULT result)
+{
+	bool postBatch;
+
+	{
+		std::scoped_lock lock(state.mutex);
+		state.result = result;
+		state.finished = true;
+
+		// The UI thread may have stopped waiting before the enumeration started, so the final
+		// batch is always posted. If the UI thread is still waiting, the message will simply be
+		// ignored.
+		postBatch = !state.batchPosted && !state.cancelled;
+		state.batchPosted = true;
+	}
+
+	state.stateChanged.SetEvent();
+
+	if (postBatch)
+	{
+		PostMessage(listView, WM_APP_ENUMERATION_BATCH_READY, state.enumerationId, 0);
+	}
+}
+
+// Waits until the enumeration has either finished, failed, or run for longer than the initial
+// timeout. If the enumeration task doesn't start within the start timeout, this returns early and
+// the results are handled asynchronously instead, in the same way as items that arrive after the
+// initial timeout. Sent messages are still dispatched while waiting, since the enumerator may need
+// to interact with the owner window (e.g. to show a prompt).
+HRESULT ShellBrowser::WaitForInitialEnumerationResults(EnumerationState &state)
+{
+	const ULONGLONG startDeadline = GetTickCount64() + ENUMERATION_START_TIMEOUT;
+	std::optional<ULONGLONG> deadline;
+
+	while (true)
+	{
+		ULONGLONG now = GetTickCount64();
+
+		{
+			std::scoped_lock lock(state.mutex);
+
+			if (state.finished)
+			{
+				return state.result;
+			}
+
+			if (state.started && !deadline)
+			{
+				deadline = now + ENUMERATION_INITIAL_TIMEOUT;
+			}
+		}
+
+		ULONGLONG currentDeadline = deadline.value_or(startDeadline);
+
+		if (now >= currentDeadline)
+		{
+			return S_OK;
+		}
+
+		DWORD timeout = static_cast<DWORD>(currentDeadline - now);
+
+		HANDLE event = state.stateChanged.get();
+		DWORD res = MsgWaitForMultipleObjects(1, &event, FALSE, timeout, QS_SENDMESSAGE);
+
+		if (res == WAIT_OBJECT_0 + 1)
+		{
+			MSG msg;
+			PeekMessage(&msg, nullptr, 0, 0, PM_NOREMOVE | PM_QS_SENDMESSAGE);
+		}
+		else if (res == WAIT_FAILED)
+		{
+			return HRESULT_FROM_WIN32(GetLastError());
+		}
+	}
+}
+
+// Moves any items that have been enumerated so far into the awaiting list. Returns true if the
+// enumeration has now finished.
+bool ShellBrowser::TakeEnumeratedItems()
+{
+	std::vector<ItemInfo_t> items;
+	bool finished;
+	HRESULT result;
+
+	{
+		std::scoped_lock lock(m_enumerationState->mutex);
+		items = std::move(m_enumerationState->pendingItems);
+		m_enumerationState->pendingItems.clear();
+		m_enumerationState->batchPosted = false;
+		finished = m_enumerationState->finished;
+		result = m_enumerationState->result;
+	}
+
+	for (auto &item : items)
+	{
+		AddItemInternal(-1, std::move(item), FALSE);
+	}
+
+	if (finished)
+	{
+		m_enumerationState.reset();
+
+		// The navigation has already been committed at this point, so the failure is handled
+		// separately, once the current operation has completed (this can be called while the
+		// navigation is still in progress).
+		if (FAILED(result))
+		{
+			PostMessage(m_hListView, WM_APP_ENUMERATION_FAILED, m_uniqueFolderId, result);
+		}
+	}
+
+	return finished;
+}
+
+void ShellBrowser::OnEnumerationBatchReady(int enumerationId)
+{
+	// The batch may belong to a folder that's no longer being shown.
+	if (!m_enumerationState || m_enumerationState->enumerationId != enumerationId)
+	{
+		return;
+	}
+
+	bool finished = TakeEnumeratedItems();
+
+	if (!m_directoryState.awaitingAddList.empty())
+	{
+		SendMessage(m_hListView, WM_SETREDRAW, FALSE, NULL);
+
+		int numPreviousItems = ListView_GetItemCount(m_hListView);
+
+		InsertAwaitingItems(m_folderSettings.showInGroups);
+
+		// The items already shown are in sorted order, so only the new batch needs to be sorted
+		// and merged in. In owner data mode, the items are merged into their sorted positions as
+		// they're inserted.
+		if (!m_ownerDataListView)
+		{
+			MergeAppendedItems(numPreviousItems);
+		}
+
+		SendMessage(m_hListView, WM_SETREDRAW, TRUE, NULL);
+	}
+
+	if (finished && !m_directoryState.pendingSelection.empty())
+	{
+		SelectItems(ShallowCopyPidls(m_directoryState.pendingSelection));
+		m_directoryState.pendingSelection.clear();
+	}
+
+	directoryModified.m_signal();
+}
+
+// Called when the enumeration fails after the UI thread has stopped waiting for it (and the
+// navigation has been committed). That's treated in the same way as a failure that occurs before
+// the navigation is committed: the navigation is reported as having failed and the previous folder
+// is shown again.
+void ShellBrowser::OnEnumerationFailed(int folderId, HRESULT hr)
+{
+	// The user may have navigated elsewhere in the meantime.
+	if (folderId != m_uniqueFolderId)
+	{
+		return;
+	}
+
+	LOG(warning) << L"Enumeration of \"" << m_directoryState.directory
+				 << L"\" failed after the navigation was committed (hr = 0x" << std::hex << hr
+				 << L").";
+
+	m_navigationFailedSignal();
+
+	if (m_navigationController->CanGoBack())
+	{
+		m_navigationController->GoBack();
+	}
+}
+
+void ShellBrowser::CancelEnumeration()
+{
+	if (!m_enumerationState)
+	{
+		return;
+	}
+
+	m_enumerationState->cancelled = true;
+	m_enumerationState.reset();
+}
+
+bool ShellBrowser::IsEnumerationInProgress() const
+{
+	return m_enumerationState != nullptr;
 }
 
 std::optional<int> ShellBrowser::AddItemInternal(IShellFolder *shellFolder,
@@ -254,6 +670,8 @@ std::optional<int> ShellBrowser::AddItemInternal(IShellFolder *shellFolder,
 int ShellBrowser::AddItemInternal(int itemIndex, ItemInfo_t itemInfo, BOOL setPosition)
 {
 	int itemId = GenerateUniqueItemId();
+	UpdateItemColorRule(itemInfo);
+	AddItemToLookupIndexes(itemId, itemInfo);
 	m_itemInfoMap.insert({ itemId, std::move(itemInfo) });
 
 	AwaitingAdd_t awaitingAdd;
@@ -279,6 +697,17 @@ int ShellBrowser::AddItemInternal(int itemIndex, ItemInfo_t itemInfo, BOOL setPo
 
 std::optional<ShellBrowser::ItemInfo_t> ShellBrowser::GetItemInformation(
 	IShellFolder *shellFolder, PCIDLIST_ABSOLUTE pidlDirectory, PCITEMID_CHILD pidlChild)
+{
+	bool isRecycleBin = m_recycleBinPidl
+		&& m_desktopFolder->CompareIDs(SHCIDS_CANONICALONLY, pidlDirectory, m_recycleBinPidl.get())
+			== 0;
+
+	return GetItemInformation(shellFolder, pidlDirectory, pidlChild, isRecycleBin);
+}
+
+// Note that this may be called on a background thread, so it shouldn't access any instance state.
+std::optional<ShellBrowser::ItemInfo_t> ShellBrowser::GetItemInformation(IShellFolder *shellFolder,
+	PCIDLIST_ABSOLUTE pidlDirectory, PCITEMID_CHILD pidlChild, bool isRecycleBin)
 {
 	ItemInfo_t itemInfo;
 
@@ -308,10 +737,6 @@ std::optional<ShellBrowser::ItemInfo_t> ShellBrowser::GetItemInformation(
 
 	SHGDNF displayNameFlags = SHGDN_INFOLDER;
 
-	bool isRecycleBin = m_recycleBinPidl
-		&& m_desktopFolder->CompareIDs(SHCIDS_CANONICALONLY, pidlDirectory, m_recycleBinPidl.get())
-			== 0;
-
 	// SHGDN_INFOLDER | SHGDN_FORPARSING is used to ensure that the name retrieved for a filesystem
 	// file contains an extension, even if extensions are hidden in Windows Explorer. When using
 	// SHGDN_INFOLDER by itself, the resulting name won't contain an extension if extensions are
@@ -381,6 +806,95 @@ std::optional<ShellBrowser::ItemInfo_t> ShellBrowser::GetItemInformation(
 	return std::move(itemInfo);
 }
 
+// Builds the item information from the details returned by an ItemSource. The item's pidl is
+// constructed from that data as well, so the item doesn't need to be accessed again.
+std::optional<ShellBrowser::ItemInfo_t> ShellBrowser::GetFileSystemItemInformation(
+	IShellFolder *shellFolder, const EnumerationState &state, const FileSystemItem &item)
+{
+	WIN32_FIND_DATA wfd = {};
+	wfd.dwFileAttributes = item.attributes;
+	wfd.ftCreationTime = UInt64ToFileTime(item.creationTime);
+	wfd.ftLastAccessTime = UInt64ToFileTime(item.lastAccessTime);
+	wfd.ftLastWriteTime = UInt64ToFileTime(item.lastWriteTime);
+	wfd.nFileSizeHigh = static_cast<DWORD>(item.size >> 32);
+	wfd.nFileSizeLow = static_cast<DWORD>(item.size & 0xFFFFFFFF);
+
+	HRESULT hr = StringCchCopy(wfd.cFileName, SIZEOF_ARRAY(wfd.cFileName), item.name.c_str());
+
+	if (FAILED(hr))
+	{
+		return std::nullopt;
+	}
+
+	unique_pidl_child pidlChild;
+	hr = CreateChildPidlFromFindData(shellFolder, wfd, wil::out_param(pidlChild));
+
+	if (FAILED(hr))
+	{
+		return std::nullopt;
+	}
+
+	if (RequiresShellItemInformation(wfd))
+	{
+		return GetItemInformation(
+			shellFolder, state.pidlDirectory.get(), pidlChild.get(), state.isRecycleBin);
+	}
+
+	// The editing name depends on whether or not extensions are hidden in Windows Explorer, so it
+	// still needs to be retrieved from the shell. That's based solely on the pidl, however.
+	std::wstring editingName;
+	hr = GetDisplayName(
+		shellFolder, pidlChild.get(), SHGDN_INFOLDER | SHGDN_FOREDITING, editingName);
+
+	if (FAILED(hr))
+	{
+		return std::nullopt;
+	}
+
+	ItemInfo_t itemInfo;
+	itemInfo.pidlComplete.reset(ILCombine(state.pidlDirectory.get(), pidlChild.get()));
+	itemInfo.pridl = std::move(pidlChild);
+	itemInfo.parsingName = state.directory;
+
+	if (!itemInfo.parsingName.empty() && itemInfo.parsingName.back() != '\\')
+	{
+		itemInfo.parsingName += '\\';
+	}
+
+	itemInfo.parsingName += item.name;
+	itemInfo.displayName = item.name;
+	itemInfo.editingName = editingName;
+	itemInfo.bDrive = FALSE;
+	itemInfo.wfd = wfd;
+	itemInfo.isFindDataValid = true;
+
+	return std::move(itemInfo);
+}
+
+// Returns true if the shell may present the item differently to the underlying file. For example,
+// shortcuts can have their extension hidden and folders can be given a localized name or custom
+// handler through a desktop.ini file (which is only read when the folder is marked as read-only
+// or system).
+bool ShellBrowser::RequiresShellItemInformation(const WIN32_FIND_DATA &wfd)
+{
+	if (WI_IsFlagSet(wfd.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY))
+	{
+		return PathIsSystemFolder(nullptr, wfd.dwFileAttributes);
+	}
+
+	const TCHAR *extension = PathFindExtension(wfd.cFileName);
+
+	for (const TCHAR *shellExtension : { L".lnk", L".url", L".pif", L".scf", L".library-ms" })
+	{
+		if (lstrcmpi(extension, shellExtension) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 HRESULT ShellBrowser::ExtractFindDataUsingPropertyStore(
 	IShellFolder *shellFolder, PCITEMID_CHILD pidlChild, WIN32_FIND_DATA &output)
 {
@@ -452,6 +966,12 @@ void ShellBrowser::InsertAwaitingItems(BOOL bInsertIntoGroup)
 		ApplyFolderEmptyBackgroundImage(false);
 	}
 
+	if (m_ownerDataListView)
+	{
+		InsertAwaitingItemsOwnerData();
+		return;
+	}
+
 	/* Make the listview allocate space (for internal data structures)
 	for all the items at once, rather than individually.
 	Acts as a speed optimization. */
@@ -465,30 +985,68 @@ void ShellBrowser::InsertAwaitingItems(BOOL bInsertIntoGroup)
 	int nAdded = 0;
 	std::optional<int> itemToRename;
 
+	// Filtered items are set aside first, so that groups are only determined for the items that
+	// will actually be inserted.
+	std::vector<const AwaitingAdd_t *> itemsToInsert;
+	itemsToInsert.reserve(m_directoryState.awaitingAddList.size());
+
 	for (const auto &awaitingItem : m_directoryState.awaitingAddList)
 	{
-		const auto &itemInfo = m_itemInfoMap.at(awaitingItem.iItemInternal);
-
-		if (IsFileFiltered(itemInfo))
+		if (IsFileFiltered(m_itemInfoMap.at(awaitingItem.iItemInternal)))
 		{
 			m_directoryState.filteredItemsList.insert(awaitingItem.iItemInternal);
 			continue;
 		}
 
+		itemsToInsert.push_back(&awaitingItem);
+	}
+
+	std::vector<int> groupIds;
+	std::unordered_set<int> updatedGroups;
+
+	// Where determining the groups is expensive, the items are inserted without a group (and so
+	// aren't shown) and moved into their groups once those have been determined.
+	bool groupInBackground =
+		bInsertIntoGroup && ShouldDetermineGroupsInBackground(itemsToInsert.size());
+	std::vector<int> itemsToGroup;
+
+	if (bInsertIntoGroup && !groupInBackground)
+	{
+		std::vector<int> internalIndexes;
+		internalIndexes.reserve(itemsToInsert.size());
+
+		for (const auto *awaitingItem : itemsToInsert)
+		{
+			internalIndexes.push_back(awaitingItem->iItemInternal);
+		}
+
+		groupIds = DetermineItemGroups(internalIndexes);
+	}
+
+	for (size_t i = 0; i < itemsToInsert.size(); i++)
+	{
+		const auto &awaitingItem = *itemsToInsert[i];
+		const auto &itemInfo = m_itemInfoMap.at(awaitingItem.iItemInternal);
+
+		UpdateSortKeys(awaitingItem.iItemInternal);
+
 		BasicItemInfo_t basicItemInfo = getBasicItemInfo(awaitingItem.iItemInternal);
 		std::wstring filename = ProcessItemFileName(basicItemInfo, m_config->globalFolderSettings);
 
 		LVITEM lv;
 		lv.mask = LVIF_TEXT | LVIF_IMAGE | LVIF_PARAM;
 
-		if (bInsertIntoGroup)
+		if (groupInBackground)
 		{
-			int groupId = DetermineItemGroup(awaitingItem.iItemInternal);
-
 			lv.mask |= LVIF_GROUPID;
-			lv.iGroupId = groupId;
+			lv.iGroupId = I_GROUPIDNONE;
+		}
+		else if (bInsertIntoGroup)
+		{
+			lv.mask |= LVIF_GROUPID;
+			lv.iGroupId = groupIds[i];
 
-			EnsureGroupExistsInListView(groupId);
+			EnsureGroupExistsInListView(groupIds[i]);
 		}
 
 		lv.iItem = awaitingItem.iItem;
@@ -512,6 +1070,22 @@ void ShellBrowser::InsertAwaitingItems(BOOL bInsertIntoGroup)
 		/* Insert the item into the list view control. */
 		int iItemIndex = ListView_InsertItem(m_hListView, &lv);
 
+		if (iItemIndex != -1)
+		{
+			OnItemPositionInserted(iItemIndex, awaitingItem.iItemInternal);
+		}
+
+		// The group headers are updated once all the items have been inserted.
+		if (groupInBackground && iItemIndex != -1)
+		{
+			itemsToGroup.push_back(awaitingItem.iItemInternal);
+		}
+		else if (bInsertIntoGroup && iItemIndex != -1)
+		{
+			ChangeGroupItemCount(groupIds[i], 1);
+			updatedGroups.insert(groupIds[i]);
+		}
+
 		if (awaitingItem.bPosition && m_folderSettings.viewMode != +ViewMode::Details)
 		{
 			POINT ptItem;
@@ -559,6 +1133,13 @@ void ShellBrowser::InsertAwaitingItems(BOOL bInsertIntoGroup)
 		nAdded++;
 	}
 
+	UpdateGroupHeaders(updatedGroups);
+
+	if (groupInBackground)
+	{
+		StartBackgroundGrouping(itemsToGroup);
+	}
+
 	if (m_folderSettings.autoArrange)
 	{
 		ListViewHelper::SetAutoArrange(m_hListView, TRUE);
@@ -597,7 +1178,7 @@ BOOL ShellBrowser::IsFileFiltered(const ItemInfo_t &itemInfo) const
 	if (m_folderSettings.applyFilter
 		&& ((itemInfo.wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != FILE_ATTRIBUTE_DIRECTORY))
 	{
-		bFilenameFiltered = IsFilenameFiltered(itemInfo.displayName.c_str());
+		bFilenameFiltered = IsFilenameFiltered(itemInfo);
 	}
 
 	if (m_config->globalFolderSettings.hideSystemFiles)
@@ -612,9 +1193,7 @@ BOOL ShellBrowser::IsFileFiltered(const ItemInfo_t &itemInfo) const
 void ShellBrowser::RemoveItem(int iItemInternal)
 {
 	ULARGE_INTEGER ulFileSize;
-	LVFINDINFO lvfi;
 	BOOL bFolder;
-	int iItem;
 	int nItems;
 
 	if (iItemInternal == -1)
@@ -622,6 +1201,17 @@ void ShellBrowser::RemoveItem(int iItemInternal)
 		return;
 	}
 
+	// A filtered item isn't in the listview and has already been removed from the item counts
+	// and the directory size, so only its stored details need to be removed.
+	if (m_directoryState.filteredItemsList.erase(iItemInternal) > 0)
+	{
+		RemoveItemFromLookupIndexes(iItemInternal, m_itemInfoMap.at(iItemInternal));
+		m_columnValueCache->RemoveItem(iItemInternal);
+		m_thumbnailSlots.Release(iItemInternal);
+		m_itemInfoMap.erase(iItemInternal);
+		return;
+	}
+
 	/* Is this item a folder? */
 	bFolder = (m_itemInfoMap.at(iItemInternal).wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
 		== FILE_ATTRIBUTE_DIRECTORY;
@@ -637,15 +1227,13 @@ void ShellBrowser::RemoveItem(int iItemInternal)
 	Could use filename, providing removed
 	items are always deleted before new
 	items are inserted. */
-	lvfi.flags = LVFI_PARAM;
-	lvfi.lParam = iItemInternal;
-	iItem = ListView_FindItem(m_hListView, -1, &lvfi);
+	auto iItem = LocateItemByInternalIndex(iItemInternal);
 
-	if (iItem != -1)
+	if (iItem)
 	{
 		if (m_folderSettings.showInGroups)
 		{
-			auto groupId = GetItemGroupId(iItem);
+			auto groupId = GetItemGroupId(*iItem);
 
 			if (groupId)
 			{
@@ -654,9 +1242,20 @@ void ShellBrowser::RemoveItem(int iItemInternal)
 		}
 
 		/* Remove the item from the listview. */
-		ListView_DeleteItem(m_hListView, iItem);
+		if (m_ownerDataListView)
+		{
+			RemoveOwnerDataItem(*iItem);
+		}
+		else
+		{
+			ListView_DeleteItem(m_hListView, *iItem);
+			OnItemPositionRemoved(iItemInternal);
+		}
 	}
 
+	RemoveItemFromLookupIndexes(iItemInternal, m_itemInfoMap.at(iItemInternal));
+	m_columnValueCache->RemoveItem(iItemInternal);
+	m_thumbnailSlots.Release(iItemInternal);
 	m_itemInfoMap.erase(iItemInternal);
 
 	nItems = ListView_GetItemCount(m_hListView);
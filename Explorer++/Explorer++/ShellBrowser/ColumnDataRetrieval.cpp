@@ -5,9 +5,9 @@
 #include "stdafx.h"
 #include "ColumnDataRetrieval.h"
 #include "Columns.h"
+#include "FileFacts.h"
 #include "FolderSettings.h"
 #include "ItemData.h"
-#include "../Helper/DriveInfo.h"
 #include "../Helper/FileOperations.h"
 #include "../Helper/FolderSize.h"
 #include "../Helper/Helper.h"
@@ -17,13 +17,20 @@
 #include <wil/com.h>
 #include <IPHlpApi.h>
 #include <propkey.h>
-#include <filesystem>
 
 BOOL GetPrinterStatusDescription(DWORD dwStatus, TCHAR *szStatus, size_t cchMax);
 
 std::wstring GetColumnText(ColumnType columnType, const BasicItemInfo_t &basicItemInfo,
 	const GlobalFolderSettings &globalFolderSettings)
 {
+	FileFact fileFacts = GetFileFactsForColumn(columnType);
+
+	if (fileFacts != FileFact::None)
+	{
+		return GetFileFactsColumnText(
+			columnType, RetrieveFileFacts(basicItemInfo, fileFacts), globalFolderSettings);
+	}
+
 	switch (columnType)
 	{
 	case ColumnType::Name:
@@ -43,28 +50,9 @@ std::wstring GetColumnText(ColumnType columnType, const BasicItemInfo_t &basicIt
 
 	case ColumnType::Attributes:
 		return GetAttributeColumnText(basicItemInfo);
-	case ColumnType::RealSize:
-		return GetRealSizeColumnText(basicItemInfo, globalFolderSettings);
-	case ColumnType::ShortName:
-		return GetShortNameColumnText(basicItemInfo);
-	case ColumnType::Owner:
-		return GetOwnerColumnText(basicItemInfo);
-
-	case ColumnType::ProductName:
-		return GetVersionColumnText(basicItemInfo, VersionInfoType::ProductName);
-	case ColumnType::Company:
-		return GetVersionColumnText(basicItemInfo, VersionInfoType::Company);
-	case ColumnType::Description:
-		return GetVersionColumnText(basicItemInfo, VersionInfoType::Description);
-	case ColumnType::FileVersion:
-		return GetVersionColumnText(basicItemInfo, VersionInfoType::FileVersion);
-	case ColumnType::ProductVersion:
-		return GetVersionColumnText(basicItemInfo, VersionInfoType::ProductVersion);
 
 	case ColumnType::ShortcutTo:
 		return GetShortcutToColumnText(basicItemInfo);
-	case ColumnType::HardLinks:
-		return GetHardLinksColumnText(basicItemInfo);
 	case ColumnType::Extension:
 		return GetExtensionColumnText(basicItemInfo);
 
@@ -182,6 +170,41 @@ std::wstring GetColumnText(ColumnType columnType, const BasicItemInfo_t &basicIt
 	return EMPTY_STRING;
 }
 
+// Returns the text for a column whose value comes from the file facts for an item (see
+// GetFileFactsForColumn).
+std::wstring GetFileFactsColumnText(ColumnType columnType, const FileFacts &fileFacts,
+	const GlobalFolderSettings &globalFolderSettings)
+{
+	switch (columnType)
+	{
+	case ColumnType::RealSize:
+		return GetRealSizeColumnText(fileFacts, globalFolderSettings);
+	case ColumnType::ShortName:
+		return GetShortNameColumnText(fileFacts);
+	case ColumnType::Owner:
+		return GetOwnerColumnText(fileFacts);
+	case ColumnType::HardLinks:
+		return GetHardLinksColumnText(fileFacts);
+
+	case ColumnType::ProductName:
+		return GetVersionColumnText(fileFacts, VersionInfoType::ProductName);
+	case ColumnType::Company:
+		return GetVersionColumnText(fileFacts, VersionInfoType::Company);
+	case ColumnType::Description:
+		return GetVersionColumnText(fileFacts, VersionInfoType::Description);
+	case ColumnType::FileVersion:
+		return GetVersionColumnText(fileFacts, VersionInfoType::FileVersion);
+	case ColumnType::ProductVersion:
+		return GetVersionColumnText(fileFacts, VersionInfoType::ProductVersion);
+
+	default:
+		assert(false);
+		break;
+	}
+
+	return EMPTY_STRING;
+}
+
 std::wstring GetNameColumnText(
 	const BasicItemInfo_t &itemInfo, const GlobalFolderSettings &globalFolderSettings)
 {
@@ -350,10 +373,10 @@ std::wstring GetTimeColumnText(const BasicItemInfo_t &itemInfo, TimeType timeTyp
 }
 
 std::wstring GetRealSizeColumnText(
-	const BasicItemInfo_t &itemInfo, const GlobalFolderSettings &globalFolderSettings)
+	const FileFacts &fileFacts, const GlobalFolderSettings &globalFolderSettings)
 {
 	ULARGE_INTEGER realFileSize;
-	bool res = GetRealSizeColumnRawData(itemInfo, realFileSize);
+	bool res = GetRealSizeColumnRawData(fileFacts, realFileSize);
 
 	if (!res)
 	{
@@ -367,33 +390,17 @@ std::wstring GetRealSizeColumnText(
 	return realFileSizeText;
 }
 
-bool GetRealSizeColumnRawData(const BasicItemInfo_t &itemInfo, ULARGE_INTEGER &RealFileSize)
+// The real size is the amount of space the file takes up on disk, as reported by the file system.
+// Unlike the nominal size rounded up to the cluster size, this also accounts for compressed and
+// sparse files.
+bool GetRealSizeColumnRawData(const FileFacts &fileFacts, ULARGE_INTEGER &RealFileSize)
 {
-	if ((itemInfo.wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY)
+	if (!fileFacts.allocationSize)
 	{
 		return false;
 	}
 
-	TCHAR root[MAX_PATH];
-	StringCchCopy(root, SIZEOF_ARRAY(root), itemInfo.getFullPath().c_str());
-	PathStripToRoot(root);
-
-	DWORD dwClusterSize;
-	BOOL bRet = GetClusterSize(root, &dwClusterSize);
-
-	if (!bRet)
-	{
-		return false;
-	}
-
-	ULARGE_INTEGER realFileSizeTemp = { itemInfo.wfd.nFileSizeLow, itemInfo.wfd.nFileSizeHigh };
-
-	if (realFileSizeTemp.QuadPart != 0 && (realFileSizeTemp.QuadPart % dwClusterSize) != 0)
-	{
-		realFileSizeTemp.QuadPart += dwClusterSize - (realFileSizeTemp.QuadPart % dwClusterSize);
-	}
-
-	RealFileSize = realFileSizeTemp;
+	RealFileSize.QuadPart = *fileFacts.allocationSize;
 
 	return true;
 }
@@ -412,41 +419,14 @@ std::wstring GetAttributeColumnText(const BasicItemInfo_t &itemInfo)
 	return L"";
 }
 
-std::wstring GetShortNameColumnText(const BasicItemInfo_t &itemInfo)
+std::wstring GetShortNameColumnText(const FileFacts &fileFacts)
 {
-	DWORD length = GetShortPathName(itemInfo.getFullPath().c_str(), nullptr, 0);
-
-	if (length == 0)
-	{
-		return {};
-	}
-
-	std::wstring shortPath;
-	shortPath.resize(length);
-
-	length = GetShortPathName(
-		itemInfo.getFullPath().c_str(), shortPath.data(), static_cast<DWORD>(shortPath.capacity()));
-
-	if (length == 0)
-	{
-		return {};
-	}
-
-	std::filesystem::path path(shortPath);
-	return path.filename();
+	return fileFacts.shortName.value_or(EMPTY_STRING);
 }
 
-std::wstring GetOwnerColumnText(const BasicItemInfo_t &itemInfo)
+std::wstring GetOwnerColumnText(const FileFacts &fileFacts)
 {
-	TCHAR owner[512];
-	BOOL ret = GetFileOwner(itemInfo.getFullPath().c_str(), owner, SIZEOF_ARRAY(owner));
-
-	if (!ret)
-	{
-		return EMPTY_STRING;
-	}
-
-	return owner;
+	return fileFacts.owner.value_or(EMPTY_STRING);
 }
 
 std::wstring GetItemDetailsColumnText(const BasicItemInfo_t &itemInfo, const SHCOLUMNID *pscid,
@@ -492,47 +472,16 @@ HRESULT GetItemDetailsRawData(const BasicItemInfo_t &itemInfo, const SHCOLUMNID
 	return hr;
 }
 
-std::wstring GetVersionColumnText(const BasicItemInfo_t &itemInfo, VersionInfoType versioninfoType)
+std::wstring GetVersionColumnText(const FileFacts &fileFacts, VersionInfoType versioninfoType)
 {
-	std::wstring versionInfoName;
-
-	switch (versioninfoType)
-	{
-	case VersionInfoType::ProductName:
-		versionInfoName = L"ProductName";
-		break;
-
-	case VersionInfoType::Company:
-		versionInfoName = L"CompanyName";
-		break;
-
-	case VersionInfoType::Description:
-		versionInfoName = L"FileDescription";
-		break;
-
-	case VersionInfoType::FileVersion:
-		versionInfoName = L"FileVersion";
-		break;
+	auto itr = fileFacts.versionInfo.find(versioninfoType);
 
-	case VersionInfoType::ProductVersion:
-		versionInfoName = L"ProductVersion";
-		break;
-
-	default:
-		assert(false);
-		break;
-	}
-
-	TCHAR versionInfo[512];
-	BOOL versionInfoObtained = GetVersionInfoString(itemInfo.getFullPath().c_str(),
-		versionInfoName.c_str(), versionInfo, SIZEOF_ARRAY(versionInfo));
-
-	if (!versionInfoObtained)
+	if (itr == fileFacts.versionInfo.end())
 	{
 		return EMPTY_STRING;
 	}
 
-	return versionInfo;
+	return itr->second;
 }
 
 std::wstring GetShortcutToColumnText(const BasicItemInfo_t &itemInfo)
@@ -549,24 +498,24 @@ std::wstring GetShortcutToColumnText(const BasicItemInfo_t &itemInfo)
 	return resolvedLinkPath;
 }
 
-std::wstring GetHardLinksColumnText(const BasicItemInfo_t &itemInfo)
+std::wstring GetHardLinksColumnText(const FileFacts &fileFacts)
 {
-	DWORD numHardLinks = GetHardLinksColumnRawData(itemInfo);
-
-	if (numHardLinks == -1)
+	if (!fileFacts.numHardLinks)
 	{
 		return EMPTY_STRING;
 	}
 
+	DWORD numHardLinks = GetHardLinksColumnRawData(fileFacts);
+
 	TCHAR numHardLinksString[32];
 	StringCchPrintf(numHardLinksString, SIZEOF_ARRAY(numHardLinksString), _T("%ld"), numHardLinks);
 
 	return numHardLinksString;
 }
 
-DWORD GetHardLinksColumnRawData(const BasicItemInfo_t &itemInfo)
+DWORD GetHardLinksColumnRawData(const FileFacts &fileFacts)
 {
-	return GetNumFileHardLinks(itemInfo.getFullPath().c_str());
+	return fileFacts.numHardLinks.value_or(0);
 }
 
 std::wstring GetExtensionColumnText(const BasicItemInfo_t &itemInfo)
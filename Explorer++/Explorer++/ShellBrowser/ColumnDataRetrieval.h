@@ -8,6 +8,7 @@
 #include <string>
 
 struct BasicItemInfo_t;
+struct FileFacts;
 struct GlobalFolderSettings;
 
 enum class TimeType
@@ -65,6 +66,8 @@ enum class MediaMetadataType
 
 std::wstring GetColumnText(ColumnType columnType, const BasicItemInfo_t &basicItemInfo,
 	const GlobalFolderSettings &globalFolderSettings);
+std::wstring GetFileFactsColumnText(ColumnType columnType, const FileFacts &fileFacts,
+	const GlobalFolderSettings &globalFolderSettings);
 std::wstring GetNameColumnText(
 	const BasicItemInfo_t &itemInfo, const GlobalFolderSettings &globalFolderSettings);
 std::wstring ProcessItemFileName(
@@ -73,21 +76,21 @@ std::wstring GetTypeColumnText(const BasicItemInfo_t &itemInfo);
 std::wstring GetTimeColumnText(const BasicItemInfo_t &itemInfo, TimeType timeType,
 	const GlobalFolderSettings &globalFolderSettings);
 std::wstring GetRealSizeColumnText(
-	const BasicItemInfo_t &itemInfo, const GlobalFolderSettings &globalFolderSettings);
-bool GetRealSizeColumnRawData(const BasicItemInfo_t &itemInfo, ULARGE_INTEGER &RealFileSize);
+	const FileFacts &fileFacts, const GlobalFolderSettings &globalFolderSettings);
+bool GetRealSizeColumnRawData(const FileFacts &fileFacts, ULARGE_INTEGER &RealFileSize);
 std::wstring GetAttributeColumnText(const BasicItemInfo_t &itemInfo);
-std::wstring GetShortNameColumnText(const BasicItemInfo_t &itemInfo);
-std::wstring GetOwnerColumnText(const BasicItemInfo_t &itemInfo);
+std::wstring GetShortNameColumnText(const FileFacts &fileFacts);
+std::wstring GetOwnerColumnText(const FileFacts &fileFacts);
 std::wstring GetItemDetailsColumnText(const BasicItemInfo_t &itemInfo, const SHCOLUMNID *pscid,
 	const GlobalFolderSettings &globalFolderSettings);
 HRESULT GetItemDetails(const BasicItemInfo_t &itemInfo, const SHCOLUMNID *pscid, TCHAR *szDetail,
 	size_t cchMax, const GlobalFolderSettings &globalFolderSettings);
 HRESULT GetItemDetailsRawData(
 	const BasicItemInfo_t &itemInfo, const SHCOLUMNID *pscid, VARIANT *vt);
-std::wstring GetVersionColumnText(const BasicItemInfo_t &itemInfo, VersionInfoType versioninfoType);
+std::wstring GetVersionColumnText(const FileFacts &fileFacts, VersionInfoType versioninfoType);
 std::wstring GetShortcutToColumnText(const BasicItemInfo_t &itemInfo);
-std::wstring GetHardLinksColumnText(const BasicItemInfo_t &itemInfo);
-DWORD GetHardLinksColumnRawData(const BasicItemInfo_t &itemInfo);
+std::wstring GetHardLinksColumnText(const FileFacts &fileFacts);
+DWORD GetHardLinksColumnRawData(const FileFacts &fileFacts);
 std::wstring GetExtensionColumnText(const BasicItemInfo_t &itemInfo);
 std::wstring GetImageColumnText(const BasicItemInfo_t &itemInfo, PROPID PropertyID);
 std::wstring GetFileSystemColumnText(const BasicItemInfo_t &itemInfo);
@@ -12,42 +12,227 @@
 #include "ResourceHelper.h"
 #include "SortModes.h"
 #include "ViewModes.h"
+#include "../Helper/Logging.h"
 #include "../Helper/Macros.h"
 #include <cassert>
 #include <list>
 
 void ShellBrowser::QueueColumnTask(int itemInternalIndex, ColumnType columnType)
 {
+	ColumnTaskKey key = { itemInternalIndex, columnType };
 	int columnResultID = m_columnResultIDCounter++;
 
 	BasicItemInfo_t basicItemInfo = getBasicItemInfo(itemInternalIndex);
 	GlobalFolderSettings globalFolderSettings = m_config->globalFolderSettings;
 
-	auto result = m_columnThreadPool.push([this, columnResultID, columnType, itemInternalIndex,
-											  basicItemInfo, globalFolderSettings](int id) {
-		UNREFERENCED_PARAMETER(id);
+	// std::function requires a copyable target, so the packaged_task is shared.
+	auto task = std::make_shared<std::packaged_task<ColumnResult_t()>>(
+		[resultBatcher = m_columnResultBatcher, columnResultID, columnType, itemInternalIndex,
+			basicItemInfo, globalFolderSettings, columnValueCache = m_columnValueCache]() {
+			return GetColumnTextAsync(*resultBatcher, columnResultID, columnType,
+				itemInternalIndex, basicItemInfo, globalFolderSettings, *columnValueCache);
+		});
+	auto result = task->get_future();
+
+	int priority = 0;
+	auto index = LocateItemByInternalIndex(itemInternalIndex);
+
+	if (index)
+	{
+		priority = CalculateColumnTaskPriority(
+			*index, ListView_GetTopIndex(m_hListView), ListView_GetCountPerPage(m_hListView));
+	}
 
-		return GetColumnTextAsync(m_hListView, columnResultID, columnType, itemInternalIndex,
-			basicItemInfo, globalFolderSettings);
-	});
+	bool queued = m_columnTaskScheduler.Queue(key, priority, [task]() { (*task)(); });
 
-	// The function call above might finish before this line runs,
+	if (!queued)
+	{
+		// The text for this cell has already been requested and that request is still waiting
+		// to run. The result from that request will be used.
+		return;
+	}
+
+	// The task above might finish before this line runs,
 	// but that doesn't matter, as the results won't be processed
 	// until a message posted to the main thread has been handled
 	// (which can only occur after this function has returned).
 	m_columnResults.insert({ columnResultID, std::move(result) });
+	m_queuedColumnTasks[key] = columnResultID;
 }
 
-ShellBrowser::ColumnResult_t ShellBrowser::GetColumnTextAsync(HWND listView, int columnResultId,
-	ColumnType columnType, int internalIndex, const BasicItemInfo_t &basicItemInfo,
-	const GlobalFolderSettings &globalFolderSettings)
+// Returns the distance of the item from the visible area of the listview. Items that are visible
+// have a distance of 0 and have their column text retrieved first.
+int ShellBrowser::CalculateColumnTaskPriority(int index, int topIndex, int countPerPage)
 {
-	std::wstring columnText = GetColumnText(columnType, basicItemInfo, globalFolderSettings);
+	if (index < topIndex)
+	{
+		return topIndex - index;
+	}
+
+	int bottomIndex = topIndex + countPerPage - 1;
+
+	if (index > bottomIndex)
+	{
+		return index - bottomIndex;
+	}
+
+	return 0;
+}
+
+// Called once the listview has been scrolled. Tasks for items that are close to the new visible
+// area are moved to the front of the queue, while tasks for items that are more than a page away
+// are dropped. If those items are scrolled back into view, their text will be requested again.
+void ShellBrowser::RescheduleColumnTasks()
+{
+	if (m_folderSettings.viewMode != +ViewMode::Details)
+	{
+		return;
+	}
+
+	int topIndex = ListView_GetTopIndex(m_hListView);
+	int countPerPage = ListView_GetCountPerPage(m_hListView);
+
+	auto droppedTasks = m_columnTaskScheduler.Reprioritize(
+		[this, topIndex, countPerPage](const ColumnTaskKey &key) -> std::optional<int> {
+			auto index = LocateItemByInternalIndex(key.itemInternalIndex);
+
+			if (!index)
+			{
+				return std::nullopt;
+			}
 
-	// This message may be delivered before this function has returned.
+			int priority = CalculateColumnTaskPriority(*index, topIndex, countPerPage);
+
+			if (priority > countPerPage)
+			{
+				return std::nullopt;
+			}
+
+			return priority;
+		});
+
+	for (const auto &key : droppedTasks)
+	{
+		auto itr = m_queuedColumnTasks.find(key);
+
+		if (itr != m_queuedColumnTasks.end())
+		{
+			m_columnResults.erase(itr->second);
+			m_queuedColumnTasks.erase(itr);
+		}
+
+		if (m_ownerDataListView)
+		{
+			auto itemItr = m_itemInfoMap.find(key.itemInternalIndex);
+
+			if (itemItr != m_itemInfoMap.end())
+			{
+				// Removing the empty entry means the column will be requested again the next time
+				// the item is shown.
+				auto &columnText = itemItr->second.columnText;
+				auto textItr = columnText.find(key.columnType);
+
+				if (textItr != columnText.end() && !textItr->second)
+				{
+					columnText.erase(textItr);
+				}
+			}
+		}
+	}
+}
+
+void ShellBrowser::ClearColumnTasks()
+{
+	auto counters = m_columnTaskScheduler.GetCounters();
+	LOG(debug) << L"ShellBrowser - Column tasks: " << counters.numQueued << L" queued, "
+			   << counters.numDeduplicated << L" deduplicated, " << counters.numDropped
+			   << L" dropped, " << counters.numCompleted << L" completed, max queue depth "
+			   << counters.maxQueueDepth << L", average latency "
+			   << counters.GetAverageLatency().count() << L"us, max latency "
+			   << counters.maxLatency.count() << L"us";
+
+	m_columnTaskScheduler.Clear();
+	m_columnResults.clear();
+	m_queuedColumnTasks.clear();
+	m_columnResultBatcher->Clear();
+}
+
+// Column tasks for the current folder run in parallel. How much parallelism helps depends on the
+// type of volume the folder is on. SSDs handle many concurrent requests well, whereas hard disks
+// and network shares can slow down considerably when too many requests are made at once.
+void ShellBrowser::UpdateColumnConcurrencyLimit()
+{
+	VolumeType volumeType = VolumeType::Other;
+
+	if (!m_directoryState.virtualFolder)
+	{
+		volumeType = GetVolumeType(m_directoryState.directory);
+	}
+
+	int concurrencyLimit = GetColumnConcurrencyLimit(volumeType);
+
+	if (concurrencyLimit > 0)
+	{
+		m_columnTaskScheduler.SetConcurrencyLimit(concurrencyLimit);
+	}
+	else
+	{
+		m_columnTaskScheduler.SetConcurrencyLimit(std::nullopt);
+	}
+
+	LOG(debug) << L"ShellBrowser - Column concurrency limit for \"" << m_directoryState.directory
+			   << L"\": " << concurrencyLimit;
+}
+
+int ShellBrowser::GetColumnConcurrencyLimit(VolumeType volumeType) const
+{
+	switch (volumeType)
+	{
+	case VolumeType::SolidState:
+		return m_config->columnConcurrencySolidState;
+
+	case VolumeType::Rotational:
+		return m_config->columnConcurrencyRotational;
+
+	case VolumeType::Removable:
+		return m_config->columnConcurrencyRemovable;
+
+	case VolumeType::Network:
+		return m_config->columnConcurrencyNetwork;
+
+	case VolumeType::Other:
+	default:
+		return m_config->columnConcurrencyOther;
+	}
+}
+
+PriorityTaskSchedulerCounters ShellBrowser::GetColumnTaskCounters() const
+{
+	return m_columnTaskScheduler.GetCounters();
+}
+
+ShellBrowser::ColumnResult_t ShellBrowser::GetColumnTextAsync(ResultBatcher<int> &resultBatcher,
+	int columnResultId, ColumnType columnType, int internalIndex,
+	const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings,
+	ColumnValueCache &columnValueCache)
+{
+	std::wstring columnText;
+
+	if (ColumnValueCache::IsCachedColumn(columnType))
+	{
+		auto columnValue = columnValueCache.GetOrRetrieveValue(
+			internalIndex, columnType, basicItemInfo, globalFolderSettings);
+		columnText = columnValue->text;
+	}
+	else
+	{
+		columnText = GetColumnText(columnType, basicItemInfo, globalFolderSettings);
+	}
+
+	// This result may be processed before this function has returned.
 	// That doesn't actually matter, since the message handler will
 	// simply wait for the result to be returned.
-	PostMessage(listView, WM_APP_COLUMN_RESULT_READY, columnResultId, 0);
+	resultBatcher.AddResult(columnResultId);
 
 	ColumnResult_t result;
 	result.itemInternalIndex = internalIndex;
@@ -57,6 +242,17 @@ ShellBrowser::ColumnResult_t ShellBrowser::GetColumnTextAsync(HWND listView, int
 	return result;
 }
 
+// Column results are applied in batches, with redrawing disabled, so that the listview is only
+// repainted once per batch, rather than once per cell. Each batch is limited in duration, so that
+// a large number of results won't prevent the listview from being repainted.
+void ShellBrowser::ProcessColumnResultBatch()
+{
+	SendMessage(m_hListView, WM_SETREDRAW, FALSE, NULL);
+	m_columnResultBatcher->ProcessBatch(
+		[this](int columnResultId) { ProcessColumnResult(columnResultId); });
+	SendMessage(m_hListView, WM_SETREDRAW, TRUE, NULL);
+}
+
 void ShellBrowser::ProcessColumnResult(int columnResultId)
 {
 	auto itr = m_columnResults.find(columnResultId);
@@ -74,6 +270,14 @@ void ShellBrowser::ProcessColumnResult(int columnResultId)
 
 	auto result = itr->second.get();
 
+	ColumnTaskKey key = { result.itemInternalIndex, result.columnType };
+	auto queuedItr = m_queuedColumnTasks.find(key);
+
+	if (queuedItr != m_queuedColumnTasks.end() && queuedItr->second == columnResultId)
+	{
+		m_queuedColumnTasks.erase(queuedItr);
+	}
+
 	auto index = LocateItemByInternalIndex(result.itemInternalIndex);
 
 	if (!index)
@@ -90,6 +294,16 @@ void ShellBrowser::ProcessColumnResult(int columnResultId)
 		return;
 	}
 
+	if (m_ownerDataListView)
+	{
+		m_itemInfoMap.at(result.itemInternalIndex).columnText[result.columnType] =
+			result.columnText;
+		RedrawItem(*index);
+
+		m_columnResults.erase(itr);
+		return;
+	}
+
 	auto columnText = std::make_unique<TCHAR[]>(result.columnText.size() + 1);
 	StringCchCopy(columnText.get(), result.columnText.size() + 1, result.columnText.c_str());
 	ListView_SetItemText(m_hListView, *index, *columnIndex, columnText.get());
@@ -243,6 +457,25 @@ void ShellBrowser::SetActiveColumnSet()
 		m_pActiveColumns = pActiveColumns;
 		m_listViewColumnsSetUp = false;
 	}
+
+	UpdateColumnValueCacheColumns();
+}
+
+// The column value cache uses the set of columns shown to determine which file facts should be
+// retrieved together.
+void ShellBrowser::UpdateColumnValueCacheColumns()
+{
+	std::vector<ColumnType> columnTypes;
+
+	for (const Column_t &column : *m_pActiveColumns)
+	{
+		if (column.bChecked)
+		{
+			columnTypes.push_back(column.type);
+		}
+	}
+
+	m_columnValueCache->SetActiveColumns(columnTypes);
 }
 
 SortMode ShellBrowser::DetermineColumnSortMode(ColumnType columnType)
@@ -1003,6 +1236,7 @@ void ShellBrowser::SetCurrentColumns(const std::vector<Column_t> &columns)
 	}
 
 	*m_pActiveColumns = columns;
+	UpdateColumnValueCacheColumns();
 
 	// The folder will need to be re-sorted if the sorting column was removed.
 	if (sortFolder)
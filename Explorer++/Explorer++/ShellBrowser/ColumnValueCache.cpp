@@ -0,0 +1,332 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "ColumnValueCache.h"
+#include "ColumnDataRetrieval.h"
+#include "FolderSettings.h"
+#include "ItemData.h"
+#include "../Helper/Macros.h"
+#include "../Helper/PersistentItemCache.h"
+#include "../Helper/ShellHelper.h"
+#include "../Helper/TimeHelper.h"
+#include <wil/common.h>
+#include <propkey.h>
+
+namespace
+{
+	// Persisted values are stored using the column type (offset by this value) as the field ID.
+	// The column type values never change, since they're also used when saving settings.
+	const std::uint32_t PERSISTED_COLUMN_FIELD_BASE = 0x100;
+
+	// Only items in the file system have a size and modification time that can be used to tell
+	// whether a persisted value is still valid.
+	std::optional<PersistentItemCache::ItemKey> GetPersistentItemKey(
+		const BasicItemInfo_t &basicItemInfo)
+	{
+		if (!basicItemInfo.isFindDataValid || basicItemInfo.isRoot)
+		{
+			return std::nullopt;
+		}
+
+		std::wstring fullPath = basicItemInfo.getFullPath();
+
+		if (fullPath.empty() || IsPathGUID(fullPath.c_str()))
+		{
+			return std::nullopt;
+		}
+
+		ULARGE_INTEGER fileSize = { basicItemInfo.wfd.nFileSizeLow,
+			basicItemInfo.wfd.nFileSizeHigh };
+
+		return PersistentItemCache::ItemKey{ fullPath, fileSize.QuadPart,
+			FileTimeToUInt64(basicItemInfo.wfd.ftLastWriteTime) };
+	}
+
+	const SHCOLUMNID *GetItemDetailsColumnId(ColumnType columnType)
+	{
+		switch (columnType)
+		{
+		case ColumnType::Title:
+			return &PKEY_Title;
+
+		case ColumnType::Subject:
+			return &PKEY_Subject;
+
+		case ColumnType::Authors:
+			return &PKEY_Author;
+
+		case ColumnType::Keywords:
+			return &PKEY_Keywords;
+
+		case ColumnType::Comment:
+			return &PKEY_Comment;
+
+		case ColumnType::OriginalLocation:
+			return &SCID_ORIGINAL_LOCATION;
+
+		case ColumnType::DateDeleted:
+			return &SCID_DATE_DELETED;
+
+		default:
+			return nullptr;
+		}
+	}
+}
+
+ColumnValueCache::ColumnValueCache(PersistentItemCache *persistentItemCache) :
+	m_persistentItemCache(persistentItemCache)
+{
+}
+
+bool ColumnValueCache::IsCachedColumn(ColumnType columnType)
+{
+	if (GetItemDetailsColumnId(columnType))
+	{
+		return true;
+	}
+
+	if (GetFileFactsForColumn(columnType) != FileFact::None)
+	{
+		return true;
+	}
+
+	switch (columnType)
+	{
+	case ColumnType::Type:
+	case ColumnType::CameraModel:
+	case ColumnType::DateTaken:
+	case ColumnType::Width:
+	case ColumnType::Height:
+		return true;
+
+	default:
+		break;
+	}
+
+	return columnType >= ColumnType::MediaBitrate && columnType <= ColumnType::MediaYear;
+}
+
+// Columns whose text depends on the current settings (e.g. the real size column), or whose value
+// can change without the file being modified (e.g. the owner column), aren't persisted. That
+// includes the type column, since the type name depends on the file associations, rather than on
+// the file itself.
+bool ColumnValueCache::IsPersistedColumn(ColumnType columnType)
+{
+	switch (columnType)
+	{
+	case ColumnType::ProductName:
+	case ColumnType::Company:
+	case ColumnType::Description:
+	case ColumnType::FileVersion:
+	case ColumnType::ProductVersion:
+	case ColumnType::CameraModel:
+	case ColumnType::DateTaken:
+	case ColumnType::Width:
+	case ColumnType::Height:
+		return true;
+
+	default:
+		break;
+	}
+
+	return columnType >= ColumnType::MediaBitrate && columnType <= ColumnType::MediaYear;
+}
+
+void ColumnValueCache::SetActiveColumns(const std::vector<ColumnType> &columnTypes)
+{
+	FileFact activeFileFacts = FileFact::None;
+
+	for (auto columnType : columnTypes)
+	{
+		activeFileFacts |= GetFileFactsForColumn(columnType);
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_activeFileFacts = activeFileFacts;
+}
+
+std::shared_ptr<const ColumnValue> ColumnValueCache::GetValue(
+	int internalIndex, ColumnType columnType) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto itemItr = m_values.find(internalIndex);
+
+	if (itemItr == m_values.end())
+	{
+		return nullptr;
+	}
+
+	auto valueItr = itemItr->second.find(columnType);
+
+	if (valueItr == itemItr->second.end())
+	{
+		return nullptr;
+	}
+
+	return valueItr->second;
+}
+
+std::shared_ptr<const ColumnValue> ColumnValueCache::GetOrRetrieveValue(int internalIndex,
+	ColumnType columnType, const BasicItemInfo_t &basicItemInfo,
+	const GlobalFolderSettings &globalFolderSettings)
+{
+	auto value = GetValue(internalIndex, columnType);
+
+	if (value)
+	{
+		return value;
+	}
+
+	// The lock isn't held while the value is being retrieved, so that values for other items can
+	// be retrieved at the same time. If two threads retrieve the same value, the second result
+	// will simply replace the first.
+	value = std::make_shared<const ColumnValue>(
+		RetrieveValue(internalIndex, columnType, basicItemInfo, globalFolderSettings));
+	SetValue(internalIndex, columnType, value);
+
+	return value;
+}
+
+ColumnValue ColumnValueCache::RetrieveValue(int internalIndex, ColumnType columnType,
+	const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings)
+{
+	std::optional<PersistentItemCache::ItemKey> persistentItemKey;
+
+	if (m_persistentItemCache && IsPersistedColumn(columnType))
+	{
+		persistentItemKey = GetPersistentItemKey(basicItemInfo);
+	}
+
+	auto fieldId = PERSISTED_COLUMN_FIELD_BASE + static_cast<std::uint32_t>(columnType);
+
+	if (persistentItemKey)
+	{
+		auto persistedText = m_persistentItemCache->GetValue(*persistentItemKey, fieldId);
+
+		if (persistedText)
+		{
+			ColumnValue value;
+			value.text = std::move(*persistedText);
+			return value;
+		}
+	}
+
+	ColumnValue value =
+		RetrieveValueFromItem(internalIndex, columnType, basicItemInfo, globalFolderSettings);
+
+	if (persistentItemKey)
+	{
+		m_persistentItemCache->SetValue(*persistentItemKey, fieldId, value.text);
+	}
+
+	return value;
+}
+
+ColumnValue ColumnValueCache::RetrieveValueFromItem(int internalIndex, ColumnType columnType,
+	const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings)
+{
+	FileFact facts = GetFileFactsForColumn(columnType);
+
+	if (facts == FileFact::None)
+	{
+		return RetrieveColumnValue(columnType, basicItemInfo, globalFolderSettings);
+	}
+
+	auto fileFacts = GetOrRetrieveFileFacts(internalIndex, facts, basicItemInfo);
+
+	ColumnValue value;
+	value.text = GetFileFactsColumnText(columnType, *fileFacts, globalFolderSettings);
+	return value;
+}
+
+std::shared_ptr<const FileFacts> ColumnValueCache::GetOrRetrieveFileFacts(
+	int internalIndex, FileFact facts, const BasicItemInfo_t &basicItemInfo)
+{
+	std::shared_ptr<FileFactsEntry> entry;
+	FileFact activeFileFacts;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto &existingEntry = m_fileFacts[internalIndex];
+
+		if (!existingEntry)
+		{
+			existingEntry = std::make_shared<FileFactsEntry>();
+		}
+
+		entry = existingEntry;
+		activeFileFacts = m_activeFileFacts;
+	}
+
+	// Only the lock for this item is held here, so that the facts for other items can be retrieved
+	// at the same time.
+	std::lock_guard<std::mutex> entryLock(entry->mutex);
+
+	FileFact existingFacts = entry->facts ? entry->facts->retrieved : FileFact::None;
+
+	if (WI_AreAllFlagsSet(existingFacts, facts))
+	{
+		return entry->facts;
+	}
+
+	FileFacts updatedFacts = entry->facts ? *entry->facts : FileFacts();
+	updatedFacts.Merge(
+		RetrieveFileFacts(basicItemInfo, (facts | activeFileFacts) & ~existingFacts));
+
+	entry->facts = std::make_shared<const FileFacts>(std::move(updatedFacts));
+
+	return entry->facts;
+}
+
+void ColumnValueCache::SetValue(
+	int internalIndex, ColumnType columnType, std::shared_ptr<const ColumnValue> value)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_values[internalIndex][columnType] = std::move(value);
+}
+
+void ColumnValueCache::RemoveItem(int internalIndex)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_values.erase(internalIndex);
+	m_fileFacts.erase(internalIndex);
+}
+
+ColumnValue RetrieveColumnValue(ColumnType columnType, const BasicItemInfo_t &basicItemInfo,
+	const GlobalFolderSettings &globalFolderSettings)
+{
+	ColumnValue value;
+
+	const SHCOLUMNID *columnId = GetItemDetailsColumnId(columnType);
+
+	if (!columnId)
+	{
+		value.text = GetColumnText(columnType, basicItemInfo, globalFolderSettings);
+		return value;
+	}
+
+	wil::unique_variant rawData;
+	HRESULT hr = GetItemDetailsRawData(basicItemInfo, columnId, rawData.addressof());
+
+	if (FAILED(hr))
+	{
+		return value;
+	}
+
+	TCHAR text[512];
+	hr = ConvertVariantToString(
+		rawData.addressof(), text, SIZEOF_ARRAY(text), globalFolderSettings.showFriendlyDates);
+
+	if (SUCCEEDED(hr))
+	{
+		value.text = text;
+	}
+
+	value.rawData = std::move(rawData);
+
+	return value;
+}
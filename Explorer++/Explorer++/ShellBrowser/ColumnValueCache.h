@@ -0,0 +1,101 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "Columns.h"
+#include "FileFacts.h"
+#include <wil/resource.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct BasicItemInfo_t;
+struct GlobalFolderSettings;
+class PersistentItemCache;
+
+// The value of a column for a single item.
+struct ColumnValue
+{
+	// The text that's shown in the column.
+	std::wstring text;
+
+	// Only used for columns that are retrieved through IShellFolder2::GetDetailsEx (e.g. the
+	// title and author columns). Those columns are sorted using the raw value, rather than the
+	// text. This will be empty if the value couldn't be retrieved.
+	std::optional<wil::unique_variant> rawData;
+};
+
+// Stores the values of columns that are expensive to retrieve (i.e. columns that require a file to
+// be opened, or the shell to be queried). The same values are used both when displaying a column
+// and when sorting by it, so the data for each item only has to be read once while a folder is
+// being shown.
+//
+// The file facts for each item are also stored here. When the facts for an item are first needed,
+// the facts for every active column are retrieved together, so that the file is only opened once,
+// regardless of how many of those columns are shown.
+//
+// Values for columns whose text depends only on the contents of a file (e.g. the version and
+// media columns) are also stored in the persistent cache, if there is one. That way, they don't
+// have to be retrieved again when the folder is next shown, even in a later session.
+//
+// Values can be retrieved and stored from any thread.
+class ColumnValueCache
+{
+public:
+	// The persistent cache is optional.
+	explicit ColumnValueCache(PersistentItemCache *persistentItemCache = nullptr);
+
+	static bool IsCachedColumn(ColumnType columnType);
+	static bool IsPersistedColumn(ColumnType columnType);
+
+	// Should be called whenever the set of columns shown changes.
+	void SetActiveColumns(const std::vector<ColumnType> &columnTypes);
+
+	std::shared_ptr<const ColumnValue> GetValue(int internalIndex, ColumnType columnType) const;
+
+	// Returns the cached value, if there is one. Otherwise, retrieves the value and stores it.
+	std::shared_ptr<const ColumnValue> GetOrRetrieveValue(int internalIndex, ColumnType columnType,
+		const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings);
+
+	// Returns facts that include at least the requested facts. If any of the requested facts are
+	// missing, they'll be retrieved, along with any other facts needed by the active columns.
+	std::shared_ptr<const FileFacts> GetOrRetrieveFileFacts(
+		int internalIndex, FileFact facts, const BasicItemInfo_t &basicItemInfo);
+
+	// Should be called whenever an item is updated or removed.
+	void RemoveItem(int internalIndex);
+
+private:
+	using ItemValues = std::unordered_map<ColumnType, std::shared_ptr<const ColumnValue>>;
+
+	// Each item has its own lock, which is held while the facts for the item are being retrieved.
+	// That way, when the values for several columns are requested at the same time, the file is
+	// still only read once.
+	struct FileFactsEntry
+	{
+		std::mutex mutex;
+		std::shared_ptr<const FileFacts> facts;
+	};
+
+	ColumnValue RetrieveValue(int internalIndex, ColumnType columnType,
+		const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings);
+	ColumnValue RetrieveValueFromItem(int internalIndex, ColumnType columnType,
+		const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings);
+	void SetValue(int internalIndex, ColumnType columnType,
+		std::shared_ptr<const ColumnValue> value);
+
+	PersistentItemCache *const m_persistentItemCache;
+
+	mutable std::mutex m_mutex;
+	std::unordered_map<int, ItemValues> m_values;
+	std::unordered_map<int, std::shared_ptr<FileFactsEntry>> m_fileFacts;
+	FileFact m_activeFileFacts = FileFact::None;
+};
+
+ColumnValue RetrieveColumnValue(ColumnType columnType, const BasicItemInfo_t &basicItemInfo,
+	const GlobalFolderSettings &globalFolderSettings);
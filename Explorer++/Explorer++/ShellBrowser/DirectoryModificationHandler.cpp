@@ -64,6 +64,14 @@ void ShellBrowser::OnShellNotify(WPARAM wParam, LPARAM lParam)
 
 void ShellBrowser::OnProcessShellChangeNotifications()
 {
+	// Changes can't be reliably applied until the folder has been fully enumerated (e.g. an item
+	// that's been created might also be returned by the enumerator). The timer will continue to
+	// fire until the enumeration has finished.
+	if (IsEnumerationInProgress())
+	{
+		return;
+	}
+
 	SendMessage(m_hListView, WM_SETREDRAW, FALSE, NULL);
 
 	for (const auto &change : m_directoryState.shellChangeNotifications)
@@ -428,6 +436,10 @@ void ShellBrowser::ModifyItem(PCIDLIST_ABSOLUTE pidl)
 
 	m_directoryState.totalDirSize.QuadPart += newFileSize.QuadPart - oldFileSize.QuadPart;
 
+	UpdateItemColorRule(*itemInfo);
+	RemoveItemFromLookupIndexes(*internalIndex, m_itemInfoMap.at(*internalIndex));
+	AddItemToLookupIndexes(*internalIndex, *itemInfo);
+	m_columnValueCache->RemoveItem(*internalIndex);
 	m_itemInfoMap[*internalIndex] = std::move(*itemInfo);
 	const ItemInfo_t &updatedItemInfo = m_itemInfoMap[*internalIndex];
 
@@ -447,10 +459,13 @@ void ShellBrowser::ModifyItem(PCIDLIST_ABSOLUTE pidl)
 
 	if (IsFileFiltered(updatedItemInfo))
 	{
-		RemoveFilteredItem(*itemIndex, *internalIndex);
+		RemoveFilteredItem(*itemIndex);
 		return;
 	}
 
+	// The rest of the items are still in sorted order, so only this item needs to be moved.
+	itemIndex = MoveItemToSortedPosition(*itemIndex);
+
 	InvalidateIconForItem(*itemIndex);
 
 	if (m_folderSettings.viewMode == +ViewMode::Details)
@@ -458,17 +473,20 @@ void ShellBrowser::ModifyItem(PCIDLIST_ABSOLUTE pidl)
 		InvalidateAllColumnsForItem(*itemIndex);
 	}
 
-	if (WI_IsFlagSet(updatedItemInfo.wfd.dwFileAttributes, FILE_ATTRIBUTE_HIDDEN))
-	{
-		ListView_SetItemState(m_hListView, *itemIndex, LVIS_CUT, LVIS_CUT);
-	}
-	else
+	// In owner data mode, the cut state is derived from the item's attributes whenever the item is
+	// drawn.
+	if (!m_ownerDataListView)
 	{
-		ListView_SetItemState(m_hListView, *itemIndex, 0, LVIS_CUT);
+		if (WI_IsFlagSet(updatedItemInfo.wfd.dwFileAttributes, FILE_ATTRIBUTE_HIDDEN))
+		{
+			ListView_SetItemState(m_hListView, *itemIndex, LVIS_CUT, LVIS_CUT);
+		}
+		else
+		{
+			ListView_SetItemState(m_hListView, *itemIndex, 0, LVIS_CUT);
+		}
 	}
 
-	ListView_SortItems(m_hListView, SortStub, this);
-
 	if (m_folderSettings.showInGroups)
 	{
 		int groupId = DetermineItemGroup(*internalIndex);
@@ -578,6 +596,10 @@ void ShellBrowser::RenameItem(int internalIndex, PCIDLIST_ABSOLUTE pidlNew)
 		return;
 	}
 
+	UpdateItemColorRule(*itemInfo);
+	RemoveItemFromLookupIndexes(internalIndex, m_itemInfoMap.at(internalIndex));
+	AddItemToLookupIndexes(internalIndex, *itemInfo);
+	m_columnValueCache->RemoveItem(internalIndex);
 	m_itemInfoMap[internalIndex] = std::move(*itemInfo);
 	const ItemInfo_t &updatedItemInfo = m_itemInfoMap[internalIndex];
 
@@ -596,10 +618,12 @@ void ShellBrowser::RenameItem(int internalIndex, PCIDLIST_ABSOLUTE pidlNew)
 
 	if (IsFileFiltered(updatedItemInfo))
 	{
-		RemoveFilteredItem(*itemIndex, internalIndex);
+		RemoveFilteredItem(*itemIndex);
 		return;
 	}
 
+	itemIndex = MoveItemToSortedPosition(*itemIndex);
+
 	InvalidateIconForItem(*itemIndex);
 
 	if (m_folderSettings.viewMode == +ViewMode::Details)
@@ -610,6 +634,10 @@ void ShellBrowser::RenameItem(int internalIndex, PCIDLIST_ABSOLUTE pidlNew)
 		// column, since that won't be necessary if the item isn't currently visible.
 		InvalidateAllColumnsForItem(*itemIndex);
 	}
+	else if (m_ownerDataListView)
+	{
+		RedrawItem(*itemIndex);
+	}
 	else
 	{
 		BasicItemInfo_t basicItemInfo = getBasicItemInfo(internalIndex);
@@ -617,8 +645,6 @@ void ShellBrowser::RenameItem(int internalIndex, PCIDLIST_ABSOLUTE pidlNew)
 		ListView_SetItemText(m_hListView, *itemIndex, 0, filename.data());
 	}
 
-	ListView_SortItems(m_hListView, SortStub, this);
-
 	if (m_folderSettings.showInGroups)
 	{
 		int groupId = DetermineItemGroup(internalIndex);
@@ -633,6 +659,13 @@ void ShellBrowser::InvalidateAllColumnsForItem(int itemIndex)
 		return;
 	}
 
+	if (m_ownerDataListView)
+	{
+		GetItemByIndex(itemIndex).columnText.clear();
+		RedrawItem(itemIndex);
+		return;
+	}
+
 	auto numColumns = std::count_if(
 		m_pActiveColumns->begin(), m_pActiveColumns->end(), [](const Column_t &column) {
 			return column.bChecked;
@@ -646,6 +679,18 @@ void ShellBrowser::InvalidateAllColumnsForItem(int itemIndex)
 
 void ShellBrowser::InvalidateIconForItem(int itemIndex)
 {
+	auto &itemInfo = GetItemByIndex(itemIndex);
+	itemInfo.thumbnailIndex.reset();
+	itemInfo.thumbnailRetrieved = false;
+
+	if (m_ownerDataListView)
+	{
+		itemInfo.iconIndex.reset();
+		itemInfo.iconRequested = false;
+		RedrawItem(itemIndex);
+		return;
+	}
+
 	LVITEM lvItem;
 	lvItem.mask = LVIF_IMAGE;
 	lvItem.iItem = itemIndex;
@@ -242,14 +242,7 @@ void ShellBrowser::HandleDragSelection(const POINT *ppt)
 
 	if (!(info.flags & LVHT_NOWHERE) && info.iItem != -1)
 	{
-		LVITEM lvItem;
-
-		lvItem.mask = LVIF_PARAM;
-		lvItem.iItem = info.iItem;
-		lvItem.iSubItem = 0;
-		ListView_GetItem(m_hListView, &lvItem);
-
-		iInternalIndex = (int) lvItem.lParam;
+		iInternalIndex = GetItemInternalIndex(info.iItem);
 
 		if (iInternalIndex != -1)
 		{
@@ -431,14 +424,7 @@ HRESULT _stdcall ShellBrowser::Drop(
 	listview, append the folders name onto the destination path. */
 	if (m_bOverFolder)
 	{
-		LVITEM lvItem;
-
-		lvItem.mask = LVIF_PARAM;
-		lvItem.iItem = m_iDropFolder;
-		lvItem.iSubItem = 0;
-		ListView_GetItem(m_hListView, &lvItem);
-
-		PathAppend(finalDestDirectory, m_itemInfoMap.at((int) lvItem.lParam).wfd.cFileName);
+		PathAppend(finalDestDirectory, GetItemByIndex(m_iDropFolder).wfd.cFileName);
 	}
 
 	if (m_bDataAccept)
@@ -535,6 +521,13 @@ void ShellBrowser::RepositionLocalFiles(const POINT *ppt)
 	POINT pt;
 	POINT ptOrigin;
 
+	/* In owner data mode, items are always shown in sorted
+	order and can't be positioned. */
+	if (m_ownerDataListView)
+	{
+		return;
+	}
+
 	pt = *ppt;
 	ScreenToClient(m_hListView, &pt);
 
@@ -617,6 +610,7 @@ void ShellBrowser::RepositionLocalFiles(const POINT *ppt)
 			}
 
 			ListView_SortItems(m_hListView, SortTemporaryStub, (LPARAM) this);
+			InvalidateItemPositions();
 		}
 		else
 		{
@@ -0,0 +1,236 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "FileFacts.h"
+#include "ItemData.h"
+#include "../Helper/Helper.h"
+#include "../Helper/Macros.h"
+#include <wil/common.h>
+#include <filesystem>
+#include <vector>
+
+namespace
+{
+	struct VersionInfoName
+	{
+		VersionInfoType type;
+		const TCHAR *name;
+	};
+
+	const VersionInfoName VERSION_INFO_NAMES[] = {
+		{ VersionInfoType::ProductName, L"ProductName" },
+		{ VersionInfoType::Company, L"CompanyName" },
+		{ VersionInfoType::Description, L"FileDescription" },
+		{ VersionInfoType::FileVersion, L"FileVersion" },
+		{ VersionInfoType::ProductVersion, L"ProductVersion" }
+	};
+
+	void RetrieveHandleFacts(const std::wstring &fullPath, FileFact facts, FileFacts &fileFacts)
+	{
+		DWORD desiredAccess = 0;
+
+		if (WI_IsFlagSet(facts, FileFact::Owner))
+		{
+			desiredAccess |= READ_CONTROL;
+		}
+
+		if (WI_IsAnyFlagSet(facts, FileFact::HardLinks | FileFact::AllocationSize))
+		{
+			desiredAccess |= FILE_READ_ATTRIBUTES;
+		}
+
+		if (desiredAccess == 0)
+		{
+			return;
+		}
+
+		wil::unique_hfile file(CreateFile(fullPath.c_str(), desiredAccess,
+			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+			FILE_FLAG_BACKUP_SEMANTICS, nullptr));
+
+		if (!file)
+		{
+			return;
+		}
+
+		if (WI_IsFlagSet(facts, FileFact::Owner))
+		{
+			TCHAR owner[512];
+			BOOL res = GetFileOwner(file.get(), owner, SIZEOF_ARRAY(owner));
+
+			if (res)
+			{
+				fileFacts.owner = owner;
+			}
+		}
+
+		if (WI_IsFlagSet(facts, FileFact::HardLinks))
+		{
+			BY_HANDLE_FILE_INFORMATION fileInfo;
+			BOOL res = GetFileInformationByHandle(file.get(), &fileInfo);
+
+			if (res)
+			{
+				fileFacts.numHardLinks = fileInfo.nNumberOfLinks;
+			}
+		}
+
+		if (WI_IsFlagSet(facts, FileFact::AllocationSize))
+		{
+			FILE_STANDARD_INFO standardInfo;
+			BOOL res = GetFileInformationByHandleEx(
+				file.get(), FileStandardInfo, &standardInfo, sizeof(standardInfo));
+
+			if (res)
+			{
+				fileFacts.allocationSize = standardInfo.AllocationSize.QuadPart;
+			}
+		}
+	}
+
+	std::optional<std::wstring> RetrieveShortName(const BasicItemInfo_t &itemInfo)
+	{
+		// The short name may have been returned when the item was enumerated, in which case there's
+		// no need to query the file system.
+		if (itemInfo.isFindDataValid && itemInfo.wfd.cAlternateFileName[0] != '\0')
+		{
+			return itemInfo.wfd.cAlternateFileName;
+		}
+
+		std::wstring fullPath = itemInfo.getFullPath();
+		DWORD length = GetShortPathName(fullPath.c_str(), nullptr, 0);
+
+		if (length == 0)
+		{
+			return std::nullopt;
+		}
+
+		std::wstring shortPath;
+		shortPath.resize(length);
+
+		length = GetShortPathName(
+			fullPath.c_str(), shortPath.data(), static_cast<DWORD>(shortPath.capacity()));
+
+		if (length == 0)
+		{
+			return std::nullopt;
+		}
+
+		shortPath.resize(length);
+
+		std::filesystem::path path(shortPath);
+		return path.filename();
+	}
+
+	void RetrieveVersionInfo(const std::wstring &fullPath, FileFacts &fileFacts)
+	{
+		std::vector<std::wstring> names;
+
+		for (const auto &versionInfoName : VERSION_INFO_NAMES)
+		{
+			names.emplace_back(versionInfoName.name);
+		}
+
+		auto values = GetVersionInfoStrings(fullPath.c_str(), names);
+
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			if (values[i])
+			{
+				fileFacts.versionInfo[VERSION_INFO_NAMES[i].type] = *values[i];
+			}
+		}
+	}
+}
+
+void FileFacts::Merge(FileFacts &&other)
+{
+	FileFact newFacts = other.retrieved & ~retrieved;
+
+	if (WI_IsFlagSet(newFacts, FileFact::Owner))
+	{
+		owner = std::move(other.owner);
+	}
+
+	if (WI_IsFlagSet(newFacts, FileFact::HardLinks))
+	{
+		numHardLinks = other.numHardLinks;
+	}
+
+	if (WI_IsFlagSet(newFacts, FileFact::AllocationSize))
+	{
+		allocationSize = other.allocationSize;
+	}
+
+	if (WI_IsFlagSet(newFacts, FileFact::ShortName))
+	{
+		shortName = std::move(other.shortName);
+	}
+
+	if (WI_IsFlagSet(newFacts, FileFact::VersionInfo))
+	{
+		versionInfo = std::move(other.versionInfo);
+	}
+
+	retrieved |= newFacts;
+}
+
+FileFact GetFileFactsForColumn(ColumnType columnType)
+{
+	switch (columnType)
+	{
+	case ColumnType::Owner:
+		return FileFact::Owner;
+
+	case ColumnType::HardLinks:
+		return FileFact::HardLinks;
+
+	case ColumnType::RealSize:
+		return FileFact::AllocationSize;
+
+	case ColumnType::ShortName:
+		return FileFact::ShortName;
+
+	case ColumnType::ProductName:
+	case ColumnType::Company:
+	case ColumnType::Description:
+	case ColumnType::FileVersion:
+	case ColumnType::ProductVersion:
+		return FileFact::VersionInfo;
+
+	default:
+		return FileFact::None;
+	}
+}
+
+FileFacts RetrieveFileFacts(const BasicItemInfo_t &itemInfo, FileFact facts)
+{
+	FileFacts fileFacts;
+	fileFacts.retrieved = facts;
+
+	std::wstring fullPath = itemInfo.getFullPath();
+	FileFact handleFacts = facts;
+
+	// The real size column has always been left blank for folders.
+	if (WI_IsFlagSet(itemInfo.wfd.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY))
+	{
+		WI_ClearFlag(handleFacts, FileFact::AllocationSize);
+	}
+
+	// The owner, number of hard links and allocation size all come from the same handle.
+	RetrieveHandleFacts(fullPath, handleFacts, fileFacts);
+
+	if (WI_IsFlagSet(facts, FileFact::ShortName))
+	{
+		fileFacts.shortName = RetrieveShortName(itemInfo);
+	}
+
+	if (WI_IsFlagSet(facts, FileFact::VersionInfo))
+	{
+		RetrieveVersionInfo(fullPath, fileFacts);
+	}
+
+	return fileFacts;
+}
@@ -0,0 +1,52 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "ColumnDataRetrieval.h"
+#include "Columns.h"
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+struct BasicItemInfo_t;
+
+// The pieces of information about a file that are read directly from the file system (rather than
+// from the data returned during enumeration).
+enum class FileFact : unsigned int
+{
+	None = 0,
+	Owner = 1 << 0,
+	HardLinks = 1 << 1,
+	AllocationSize = 1 << 2,
+	ShortName = 1 << 3,
+	VersionInfo = 1 << 4
+};
+DEFINE_ENUM_FLAG_OPERATORS(FileFact);
+
+// The facts retrieved for a single item. Each fact will be empty if it wasn't requested, or if it
+// couldn't be retrieved.
+struct FileFacts
+{
+	// The facts that have been requested. This is used to determine whether the facts need to be
+	// retrieved again when an additional column is shown.
+	FileFact retrieved = FileFact::None;
+
+	std::optional<std::wstring> owner;
+	std::optional<DWORD> numHardLinks;
+	std::optional<ULONGLONG> allocationSize;
+	std::optional<std::wstring> shortName;
+	std::unordered_map<VersionInfoType, std::wstring> versionInfo;
+
+	// Copies any facts retrieved in other that haven't been retrieved here.
+	void Merge(FileFacts &&other);
+};
+
+// Returns the facts needed to display the specified column, or FileFact::None if the column
+// doesn't use any.
+FileFact GetFileFactsForColumn(ColumnType columnType);
+
+// Retrieves the requested facts in a single pass. Regardless of how many facts are requested, the
+// file itself is only opened once.
+FileFacts RetrieveFileFacts(const BasicItemInfo_t &itemInfo, FileFact facts);
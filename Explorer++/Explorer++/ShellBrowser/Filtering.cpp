@@ -7,6 +7,14 @@
 #include "MainResource.h"
 #include "../Helper/ListViewHelper.h"
 
+// When fewer items than this are being restored, each item is simply inserted at its sorted
+// position. Above this, the items are appended and the listview is reordered once.
+const size_t BULK_RESTORE_MIN_ITEMS = 100;
+
+// Similarly, when at least this many items are being removed, every item is removed at once and
+// the remaining items are inserted back, rather than each filtered item being deleted separately.
+const size_t BULK_REMOVE_MIN_ITEMS = 100;
+
 std::wstring ShellBrowser::GetFilter() const
 {
 	return m_folderSettings.filter;
@@ -15,16 +23,42 @@ std::wstring ShellBrowser::GetFilter() const
 void ShellBrowser::SetFilter(std::wstring_view filter)
 {
 	m_folderSettings.filter = filter;
+	UpdateFilterExpression();
 
 	if (m_folderSettings.applyFilter)
 	{
-		UnfilterAllItems();
-		UpdateFiltering();
+		// Only the difference between the previous and new set of visible items is applied, with
+		// each item being checked against the new filter once.
+		std::vector<int> previouslyFilteredItems(m_directoryState.filteredItemsList.begin(),
+			m_directoryState.filteredItemsList.end());
+
+		RemoveFilteredItems();
+
+		std::vector<int> itemsToRestore;
+
+		for (int internalIndex : previouslyFilteredItems)
+		{
+			if (!IsFileFiltered(m_itemInfoMap.at(internalIndex)))
+			{
+				itemsToRestore.push_back(internalIndex);
+			}
+		}
+
+		RestoreFilteredItems(itemsToRestore);
+
+		SendMessage(m_hOwner, WM_USER_UPDATEWINDOWS, 0, 0);
 	}
 }
 
+// Each change to the status filters (or unfilters) every item, so setting the status to its
+// current value does nothing.
 void ShellBrowser::SetFilterStatus(BOOL bFilter)
 {
+	if ((bFilter != FALSE) == (m_folderSettings.applyFilter != FALSE))
+	{
+		return;
+	}
+
 	m_folderSettings.applyFilter = bFilter;
 
 	UpdateFiltering();
@@ -38,6 +72,7 @@ BOOL ShellBrowser::GetFilterStatus() const
 void ShellBrowser::SetFilterCaseSensitive(BOOL filterCaseSensitive)
 {
 	m_folderSettings.filterCaseSensitive = filterCaseSensitive;
+	UpdateFilterExpression();
 }
 
 BOOL ShellBrowser::GetFilterCaseSensitive() const
@@ -75,59 +110,271 @@ void ShellBrowser::RemoveFilteredItems()
 		return;
 	}
 
+	if (m_ownerDataListView)
+	{
+		// Removing the items one at a time would mean rebuilding the item order once for each
+		// filtered item, so the remaining items are collected in a single pass instead.
+		std::vector<int> remainingItems;
+		remainingItems.reserve(m_directoryState.ownerDataItems.size());
+
+		for (int internalIndex : m_directoryState.ownerDataItems)
+		{
+			const auto &item = m_itemInfoMap.at(internalIndex);
+
+			if (WI_IsFlagClear(item.wfd.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY)
+				&& IsFilenameFiltered(item))
+			{
+				ULARGE_INTEGER ulFileSize = { item.wfd.nFileSizeLow, item.wfd.nFileSizeHigh };
+				m_directoryState.totalDirSize.QuadPart -= ulFileSize.QuadPart;
+				m_directoryState.numItems--;
+
+				m_directoryState.filteredItemsList.insert(internalIndex);
+
+				continue;
+			}
+
+			remainingItems.push_back(internalIndex);
+		}
+
+		// The selection information is recalculated here, so there's no need to adjust the
+		// selection size above.
+		SetOwnerDataItems(std::move(remainingItems));
+
+		SendMessage(m_hOwner, WM_USER_UPDATEWINDOWS, 0, 0);
+		return;
+	}
+
+	// The items are collected in descending order, so that removing an item doesn't change the
+	// index of any item still to be removed.
+	std::vector<int> itemsToRemove;
 	int nItems = ListView_GetItemCount(m_hListView);
 
 	for (int i = nItems - 1; i >= 0; i--)
 	{
-		int internalIndex = GetItemInternalIndex(i);
+		const auto &item = m_itemInfoMap.at(GetItemInternalIndex(i));
+
+		if (WI_IsFlagClear(item.wfd.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY)
+			&& IsFilenameFiltered(item))
+		{
+			itemsToRemove.push_back(i);
+		}
+	}
+
+	if (!itemsToRemove.empty())
+	{
+		SendMessage(m_hListView, WM_SETREDRAW, FALSE, NULL);
+		RemoveFilteredItemsAtIndexes(itemsToRemove);
+		SendMessage(m_hListView, WM_SETREDRAW, TRUE, NULL);
+	}
+
+	SendMessage(m_hOwner, WM_USER_UPDATEWINDOWS, 0, 0);
+}
+
+void ShellBrowser::RemoveFilteredItem(int iItem)
+{
+	RemoveFilteredItemsAtIndexes({ iItem });
+}
+
+// Removes the items at the specified indexes (which should be in descending order) and adds them
+// to the filtered list. Group headers are only updated once every item has been removed.
+void ShellBrowser::RemoveFilteredItemsAtIndexes(const std::vector<int> &indexes)
+{
+	if (!m_ownerDataListView && indexes.size() >= BULK_REMOVE_MIN_ITEMS)
+	{
+		RemoveFilteredItemsInBulk(indexes);
+		return;
+	}
+
+	std::unordered_set<int> updatedGroups;
+
+	for (int index : indexes)
+	{
+		int internalIndex = GetItemInternalIndex(index);
+		const auto &item = m_itemInfoMap.at(internalIndex);
+		ULARGE_INTEGER ulFileSize = { item.wfd.nFileSizeLow, item.wfd.nFileSizeHigh };
 
-		if (!((m_itemInfoMap.at(internalIndex).wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-				== FILE_ATTRIBUTE_DIRECTORY))
+		if (ListView_GetItemState(m_hListView, index, LVIS_SELECTED) == LVIS_SELECTED)
 		{
-			if (IsFilenameFiltered(m_itemInfoMap.at(internalIndex).displayName.c_str()))
+			m_directoryState.fileSelectionSize.QuadPart -= ulFileSize.QuadPart;
+		}
+
+		/* Take the file size of the removed file away from the total
+		directory size. */
+		m_directoryState.totalDirSize.QuadPart -= ulFileSize.QuadPart;
+
+		if (m_folderSettings.showInGroups)
+		{
+			auto groupId = GetItemGroupId(index);
+
+			if (groupId)
 			{
-				RemoveFilteredItem(i, internalIndex);
+				ChangeGroupItemCount(*groupId, -1);
+				updatedGroups.insert(*groupId);
 			}
 		}
+
+		if (m_ownerDataListView)
+		{
+			RemoveOwnerDataItem(index);
+		}
+		else
+		{
+			ListView_DeleteItem(m_hListView, index);
+			OnItemPositionRemoved(internalIndex);
+		}
+
+		m_directoryState.numItems--;
+
+		assert(m_directoryState.filteredItemsList.count(internalIndex) == 0);
+		m_directoryState.filteredItemsList.insert(internalIndex);
 	}
 
-	SendMessage(m_hOwner, WM_USER_UPDATEWINDOWS, 0, 0);
+	for (int groupId : updatedGroups)
+	{
+		const ListViewGroup &group = GetListViewGroupById(groupId);
+
+		if (group.numItems == 0)
+		{
+			RemoveGroupFromListView(group);
+		}
+		else
+		{
+			UpdateGroupHeader(group);
+		}
+	}
 }
 
-void ShellBrowser::RemoveFilteredItem(int iItem, int iItemInternal)
+// Deleting an item from the listview shifts every item after it, so removing a large number of
+// items one at a time is slow. Instead, every item is deleted and the remaining items (which are
+// already in sorted order) are inserted again. The group and selection of each remaining item is
+// kept. Redraw should be disabled while this runs (as it is in RemoveFilteredItems()), so that
+// the listview isn't briefly shown empty.
+void ShellBrowser::RemoveFilteredItemsInBulk(const std::vector<int> &indexes)
 {
-	ULARGE_INTEGER ulFileSize;
+	std::unordered_set<int> indexesToRemove(indexes.begin(), indexes.end());
+	std::vector<int> remainingItems;
+	std::vector<std::optional<int>> remainingItemGroups;
+	std::unordered_set<int> selectedItems;
+	std::optional<int> focusedItem;
+	std::unordered_map<int, int> numItemsRemovedFromGroup;
+
+	int nItems = ListView_GetItemCount(m_hListView);
+	int focusedIndex = ListView_GetNextItem(m_hListView, -1, LVNI_FOCUSED);
 
-	const auto &item = m_itemInfoMap.at(iItemInternal);
+	remainingItems.reserve(nItems - indexesToRemove.size());
+	remainingItemGroups.reserve(nItems - indexesToRemove.size());
 
-	if (ListView_GetItemState(m_hListView, iItem, LVIS_SELECTED) == LVIS_SELECTED)
+	for (int i = 0; i < nItems; i++)
 	{
-		ulFileSize.LowPart = item.wfd.nFileSizeLow;
-		ulFileSize.HighPart = item.wfd.nFileSizeHigh;
+		int internalIndex = GetItemInternalIndex(i);
+		bool selected = ListView_GetItemState(m_hListView, i, LVIS_SELECTED) == LVIS_SELECTED;
+
+		// No notifications are sent when the items are deleted, so the selection information is
+		// updated here. The remaining items will be counted again once they're reselected.
+		if (selected)
+		{
+			UpdateFileSelectionInfo(internalIndex, FALSE);
+		}
+
+		std::optional<int> groupId;
+
+		if (m_folderSettings.showInGroups)
+		{
+			groupId = GetItemGroupId(i);
+		}
+
+		if (indexesToRemove.count(i) == 0)
+		{
+			remainingItems.push_back(internalIndex);
+			remainingItemGroups.push_back(groupId);
 
-		m_directoryState.fileSelectionSize.QuadPart -= ulFileSize.QuadPart;
+			if (selected)
+			{
+				selectedItems.insert(internalIndex);
+			}
+
+			if (i == focusedIndex)
+			{
+				focusedItem = internalIndex;
+			}
+
+			continue;
+		}
+
+		if (groupId)
+		{
+			numItemsRemovedFromGroup[*groupId]++;
+		}
+
+		assert(m_directoryState.filteredItemsList.count(internalIndex) == 0);
+		m_directoryState.filteredItemsList.insert(internalIndex);
 	}
 
-	/* Take the file size of the removed file away from the total
-	directory size. */
-	ulFileSize.LowPart = item.wfd.nFileSizeLow;
-	ulFileSize.HighPart = item.wfd.nFileSizeHigh;
+	ListView_DeleteAllItems(m_hListView);
+	InvalidateItemPositions();
+
+	// The size of each remaining item is added back as the item is inserted. The number of items
+	// is also reset when the items are inserted.
+	m_directoryState.totalDirSize.QuadPart = 0;
+
+	for (size_t i = 0; i < remainingItems.size(); i++)
+	{
+		AwaitingAdd_t awaitingAdd;
+		awaitingAdd.iItem = static_cast<int>(i);
+		awaitingAdd.bPosition = FALSE;
+		awaitingAdd.iAfter = -1;
+		awaitingAdd.iItemInternal = remainingItems[i];
+		m_directoryState.awaitingAddList.push_back(awaitingAdd);
+	}
 
-	m_directoryState.totalDirSize.QuadPart -= ulFileSize.QuadPart;
+	// The groups of the remaining items are already known, so there's no need to determine them
+	// again. Items whose group is still being determined in the background are left as they are.
+	InsertAwaitingItems(FALSE);
 
-	/* Remove the item from the m_hListView. */
-	ListView_DeleteItem(m_hListView, iItem);
+	for (size_t i = 0; i < remainingItems.size(); i++)
+	{
+		int index = static_cast<int>(i);
 
-	m_directoryState.numItems--;
+		if (remainingItemGroups[i])
+		{
+			LVITEM item;
+			item.mask = LVIF_GROUPID;
+			item.iItem = index;
+			item.iSubItem = 0;
+			item.iGroupId = *remainingItemGroups[i];
+			ListView_SetItem(m_hListView, &item);
+		}
 
-	assert(m_directoryState.filteredItemsList.count(iItemInternal) == 0);
-	m_directoryState.filteredItemsList.insert(iItemInternal);
+		if (selectedItems.count(remainingItems[i]) > 0)
+		{
+			ListView_SetItemState(m_hListView, index, LVIS_SELECTED, LVIS_SELECTED);
+		}
+
+		if (focusedItem && remainingItems[i] == *focusedItem)
+		{
+			ListView_SetItemState(m_hListView, index, LVIS_FOCUSED, LVIS_FOCUSED);
+			ListView_EnsureVisible(m_hListView, index, FALSE);
+		}
+	}
+
+	for (auto [groupId, numItemsRemoved] : numItemsRemovedFromGroup)
+	{
+		const ListViewGroup &group = ChangeGroupItemCount(groupId, -numItemsRemoved);
+
+		if (group.numItems == 0)
+		{
+			RemoveGroupFromListView(group);
+		}
+		else
+		{
+			UpdateGroupHeader(group);
+		}
+	}
 }
 
-BOOL ShellBrowser::IsFilenameFiltered(const TCHAR *FileName) const
+BOOL ShellBrowser::IsFilenameFiltered(const ItemInfo_t &itemInfo) const
 {
-	if (CheckWildcardMatch(
-			m_folderSettings.filter.c_str(), FileName, m_folderSettings.filterCaseSensitive))
+	if (m_filterExpression->Matches(itemInfo.displayName, itemInfo.wfd))
 	{
 		return FALSE;
 	}
@@ -135,15 +382,82 @@ BOOL ShellBrowser::IsFilenameFiltered(const TCHAR *FileName) const
 	return TRUE;
 }
 
+void ShellBrowser::UpdateFilterExpression()
+{
+	m_filterExpression.emplace(m_folderSettings.filter, m_folderSettings.filterCaseSensitive);
+}
+
 void ShellBrowser::UnfilterAllItems()
 {
-	for (int internalIndex : m_directoryState.filteredItemsList)
+	std::vector<int> filteredItems(m_directoryState.filteredItemsList.begin(),
+		m_directoryState.filteredItemsList.end());
+	RestoreFilteredItems(filteredItems);
+
+	SendMessage(m_hOwner, WM_USER_UPDATEWINDOWS, 0, 0);
+}
+
+// Removes the specified items from the filtered list and inserts them back into the listview. Any
+// item that's still filtered (e.g. because it's a hidden system file) will be added back to the
+// filtered list.
+void ShellBrowser::RestoreFilteredItems(const std::vector<int> &internalIndexes)
+{
+	if (internalIndexes.empty())
 	{
-		RestoreFilteredItem(internalIndex);
+		return;
 	}
 
-	m_directoryState.filteredItemsList.clear();
-	SendMessage(m_hOwner, WM_USER_UPDATEWINDOWS, 0, 0);
+	for (int internalIndex : internalIndexes)
+	{
+		m_directoryState.filteredItemsList.erase(internalIndex);
+	}
+
+	if (m_ownerDataListView)
+	{
+		// The items will all be merged in at once.
+		for (int internalIndex : internalIndexes)
+		{
+			AwaitingAdd_t awaitingAdd;
+			awaitingAdd.iItem = 0;
+			awaitingAdd.bPosition = FALSE;
+			awaitingAdd.iAfter = -1;
+			awaitingAdd.iItemInternal = internalIndex;
+			m_directoryState.awaitingAddList.push_back(awaitingAdd);
+		}
+
+		InsertAwaitingItems(FALSE);
+		return;
+	}
+
+	if (internalIndexes.size() < BULK_RESTORE_MIN_ITEMS)
+	{
+		for (int internalIndex : internalIndexes)
+		{
+			RestoreFilteredItem(internalIndex);
+		}
+
+		return;
+	}
+
+	// Inserting each item at its sorted position would shift every item after it, so the items
+	// are appended instead, with the listview then being reordered in a single pass.
+	int numPreviousItems = ListView_GetItemCount(m_hListView);
+
+	for (size_t i = 0; i < internalIndexes.size(); i++)
+	{
+		AwaitingAdd_t awaitingAdd;
+		awaitingAdd.iItem = numPreviousItems + static_cast<int>(i);
+		awaitingAdd.bPosition = FALSE;
+		awaitingAdd.iAfter = -1;
+		awaitingAdd.iItemInternal = internalIndexes[i];
+		m_directoryState.awaitingAddList.push_back(awaitingAdd);
+	}
+
+	SendMessage(m_hListView, WM_SETREDRAW, FALSE, NULL);
+
+	InsertAwaitingItems(m_folderSettings.showInGroups);
+	MergeAppendedItems(numPreviousItems);
+
+	SendMessage(m_hListView, WM_SETREDRAW, TRUE, NULL);
 }
 
 void ShellBrowser::UnfilterItem(int internalIndex)
@@ -12,6 +12,7 @@
 #include "../Helper/Helper.h"
 #include "../Helper/Macros.h"
 #include "../Helper/ShellHelper.h"
+#include "../Helper/SortKey.h"
 #include "../Helper/TimeHelper.h"
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
@@ -19,34 +20,159 @@
 #include <wil/common.h>
 #include <iphlpapi.h>
 #include <propkey.h>
+#include <algorithm>
 #include <cassert>
 #include <list>
+#include <thread>
 
 namespace
 {
 	const uint64_t KBYTE = 1024;
 	const uint64_t MBYTE = 1024 * 1024;
 	const uint64_t GBYTE = 1024 * 1024 * 1024;
+
+	// When grouping requires the items themselves to be accessed, each thread used should have at
+	// least this many items to process.
+	const size_t GROUPING_MIN_ITEMS_PER_THREAD = 16;
+
+	struct SizeGroup
+	{
+		int nameResourceId;
+		uint64_t upperLimit;
+	};
+
+	// If the limits here are adjusted, the entries in the string table should be updated as well
+	// (since they reference the limits as well).
+	const SizeGroup SIZE_GROUPS[] = { { IDS_GROUPBY_SIZE_EMPTY, 0 },
+		{ IDS_GROUPBY_SIZE_TINY, 16 * KBYTE }, { IDS_GROUPBY_SIZE_SMALL, MBYTE },
+		{ IDS_GROUPBY_SIZE_MEDIUM, 128 * MBYTE }, { IDS_GROUPBY_SIZE_LARGE, GBYTE },
+		{ IDS_GROUPBY_SIZE_HUGE, 4 * GBYTE },
+		{ IDS_GROUPBY_SIZE_GIGANTIC, boost::integer_traits<uint64_t>::const_max } };
+
+	// Only drives are grouped by their total size or free space, so for anything else, there's no
+	// need to retrieve the item's path.
+	std::optional<std::wstring> GetDriveRoot(const BasicItemInfo_t &itemInfo)
+	{
+		if (!itemInfo.isRoot)
+		{
+			return std::nullopt;
+		}
+
+		std::wstring fullPath = itemInfo.getFullPath();
+
+		if (!PathIsRoot(fullPath.c_str()))
+		{
+			return std::nullopt;
+		}
+
+		return fullPath;
+	}
 }
 
+// Values that are the same for every item being grouped. These are computed once, when a set of
+// items is grouped, rather than once per item.
+struct ShellBrowser::GroupingContext
+{
+	struct DateGroup
+	{
+		// Items on or after this date (and before the start of the previous group) are placed in
+		// this group.
+		boost::gregorian::date start;
+
+		std::wstring name;
+		int relativeSortPosition;
+	};
+
+	struct DriveSpace
+	{
+		ULARGE_INTEGER totalBytes;
+		ULARGE_INTEGER freeBytes;
+	};
+
+	SortMode sortMode;
+
+	// Items are grouped on the task executor, so a copy of the settings is used, rather than the
+	// settings in the config (which can be changed on the UI thread at any time).
+	GlobalFolderSettings globalFolderSettings;
+
+	std::wstring unspecifiedGroupName;
+	std::wstring otherNameGroupName;
+	std::wstring folderSizeGroupName;
+
+	// Has the same number of entries as SIZE_GROUPS.
+	std::vector<std::wstring> sizeGroupNames;
+
+	// Ordered from the most recent group to the oldest. An item belongs to the first group that
+	// starts on or before its date.
+	std::vector<DateGroup> dateGroups;
+
+	// Items can be grouped on several threads at once, so access to the drive values is
+	// synchronized. Each drive is only queried once.
+	mutable std::mutex driveSpaceMutex;
+	mutable std::unordered_map<std::wstring, std::optional<DriveSpace>> driveSpace;
+
+	std::optional<DriveSpace> GetDriveSpace(const std::wstring &root) const
+	{
+		std::lock_guard<std::mutex> lock(driveSpaceMutex);
+
+		auto itr = driveSpace.find(root);
+
+		if (itr != driveSpace.end())
+		{
+			return itr->second;
+		}
+
+		std::optional<DriveSpace> space;
+		DriveSpace currentSpace;
+
+		if (GetDiskFreeSpaceEx(
+				root.c_str(), nullptr, &currentSpace.totalBytes, &currentSpace.freeBytes))
+		{
+			space = currentSpace;
+		}
+
+		driveSpace.insert({ root, space });
+
+		return space;
+	}
+};
+
 BOOL ShellBrowser::GetShowInGroups() const
 {
 	return m_folderSettings.showInGroups;
 }
 
+bool ShellBrowser::IsOwnerDataListView() const
+{
+	return m_ownerDataListView;
+}
+
 /* Simply sets the grouping flag, without actually moving
 items into groups. */
 void ShellBrowser::SetShowInGroupsFlag(BOOL bShowInGroups)
 {
+	// Groups aren't supported in owner data mode. To show groups, a new tab (which will use a
+	// regular listview) needs to be created instead. See TabContainer::RecreateTab().
+	if (m_ownerDataListView)
+	{
+		return;
+	}
+
 	m_folderSettings.showInGroups = bShowInGroups;
 }
 
 void ShellBrowser::SetShowInGroups(BOOL bShowInGroups)
 {
+	if (m_ownerDataListView)
+	{
+		return;
+	}
+
 	m_folderSettings.showInGroups = bShowInGroups;
 
 	if (!m_folderSettings.showInGroups)
 	{
+		CancelBackgroundGrouping();
 		ListView_EnableGroupView(m_hListView, FALSE);
 		SortFolder(m_folderSettings.sortMode);
 		return;
@@ -67,33 +193,9 @@ int ShellBrowser::GroupComparison(int id1, int id2)
 {
 	const auto &group1 = GetListViewGroupById(id1);
 	const auto &group2 = GetListViewGroupById(id2);
-	int comparisonResult = 0;
+	int comparisonResult = group1.sortBucket - group2.sortBucket;
 
-	if (group1.relativeSortPosition == INT_MIN && group2.relativeSortPosition != INT_MIN)
-	{
-		comparisonResult = -1;
-	}
-	else if (group1.relativeSortPosition != INT_MIN && group2.relativeSortPosition == INT_MIN)
-	{
-		comparisonResult = 1;
-	}
-	else if (group1.relativeSortPosition == INT_MIN && group2.relativeSortPosition == INT_MIN)
-	{
-		comparisonResult = 0;
-	}
-	else if (group1.relativeSortPosition == INT_MAX && group2.relativeSortPosition != INT_MAX)
-	{
-		comparisonResult = 1;
-	}
-	else if (group1.relativeSortPosition != INT_MAX && group2.relativeSortPosition == INT_MAX)
-	{
-		comparisonResult = -1;
-	}
-	else if (group1.relativeSortPosition == INT_MAX && group2.relativeSortPosition == INT_MAX)
-	{
-		comparisonResult = 0;
-	}
-	else
+	if (comparisonResult == 0 && group1.sortBucket == 0)
 	{
 		switch (m_folderSettings.sortMode)
 		{
@@ -126,7 +228,7 @@ int ShellBrowser::GroupComparison(int id1, int id2)
 
 int ShellBrowser::GroupNameComparison(const ListViewGroup &group1, const ListViewGroup &group2)
 {
-	return group1.name.compare(group2.name);
+	return CompareSortKeys(group1.nameSortKey, group2.nameSortKey);
 }
 
 int ShellBrowser::GroupRelativePositionComparison(
@@ -135,7 +237,7 @@ int ShellBrowser::GroupRelativePositionComparison(
 	return group1.relativeSortPosition - group2.relativeSortPosition;
 }
 
-const ShellBrowser::ListViewGroup ShellBrowser::GetListViewGroupById(int groupId)
+const ShellBrowser::ListViewGroup &ShellBrowser::GetListViewGroupById(int groupId) const
 {
 	auto itr = m_listViewGroups.get<0>().find(groupId);
 	assert(itr != m_listViewGroups.get<0>().end());
@@ -143,15 +245,268 @@ const ShellBrowser::ListViewGroup ShellBrowser::GetListViewGroupById(int groupId
 	return *itr;
 }
 
+// Returns true if determining an item's group requires the item itself to be accessed (e.g. to
+// read its version information), rather than just the information retrieved when the folder was
+// enumerated.
+bool ShellBrowser::DoesGroupingAccessItems(SortMode sortMode)
+{
+	switch (sortMode)
+	{
+	case SortMode::Name:
+	case SortMode::Size:
+	case SortMode::DateModified:
+	case SortMode::ShortName:
+	case SortMode::Extension:
+	case SortMode::Created:
+	case SortMode::Accessed:
+		return false;
+
+	default:
+		return true;
+	}
+}
+
 int ShellBrowser::DetermineItemGroup(int iItemInternal)
 {
-	BasicItemInfo_t basicItemInfo = getBasicItemInfo(iItemInternal);
+	// Any group that's still being determined in the background for this item is out of date.
+	m_pendingItemGroups.erase(iItemInternal);
+
+	return DetermineItemGroups({ iItemInternal })[0];
+}
+
+std::vector<int> ShellBrowser::DetermineItemGroups(const std::vector<int> &internalIndexes)
+{
+	auto context = CreateGroupingContext();
+
+	std::vector<int> groupIds;
+	groupIds.reserve(internalIndexes.size());
+
+	for (int internalIndex : internalIndexes)
+	{
+		auto groupInfo = DetermineItemGroupInfo(getBasicItemInfo(internalIndex), *context);
+		groupIds.push_back(GetOrCreateItemGroup(groupInfo, *context));
+	}
+
+	return groupIds;
+}
+
+// Determining the group for an item can be expensive when the item itself has to be read (e.g.
+// to retrieve its version information). In that case, for anything other than a handful of items,
+// the groups are determined in the background, rather than blocking the UI thread.
+bool ShellBrowser::ShouldDetermineGroupsInBackground(size_t numItems) const
+{
+	return DoesGroupingAccessItems(m_folderSettings.sortMode)
+		&& numItems >= GROUPING_MIN_ITEMS_PER_THREAD;
+}
+
+// The items should already be in the listview, but not in any group. Each item will be moved into
+// its group once the groups have been determined (see OnGroupingResultReady()).
+void ShellBrowser::StartBackgroundGrouping(const std::vector<int> &internalIndexes)
+{
+	if (internalIndexes.empty())
+	{
+		return;
+	}
+
+	auto groupingState =
+		std::make_shared<GroupingState>(m_groupingIdCounter++, CreateGroupingContext());
+	groupingState->internalIndexes = internalIndexes;
+	groupingState->items.reserve(internalIndexes.size());
+
+	for (int internalIndex : internalIndexes)
+	{
+		groupingState->items.push_back(getBasicItemInfo(internalIndex));
+		m_pendingItemGroups[internalIndex] = groupingState->groupingId;
+	}
+
+	groupingState->groupInfos.resize(internalIndexes.size());
+
+	m_groupingStates.insert({ groupingState->groupingId, groupingState });
+
+	size_t numItems = internalIndexes.size();
+	size_t maxTasks = (std::max)(std::thread::hardware_concurrency(), 1U);
+	size_t numTasks = std::clamp<size_t>(numItems / GROUPING_MIN_ITEMS_PER_THREAD, 1, maxTasks);
+	size_t itemsPerTask = (numItems + numTasks - 1) / numTasks;
+	groupingState->numPendingTasks = (numItems + itemsPerTask - 1) / itemsPerTask;
+
+	for (size_t first = 0; first < numItems; first += itemsPerTask)
+	{
+		size_t last = (std::min)(first + itemsPerTask, numItems);
+
+		m_groupingTaskQueue->PushTask([this, listView = m_hListView, groupingState, first, last]() {
+			DetermineItemGroupsAsync(*groupingState, first, last);
+
+			// The last task to finish notifies the UI thread.
+			if (--groupingState->numPendingTasks == 0 && !groupingState->cancelled)
+			{
+				PostMessage(listView, WM_APP_GROUPING_RESULT_READY, groupingState->groupingId, 0);
+			}
+		});
+	}
+}
+
+void ShellBrowser::DetermineItemGroupsAsync(
+	GroupingState &groupingState, size_t first, size_t last) const
+{
+	for (size_t i = first; i < last && !groupingState.cancelled; i++)
+	{
+		groupingState.groupInfos[i] =
+			DetermineItemGroupInfo(groupingState.items[i], *groupingState.context);
+	}
+}
+
+void ShellBrowser::OnGroupingResultReady(int groupingId)
+{
+	auto itr = m_groupingStates.find(groupingId);
+
+	if (itr == m_groupingStates.end())
+	{
+		return;
+	}
+
+	auto groupingState = itr->second;
+	m_groupingStates.erase(itr);
+
+	SendMessage(m_hListView, WM_SETREDRAW, FALSE, NULL);
+
+	std::unordered_set<int> updatedGroups;
+
+	for (size_t i = 0; i < groupingState->internalIndexes.size(); i++)
+	{
+		int internalIndex = groupingState->internalIndexes[i];
+		auto pendingItr = m_pendingItemGroups.find(internalIndex);
+
+		// If the item has been updated (or grouped again) since this request was made, the group
+		// determined here is out of date.
+		if (pendingItr == m_pendingItemGroups.end() || pendingItr->second != groupingId)
+		{
+			continue;
+		}
+
+		m_pendingItemGroups.erase(pendingItr);
+
+		auto index = LocateItemByInternalIndex(internalIndex);
+
+		// The item may have been removed and then inserted into a group again in the meantime.
+		if (!index || GetItemGroupId(*index))
+		{
+			continue;
+		}
+
+		int groupId =
+			GetOrCreateItemGroup(groupingState->groupInfos[i], *groupingState->context);
+
+		EnsureGroupExistsInListView(groupId);
+
+		LVITEM item;
+		item.mask = LVIF_GROUPID;
+		item.iItem = *index;
+		item.iSubItem = 0;
+		item.iGroupId = groupId;
+		BOOL res = ListView_SetItem(m_hListView, &item);
+
+		if (res)
+		{
+			ChangeGroupItemCount(groupId, 1);
+			updatedGroups.insert(groupId);
+		}
+	}
+
+	UpdateGroupHeaders(updatedGroups);
+
+	SendMessage(m_hListView, WM_SETREDRAW, TRUE, NULL);
+}
+
+void ShellBrowser::CancelBackgroundGrouping()
+{
+	for (auto &[groupingId, groupingState] : m_groupingStates)
+	{
+		groupingState->cancelled = true;
+	}
+
+	m_groupingStates.clear();
+	m_pendingItemGroups.clear();
+	m_groupingTaskQueue->Clear();
+}
+
+std::unique_ptr<ShellBrowser::GroupingContext> ShellBrowser::CreateGroupingContext() const
+{
+	using namespace boost::gregorian;
+
+	auto context = std::make_unique<GroupingContext>();
+	context->sortMode = m_folderSettings.sortMode;
+	context->globalFolderSettings = m_config->globalFolderSettings;
+	context->unspecifiedGroupName =
+		ResourceHelper::LoadString(m_hResourceModule, IDS_GROUPBY_UNSPECIFIED);
+
+	switch (context->sortMode)
+	{
+	case SortMode::Name:
+	case SortMode::ShortName:
+		context->otherNameGroupName =
+			ResourceHelper::LoadString(m_hResourceModule, IDS_GROUPBY_NAME_OTHER);
+		break;
+
+	case SortMode::Size:
+		context->folderSizeGroupName =
+			ResourceHelper::LoadString(m_hResourceModule, IDS_GROUPBY_SIZE_FOLDERS);
+
+		for (const auto &sizeGroup : SIZE_GROUPS)
+		{
+			context->sizeGroupNames.push_back(
+				ResourceHelper::LoadString(m_hResourceModule, sizeGroup.nameResourceId));
+		}
+		break;
+
+	case SortMode::DateModified:
+	case SortMode::Created:
+	case SortMode::Accessed:
+	{
+		date today = day_clock::local_day();
+
+		// Note that this assumes that Sunday is the first day of the week.
+		date startOfWeek = today - days(today.day_of_week().as_number());
+		date startOfMonth = date(today.year(), today.month(), 1);
+		date startOfYear = date(today.year(), 1, 1);
+
+		std::pair<date, UINT> dateGroups[] = { { today + days(1), IDS_GROUPBY_DATE_FUTURE },
+			{ today, IDS_GROUPBY_DATE_TODAY }, { today - days(1), IDS_GROUPBY_DATE_YESTERDAY },
+			{ startOfWeek, IDS_GROUPBY_DATE_THIS_WEEK },
+			{ startOfWeek - weeks(1), IDS_GROUPBY_DATE_LAST_WEEK },
+			{ startOfMonth, IDS_GROUPBY_DATE_THIS_MONTH },
+			{ startOfMonth - months(1), IDS_GROUPBY_DATE_LAST_MONTH },
+			{ startOfYear, IDS_GROUPBY_DATE_THIS_YEAR },
+			{ startOfYear - years(1), IDS_GROUPBY_DATE_LAST_YEAR },
+			{ date(boost::date_time::min_date_time), IDS_GROUPBY_DATE_LONG_AGO } };
+
+		int relativeSortPosition = 0;
+
+		for (const auto &[start, nameResourceId] : dateGroups)
+		{
+			context->dateGroups.push_back({ start,
+				ResourceHelper::LoadString(m_hResourceModule, nameResourceId),
+				relativeSortPosition });
+			relativeSortPosition--;
+		}
+	}
+	break;
+
+	default:
+		break;
+	}
+
+	return context;
+}
+
+std::optional<ShellBrowser::GroupInfo> ShellBrowser::DetermineItemGroupInfo(
+	const BasicItemInfo_t &basicItemInfo, const GroupingContext &context) const
+{
 	std::optional<GroupInfo> groupInfo;
 
-	switch (m_folderSettings.sortMode)
+	switch (context.sortMode)
 	{
 	case SortMode::Name:
-		groupInfo = DetermineItemNameGroup(basicItemInfo);
+		groupInfo = DetermineItemNameGroup(basicItemInfo, context);
 		break;
 
 	case SortMode::Type:
@@ -159,19 +514,20 @@ int ShellBrowser::DetermineItemGroup(int iItemInternal)
 		break;
 
 	case SortMode::Size:
-		groupInfo = DetermineItemSizeGroup(basicItemInfo);
+		groupInfo = DetermineItemSizeGroup(basicItemInfo, context);
 		break;
 
 	case SortMode::DateModified:
-		groupInfo = DetermineItemDateGroup(basicItemInfo, GroupByDateType::Modified);
+		groupInfo =
+			DetermineItemDateGroup(basicItemInfo, GroupByDateType::Modified, context);
 		break;
 
 	case SortMode::TotalSize:
-		groupInfo = DetermineItemTotalSizeGroup(basicItemInfo);
+		groupInfo = DetermineItemTotalSizeGroup(basicItemInfo, context);
 		break;
 
 	case SortMode::FreeSpace:
-		groupInfo = DetermineItemFreeSpaceGroup(basicItemInfo);
+		groupInfo = DetermineItemFreeSpaceGroup(basicItemInfo, context);
 		break;
 
 	case SortMode::DateDeleted:
@@ -179,7 +535,7 @@ int ShellBrowser::DetermineItemGroup(int iItemInternal)
 
 	case SortMode::OriginalLocation:
 		groupInfo = DetermineItemSummaryGroup(
-			basicItemInfo, &SCID_ORIGINAL_LOCATION, m_config->globalFolderSettings);
+			basicItemInfo, &SCID_ORIGINAL_LOCATION, context.globalFolderSettings);
 		break;
 
 	case SortMode::Attributes:
@@ -187,7 +543,7 @@ int ShellBrowser::DetermineItemGroup(int iItemInternal)
 		break;
 
 	case SortMode::ShortName:
-		groupInfo = DetermineItemNameGroup(basicItemInfo);
+		groupInfo = DetermineItemNameGroup(basicItemInfo, context);
 		break;
 
 	case SortMode::Owner:
@@ -225,36 +581,38 @@ int ShellBrowser::DetermineItemGroup(int iItemInternal)
 		break;
 
 	case SortMode::Created:
-		groupInfo = DetermineItemDateGroup(basicItemInfo, GroupByDateType::Created);
+		groupInfo =
+			DetermineItemDateGroup(basicItemInfo, GroupByDateType::Created, context);
 		break;
 
 	case SortMode::Accessed:
-		groupInfo = DetermineItemDateGroup(basicItemInfo, GroupByDateType::Accessed);
+		groupInfo =
+			DetermineItemDateGroup(basicItemInfo, GroupByDateType::Accessed, context);
 		break;
 
 	case SortMode::Title:
 		groupInfo =
-			DetermineItemSummaryGroup(basicItemInfo, &PKEY_Title, m_config->globalFolderSettings);
+			DetermineItemSummaryGroup(basicItemInfo, &PKEY_Title, context.globalFolderSettings);
 		break;
 
 	case SortMode::Subject:
 		groupInfo =
-			DetermineItemSummaryGroup(basicItemInfo, &PKEY_Subject, m_config->globalFolderSettings);
+			DetermineItemSummaryGroup(basicItemInfo, &PKEY_Subject, context.globalFolderSettings);
 		break;
 
 	case SortMode::Authors:
 		groupInfo =
-			DetermineItemSummaryGroup(basicItemInfo, &PKEY_Author, m_config->globalFolderSettings);
+			DetermineItemSummaryGroup(basicItemInfo, &PKEY_Author, context.globalFolderSettings);
 		break;
 
 	case SortMode::Keywords:
 		groupInfo = DetermineItemSummaryGroup(
-			basicItemInfo, &PKEY_Keywords, m_config->globalFolderSettings);
+			basicItemInfo, &PKEY_Keywords, context.globalFolderSettings);
 		break;
 
 	case SortMode::Comments:
 		groupInfo =
-			DetermineItemSummaryGroup(basicItemInfo, &PKEY_Comment, m_config->globalFolderSettings);
+			DetermineItemSummaryGroup(basicItemInfo, &PKEY_Comment, context.globalFolderSettings);
 		break;
 
 	case SortMode::CameraModel:
@@ -301,13 +659,7 @@ int ShellBrowser::DetermineItemGroup(int iItemInternal)
 		break;
 	}
 
-	if (!groupInfo)
-	{
-		groupInfo = GroupInfo(
-			ResourceHelper::LoadString(m_hResourceModule, IDS_GROUPBY_UNSPECIFIED), INT_MIN);
-	}
-
-	return GetOrCreateListViewGroup(*groupInfo);
+	return groupInfo;
 }
 
 int ShellBrowser::GetOrCreateListViewGroup(const GroupInfo &groupInfo)
@@ -322,15 +674,28 @@ int ShellBrowser::GetOrCreateListViewGroup(const GroupInfo &groupInfo)
 
 	int groupId = m_groupIdCounter++;
 
-	ListViewGroup listViewGroup(groupId, groupInfo);
-	m_listViewGroups.insert(listViewGroup);
+	ListViewGroup listViewGroup(groupId, groupInfo,
+		CreateSortKey(groupInfo.name, m_config->globalFolderSettings.useNaturalSortOrder));
+	m_listViewGroups.insert(std::move(listViewGroup));
 
 	return groupId;
 }
 
+// Items that don't belong to any particular group are placed in the unspecified group.
+int ShellBrowser::GetOrCreateItemGroup(
+	const std::optional<GroupInfo> &groupInfo, const GroupingContext &context)
+{
+	if (groupInfo)
+	{
+		return GetOrCreateListViewGroup(*groupInfo);
+	}
+
+	return GetOrCreateListViewGroup(GroupInfo(context.unspecifiedGroupName, INT_MIN));
+}
+
 /* TODO: These groups have changed as of Windows Vista.*/
 std::optional<ShellBrowser::GroupInfo> ShellBrowser::DetermineItemNameGroup(
-	const BasicItemInfo_t &itemInfo) const
+	const BasicItemInfo_t &itemInfo, const GroupingContext &context) const
 {
 	/* Take the first character of the item's name,
 	and use it to determine which group it belongs to. */
@@ -342,103 +707,63 @@ std::optional<ShellBrowser::GroupInfo> ShellBrowser::DetermineItemNameGroup(
 	}
 	else
 	{
-		return GroupInfo(
-			ResourceHelper::LoadString(m_hResourceModule, IDS_GROUPBY_NAME_OTHER), INT_MAX);
+		return GroupInfo(context.otherNameGroupName, INT_MAX);
 	}
 }
 
 std::optional<ShellBrowser::GroupInfo> ShellBrowser::DetermineItemSizeGroup(
-	const BasicItemInfo_t &itemInfo) const
+	const BasicItemInfo_t &itemInfo, const GroupingContext &context) const
 {
 	if ((itemInfo.wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY)
 	{
-		return GroupInfo(
-			ResourceHelper::LoadString(m_hResourceModule, IDS_GROUPBY_SIZE_FOLDERS), 0);
+		return GroupInfo(context.folderSizeGroupName, 0);
 	}
 	else if (!itemInfo.isFindDataValid)
 	{
 		return std::nullopt;
 	}
 
-	struct SizeGroup
-	{
-		int nameResourceId;
-		uint64_t upperLimit;
-	};
-
-	// If the limits here are adjusted, the entries in the string table should be updated as well
-	// (since they reference the limits as well).
-	SizeGroup sizeGroups[] = { { IDS_GROUPBY_SIZE_EMPTY, 0 }, { IDS_GROUPBY_SIZE_TINY, 16 * KBYTE },
-		{ IDS_GROUPBY_SIZE_SMALL, MBYTE }, { IDS_GROUPBY_SIZE_MEDIUM, 128 * MBYTE },
-		{ IDS_GROUPBY_SIZE_LARGE, GBYTE }, { IDS_GROUPBY_SIZE_HUGE, 4 * GBYTE },
-		{ IDS_GROUPBY_SIZE_GIGANTIC, boost::integer_traits<uint64_t>::const_max } };
-
 	ULARGE_INTEGER fileSize = { itemInfo.wfd.nFileSizeLow, itemInfo.wfd.nFileSizeHigh };
 	int currentIndex = 0;
 
-	while (fileSize.QuadPart > sizeGroups[currentIndex].upperLimit
-		&& currentIndex < (SIZEOF_ARRAY(sizeGroups) - 1))
+	while (fileSize.QuadPart > SIZE_GROUPS[currentIndex].upperLimit
+		&& currentIndex < (SIZEOF_ARRAY(SIZE_GROUPS) - 1))
 	{
 		currentIndex++;
 	}
 
-	return GroupInfo(
-		ResourceHelper::LoadString(m_hResourceModule, sizeGroups[currentIndex].nameResourceId),
-		currentIndex + 1);
+	return GroupInfo(context.sizeGroupNames[currentIndex], currentIndex + 1);
 }
 
 /* TODO: These groups have changed as of Windows Vista. */
 std::optional<ShellBrowser::GroupInfo> ShellBrowser::DetermineItemTotalSizeGroup(
-	const BasicItemInfo_t &itemInfo) const
+	const BasicItemInfo_t &itemInfo, const GroupingContext &context) const
 {
-	IShellFolder *pShellFolder = nullptr;
-	PCITEMID_CHILD pidlRelative = nullptr;
 	const TCHAR *sizeGroups[] = { _T("Small"), _T("Medium"), _T("Huge"), _T("Gigantic") };
-	TCHAR szItem[MAX_PATH];
-	STRRET str;
-	ULARGE_INTEGER nTotalBytes;
-	ULARGE_INTEGER nFreeBytes;
-	BOOL bRoot;
-	BOOL bRes = FALSE;
-	ULARGE_INTEGER totalSizeGroupLimits[6];
-	int iSize = 0;
-	int i;
-
-	totalSizeGroupLimits[0].QuadPart = 0;
-	totalSizeGroupLimits[1].QuadPart = 0;
-	totalSizeGroupLimits[2].QuadPart = GBYTE;
-	totalSizeGroupLimits[3].QuadPart = 20 * totalSizeGroupLimits[2].QuadPart;
-	totalSizeGroupLimits[4].QuadPart = 100 * totalSizeGroupLimits[2].QuadPart;
-
-	SHBindToParent(itemInfo.pidlComplete.get(), IID_PPV_ARGS(&pShellFolder), &pidlRelative);
-
-	pShellFolder->GetDisplayNameOf(pidlRelative, SHGDN_FORPARSING, &str);
-	StrRetToBuf(&str, pidlRelative, szItem, SIZEOF_ARRAY(szItem));
+	const uint64_t totalSizeGroupLimits[] = { 0, 0, GBYTE, 20 * GBYTE };
 
-	bRoot = PathIsRoot(szItem);
+	auto root = GetDriveRoot(itemInfo);
 
-	if (bRoot)
+	if (!root)
 	{
-		bRes = GetDiskFreeSpaceEx(szItem, nullptr, &nTotalBytes, &nFreeBytes);
-
-		pShellFolder->Release();
-
-		i = SIZEOF_ARRAY(sizeGroups) - 1;
+		return std::nullopt;
+	}
 
-		while (nTotalBytes.QuadPart < totalSizeGroupLimits[i].QuadPart && i > 0)
-		{
-			i--;
-		}
+	auto driveSpace = context.GetDriveSpace(*root);
 
-		iSize = i;
+	if (!driveSpace)
+	{
+		return std::nullopt;
 	}
 
-	if (!bRoot || !bRes)
+	int i = SIZEOF_ARRAY(sizeGroups) - 1;
+
+	while (driveSpace->totalBytes.QuadPart < totalSizeGroupLimits[i] && i > 0)
 	{
-		return std::nullopt;
+		i--;
 	}
 
-	return GroupInfo(sizeGroups[iSize], iSize);
+	return GroupInfo(sizeGroups[i], i);
 }
 
 std::optional<ShellBrowser::GroupInfo> ShellBrowser::DetermineItemTypeGroupVirtual(
@@ -457,14 +782,14 @@ std::optional<ShellBrowser::GroupInfo> ShellBrowser::DetermineItemTypeGroupVirtu
 }
 
 std::optional<ShellBrowser::GroupInfo> ShellBrowser::DetermineItemDateGroup(
-	const BasicItemInfo_t &itemInfo, GroupByDateType dateType) const
+	const BasicItemInfo_t &itemInfo, GroupByDateType dateType,
+	const GroupingContext &context) const
 {
 	if (!itemInfo.isFindDataValid)
 	{
 		return std::nullopt;
 	}
 
-	using namespace boost::gregorian;
 	using namespace boost::posix_time;
 
 	SYSTEMTIME stFileTime;
@@ -502,101 +827,17 @@ std::optional<ShellBrowser::GroupInfo> ShellBrowser::DetermineItemDateGroup(
 	}
 
 	auto filePosixTime = from_ftime<ptime>(localFileTime);
-	date fileDate = filePosixTime.date();
-
-	date today = day_clock::local_day();
-	int relativeSortPosition = 0;
-
-	if (fileDate > today)
-	{
-		return GroupInfo(ResourceHelper::LoadString(m_hResourceModule, IDS_GROUPBY_DATE_FUTURE),
-			relativeSortPosition);
-	}
-
-	relativeSortPosition--;
-
-	if (fileDate == today)
-	{
-		return GroupInfo(ResourceHelper::LoadString(m_hResourceModule, IDS_GROUPBY_DATE_TODAY),
-			relativeSortPosition);
-	}
-
-	date yesterday = today - days(1);
-
-	relativeSortPosition--;
-
-	if (fileDate == yesterday)
-	{
-		return GroupInfo(ResourceHelper::LoadString(m_hResourceModule, IDS_GROUPBY_DATE_YESTERDAY),
-			relativeSortPosition);
-	}
-
-	// Note that this assumes that Sunday is the first day of the week.
-	unsigned short currentWeekday = today.day_of_week().as_number();
-	date startOfWeek = today - days(currentWeekday);
+	auto fileDate = filePosixTime.date();
 
-	relativeSortPosition--;
-
-	if (fileDate >= startOfWeek)
-	{
-		return GroupInfo(ResourceHelper::LoadString(m_hResourceModule, IDS_GROUPBY_DATE_THIS_WEEK),
-			relativeSortPosition);
-	}
-
-	date startOfLastWeek = startOfWeek - weeks(1);
-
-	relativeSortPosition--;
-
-	if (fileDate >= startOfLastWeek)
-	{
-		return GroupInfo(ResourceHelper::LoadString(m_hResourceModule, IDS_GROUPBY_DATE_LAST_WEEK),
-			relativeSortPosition);
-	}
-
-	date startOfMonth = date(today.year(), today.month(), 1);
-
-	relativeSortPosition--;
-
-	if (fileDate >= startOfMonth)
-	{
-		return GroupInfo(ResourceHelper::LoadString(m_hResourceModule, IDS_GROUPBY_DATE_THIS_MONTH),
-			relativeSortPosition);
-	}
-
-	date startOfLastMonth = startOfMonth - months(1);
-
-	relativeSortPosition--;
-
-	if (fileDate >= startOfLastMonth)
-	{
-		return GroupInfo(ResourceHelper::LoadString(m_hResourceModule, IDS_GROUPBY_DATE_LAST_MONTH),
-			relativeSortPosition);
-	}
-
-	date startOfYear = date(today.year(), 1, 1);
-
-	relativeSortPosition--;
-
-	if (fileDate >= startOfYear)
+	for (const auto &dateGroup : context.dateGroups)
 	{
-		return GroupInfo(ResourceHelper::LoadString(m_hResourceModule, IDS_GROUPBY_DATE_THIS_YEAR),
-			relativeSortPosition);
-	}
-
-	date startOfLastYear = startOfYear - years(1);
-
-	relativeSortPosition--;
-
-	if (fileDate >= startOfLastYear)
-	{
-		return GroupInfo(ResourceHelper::LoadString(m_hResourceModule, IDS_GROUPBY_DATE_LAST_YEAR),
-			relativeSortPosition);
+		if (fileDate >= dateGroup.start)
+		{
+			return GroupInfo(dateGroup.name, dateGroup.relativeSortPosition);
+		}
 	}
 
-	relativeSortPosition--;
-
-	return GroupInfo(ResourceHelper::LoadString(m_hResourceModule, IDS_GROUPBY_DATE_LONG_AGO),
-		relativeSortPosition);
+	return std::nullopt;
 }
 
 std::optional<ShellBrowser::GroupInfo> ShellBrowser::DetermineItemSummaryGroup(
@@ -619,49 +860,28 @@ std::optional<ShellBrowser::GroupInfo> ShellBrowser::DetermineItemSummaryGroup(
 
 /* TODO: Need to sort based on percentage free. */
 std::optional<ShellBrowser::GroupInfo> ShellBrowser::DetermineItemFreeSpaceGroup(
-	const BasicItemInfo_t &itemInfo) const
+	const BasicItemInfo_t &itemInfo, const GroupingContext &context) const
 {
-	TCHAR szFreeSpace[MAX_PATH];
-	IShellFolder *pShellFolder = nullptr;
-	PCITEMID_CHILD pidlRelative = nullptr;
-	STRRET str;
-	TCHAR szItem[MAX_PATH];
-	ULARGE_INTEGER nTotalBytes;
-	ULARGE_INTEGER nFreeBytes;
-	BOOL bRoot;
-	BOOL bRes = FALSE;
+	auto root = GetDriveRoot(itemInfo);
 
-	SHBindToParent(itemInfo.pidlComplete.get(), IID_PPV_ARGS(&pShellFolder), &pidlRelative);
-
-	pShellFolder->GetDisplayNameOf(pidlRelative, SHGDN_FORPARSING, &str);
-	StrRetToBuf(&str, pidlRelative, szItem, SIZEOF_ARRAY(szItem));
-
-	pShellFolder->Release();
-
-	bRoot = PathIsRoot(szItem);
-
-	if (bRoot)
+	if (!root)
 	{
-		bRes = GetDiskFreeSpaceEx(szItem, nullptr, &nTotalBytes, &nFreeBytes);
-
-		LARGE_INTEGER lDiv1;
-		LARGE_INTEGER lDiv2;
-
-		lDiv1.QuadPart = 100;
-		lDiv2.QuadPart = 10;
-
-		/* Divide by 10 to remove the one's digit, then multiply
-		by 10 so that only the ten's digit rmains. */
-		StringCchPrintf(szFreeSpace, SIZEOF_ARRAY(szFreeSpace), _T("%I64d%% free"),
-			(((nFreeBytes.QuadPart * lDiv1.QuadPart) / nTotalBytes.QuadPart) / lDiv2.QuadPart)
-				* lDiv2.QuadPart);
+		return std::nullopt;
 	}
 
-	if (!bRoot || !bRes)
+	auto driveSpace = context.GetDriveSpace(*root);
+
+	if (!driveSpace || driveSpace->totalBytes.QuadPart == 0)
 	{
 		return std::nullopt;
 	}
 
+	/* Divide by 10 to remove the one's digit, then multiply
+	by 10 so that only the ten's digit rmains. */
+	TCHAR szFreeSpace[MAX_PATH];
+	StringCchPrintf(szFreeSpace, SIZEOF_ARRAY(szFreeSpace), _T("%I64d%% free"),
+		(((driveSpace->freeBytes.QuadPart * 100) / driveSpace->totalBytes.QuadPart) / 10) * 10);
+
 	return GroupInfo(szFreeSpace);
 }
 
@@ -833,33 +1053,72 @@ std::optional<ShellBrowser::GroupInfo> ShellBrowser::DetermineItemNetworkStatus(
 
 void ShellBrowser::MoveItemsIntoGroups()
 {
-	LVITEM item;
-	int nItems;
-	int iGroupId;
-	int i = 0;
+	CancelBackgroundGrouping();
 
 	ListView_RemoveAllGroups(m_hListView);
 	ListView_EnableGroupView(m_hListView, TRUE);
 
-	nItems = ListView_GetItemCount(m_hListView);
+	int nItems = ListView_GetItemCount(m_hListView);
 
 	SendMessage(m_hListView, WM_SETREDRAW, FALSE, NULL);
 
 	m_listViewGroups.clear();
 	m_groupIdCounter = 0;
 
-	for (i = 0; i < nItems; i++)
+	std::vector<int> internalIndexes;
+	internalIndexes.reserve(nItems);
+
+	for (int i = 0; i < nItems; i++)
+	{
+		internalIndexes.push_back(GetItemInternalIndex(i));
+	}
+
+	// Since every group has been removed, none of the items are currently shown. They'll be shown
+	// again as they're moved into their groups. Group IDs are reused, so the items are explicitly
+	// removed from their previous groups first.
+	if (ShouldDetermineGroupsInBackground(internalIndexes.size()))
+	{
+		for (int i = 0; i < nItems; i++)
+		{
+			LVITEM item;
+			item.mask = LVIF_GROUPID;
+			item.iItem = i;
+			item.iSubItem = 0;
+			item.iGroupId = I_GROUPIDNONE;
+			ListView_SetItem(m_hListView, &item);
+		}
+
+		StartBackgroundGrouping(internalIndexes);
+		SendMessage(m_hListView, WM_SETREDRAW, TRUE, NULL);
+		return;
+	}
+
+	auto groupIds = DetermineItemGroups(internalIndexes);
+
+	// Since every group was removed above, there are no previous groups to update. The header
+	// of each group is only set once, after all of its items have been added.
+	std::unordered_set<int> updatedGroups;
+
+	for (int i = 0; i < nItems; i++)
 	{
-		item.mask = LVIF_PARAM;
+		EnsureGroupExistsInListView(groupIds[i]);
+
+		LVITEM item;
+		item.mask = LVIF_GROUPID;
 		item.iItem = i;
 		item.iSubItem = 0;
-		ListView_GetItem(m_hListView, &item);
-
-		iGroupId = DetermineItemGroup((int) item.lParam);
+		item.iGroupId = groupIds[i];
+		BOOL res = ListView_SetItem(m_hListView, &item);
 
-		InsertItemIntoGroup(i, iGroupId);
+		if (res)
+		{
+			ChangeGroupItemCount(groupIds[i], 1);
+			updatedGroups.insert(groupIds[i]);
+		}
 	}
 
+	UpdateGroupHeaders(updatedGroups);
+
 	SendMessage(m_hListView, WM_SETREDRAW, TRUE, NULL);
 }
 
@@ -894,7 +1153,7 @@ void ShellBrowser::InsertItemIntoGroup(int index, int groupId)
 
 void ShellBrowser::EnsureGroupExistsInListView(int groupId)
 {
-	ListViewGroup group = GetListViewGroupById(groupId);
+	const ListViewGroup &group = GetListViewGroupById(groupId);
 
 	if (group.numItems == 0)
 	{
@@ -934,20 +1193,39 @@ void ShellBrowser::UpdateGroupHeader(const ListViewGroup &listViewGroup)
 	ListView_SetGroupInfo(m_hListView, listViewGroup.id, &lvGroup);
 }
 
+void ShellBrowser::UpdateGroupHeaders(const std::unordered_set<int> &groupIds)
+{
+	for (int groupId : groupIds)
+	{
+		const ListViewGroup &group = GetListViewGroupById(groupId);
+
+		if (group.numItems > 0)
+		{
+			UpdateGroupHeader(group);
+		}
+	}
+}
+
 std::wstring ShellBrowser::GenerateGroupHeader(const ListViewGroup &listViewGroup)
 {
 	return listViewGroup.name + L" (" + std::to_wstring(listViewGroup.numItems) + L")";
 }
 
-void ShellBrowser::OnItemRemovedFromGroup(int groupId)
+// Updates the number of items in the group, without updating its header.
+const ShellBrowser::ListViewGroup &ShellBrowser::ChangeGroupItemCount(int groupId, int change)
 {
 	auto &groupIdIndex = m_listViewGroups.get<0>();
 	auto itr = groupIdIndex.find(groupId);
 	assert(itr != groupIdIndex.end());
 
-	auto updatedGroup = *itr;
-	updatedGroup.numItems--;
-	m_listViewGroups.replace(itr, updatedGroup);
+	groupIdIndex.modify(itr, [change](ListViewGroup &group) { group.numItems += change; });
+
+	return *itr;
+}
+
+void ShellBrowser::OnItemRemovedFromGroup(int groupId)
+{
+	const ListViewGroup &updatedGroup = ChangeGroupItemCount(groupId, -1);
 
 	if (updatedGroup.numItems == 0)
 	{
@@ -961,15 +1239,7 @@ void ShellBrowser::OnItemRemovedFromGroup(int groupId)
 
 void ShellBrowser::OnItemAddedToGroup(int groupId)
 {
-	auto &groupIdIndex = m_listViewGroups.get<0>();
-	auto itr = groupIdIndex.find(groupId);
-	assert(itr != groupIdIndex.end());
-
-	auto updatedGroup = *itr;
-	updatedGroup.numItems++;
-	m_listViewGroups.replace(itr, updatedGroup);
-
-	UpdateGroupHeader(updatedGroup);
+	UpdateGroupHeader(ChangeGroupItemCount(groupId, 1));
 }
 
 std::optional<int> ShellBrowser::GetItemGroupId(int index)
@@ -6,14 +6,128 @@
 #include "ShellBrowser.h"
 #include "ItemData.h"
 #include "ViewModes.h"
+#include "../Helper/ImageHelper.h"
+#include "../Helper/Logging.h"
+#include "../Helper/PixelKernels.h"
 #include "../Helper/ShellHelper.h"
+#include "../Helper/TaskExecutor.h"
+#include "../Helper/WindowHelper.h"
 #include <wil/com.h>
 #include <thumbcache.h>
+#include <algorithm>
 #include <list>
+#include <vector>
 
 #define THUMBNAIL_TYPE_ICON 0
 #define THUMBNAIL_TYPE_EXTRACTED 1
 
+namespace
+{
+	// Creating the thumbnail cache object is relatively expensive, so each worker thread creates a
+	// single instance and reuses it for every thumbnail it retrieves.
+	IThumbnailCache *GetWorkerThumbnailCache()
+	{
+		thread_local wil::com_ptr_nothrow<IThumbnailCache> thumbnailCache;
+
+		if (!thumbnailCache)
+		{
+			HRESULT hr = CoCreateInstance(CLSID_LocalThumbnailCache, nullptr, CLSCTX_INPROC_SERVER,
+				IID_PPV_ARGS(&thumbnailCache));
+
+			if (FAILED(hr))
+			{
+				return nullptr;
+			}
+
+			// The instance has to be released before COM is uninitialized on the thread.
+			TaskExecutor::AddThreadExitHandler([]() { thumbnailCache.reset(); });
+		}
+
+		return thumbnailCache.get();
+	}
+
+	// Copies a thumbnail into a 32bpp DIB, shrinking it (if necessary) so that it fits within the
+	// specified size. A thumbnail with an alpha channel is premultiplied, so that it can be drawn
+	// with AlphaBlend(). Every other thumbnail is made opaque.
+	wil::unique_hbitmap CreateThumbnailDIB(
+		HBITMAP thumbnail, WTS_ALPHATYPE alphaType, int maxWidth, int maxHeight)
+	{
+		BITMAP bm;
+
+		if (GetObject(thumbnail, sizeof(bm), &bm) == 0 || bm.bmWidth <= 0 || bm.bmHeight == 0)
+		{
+			return nullptr;
+		}
+
+		int sourceWidth = bm.bmWidth;
+		int sourceHeight = std::abs(bm.bmHeight);
+
+		// Both the source pixels and the destination DIB are bottom-up, so rows line up.
+		BITMAPINFO bmi;
+		ImageHelper::InitBitmapInfo(&bmi, sizeof(bmi), sourceWidth, sourceHeight, 32);
+
+		std::vector<std::uint32_t> sourcePixels(
+			static_cast<std::size_t>(sourceWidth) * sourceHeight);
+		wil::unique_hdc hdc(CreateCompatibleDC(nullptr));
+
+		if (!hdc
+			|| GetDIBits(hdc.get(), thumbnail, 0, sourceHeight, sourcePixels.data(), &bmi,
+				   DIB_RGB_COLORS)
+				!= sourceHeight)
+		{
+			return nullptr;
+		}
+
+		// The aspect ratio is preserved. Windows versions that ignore WTS_SCALETOREQUESTEDSIZE
+		// can return a thumbnail that's larger than requested.
+		SIZE size = { sourceWidth, sourceHeight };
+
+		if (sourceWidth > maxWidth || sourceHeight > maxHeight)
+		{
+			double scale = (std::min)(static_cast<double>(maxWidth) / sourceWidth,
+				static_cast<double>(maxHeight) / sourceHeight);
+			size.cx = (std::max)(static_cast<int>(sourceWidth * scale), 1);
+			size.cy = (std::max)(static_cast<int>(sourceHeight * scale), 1);
+		}
+
+		void *bits;
+		HBITMAP dib;
+
+		if (FAILED(ImageHelper::Create32BitHBITMAP(hdc.get(), &size, &bits, &dib)))
+		{
+			return nullptr;
+		}
+
+		ConstPixelBuffer source = { sourcePixels.data(), sourceWidth, sourceHeight, sourceWidth };
+		PixelBuffer destination = { static_cast<std::uint32_t *>(bits), size.cx, size.cy,
+			size.cx };
+
+		// When the sizes are the same, this is simply a copy.
+		PixelKernels::BoxDownscale(source, destination);
+
+		// Some thumbnail providers report an alpha channel that's entirely clear. Those
+		// thumbnails are treated as opaque, rather than being drawn as fully transparent.
+		if (alphaType == WTSAT_ARGB && PixelKernels::HasAlpha(destination))
+		{
+			PixelKernels::Premultiply(destination);
+		}
+		else
+		{
+			for (int y = 0; y < destination.height; y++)
+			{
+				std::uint32_t *row = destination.GetRow(y);
+
+				for (int x = 0; x < destination.width; x++)
+				{
+					row[x] |= 0xFF000000;
+				}
+			}
+		}
+
+		return wil::unique_hbitmap(dib);
+	}
+}
+
 void ShellBrowser::SetupThumbnailsView()
 {
 	HIMAGELIST himl;
@@ -34,17 +148,21 @@ void ShellBrowser::SetupThumbnailsView()
 
 	m_hListViewImageList = ListView_GetImageList(m_hListView, LVSIL_NORMAL);
 
-	himl = ImageList_Create(
-		THUMBNAIL_ITEM_WIDTH, THUMBNAIL_ITEM_HEIGHT, ILC_COLOR32, nItems, nItems + 100);
+	himl = CreateThumbnailImageList(nItems);
 	ListView_SetImageList(m_hListView, himl, LVSIL_NORMAL);
 
-	for (i = 0; i < nItems; i++)
+	ResetItemThumbnails();
+
+	if (!m_ownerDataListView)
 	{
-		lvItem.mask = LVIF_IMAGE;
-		lvItem.iItem = i;
-		lvItem.iSubItem = 0;
-		lvItem.iImage = I_IMAGECALLBACK;
-		ListView_SetItem(m_hListView, &lvItem);
+		for (i = 0; i < nItems; i++)
+		{
+			lvItem.mask = LVIF_IMAGE;
+			lvItem.iItem = i;
+			lvItem.iSubItem = 0;
+			lvItem.iImage = I_IMAGECALLBACK;
+			ListView_SetItem(m_hListView, &lvItem);
+		}
 	}
 
 	m_bThumbnailsSetup = TRUE;
@@ -59,16 +177,20 @@ void ShellBrowser::RemoveThumbnailsView()
 
 	nItems = ListView_GetItemCount(m_hListView);
 
-	m_thumbnailThreadPool.clear_queue();
-	m_thumbnailResults.clear();
+	ClearThumbnailTasks();
+
+	ResetItemThumbnails();
 
-	for (i = 0; i < nItems; i++)
+	if (!m_ownerDataListView)
 	{
-		lvItem.mask = LVIF_IMAGE;
-		lvItem.iItem = i;
-		lvItem.iSubItem = 0;
-		lvItem.iImage = I_IMAGECALLBACK;
-		ListView_SetItem(m_hListView, &lvItem);
+		for (i = 0; i < nItems; i++)
+		{
+			lvItem.mask = LVIF_IMAGE;
+			lvItem.iItem = i;
+			lvItem.iSubItem = 0;
+			lvItem.iImage = I_IMAGECALLBACK;
+			ListView_SetItem(m_hListView, &lvItem);
+		}
 	}
 
 	/* Destroy the thumbnails imagelist. */
@@ -79,50 +201,231 @@ void ShellBrowser::RemoveThumbnailsView()
 	m_bThumbnailsSetup = FALSE;
 }
 
+// Thumbnails are retrieved in order of distance from the visible area. Both the cache lookup and
+// the extraction (if the thumbnail isn't cached) happen in the background, so that a large folder
+// can be scrolled without waiting on the thumbnail cache.
 void ShellBrowser::QueueThumbnailTask(int internalIndex)
 {
+	if (m_queuedThumbnailTasks.count(internalIndex) > 0)
+	{
+		// The thumbnail has already been requested. The priority of the request will be updated
+		// the next time the listview is scrolled.
+		return;
+	}
+
 	int thumbnailResultID = m_thumbnailResultIDCounter++;
 
 	BasicItemInfo_t basicItemInfo = getBasicItemInfo(internalIndex);
 
-	auto result =
-		m_thumbnailThreadPool.push([this, thumbnailResultID, internalIndex, basicItemInfo](
-									   int id) -> std::optional<ThumbnailResult_t> {
-			UNREFERENCED_PARAMETER(id);
+	// std::function requires a copyable target, so the packaged_task is shared.
+	auto task = std::make_shared<std::packaged_task<ThumbnailResult_t()>>(
+		[resultBatcher = m_thumbnailResultBatcher, thumbnailResultID, internalIndex,
+			basicItemInfo]() {
+			ThumbnailResult_t result;
+			result.itemInternalIndex = internalIndex;
 
-			auto bitmap = GetThumbnail(
+			// If the thumbnail is already in the cache, it will be returned from there. Otherwise,
+			// it will be extracted (and added to the cache).
+			result.bitmap = GetThumbnail(
 				basicItemInfo.pidlComplete.get(), WTS_EXTRACT | WTS_SCALETOREQUESTEDSIZE);
 
-			if (!bitmap)
+			// Failed lookups are also reported, so that the item isn't requested again.
+			resultBatcher->AddResult(thumbnailResultID);
+
+			return result;
+		});
+	auto result = task->get_future();
+
+	int priority = 0;
+	auto index = LocateItemByInternalIndex(internalIndex);
+
+	if (index)
+	{
+		priority = CalculateThumbnailTaskPriority(*index, GetVisibleThumbnailRange());
+	}
+
+	m_thumbnailTaskScheduler.Queue(internalIndex, priority, [task]() { (*task)(); });
+
+	m_thumbnailResults.insert({ thumbnailResultID, std::move(result) });
+	m_queuedThumbnailTasks[internalIndex] = thumbnailResultID;
+}
+
+// In icon views (which include thumbnails view), LVM_GETTOPINDEX always returns 0 and
+// LVM_GETCOUNTPERPAGE returns the total number of items, so the visible range is instead
+// calculated from the scroll position and item spacing. That relies on the items being
+// auto-arranged in rows, in index order.
+ShellBrowser::VisibleItemRange ShellBrowser::GetVisibleThumbnailRange() const
+{
+	RECT clientRect;
+	GetClientRect(m_hListView, &clientRect);
+
+	DWORD spacing = ListView_GetItemSpacing(m_hListView, FALSE);
+	int itemWidth = std::max<int>(LOWORD(spacing), 1);
+	int itemHeight = std::max<int>(HIWORD(spacing), 1);
+
+	POINT origin;
+	ListView_GetOrigin(m_hListView, &origin);
+
+	int itemsPerRow = (std::max)(GetRectWidth(&clientRect) / itemWidth, 1);
+	int firstRow = std::max<int>(origin.y / itemHeight, 0);
+
+	// Partially visible rows at the top and bottom are included.
+	int numRows = GetRectHeight(&clientRect) / itemHeight + 2;
+
+	VisibleItemRange visibleRange;
+	visibleRange.firstIndex = firstRow * itemsPerRow;
+	visibleRange.numItems = numRows * itemsPerRow;
+
+	return visibleRange;
+}
+
+// Visible items have a priority of 0. Other items are ordered by their distance from the visible
+// area, with the items that lie in the direction the listview was last scrolled coming first.
+int ShellBrowser::CalculateThumbnailTaskPriority(
+	int index, const VisibleItemRange &visibleRange) const
+{
+	int distance =
+		CalculateColumnTaskPriority(index, visibleRange.firstIndex, visibleRange.numItems);
+
+	bool behind = (m_thumbnailScrollDirection > 0 && index < visibleRange.firstIndex)
+		|| (m_thumbnailScrollDirection < 0
+			&& index >= visibleRange.firstIndex + visibleRange.numItems);
+
+	if (behind)
+	{
+		distance += visibleRange.numItems;
+	}
+
+	return distance;
+}
+
+// Items within a page of the visible area are about to be (or have just been) shown, so there's
+// no point dropping their thumbnails.
+bool ShellBrowser::IsNearVisibleThumbnailRange(int index, const VisibleItemRange &visibleRange)
+{
+	int distance =
+		CalculateColumnTaskPriority(index, visibleRange.firstIndex, visibleRange.numItems);
+	return distance <= visibleRange.numItems;
+}
+
+// Called once the listview has been scrolled. Requests for items more than a page away from the
+// new visible area are dropped and the thumbnails for the next page (in the direction of the
+// scroll) are requested ahead of time.
+void ShellBrowser::RescheduleThumbnailTasks()
+{
+	if (m_folderSettings.viewMode != +ViewMode::Thumbnails)
+	{
+		return;
+	}
+
+	auto visibleRange = GetVisibleThumbnailRange();
+
+	if (visibleRange.firstIndex != m_lastFirstVisibleThumbnail)
+	{
+		m_thumbnailScrollDirection =
+			(visibleRange.firstIndex > m_lastFirstVisibleThumbnail) ? 1 : -1;
+		m_lastFirstVisibleThumbnail = visibleRange.firstIndex;
+	}
+
+	auto droppedTasks =
+		m_thumbnailTaskScheduler.Reprioritize([this, visibleRange](int internalIndex) {
+			auto index = LocateItemByInternalIndex(internalIndex);
+
+			if (!index)
 			{
-				return std::nullopt;
+				return std::optional<int>();
 			}
 
-			PostMessage(m_hListView, WM_APP_THUMBNAIL_RESULT_READY, thumbnailResultID, 0);
-
-			ThumbnailResult_t result;
-			result.itemInternalIndex = internalIndex;
-			result.bitmap = std::move(bitmap);
+			if (!IsNearVisibleThumbnailRange(*index, visibleRange))
+			{
+				return std::optional<int>();
+			}
 
-			return result;
+			return std::optional<int>(CalculateThumbnailTaskPriority(*index, visibleRange));
 		});
 
-	m_thumbnailResults.insert({ thumbnailResultID, std::move(result) });
+	for (int internalIndex : droppedTasks)
+	{
+		auto itr = m_queuedThumbnailTasks.find(internalIndex);
+
+		if (itr != m_queuedThumbnailTasks.end())
+		{
+			m_thumbnailResults.erase(itr->second);
+			m_queuedThumbnailTasks.erase(itr);
+		}
+
+		if (m_ownerDataListView)
+		{
+			// The thumbnail will be requested again the next time the item is drawn.
+			continue;
+		}
+
+		// The item will keep its current image, but resetting the image means the listview will
+		// ask for it (and the thumbnail will be requested again) once the item is next shown.
+		auto index = LocateItemByInternalIndex(internalIndex);
+
+		if (index)
+		{
+			LVITEM lvItem;
+			lvItem.mask = LVIF_IMAGE;
+			lvItem.iItem = *index;
+			lvItem.iSubItem = 0;
+			lvItem.iImage = I_IMAGECALLBACK;
+			ListView_SetItem(m_hListView, &lvItem);
+		}
+	}
+
+	PrefetchThumbnails(visibleRange);
 }
 
-std::optional<int> ShellBrowser::GetCachedThumbnailIndex(const ItemInfo_t &itemInfo)
+// Requests the thumbnails for the page of items beyond the visible area, in the direction the
+// listview is being scrolled, so that they're ready by the time they're shown.
+void ShellBrowser::PrefetchThumbnails(const VisibleItemRange &visibleRange)
 {
-	auto bitmap =
-		GetThumbnail(itemInfo.pidlComplete.get(), WTS_INCACHEONLY | WTS_SCALETOREQUESTEDSIZE);
+	int start;
+	int end;
 
-	if (!bitmap)
+	if (m_thumbnailScrollDirection > 0)
 	{
-		return std::nullopt;
+		start = visibleRange.firstIndex + visibleRange.numItems;
+		end = start + visibleRange.numItems;
 	}
+	else
+	{
+		end = visibleRange.firstIndex;
+		start = end - visibleRange.numItems;
+	}
+
+	start = (std::max)(start, 0);
+	end = (std::min)(end, ListView_GetItemCount(m_hListView));
+
+	for (int i = start; i < end; i++)
+	{
+		int internalIndex = GetItemInternalIndex(i);
+		const ItemInfo_t &itemInfo = m_itemInfoMap.at(internalIndex);
+
+		if (!itemInfo.thumbnailRetrieved)
+		{
+			QueueThumbnailTask(internalIndex);
+		}
+	}
+}
+
+void ShellBrowser::ClearThumbnailTasks()
+{
+	auto counters = m_thumbnailTaskScheduler.GetCounters();
+	LOG(debug) << L"ShellBrowser - Thumbnail tasks: " << counters.numQueued << L" queued, "
+			   << counters.numDropped << L" dropped, " << counters.numCompleted
+			   << L" completed, average latency " << counters.GetAverageLatency().count()
+			   << L"us, max latency " << counters.maxLatency.count() << L"us";
 
-	return GetExtractedThumbnail(bitmap.get());
+	m_thumbnailTaskScheduler.Clear();
+	m_thumbnailResults.clear();
+	m_queuedThumbnailTasks.clear();
+	m_thumbnailResultBatcher->Clear();
 }
 
+// Should only be called on one of the executor's worker threads (see GetWorkerThumbnailCache()).
 wil::unique_hbitmap ShellBrowser::GetThumbnail(PIDLIST_ABSOLUTE pidl, WTS_FLAGS flags)
 {
 	wil::com_ptr_nothrow<IShellItem> shellItem;
@@ -133,11 +436,9 @@ wil::unique_hbitmap ShellBrowser::GetThumbnail(PIDLIST_ABSOLUTE pidl, WTS_FLAGS
 		return nullptr;
 	}
 
-	wil::com_ptr_nothrow<IThumbnailCache> thumbnailCache;
-	hr = CoCreateInstance(
-		CLSID_LocalThumbnailCache, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&thumbnailCache));
+	IThumbnailCache *thumbnailCache = GetWorkerThumbnailCache();
 
-	if (FAILED(hr))
+	if (!thumbnailCache)
 	{
 		return nullptr;
 	}
@@ -159,10 +460,27 @@ wil::unique_hbitmap ShellBrowser::GetThumbnail(PIDLIST_ABSOLUTE pidl, WTS_FLAGS
 		return nullptr;
 	}
 
+	WTS_ALPHATYPE alphaType;
+	hr = sharedBitmap->GetFormat(&alphaType);
+
+	if (FAILED(hr))
+	{
+		alphaType = WTSAT_UNKNOWN;
+	}
+
 	// Note that the bitmap is copied here, since it's owned by the ISharedBitmap instance. As soon
-	// as that instance is destroyed, the bitmap will be destroyed.
-	return wil::unique_hbitmap(
-		reinterpret_cast<HBITMAP>(CopyImage(bitmap, IMAGE_BITMAP, 0, 0, LR_DEFAULTCOLOR)));
+	// as that instance is destroyed, the bitmap will be destroyed. The pixel work is done here,
+	// on the worker thread, so that the UI thread only has to blend the result.
+	return CreateThumbnailDIB(bitmap, alphaType, THUMBNAIL_ITEM_WIDTH, THUMBNAIL_ITEM_HEIGHT);
+}
+
+// As with column results, thumbnails are applied in batches, with redrawing disabled.
+void ShellBrowser::ProcessThumbnailResultBatch()
+{
+	SendMessage(m_hListView, WM_SETREDRAW, FALSE, NULL);
+	m_thumbnailResultBatcher->ProcessBatch(
+		[this](int thumbnailResultId) { ProcessThumbnailResult(thumbnailResultId); });
+	SendMessage(m_hListView, WM_SETREDRAW, TRUE, NULL);
 }
 
 void ShellBrowser::ProcessThumbnailResult(int thumbnailResultId)
@@ -174,50 +492,216 @@ void ShellBrowser::ProcessThumbnailResult(int thumbnailResultId)
 		return;
 	}
 
+	auto result = itr->second.get();
+	m_thumbnailResults.erase(itr);
+
+	auto queuedItr = m_queuedThumbnailTasks.find(result.itemInternalIndex);
+
+	if (queuedItr != m_queuedThumbnailTasks.end() && queuedItr->second == thumbnailResultId)
+	{
+		m_queuedThumbnailTasks.erase(queuedItr);
+	}
+
 	if (m_folderSettings.viewMode != +ViewMode::Thumbnails)
 	{
 		return;
 	}
 
-	auto result = itr->second.get();
+	auto itemItr = m_itemInfoMap.find(result.itemInternalIndex);
+
+	if (itemItr == m_itemInfoMap.end())
+	{
+		return;
+	}
 
-	if (!result)
+	itemItr->second.thumbnailRetrieved = true;
+
+	if (!result.bitmap)
 	{
-		// Thumbnail lookup failed.
+		// Thumbnail lookup failed. The item will continue to show its icon.
 		return;
 	}
 
-	int imageIndex = GetExtractedThumbnail(result->bitmap.get());
+	int imageIndex = GetExtractedThumbnail(result.itemInternalIndex, result.bitmap.get());
+	itemItr->second.thumbnailIndex = imageIndex;
 
-	auto index = LocateItemByInternalIndex(result->itemInternalIndex);
+	auto index = LocateItemByInternalIndex(result.itemInternalIndex);
 
 	if (!index)
 	{
 		return;
 	}
 
+	if (!m_ownerDataListView)
+	{
+		LVITEM lvItem;
+		lvItem.mask = LVIF_IMAGE;
+		lvItem.iItem = *index;
+		lvItem.iSubItem = 0;
+		lvItem.iImage = imageIndex;
+		ListView_SetItem(m_hListView, &lvItem);
+	}
+
+	// The thumbnail is normally drawn over the item's placeholder image, so the image index
+	// won't necessarily have changed.
+	RedrawItem(*index);
+}
+
+// Called whenever the thumbnail image list is created or destroyed, since any stored indexes
+// will no longer be valid.
+void ShellBrowser::ResetItemThumbnails()
+{
+	for (auto &item : m_itemInfoMap)
+	{
+		item.second.thumbnailIndex.reset();
+		item.second.thumbnailRetrieved = false;
+	}
+
+	ResetThumbnailSlots();
+
+	if (m_ownerDataListView)
+	{
+		InvalidateRect(m_hListView, nullptr, TRUE);
+	}
+}
+
+HIMAGELIST ShellBrowser::CreateThumbnailImageList(int numItems)
+{
+	// The image list will never need to hold more images than there are slots (unless the limit is
+	// exceeded because every image is in use), so there's no need to reserve space beyond that.
+	int initialSize = numItems;
+	auto capacity = static_cast<int>(GetThumbnailSlotCapacity());
+
+	if (capacity > 0)
+	{
+		initialSize = (std::min)(initialSize, capacity);
+	}
+
+	return ImageList_Create(
+		THUMBNAIL_ITEM_WIDTH, THUMBNAIL_ITEM_HEIGHT, ILC_COLOR32, initialSize, 100);
+}
+
+// Should be called whenever the thumbnail image list is recreated.
+void ShellBrowser::ResetThumbnailSlots()
+{
+	auto counters = m_thumbnailSlots.GetCounters();
+
+	if (counters.numSlots > 0)
+	{
+		LOG(debug) << L"ShellBrowser - Thumbnail slots: " << counters.numSlots << L" created ("
+				   << (GetThumbnailMemoryUsage() / 1024) << L"KB), " << counters.numEvictions
+				   << L" evicted, " << counters.numOverCapacity << L" over capacity";
+	}
+
+	m_thumbnailSlots.Clear();
+	m_thumbnailSlots.SetCapacity(GetThumbnailSlotCapacity());
+}
+
+std::size_t ShellBrowser::GetThumbnailSlotCapacity() const
+{
+	if (m_config->thumbnailMemoryLimit <= 0)
+	{
+		return 0;
+	}
+
+	std::size_t bytesPerThumbnail = THUMBNAIL_ITEM_WIDTH * THUMBNAIL_ITEM_HEIGHT * 4;
+	std::size_t limit = static_cast<std::size_t>(m_config->thumbnailMemoryLimit) * 1024 * 1024;
+
+	return std::max<std::size_t>(limit / bytesPerThumbnail, 1);
+}
+
+// Returns the image list index the thumbnail for the specified item should be drawn into. If the
+// item doesn't already have one, it may be taken from an item that's far from the visible area
+// and hasn't been shown recently.
+int ShellBrowser::AcquireThumbnailSlot(int internalIndex)
+{
+	// The visible range is only needed if an item has to be evicted.
+	std::optional<VisibleItemRange> visibleRange;
+
+	auto allocation = m_thumbnailSlots.Acquire(internalIndex, [this, &visibleRange](int key) {
+		auto index = LocateItemByInternalIndex(key);
+
+		if (!index)
+		{
+			return true;
+		}
+
+		if (!visibleRange)
+		{
+			visibleRange = GetVisibleThumbnailRange();
+		}
+
+		return !IsNearVisibleThumbnailRange(*index, *visibleRange);
+	});
+
+	if (allocation.evictedKey)
+	{
+		OnThumbnailSlotEvicted(*allocation.evictedKey);
+	}
+
+	return allocation.slot;
+}
+
+void ShellBrowser::OnThumbnailSlotEvicted(int internalIndex)
+{
+	auto itr = m_itemInfoMap.find(internalIndex);
+
+	if (itr == m_itemInfoMap.end())
+	{
+		return;
+	}
+
+	itr->second.thumbnailIndex.reset();
+	itr->second.thumbnailRetrieved = false;
+
+	if (m_ownerDataListView)
+	{
+		// The image is requested each time the item is drawn, so the thumbnail will be retrieved
+		// again once the item is scrolled back into view.
+		return;
+	}
+
+	auto index = LocateItemByInternalIndex(internalIndex);
+
+	if (!index)
+	{
+		return;
+	}
+
+	// The listview stores the image index, so it has to be told that the item's image is no
+	// longer valid.
 	LVITEM lvItem;
 	lvItem.mask = LVIF_IMAGE;
 	lvItem.iItem = *index;
 	lvItem.iSubItem = 0;
-	lvItem.iImage = imageIndex;
+	lvItem.iImage = I_IMAGECALLBACK;
 	ListView_SetItem(m_hListView, &lvItem);
 }
 
+LruSlotManagerCounters ShellBrowser::GetThumbnailSlotCounters() const
+{
+	return m_thumbnailSlots.GetCounters();
+}
+
+std::size_t ShellBrowser::GetThumbnailMemoryUsage() const
+{
+	return m_thumbnailSlots.GetCounters().numSlots * THUMBNAIL_ITEM_WIDTH * THUMBNAIL_ITEM_HEIGHT
+		* 4;
+}
+
 /* Draws a thumbnail based on an items icon. */
-int ShellBrowser::GetIconThumbnail(int iInternalIndex) const
+int ShellBrowser::GetIconThumbnail(int iInternalIndex)
 {
 	return GetThumbnailInternal(THUMBNAIL_TYPE_ICON, iInternalIndex, nullptr);
 }
 
 /* Draws an items extracted thumbnail. */
-int ShellBrowser::GetExtractedThumbnail(HBITMAP hThumbnailBitmap) const
+int ShellBrowser::GetExtractedThumbnail(int iInternalIndex, HBITMAP hThumbnailBitmap)
 {
-	return GetThumbnailInternal(THUMBNAIL_TYPE_EXTRACTED, 0, hThumbnailBitmap);
+	return GetThumbnailInternal(THUMBNAIL_TYPE_EXTRACTED, iInternalIndex, hThumbnailBitmap);
 }
 
-int ShellBrowser::GetThumbnailInternal(
-	int iType, int iInternalIndex, HBITMAP hThumbnailBitmap) const
+int ShellBrowser::GetThumbnailInternal(int iType, int iInternalIndex, HBITMAP hThumbnailBitmap)
 {
 	HDC hdc;
 	HDC hdcBacking;
@@ -257,9 +741,20 @@ int ShellBrowser::GetThumbnailInternal(
 	DeleteDC(hdcBacking);
 	ReleaseDC(m_hListView, hdc);
 
-	/* Add the new bitmap to the imagelist. */
+	/* Add the new bitmap to the imagelist. Slots are allocated in
+	order, so a slot is either an existing image (which is then
+	replaced) or the next image to be added. */
 	himl = ListView_GetImageList(m_hListView, LVSIL_NORMAL);
-	iImage = ImageList_Add(himl, hBackingBitmap, nullptr);
+	iImage = AcquireThumbnailSlot(iInternalIndex);
+
+	if (iImage < ImageList_GetImageCount(himl))
+	{
+		ImageList_Replace(himl, iImage, hBackingBitmap, nullptr);
+	}
+	else
+	{
+		iImage = ImageList_Add(himl, hBackingBitmap, nullptr);
+	}
 
 	/* Now delete the backing bitmap. */
 	DeleteObject(hBackingBitmap);
@@ -299,10 +794,13 @@ void ShellBrowser::DrawThumbnailInternal(HDC hdcBacking, HBITMAP hThumbnailBitma
 	GetObject(hThumbnailBitmap, sizeof(BITMAP), &bm);
 
 	/* Now, draw the thumbnail bitmap (in its centered position)
-	directly on top of the new bitmap. */
-	BitBlt(hdcBacking, (THUMBNAIL_ITEM_WIDTH - bm.bmWidth) / 2,
-		(THUMBNAIL_ITEM_HEIGHT - bm.bmHeight) / 2, THUMBNAIL_ITEM_WIDTH, THUMBNAIL_ITEM_HEIGHT,
-		hdcThumbnail, 0, 0, SRCCOPY);
+	directly on top of the new bitmap. The thumbnail is a premultiplied
+	32bpp DIB (see CreateThumbnailDIB()), so any transparent areas show
+	the background. */
+	BLENDFUNCTION blendFunction = { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA };
+	AlphaBlend(hdcBacking, (THUMBNAIL_ITEM_WIDTH - bm.bmWidth) / 2,
+		(THUMBNAIL_ITEM_HEIGHT - bm.bmHeight) / 2, bm.bmWidth, bm.bmHeight, hdcThumbnail, 0, 0,
+		bm.bmWidth, bm.bmHeight, blendFunction);
 
 	SelectObject(hdcThumbnail, hThumbnailBitmapOld);
 	DeleteDC(hdcThumbnail);
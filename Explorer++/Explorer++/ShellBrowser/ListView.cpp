@@ -132,11 +132,11 @@ LRESULT CALLBACK ShellBrowser::ListViewProc(HWND hwnd, UINT uMsg, WPARAM wParam,
 		break;
 
 	case WM_APP_COLUMN_RESULT_READY:
-		ProcessColumnResult(static_cast<int>(wParam));
+		ProcessColumnResultBatch();
 		break;
 
 	case WM_APP_THUMBNAIL_RESULT_READY:
-		ProcessThumbnailResult(static_cast<int>(wParam));
+		ProcessThumbnailResultBatch();
 		break;
 
 	case WM_APP_INFO_TIP_READY:
@@ -146,6 +146,22 @@ LRESULT CALLBACK ShellBrowser::ListViewProc(HWND hwnd, UINT uMsg, WPARAM wParam,
 	case WM_APP_SHELL_NOTIFY:
 		OnShellNotify(wParam, lParam);
 		break;
+
+	case WM_APP_ENUMERATION_BATCH_READY:
+		OnEnumerationBatchReady(static_cast<int>(wParam));
+		break;
+
+	case WM_APP_ENUMERATION_FAILED:
+		OnEnumerationFailed(static_cast<int>(wParam), static_cast<HRESULT>(lParam));
+		break;
+
+	case WM_APP_SORT_RESULT_READY:
+		OnSortResultReady(static_cast<int>(wParam));
+		break;
+
+	case WM_APP_GROUPING_RESULT_READY:
+		OnGroupingResultReady(static_cast<int>(wParam));
+		break;
 	}
 
 	return DefSubclassProc(hwnd, uMsg, wParam, lParam);
@@ -181,14 +197,18 @@ LRESULT CALLBACK ShellBrowser::ListViewParentProc(
 			case LVN_GETINFOTIP:
 				return OnListViewGetInfoTip(reinterpret_cast<NMLVGETINFOTIP *>(lParam));
 
-			case LVN_INSERTITEM:
-				OnListViewItemInserted(reinterpret_cast<NMLISTVIEW *>(lParam));
-				break;
-
 			case LVN_ITEMCHANGED:
 				OnListViewItemChanged(reinterpret_cast<NMLISTVIEW *>(lParam));
 				break;
 
+			case LVN_ODSTATECHANGED:
+				RecalculateSelectionInfo();
+				listViewSelectionChanged.m_signal();
+				break;
+
+			case LVN_ODFINDITEM:
+				return OnListViewFindItem(reinterpret_cast<NMLVFINDITEM *>(lParam));
+
 			case LVN_KEYDOWN:
 				OnListViewKeyDown(reinterpret_cast<NMLVKEYDOWN *>(lParam));
 				break;
@@ -196,6 +216,11 @@ LRESULT CALLBACK ShellBrowser::ListViewParentProc(
 			case LVN_COLUMNCLICK:
 				ColumnClicked(reinterpret_cast<NMLISTVIEW *>(lParam)->iSubItem);
 				break;
+
+			case LVN_ENDSCROLL:
+				RescheduleColumnTasks();
+				RescheduleThumbnailTasks();
+				break;
 			}
 		}
 		else if (reinterpret_cast<LPNMHDR>(lParam)->hwndFrom == ListView_GetHeader(m_hListView))
@@ -343,6 +368,12 @@ void ShellBrowser::OnListViewGetDisplayInfo(LPARAM lParam)
 	pnmv = (NMLVDISPINFO *) lParam;
 	plvItem = &pnmv->item;
 
+	if (m_ownerDataListView)
+	{
+		GetOwnerDataItemDisplayInfo(plvItem);
+		return;
+	}
+
 	int internalIndex = static_cast<int>(plvItem->lParam);
 
 	/* Construct an image here using the items
@@ -357,21 +388,26 @@ void ShellBrowser::OnListViewGetDisplayInfo(LPARAM lParam)
 	if (m_folderSettings.viewMode == +ViewMode::Thumbnails
 		&& (plvItem->mask & LVIF_IMAGE) == LVIF_IMAGE)
 	{
-		const ItemInfo_t &itemInfo = m_itemInfoMap.at(internalIndex);
-		auto cachedThumbnailIndex = GetCachedThumbnailIndex(itemInfo);
+		ItemInfo_t &itemInfo = m_itemInfoMap.at(internalIndex);
 
-		if (cachedThumbnailIndex)
+		// Retrieving a thumbnail can be slow, even when it's cached, so it's always done in the
+		// background.
+		if (!itemInfo.thumbnailIndex)
 		{
-			plvItem->iImage = *cachedThumbnailIndex;
+			itemInfo.thumbnailIndex = GetIconThumbnail(internalIndex);
 		}
 		else
 		{
-			plvItem->iImage = GetIconThumbnail(internalIndex);
+			m_thumbnailSlots.Touch(internalIndex);
 		}
 
+		plvItem->iImage = *itemInfo.thumbnailIndex;
 		plvItem->mask |= LVIF_DI_SETITEM;
 
-		QueueThumbnailTask(internalIndex);
+		if (!itemInfo.thumbnailRetrieved)
+		{
+			QueueThumbnailTask(internalIndex);
+		}
 
 		return;
 	}
@@ -432,6 +468,28 @@ void ShellBrowser::OnListViewGetDisplayInfo(LPARAM lParam)
 
 std::optional<int> ShellBrowser::GetCachedIconIndex(const ItemInfo_t &itemInfo)
 {
+	// As in IconFetcher::FindClassIconAsync(), class icons are only used for file system items.
+	// The icon of a virtual item (or a drive) is determined by the item itself, rather than by
+	// its type. The attributes of each item aren't stored, so the folder is checked instead.
+	bool canUseClassIcon = !m_directoryState.virtualFolder && !itemInfo.bDrive
+		&& !PathIsRoot(itemInfo.parsingName.c_str());
+
+	if (canUseClassIcon)
+	{
+		auto iconClass = m_cachedIcons->getIconClassRules().GetIconClass(itemInfo.parsingName,
+			WI_IsFlagSet(itemInfo.wfd.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY));
+
+		if (iconClass)
+		{
+			auto classIconIndex = m_cachedIcons->findByClass(*iconClass);
+
+			if (classIconIndex)
+			{
+				return classIconIndex;
+			}
+		}
+	}
+
 	auto cachedItr = m_cachedIcons->findByPath(itemInfo.parsingName);
 
 	if (cachedItr == m_cachedIcons->end())
@@ -451,6 +509,13 @@ void ShellBrowser::ProcessIconResult(int internalIndex, int iconIndex)
 		return;
 	}
 
+	if (m_ownerDataListView)
+	{
+		m_itemInfoMap.at(internalIndex).iconIndex = iconIndex;
+		RedrawItem(*index);
+		return;
+	}
+
 	LVITEM lvItem;
 	lvItem.mask = LVIF_IMAGE | LVIF_STATE;
 	lvItem.iItem = *index;
@@ -483,10 +548,8 @@ void ShellBrowser::QueueInfoTipTask(int internalIndex, const std::wstring &exist
 	bool virtualFolder = InVirtualFolder();
 
 	auto result =
-		m_infoTipsThreadPool.push([this, infoTipResultId, internalIndex, basicItemInfo, configCopy,
-									  virtualFolder, existingInfoTip](int id) {
-			UNREFERENCED_PARAMETER(id);
-
+		m_infoTipsTaskQueue->Push([this, infoTipResultId, internalIndex, basicItemInfo, configCopy,
+									  virtualFolder, existingInfoTip]() {
 			auto result = GetInfoTipAsync(m_hListView, infoTipResultId, internalIndex,
 				basicItemInfo, configCopy, m_hResourceModule, virtualFolder);
 
@@ -589,23 +652,24 @@ void ShellBrowser::ProcessInfoTipResult(int infoTipResultId)
 	ListView_SetInfoTip(m_hListView, &infoTip);
 }
 
-void ShellBrowser::OnListViewItemInserted(const NMLISTVIEW *itemData)
+void ShellBrowser::OnListViewItemChanged(const NMLISTVIEW *changeData)
 {
-	if (m_folderSettings.showInGroups)
+	if (changeData->uChanged != LVIF_STATE)
 	{
-		auto groupId = GetItemGroupId(itemData->iItem);
+		return;
+	}
 
-		if (groupId)
-		{
-			OnItemAddedToGroup(*groupId);
-		}
+	if (m_updatingOwnerDataItems || m_movingItem)
+	{
+		return;
 	}
-}
 
-void ShellBrowser::OnListViewItemChanged(const NMLISTVIEW *changeData)
-{
-	if (changeData->uChanged != LVIF_STATE)
+	// In owner data mode, a change that applies to every item (e.g. all items being deselected)
+	// is reported with an item index of -1.
+	if (m_ownerDataListView && changeData->iItem == -1)
 	{
+		RecalculateSelectionInfo();
+		listViewSelectionChanged.m_signal();
 		return;
 	}
 
@@ -640,7 +704,14 @@ void ShellBrowser::OnListViewItemChanged(const NMLISTVIEW *changeData)
 		}
 	}
 
-	UpdateFileSelectionInfo(static_cast<int>(changeData->lParam), currentlySelected);
+	int internalIndex = static_cast<int>(changeData->lParam);
+
+	if (m_ownerDataListView)
+	{
+		internalIndex = GetItemInternalIndex(changeData->iItem);
+	}
+
+	UpdateFileSelectionInfo(internalIndex, currentlySelected);
 
 	listViewSelectionChanged.m_signal();
 }
@@ -768,6 +839,11 @@ ShellBrowser::ItemInfo_t &ShellBrowser::GetItemByIndex(int index)
 
 int ShellBrowser::GetItemInternalIndex(int item) const
 {
+	if (m_ownerDataListView)
+	{
+		return m_directoryState.ownerDataItems.at(item);
+	}
+
 	LVITEM lvItem;
 	lvItem.mask = LVIF_PARAM;
 	lvItem.iItem = item;
@@ -784,7 +860,7 @@ int ShellBrowser::GetItemInternalIndex(int item) const
 
 void ShellBrowser::MarkItemAsCut(int item, bool cut)
 {
-	const auto &itemInfo = GetItemByIndex(item);
+	auto &itemInfo = GetItemByIndex(item);
 
 	// If the file is hidden, prevent changes to its visibility state.
 	if (WI_IsFlagSet(itemInfo.wfd.dwFileAttributes, FILE_ATTRIBUTE_HIDDEN))
@@ -792,6 +868,13 @@ void ShellBrowser::MarkItemAsCut(int item, bool cut)
 		return;
 	}
 
+	if (m_ownerDataListView)
+	{
+		itemInfo.cut = cut;
+		RedrawItem(item);
+		return;
+	}
+
 	if (cut)
 	{
 		ListView_SetItemState(m_hListView, item, LVIS_CUT, LVIS_CUT);
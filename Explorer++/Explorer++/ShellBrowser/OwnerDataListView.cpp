@@ -0,0 +1,496 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+// In owner data mode (LVS_OWNERDATA), the listview only stores the number of items, along with
+// the selection and focus state. Everything else is stored here and provided on request through
+// LVN_GETDISPINFO, which means the listview only ever asks for the items that are visible. That
+// allows folders containing a very large number of items to be shown quickly.
+
+#include "stdafx.h"
+#include "ShellBrowser.h"
+#include "Config.h"
+#include "ItemData.h"
+#include "ViewModes.h"
+#include "../Helper/IconFetcher.h"
+#include "../Helper/ShellHelper.h"
+#include <wil/common.h>
+#include <algorithm>
+#include <iterator>
+#include <string_view>
+
+void ShellBrowser::InsertAwaitingItemsOwnerData()
+{
+	std::vector<int> newItems;
+	newItems.reserve(m_directoryState.awaitingAddList.size());
+
+	std::optional<int> itemToRename;
+
+	for (const auto &awaitingItem : m_directoryState.awaitingAddList)
+	{
+		const auto &itemInfo = m_itemInfoMap.at(awaitingItem.iItemInternal);
+
+		if (IsFileFiltered(itemInfo))
+		{
+			m_directoryState.filteredItemsList.insert(awaitingItem.iItemInternal);
+			continue;
+		}
+
+		if (m_queuedRenameItem
+			&& ArePidlsEquivalent(itemInfo.pidlComplete.get(), m_queuedRenameItem.get()))
+		{
+			itemToRename = awaitingItem.iItemInternal;
+		}
+
+		ULARGE_INTEGER ulFileSize = { itemInfo.wfd.nFileSizeLow, itemInfo.wfd.nFileSizeHigh };
+		m_directoryState.totalDirSize.QuadPart += ulFileSize.QuadPart;
+
+		UpdateSortKeys(awaitingItem.iItemInternal);
+		newItems.push_back(awaitingItem.iItemInternal);
+	}
+
+	m_directoryState.awaitingAddList.clear();
+
+	const auto &existingItems = m_directoryState.ownerDataItems;
+	std::vector<int> items;
+	items.reserve(existingItems.size() + newItems.size());
+
+	if (IsBackgroundSortInProgress())
+	{
+		// The new items will be moved into position once the background sort has finished.
+		items = existingItems;
+		items.insert(items.end(), newItems.begin(), newItems.end());
+	}
+	else
+	{
+		// The existing items are already sorted, so only the new items need to be sorted, before
+		// being merged in. Note that any position requested for an item is ignored, since items
+		// can't be positioned in this mode.
+		auto compare = [this](int internalIndex1, int internalIndex2) {
+			return Sort(internalIndex1, internalIndex2) < 0;
+		};
+
+		std::stable_sort(newItems.begin(), newItems.end(), compare);
+
+		std::merge(existingItems.begin(), existingItems.end(), newItems.begin(), newItems.end(),
+			std::back_inserter(items), compare);
+	}
+
+	SetOwnerDataItems(std::move(items));
+
+	m_directoryState.numItems = static_cast<int>(m_directoryState.ownerDataItems.size());
+
+	PositionDroppedItems();
+
+	if (itemToRename)
+	{
+		m_queuedRenameItem.reset();
+
+		auto index = LocateItemByInternalIndex(*itemToRename);
+
+		if (index)
+		{
+			ListView_EditLabel(m_hListView, *index);
+		}
+	}
+}
+
+// Replaces the set of items shown in the listview. Since the listview tracks the selection and
+// focus by index, the selected and focused items are tracked by their internal index here and
+// restored at their new positions.
+void ShellBrowser::SetOwnerDataItems(std::vector<int> items)
+{
+	std::unordered_set<int> selectedItems;
+	int index = -1;
+
+	while ((index = ListView_GetNextItem(m_hListView, index, LVNI_SELECTED)) != -1)
+	{
+		selectedItems.insert(GetItemInternalIndex(index));
+	}
+
+	std::optional<int> focusedItem;
+	int focusedIndex = ListView_GetNextItem(m_hListView, -1, LVNI_FOCUSED);
+
+	if (focusedIndex != -1)
+	{
+		focusedItem = GetItemInternalIndex(focusedIndex);
+	}
+
+	bool restoreState = !selectedItems.empty() || focusedItem;
+
+	m_updatingOwnerDataItems = true;
+
+	if (restoreState)
+	{
+		ListView_SetItemState(m_hListView, -1, 0, LVIS_SELECTED | LVIS_FOCUSED);
+	}
+
+	m_directoryState.ownerDataItems = std::move(items);
+	InvalidateItemPositions();
+
+	int numItems = static_cast<int>(m_directoryState.ownerDataItems.size());
+	ListView_SetItemCountEx(m_hListView, numItems, LVSICF_NOSCROLL);
+
+	if (restoreState)
+	{
+		for (int i = 0; i < numItems; i++)
+		{
+			int internalIndex = m_directoryState.ownerDataItems[i];
+
+			if (selectedItems.count(internalIndex) > 0)
+			{
+				ListView_SetItemState(m_hListView, i, LVIS_SELECTED, LVIS_SELECTED);
+			}
+
+			if (focusedItem && internalIndex == *focusedItem)
+			{
+				ListView_SetItemState(m_hListView, i, LVIS_FOCUSED, LVIS_FOCUSED);
+			}
+		}
+	}
+
+	m_updatingOwnerDataItems = false;
+
+	if (!selectedItems.empty())
+	{
+		RecalculateSelectionInfo();
+		listViewSelectionChanged.m_signal();
+	}
+}
+
+void ShellBrowser::SortOwnerDataItems()
+{
+	std::vector<int> items = m_directoryState.ownerDataItems;
+
+	std::stable_sort(items.begin(), items.end(), [this](int internalIndex1, int internalIndex2) {
+		return Sort(internalIndex1, internalIndex2) < 0;
+	});
+
+	SetOwnerDataItems(std::move(items));
+}
+
+// When an item is deleted, the listview shifts the selection and focus state of the items after
+// it, so the item can be removed in place, without the state of every item having to be restored
+// (as it is in SetOwnerDataItems()).
+void ShellBrowser::RemoveOwnerDataItem(int index)
+{
+	bool selected = (ListView_GetItemState(m_hListView, index, LVIS_SELECTED) == LVIS_SELECTED);
+
+	m_updatingOwnerDataItems = true;
+
+	int internalIndex = m_directoryState.ownerDataItems[index];
+	m_directoryState.ownerDataItems.erase(m_directoryState.ownerDataItems.begin() + index);
+	ListView_DeleteItem(m_hListView, index);
+	OnItemPositionRemoved(internalIndex);
+
+	m_updatingOwnerDataItems = false;
+
+	if (selected)
+	{
+		RecalculateSelectionInfo();
+		listViewSelectionChanged.m_signal();
+	}
+}
+
+// Moving an item only changes the position of the items between its old and new positions, so
+// only the state of the items in that range is updated (and only that range is redrawn).
+void ShellBrowser::MoveOwnerDataItem(int index, int newIndex)
+{
+	int first = (std::min)(index, newIndex);
+	int last = (std::max)(index, newIndex);
+
+	std::vector<UINT> states;
+	states.reserve(last - first + 1);
+
+	for (int i = first; i <= last; i++)
+	{
+		states.push_back(ListView_GetItemState(m_hListView, i, LVIS_SELECTED | LVIS_FOCUSED));
+	}
+
+	auto &items = m_directoryState.ownerDataItems;
+	int internalIndex = items[index];
+
+	// The item and its state are moved to the other end of the range, with everything in between
+	// shifting by one.
+	if (index < newIndex)
+	{
+		std::rotate(items.begin() + first, items.begin() + first + 1, items.begin() + last + 1);
+		std::rotate(states.begin(), states.begin() + 1, states.end());
+	}
+	else
+	{
+		std::rotate(items.begin() + first, items.begin() + last, items.begin() + last + 1);
+		std::rotate(states.begin(), states.end() - 1, states.end());
+	}
+
+	OnItemPositionRemoved(internalIndex);
+	OnItemPositionInserted(newIndex, internalIndex);
+
+	// The set of selected items doesn't change, so there's no need to recalculate the selection
+	// info.
+	m_updatingOwnerDataItems = true;
+
+	for (int i = first; i <= last; i++)
+	{
+		UINT state = states[i - first];
+
+		if (ListView_GetItemState(m_hListView, i, LVIS_SELECTED | LVIS_FOCUSED) != state)
+		{
+			ListView_SetItemState(m_hListView, i, state, LVIS_SELECTED | LVIS_FOCUSED);
+		}
+	}
+
+	m_updatingOwnerDataItems = false;
+
+	ListView_RedrawItems(m_hListView, first, last);
+}
+
+void ShellBrowser::GetOwnerDataItemDisplayInfo(LVITEM *item)
+{
+	if (item->iItem < 0
+		|| item->iItem >= static_cast<int>(m_directoryState.ownerDataItems.size()))
+	{
+		return;
+	}
+
+	int internalIndex = GetItemInternalIndex(item->iItem);
+
+	if (WI_IsFlagSet(item->mask, LVIF_TEXT))
+	{
+		std::wstring text = GetOwnerDataItemText(internalIndex, item->iSubItem);
+		StringCchCopy(item->pszText, item->cchTextMax, text.c_str());
+	}
+
+	if (WI_IsFlagSet(item->mask, LVIF_IMAGE) && item->iSubItem == 0)
+	{
+		item->iImage = GetOwnerDataItemImage(internalIndex);
+	}
+
+	if (WI_IsFlagSet(item->mask, LVIF_STATE))
+	{
+		UINT state = GetOwnerDataItemState(item->iItem, m_itemInfoMap.at(internalIndex));
+		item->state = (item->state & ~item->stateMask) | (state & item->stateMask);
+	}
+
+	if (WI_IsFlagSet(item->mask, LVIF_COLUMNS) && m_folderSettings.viewMode == +ViewMode::Tiles
+		&& item->puColumns)
+	{
+		// These are the type and size columns (see SetTileViewItemInfo()).
+		item->cColumns = 2;
+		item->puColumns[0] = 1;
+		item->puColumns[1] = 2;
+	}
+}
+
+std::wstring ShellBrowser::GetOwnerDataItemText(int internalIndex, int subItem)
+{
+	if (m_folderSettings.viewMode == +ViewMode::Details)
+	{
+		auto columnType = GetColumnTypeByIndex(subItem);
+
+		if (columnType && *columnType != ColumnType::Name)
+		{
+			auto &itemInfo = m_itemInfoMap.at(internalIndex);
+			auto itr = itemInfo.columnText.find(*columnType);
+
+			if (itr == itemInfo.columnText.end())
+			{
+				// The empty entry indicates that the text has been requested, so that the column
+				// isn't queued again while the item is redrawn.
+				itemInfo.columnText.insert({ *columnType, std::nullopt });
+				QueueColumnTask(internalIndex, *columnType);
+
+				return L"";
+			}
+
+			return itr->second.value_or(L"");
+		}
+	}
+	else if (m_folderSettings.viewMode == +ViewMode::Tiles && subItem != 0)
+	{
+		return GetTileViewItemText(internalIndex, subItem);
+	}
+
+	BasicItemInfo_t basicItemInfo = getBasicItemInfo(internalIndex);
+	return ProcessItemFileName(basicItemInfo, m_config->globalFolderSettings);
+}
+
+int ShellBrowser::GetOwnerDataItemImage(int internalIndex)
+{
+	auto &itemInfo = m_itemInfoMap.at(internalIndex);
+
+	if (m_folderSettings.viewMode == +ViewMode::Thumbnails)
+	{
+		// Each thumbnail is added to the thumbnail image list, so the image is only generated
+		// once for each item, rather than each time the item is drawn.
+		if (!itemInfo.thumbnailIndex)
+		{
+			itemInfo.thumbnailIndex = GetIconThumbnail(internalIndex);
+		}
+		else
+		{
+			m_thumbnailSlots.Touch(internalIndex);
+		}
+
+		// If the request for the thumbnail was dropped (because the item was scrolled out of view),
+		// it will be made again here.
+		if (!itemInfo.thumbnailRetrieved)
+		{
+			QueueThumbnailTask(internalIndex);
+		}
+
+		return *itemInfo.thumbnailIndex;
+	}
+
+	if (!itemInfo.iconRequested)
+	{
+		itemInfo.iconRequested = true;
+
+		if (!itemInfo.iconIndex)
+		{
+			itemInfo.iconIndex = GetCachedIconIndex(itemInfo);
+		}
+
+		m_iconFetcher->QueueIconTask(
+			itemInfo.pidlComplete.get(), [this, internalIndex](int iconIndex) {
+				ProcessIconResult(internalIndex, iconIndex);
+			});
+	}
+
+	if (itemInfo.iconIndex)
+	{
+		// The upper eight bits contain the overlay index, which is returned as part of the item
+		// state instead.
+		return *itemInfo.iconIndex & 0x00FFFFFF;
+	}
+
+	if (WI_IsFlagSet(itemInfo.wfd.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY))
+	{
+		return m_iFolderIcon;
+	}
+
+	return m_iFileIcon;
+}
+
+UINT ShellBrowser::GetOwnerDataItemState(int index, const ItemInfo_t &itemInfo) const
+{
+	UINT state = 0;
+
+	// Hidden items are always ghosted.
+	if (itemInfo.cut || WI_IsFlagSet(itemInfo.wfd.dwFileAttributes, FILE_ATTRIBUTE_HIDDEN))
+	{
+		state |= LVIS_CUT;
+	}
+
+	if (itemInfo.iconIndex && m_folderSettings.viewMode != +ViewMode::Thumbnails)
+	{
+		state |= INDEXTOOVERLAYMASK(static_cast<UINT>(*itemInfo.iconIndex) >> 24);
+	}
+
+	// When checkboxes are shown, the check state simply mirrors the selection state.
+	if (m_config->checkBoxSelection)
+	{
+		bool selected = WI_IsFlagSet(
+			ListView_GetItemState(m_hListView, index, LVIS_SELECTED), LVIS_SELECTED);
+		state |= INDEXTOSTATEIMAGEMASK(selected ? 2 : 1);
+	}
+
+	return state;
+}
+
+// Handles the incremental search that's performed when the user types while the listview has
+// focus.
+int ShellBrowser::OnListViewFindItem(const NMLVFINDITEM *findItem) const
+{
+	if (WI_AreAllFlagsClear(findItem->lvfi.flags, LVFI_STRING | LVFI_PARTIAL)
+		|| !findItem->lvfi.psz)
+	{
+		return -1;
+	}
+
+	const auto &items = m_directoryState.ownerDataItems;
+	int numItems = static_cast<int>(items.size());
+
+	std::wstring_view searchText(findItem->lvfi.psz);
+	bool partial = WI_IsFlagSet(findItem->lvfi.flags, LVFI_PARTIAL);
+	bool wrap = WI_IsFlagSet(findItem->lvfi.flags, LVFI_WRAP);
+	int start = (std::max)(findItem->iStart, 0);
+
+	for (int i = 0; i < numItems; i++)
+	{
+		int index = start + i;
+
+		if (index >= numItems)
+		{
+			if (!wrap)
+			{
+				break;
+			}
+
+			index -= numItems;
+		}
+
+		// The display name is used here, rather than the text shown in the listview (which may
+		// have the extension removed), since it's available without any extra work.
+		const std::wstring &name = m_itemInfoMap.at(items[index]).displayName;
+
+		if (name.size() < searchText.size() || (!partial && name.size() != searchText.size()))
+		{
+			continue;
+		}
+
+		int length = static_cast<int>(searchText.size());
+
+		if (CompareString(LOCALE_USER_DEFAULT, NORM_IGNORECASE, name.c_str(), length,
+				searchText.data(), length)
+			== CSTR_EQUAL)
+		{
+			return index;
+		}
+	}
+
+	return -1;
+}
+
+// Recalculates the selection counts and size from scratch. This is used when the listview
+// reports a selection change that applies to a range of items, rather than to a single item.
+void ShellBrowser::RecalculateSelectionInfo()
+{
+	m_directoryState.numFilesSelected = 0;
+	m_directoryState.numFoldersSelected = 0;
+	m_directoryState.fileSelectionSize.QuadPart = 0;
+
+	int index = -1;
+
+	while ((index = ListView_GetNextItem(m_hListView, index, LVNI_SELECTED)) != -1)
+	{
+		UpdateFileSelectionInfo(GetItemInternalIndex(index), TRUE);
+	}
+}
+
+void ShellBrowser::RedrawItem(int index)
+{
+	ListView_RedrawItems(m_hListView, index, index);
+}
+
+// Called when pending column tasks are cancelled, so that the affected columns will be requested
+// again the next time they're shown.
+void ShellBrowser::ResetOwnerDataColumnRequests()
+{
+	for (auto &item : m_itemInfoMap)
+	{
+		auto &columnText = item.second.columnText;
+
+		for (auto itr = columnText.begin(); itr != columnText.end();)
+		{
+			if (!itr->second)
+			{
+				itr = columnText.erase(itr);
+			}
+			else
+			{
+				++itr;
+			}
+		}
+	}
+}
@@ -4,6 +4,7 @@
 
 #include "stdafx.h"
 #include "ShellBrowser.h"
+#include "ColorRuleSet.h"
 #include "Config.h"
 #include "CoreInterface.h"
 #include "DarkModeHelper.h"
@@ -23,11 +24,55 @@
 #include "../Helper/ListViewHelper.h"
 #include "../Helper/Macros.h"
 #include "../Helper/ShellHelper.h"
+#include <boost/container_hash/hash.hpp>
+#include <boost/range/adaptor/map.hpp>
 #include <wil/com.h>
 #include <list>
 
 void CALLBACK TimerProc(HWND hwnd, UINT uMsg, UINT_PTR idEvent, DWORD dwTime);
 
+namespace
+{
+	// Parsing names are compared case-insensitively, so that the key for an item will match
+	// regardless of the case used in the PIDL passed to a change notification.
+	std::wstring GetParsingNameKey(const std::wstring &parsingName)
+	{
+		std::wstring key = parsingName;
+		CharUpperBuff(key.data(), static_cast<DWORD>(key.size()));
+		return key;
+	}
+
+	// The pidl passed to a change notification will usually be byte-for-byte identical to the
+	// pidl stored for the item, in which case it can be found by hashing the pidl, without any
+	// calls into the shell.
+	std::size_t GetPidlKey(PCIDLIST_ABSOLUTE pidl)
+	{
+		auto *bytes = reinterpret_cast<const unsigned char *>(pidl);
+		return boost::hash_range(bytes, bytes + ILGetSize(pidl));
+	}
+
+	bool ArePidlsIdentical(PCIDLIST_ABSOLUTE pidl1, PCIDLIST_ABSOLUTE pidl2)
+	{
+		UINT size = ILGetSize(pidl1);
+		return size == ILGetSize(pidl2) && memcmp(pidl1, pidl2, size) == 0;
+	}
+
+	template <typename Key>
+	void RemoveIndexEntry(std::unordered_multimap<Key, int> &index, const Key &key,
+		int internalIndex)
+	{
+		auto range = index.equal_range(key);
+		auto itr = std::find_if(range.first, range.second, [internalIndex](const auto &entry) {
+			return entry.second == internalIndex;
+		});
+
+		if (itr != range.second)
+		{
+			index.erase(itr);
+		}
+	}
+}
+
 int ShellBrowser::listViewParentSubclassIdCounter = 0;
 
 /* IUnknown interface members. */
@@ -105,28 +150,61 @@ ShellBrowser::ShellBrowser(int id, HWND hOwner, IExplorerplusplus *coreInterface
 	m_hOwner(hOwner),
 	m_cachedIcons(coreInterface->GetCachedIcons()),
 	m_iconResourceLoader(coreInterface->GetIconResourceLoader()),
+	m_colorRuleSet(coreInterface->GetColorRuleSet()),
 	m_config(coreInterface->GetConfig()),
 	m_tabNavigation(tabNavigation),
 	m_fileActionHandler(fileActionHandler),
 	m_folderSettings(folderSettings),
+	m_ownerDataListView(
+		coreInterface->GetConfig()->ownerDataListView && !folderSettings.showInGroups),
+	m_updatingOwnerDataItems(false),
+	m_movingItem(false),
 	m_folderColumns(initialColumns
 			? *initialColumns
 			: coreInterface->GetConfig()->globalFolderSettings.folderColumns),
-	m_columnThreadPool(
-		1, std::bind(CoInitializeEx, nullptr, COINIT_APARTMENTTHREADED), CoUninitialize),
+	m_enumerationTaskQueue(coreInterface->GetTaskExecutor()->CreateQueue(
+		L"Enumeration", TaskPriorityClass::Interactive)),
+	m_enumerationIdCounter(0),
+	m_columnTaskScheduler(
+		coreInterface->GetTaskExecutor()->CreateQueue(L"Columns", TaskPriorityClass::Background)),
 	m_columnResultIDCounter(0),
-	m_thumbnailThreadPool(
-		1, std::bind(CoInitializeEx, nullptr, COINIT_APARTMENTTHREADED), CoUninitialize),
+	m_persistentItemCache(coreInterface->GetPersistentItemCache()),
+	m_columnValueCache(std::make_shared<ColumnValueCache>(m_persistentItemCache)),
+	m_thumbnailTaskScheduler(coreInterface->GetTaskExecutor()->CreateQueue(
+		L"Thumbnails", TaskPriorityClass::Background)),
 	m_thumbnailResultIDCounter(0),
-	m_infoTipsThreadPool(
-		1, std::bind(CoInitializeEx, nullptr, COINIT_APARTMENTTHREADED), CoUninitialize),
+	m_lastFirstVisibleThumbnail(0),
+	m_thumbnailScrollDirection(1),
+	m_thumbnailSlots(0),
+	m_infoTipsTaskQueue(coreInterface->GetTaskExecutor()->CreateQueue(
+		L"Info tips", TaskPriorityClass::Background)),
 	m_infoTipResultIDCounter(0),
-	m_rightClickDragAllowed(false)
+	m_sortTaskQueue(
+		coreInterface->GetTaskExecutor()->CreateQueue(L"Sort", TaskPriorityClass::Background)),
+	m_sortIdCounter(0),
+	m_rightClickDragAllowed(false),
+	m_groupIdCounter(0),
+	m_groupingTaskQueue(
+		coreInterface->GetTaskExecutor()->CreateQueue(L"Grouping", TaskPriorityClass::Background)),
+	m_groupingIdCounter(0)
 {
 	m_iRefCount = 1;
 
+	UpdateFilterExpression();
+
 	m_hListView = SetUpListView(hOwner);
-	m_iconFetcher = std::make_unique<IconFetcher>(m_hListView, m_cachedIcons);
+
+	// Results from the column and thumbnail tasks are delivered in batches (see
+	// ProcessColumnResultBatch() and ProcessThumbnailResultBatch()).
+	m_columnResultBatcher = std::make_shared<ResultBatcher<int>>(
+		[listView = m_hListView]() { PostMessage(listView, WM_APP_COLUMN_RESULT_READY, 0, 0); });
+	m_thumbnailResultBatcher = std::make_shared<ResultBatcher<int>>([listView = m_hListView]() {
+		PostMessage(listView, WM_APP_THUMBNAIL_RESULT_READY, 0, 0);
+	});
+
+	m_iconFetcher = std::make_unique<IconFetcher>(m_hListView, m_cachedIcons,
+		coreInterface->GetIconRequestCoalescer(), coreInterface->GetTaskExecutor(),
+		TaskPriorityClass::Background);
 	m_navigationController =
 		std::make_unique<ShellNavigationController>(this, tabNavigation, m_iconFetcher.get());
 
@@ -167,6 +245,8 @@ ShellBrowser::ShellBrowser(int id, HWND hOwner, IExplorerplusplus *coreInterface
 
 	m_connections.push_back(coreInterface->AddApplicationShuttingDownObserver(
 		std::bind(&ShellBrowser::OnApplicationShuttingDown, this)));
+	m_connections.push_back(m_colorRuleSet->AddRulesChangedObserver(
+		std::bind(&ShellBrowser::OnColorRulesChanged, this)));
 }
 
 ShellBrowser::~ShellBrowser()
@@ -180,9 +260,17 @@ ShellBrowser::~ShellBrowser()
 
 	DestroyWindow(m_hListView);
 
-	m_columnThreadPool.clear_queue();
-	m_thumbnailThreadPool.clear_queue();
-	m_infoTipsThreadPool.clear_queue();
+	CancelEnumeration();
+	m_enumerationTaskQueue->Clear();
+
+	m_columnTaskScheduler.Clear();
+	m_thumbnailTaskScheduler.Clear();
+	m_infoTipsTaskQueue->Clear();
+
+	CancelBackgroundSort();
+	m_sortTaskQueue->Clear();
+
+	CancelBackgroundGrouping();
 
 	/* Release the drag and drop helpers. */
 	m_pDropTargetHelper->Release();
@@ -199,16 +287,30 @@ HWND ShellBrowser::SetUpListView(HWND parent)
 	// can be set immediately when in dark mode. Without this style, ListView_GetHeader() will
 	// return NULL. The actual view mode set here doesn't matter, since it will be updated when
 	// navigating to a folder.
-	HWND hListView = CreateListView(parent,
-		WS_CHILD | WS_VISIBLE | WS_CLIPSIBLINGS | WS_CLIPCHILDREN | LVS_REPORT | LVS_EDITLABELS
-			| LVS_SHOWSELALWAYS | LVS_SHAREIMAGELISTS | LVS_AUTOARRANGE | WS_TABSTOP
-			| LVS_ALIGNTOP);
+	DWORD style = WS_CHILD | WS_VISIBLE | WS_CLIPSIBLINGS | WS_CLIPCHILDREN | LVS_REPORT
+		| LVS_EDITLABELS | LVS_SHOWSELALWAYS | LVS_SHAREIMAGELISTS | LVS_AUTOARRANGE | WS_TABSTOP
+		| LVS_ALIGNTOP;
+
+	if (m_ownerDataListView)
+	{
+		style |= LVS_OWNERDATA;
+	}
+
+	HWND hListView = CreateListView(parent, style);
 
 	if (hListView == nullptr)
 	{
 		return nullptr;
 	}
 
+	if (m_ownerDataListView)
+	{
+		// The cut state, overlay and checkbox state for each item are provided through
+		// LVN_GETDISPINFO.
+		ListView_SetCallbackMask(
+			hListView, LVIS_CUT | LVIS_OVERLAYMASK | LVIS_STATEIMAGEMASK);
+	}
+
 	auto dwExtendedStyle = ListView_GetExtendedListViewStyle(hListView);
 
 	if (m_config->useFullRowSelect)
@@ -410,8 +512,12 @@ void ShellBrowser::SetViewModeInternal(ViewMode viewMode)
 
 	if (viewMode != +ViewMode::Details)
 	{
-		m_columnThreadPool.clear_queue();
-		m_columnResults.clear();
+		ClearColumnTasks();
+
+		if (m_ownerDataListView)
+		{
+			ResetOwnerDataColumnRequests();
+		}
 	}
 
 	ViewMode previousViewMode = m_folderSettings.viewMode;
@@ -442,6 +548,14 @@ void ShellBrowser::SetViewModeInternal(ViewMode viewMode)
 
 void ShellBrowser::SetFirstColumnTextToCallback()
 {
+	// In owner data mode, the text for every item is always retrieved through LVN_GETDISPINFO, so
+	// the listview only needs to be redrawn.
+	if (m_ownerDataListView)
+	{
+		InvalidateRect(m_hListView, nullptr, TRUE);
+		return;
+	}
+
 	int numItems = ListView_GetItemCount(m_hListView);
 
 	for (int i = 0; i < numItems; i++)
@@ -452,6 +566,12 @@ void ShellBrowser::SetFirstColumnTextToCallback()
 
 void ShellBrowser::SetFirstColumnTextToFilename()
 {
+	if (m_ownerDataListView)
+	{
+		InvalidateRect(m_hListView, nullptr, TRUE);
+		return;
+	}
+
 	int numItems = ListView_GetItemCount(m_hListView);
 
 	for (int i = 0; i < numItems; i++)
@@ -517,6 +637,19 @@ int ShellBrowser::GetId() const
 	return m_ID;
 }
 
+// Called when the tab is selected or deselected, so that the work for the selected tab takes
+// priority over the work for every other tab. The enumeration queue isn't affected, since it's
+// always interactive.
+void ShellBrowser::SetTaskPriorityClass(TaskPriorityClass priorityClass)
+{
+	m_columnTaskScheduler.SetPriorityClass(priorityClass);
+	m_thumbnailTaskScheduler.SetPriorityClass(priorityClass);
+	m_infoTipsTaskQueue->SetPriorityClass(priorityClass);
+	m_sortTaskQueue->SetPriorityClass(priorityClass);
+	m_groupingTaskQueue->SetPriorityClass(priorityClass);
+	m_iconFetcher->SetPriorityClass(priorityClass);
+}
+
 void ShellBrowser::OnGridlinesSettingChanged()
 {
 	ListViewHelper::SetGridlines(m_hListView, m_config->globalFolderSettings.showGridlines);
@@ -552,6 +685,11 @@ std::wstring ShellBrowser::GetItemFullName(int index) const
 	return GetItemByIndex(index).parsingName;
 }
 
+std::optional<int> ShellBrowser::GetItemColorRuleIndex(int index) const
+{
+	return GetItemByIndex(index).colorRuleIndex;
+}
+
 std::wstring ShellBrowser::GetDirectory() const
 {
 	return m_directoryState.directory;
@@ -600,19 +738,16 @@ void ShellBrowser::SelectItems(const std::vector<PCIDLIST_ABSOLUTE> &pidls)
 
 int ShellBrowser::LocateFileItemIndex(const TCHAR *szFileName) const
 {
-	LV_FINDINFO lvFind;
-	int iItem;
-	int iInternalIndex;
-
-	iInternalIndex = LocateFileItemInternalIndex(szFileName);
+	int iInternalIndex = LocateFileItemInternalIndex(szFileName);
 
 	if (iInternalIndex != -1)
 	{
-		lvFind.flags = LVFI_PARAM;
-		lvFind.lParam = iInternalIndex;
-		iItem = ListView_FindItem(m_hListView, -1, &lvFind);
+		auto index = LocateItemByInternalIndex(iInternalIndex);
 
-		return iItem;
+		if (index)
+		{
+			return *index;
+		}
 	}
 
 	return -1;
@@ -620,13 +755,14 @@ int ShellBrowser::LocateFileItemIndex(const TCHAR *szFileName) const
 
 int ShellBrowser::LocateFileItemInternalIndex(const TCHAR *szFileName) const
 {
-	for (int i = 0; i < m_directoryState.numItems; i++)
-	{
-		const auto &item = GetItemByIndex(i);
+	auto range = m_directoryState.filenameIndex.equal_range(szFileName);
 
-		if (lstrcmp(item.wfd.cFileName, szFileName) == 0)
+	for (auto itr = range.first; itr != range.second; ++itr)
+	{
+		// Filtered items are still indexed, but aren't shown in the listview.
+		if (LocateItemByInternalIndex(itr->second))
 		{
-			return GetItemInternalIndex(i);
+			return itr->second;
 		}
 	}
 
@@ -647,6 +783,42 @@ std::optional<int> ShellBrowser::GetItemIndexForPidl(PCIDLIST_ABSOLUTE pidl) con
 
 std::optional<int> ShellBrowser::GetItemInternalIndexForPidl(PCIDLIST_ABSOLUTE pidl) const
 {
+	auto pidlRange = m_directoryState.pidlIndex.equal_range(GetPidlKey(pidl));
+
+	for (auto itr = pidlRange.first; itr != pidlRange.second; ++itr)
+	{
+		if (ArePidlsIdentical(pidl, m_itemInfoMap.at(itr->second).pidlComplete.get()))
+		{
+			return itr->second;
+		}
+	}
+
+	// The pidl may still refer to one of the items, even if it's not identical to the item's
+	// pidl (e.g. because the data cached in the pidl has changed), so the slower lookup by parsing
+	// name is used as a fallback.
+	std::wstring parsingName;
+	HRESULT hr = GetDisplayName(pidl, SHGDN_FORPARSING, parsingName);
+
+	if (SUCCEEDED(hr))
+	{
+		auto range = m_directoryState.parsingNameIndex.equal_range(GetParsingNameKey(parsingName));
+
+		for (auto itr = range.first; itr != range.second; ++itr)
+		{
+			if (ArePidlsEquivalent(pidl, m_itemInfoMap.at(itr->second).pidlComplete.get()))
+			{
+				return itr->second;
+			}
+		}
+
+		// Parsing names are stable for file system items, so there's no need to check every
+		// item. That's not necessarily the case for items in virtual folders.
+		if (!m_directoryState.virtualFolder)
+		{
+			return std::nullopt;
+		}
+	}
+
 	auto itr = std::find_if(m_itemInfoMap.begin(), m_itemInfoMap.end(), [pidl](const auto &pair) {
 		return ArePidlsEquivalent(pidl, pair.second.pidlComplete.get());
 	});
@@ -661,17 +833,98 @@ std::optional<int> ShellBrowser::GetItemInternalIndexForPidl(PCIDLIST_ABSOLUTE p
 
 std::optional<int> ShellBrowser::LocateItemByInternalIndex(int internalIndex) const
 {
-	LVFINDINFO lvfi;
-	lvfi.flags = LVFI_PARAM;
-	lvfi.lParam = internalIndex;
-	int item = ListView_FindItem(m_hListView, -1, &lvfi);
+	if (!m_directoryState.itemPositionsValid)
+	{
+		RebuildItemPositions();
+	}
+
+	auto position = m_directoryState.itemPositions.GetPosition(internalIndex);
 
-	if (item == -1)
+	if (!position)
 	{
 		return std::nullopt;
 	}
 
-	return item;
+	// The position is checked, in case the listview was changed without the index being
+	// updated.
+	if (*position >= ListView_GetItemCount(m_hListView)
+		|| GetItemInternalIndex(*position) != internalIndex)
+	{
+		RebuildItemPositions();
+
+		position = m_directoryState.itemPositions.GetPosition(internalIndex);
+	}
+
+	return position;
+}
+
+void ShellBrowser::AddItemToLookupIndexes(int internalIndex, const ItemInfo_t &itemInfo)
+{
+	m_directoryState.filenameIndex.insert({ itemInfo.wfd.cFileName, internalIndex });
+	m_directoryState.pidlIndex.insert(
+		{ GetPidlKey(itemInfo.pidlComplete.get()), internalIndex });
+	m_directoryState.parsingNameIndex.insert(
+		{ GetParsingNameKey(itemInfo.parsingName), internalIndex });
+}
+
+void ShellBrowser::RemoveItemFromLookupIndexes(int internalIndex, const ItemInfo_t &itemInfo)
+{
+	RemoveIndexEntry(m_directoryState.filenameIndex, std::wstring(itemInfo.wfd.cFileName),
+		internalIndex);
+	RemoveIndexEntry(m_directoryState.pidlIndex, GetPidlKey(itemInfo.pidlComplete.get()),
+		internalIndex);
+	RemoveIndexEntry(m_directoryState.parsingNameIndex, GetParsingNameKey(itemInfo.parsingName),
+		internalIndex);
+}
+
+void ShellBrowser::InvalidateItemPositions()
+{
+	m_directoryState.itemPositionsValid = false;
+}
+
+// Called after a single item has been inserted into the listview. If the index is going to be
+// rebuilt anyway, there's nothing to update.
+void ShellBrowser::OnItemPositionInserted(int index, int internalIndex)
+{
+	if (!m_directoryState.itemPositionsValid)
+	{
+		return;
+	}
+
+	m_directoryState.itemPositions.Insert(index, internalIndex);
+}
+
+void ShellBrowser::OnItemPositionRemoved(int internalIndex)
+{
+	if (!m_directoryState.itemPositionsValid)
+	{
+		return;
+	}
+
+	m_directoryState.itemPositions.Remove(internalIndex);
+}
+
+void ShellBrowser::RebuildItemPositions() const
+{
+	std::vector<int> items;
+
+	if (m_ownerDataListView)
+	{
+		items = m_directoryState.ownerDataItems;
+	}
+	else
+	{
+		int numItems = ListView_GetItemCount(m_hListView);
+		items.reserve(numItems);
+
+		for (int i = 0; i < numItems; i++)
+		{
+			items.push_back(GetItemInternalIndex(i));
+		}
+	}
+
+	m_directoryState.itemPositions.Assign(items);
+	m_directoryState.itemPositionsValid = true;
 }
 
 WIN32_FIND_DATA ShellBrowser::GetItemFileFindData(int index) const
@@ -747,8 +1000,9 @@ void ShellBrowser::PositionDroppedItems()
 	int iItem;
 
 	/* LVNI_TOLEFT and LVNI_TORIGHT cause exceptions
-	in details view. */
-	if (m_folderSettings.viewMode == +ViewMode::Details)
+	in details view. Items also can't be positioned in
+	owner data mode. */
+	if (m_folderSettings.viewMode == +ViewMode::Details || m_ownerDataListView)
 	{
 		m_droppedFileNameList.clear();
 		return;
@@ -927,48 +1181,91 @@ void ShellBrowser::PositionDroppedItems()
 	}
 }
 
-int ShellBrowser::DetermineItemSortedPosition(LPARAM lParam) const
+/* The item will always be inserted BEFORE
+the item at the returned position. For example,
+0 will place the item at 0 (and push 0 to 1).
+To place the item in the last position, the
+number of items is returned. */
+int ShellBrowser::DetermineItemSortedPosition(LPARAM lParam)
 {
-	LVITEM lvItem;
-	BOOL bItem;
-	int res = 1;
-	int nItems = 0;
-	int i = 0;
+	return FindSortedPosition(static_cast<int>(lParam), -1);
+}
 
-	nItems = ListView_GetItemCount(m_hListView);
+// Binary searches the items in the listview (which are kept in sorted order) for the position at
+// which the specified item should be placed. If ignoredIndex is set, the item at that index is
+// skipped over, with the returned position being the position the item should have once that
+// item is removed.
+int ShellBrowser::FindSortedPosition(int internalIndex, int ignoredIndex)
+{
+	UpdateSortKeys(internalIndex);
 
-	while (res > 0 && i < nItems)
+	// The item will be moved into position once the background sort has finished.
+	if (IsBackgroundSortInProgress())
 	{
-		lvItem.mask = LVIF_PARAM;
-		lvItem.iItem = i;
-		lvItem.iSubItem = 0;
-		bItem = ListView_GetItem(m_hListView, &lvItem);
+		return (ignoredIndex != -1) ? ignoredIndex : ListView_GetItemCount(m_hListView);
+	}
+
+	int numItems = ListView_GetItemCount(m_hListView);
+
+	if (ignoredIndex != -1)
+	{
+		numItems--;
+	}
+
+	int first = 0;
+	int count = numItems;
 
-		if (bItem)
+	while (count > 0)
+	{
+		int step = count / 2;
+		int mid = first + step;
+		int index = (ignoredIndex != -1 && mid >= ignoredIndex) ? mid + 1 : mid;
+
+		if (Sort(internalIndex, GetItemInternalIndex(index)) > 0)
 		{
-			res = Sort(static_cast<int>(lParam), static_cast<int>(lvItem.lParam));
+			first = mid + 1;
+			count -= step + 1;
 		}
 		else
 		{
-			res = 0;
+			count = step;
 		}
+	}
+
+	return first;
+}
 
-		i++;
+// Moves the item at the specified index into its sorted position, leaving every other item where
+// it is. Returns the new index of the item.
+int ShellBrowser::MoveItemToSortedPosition(int index)
+{
+	int internalIndex = GetItemInternalIndex(index);
+	int newIndex = FindSortedPosition(internalIndex, index);
+
+	if (newIndex == index)
+	{
+		return index;
 	}
 
-	/* The item will always be inserted BEFORE
-	the item at position i that we specify here.
-	For example, specifying 0, will place the item
-	at 0 (and push 0 to 1), specifying 1 will place
-	the item at 1 (and push 1 to 2).
-	Therefore, to place in the last position, need
-	to place AFTER last item. */
-	if ((i - 1) == nItems - 1 && res > 0)
+	if (m_ownerDataListView)
 	{
-		i++;
+		MoveOwnerDataItem(index, newIndex);
+		return newIndex;
 	}
 
-	return i - 1;
+	m_movingItem = true;
+	ListViewHelper::MoveItem(m_hListView, index, newIndex);
+	m_movingItem = false;
+
+	OnItemPositionRemoved(internalIndex);
+	OnItemPositionInserted(newIndex, internalIndex);
+
+	if (m_folderSettings.viewMode == +ViewMode::Tiles)
+	{
+		SetTileViewItemInfo(newIndex, internalIndex);
+	}
+
+	return newIndex;
 }
 
 int ShellBrowser::GetNumItems() const
@@ -1245,16 +1542,13 @@ void ShellBrowser::UpdateDriveIcon(const TCHAR *szDrive)
 	{
 		for (i = 0; i < m_directoryState.numItems; i++)
 		{
-			lvItem.mask = LVIF_PARAM;
-			lvItem.iItem = i;
-			lvItem.iSubItem = 0;
-			ListView_GetItem(m_hListView, &lvItem);
+			int internalIndex = GetItemInternalIndex(i);
 
 			if (ArePidlsEquivalent(
-					pidlDrive.get(), m_itemInfoMap.at((int) lvItem.lParam).pidlComplete.get()))
+					pidlDrive.get(), m_itemInfoMap.at(internalIndex).pidlComplete.get()))
 			{
 				iItem = i;
-				iItemInternal = (int) lvItem.lParam;
+				iItemInternal = internalIndex;
 
 				break;
 			}
@@ -1267,6 +1561,13 @@ void ShellBrowser::UpdateDriveIcon(const TCHAR *szDrive)
 
 		m_itemInfoMap.at(iItemInternal).displayName = displayName;
 
+		if (m_ownerDataListView)
+		{
+			m_itemInfoMap.at(iItemInternal).iconIndex = shfi.iIcon;
+			RedrawItem(iItem);
+			return;
+		}
+
 		/* Update the drives icon and display name. */
 		lvItem.mask = LVIF_TEXT | LVIF_IMAGE;
 		lvItem.iImage = shfi.iIcon;
@@ -1279,22 +1580,18 @@ void ShellBrowser::UpdateDriveIcon(const TCHAR *szDrive)
 
 void ShellBrowser::RemoveDrive(const TCHAR *szDrive)
 {
-	LVITEM lvItem;
 	int iItemInternal = -1;
 	int i = 0;
 
 	for (i = 0; i < m_directoryState.numItems; i++)
 	{
-		lvItem.mask = LVIF_PARAM;
-		lvItem.iItem = i;
-		lvItem.iSubItem = 0;
-		ListView_GetItem(m_hListView, &lvItem);
+		int internalIndex = GetItemInternalIndex(i);
 
-		if (m_itemInfoMap.at((int) lvItem.lParam).bDrive)
+		if (m_itemInfoMap.at(internalIndex).bDrive)
 		{
-			if (lstrcmp(szDrive, m_itemInfoMap.at((int) lvItem.lParam).szDrive) == 0)
+			if (lstrcmp(szDrive, m_itemInfoMap.at(internalIndex).szDrive) == 0)
 			{
-				iItemInternal = (int) lvItem.lParam;
+				iItemInternal = internalIndex;
 				break;
 			}
 		}
@@ -1504,4 +1801,22 @@ void ShellBrowser::OnApplicationShuttingDown()
 		// running, any clipboard objects will still be available.
 		OleFlushClipboard();
 	}
+}
+
+void ShellBrowser::UpdateItemColorRule(ItemInfo_t &itemInfo) const
+{
+	itemInfo.colorRuleIndex = m_colorRuleSet->GetMatchingRuleIndex(
+		PathFindFileName(itemInfo.parsingName.c_str()), itemInfo.wfd.dwFileAttributes);
+}
+
+void ShellBrowser::OnColorRulesChanged()
+{
+	// Any existing rule indexes refer to the previous set of rules, so every item (including
+	// those that are currently filtered out) needs to be matched again.
+	for (auto &itemInfo : m_itemInfoMap | boost::adaptors::map_values)
+	{
+		UpdateItemColorRule(itemInfo);
+	}
+
+	InvalidateRect(m_hListView, nullptr, FALSE);
 }
\ No newline at end of file
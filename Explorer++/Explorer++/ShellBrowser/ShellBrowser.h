@@ -5,16 +5,24 @@
 #pragma once
 
 #include "ColumnDataRetrieval.h"
+#include "ColumnValueCache.h"
 #include "Columns.h"
 #include "FolderSettings.h"
+#include "ItemData.h"
 #include "NavigatorInterface.h"
 #include "SignalWrapper.h"
 #include "SortModes.h"
 #include "ViewModes.h"
+#include "../Helper/DriveInfo.h"
 #include "../Helper/DropHandler.h"
+#include "../Helper/ItemPositionIndex.h"
+#include "../Helper/LruSlotManager.h"
 #include "../Helper/Macros.h"
+#include "../Helper/PriorityTaskScheduler.h"
+#include "../Helper/ResultBatcher.h"
 #include "../Helper/ShellHelper.h"
-#include "../ThirdParty/CTPL/cpl_stl.h"
+#include "../Helper/TaskExecutor.h"
+#include "../Helper/FilterExpression.h"
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index_container.hpp>
@@ -22,8 +30,10 @@
 #include <wil/com.h>
 #include <wil/resource.h>
 #include <thumbcache.h>
+#include <atomic>
 #include <future>
 #include <list>
+#include <mutex>
 #include <optional>
 #include <unordered_map>
 #include <unordered_set>
@@ -33,11 +43,15 @@
 
 struct BasicItemInfo_t;
 class CachedIcons;
+class ColorRuleSet;
 struct Config;
 class FileActionHandler;
+struct FileSystemItem;
 class IconFetcher;
 class IconResourceLoader;
 __interface IExplorerplusplus;
+class ItemSource;
+class PersistentItemCache;
 struct PreservedFolderState;
 struct PreservedHistoryEntry;
 class ShellNavigationController;
@@ -111,6 +125,10 @@ public:
 	int GetNumSelectedFiles() const;
 	int GetNumSelectedFolders() const;
 	int GetNumSelected() const;
+	PriorityTaskSchedulerCounters GetColumnTaskCounters() const;
+	LruSlotManagerCounters GetThumbnailSlotCounters() const;
+	std::size_t GetThumbnailMemoryUsage() const;
+	void SetTaskPriorityClass(TaskPriorityClass priorityClass);
 
 	/* ID. */
 	int GetId() const;
@@ -130,6 +148,7 @@ public:
 	std::wstring GetItemDisplayName(int index) const;
 	std::wstring GetItemEditingName(int index) const;
 	std::wstring GetItemFullName(int index) const;
+	std::optional<int> GetItemColorRuleIndex(int index) const;
 
 	void ShowPropertiesForSelectedFiles() const;
 
@@ -165,6 +184,7 @@ public:
 	BOOL GetShowInGroups() const;
 	void SetShowInGroups(BOOL bShowInGroups);
 	void SetShowInGroupsFlag(BOOL bShowInGroups);
+	bool IsOwnerDataListView() const;
 
 	int CALLBACK SortTemporary(LPARAM lParam1, LPARAM lParam2);
 
@@ -186,6 +206,34 @@ public:
 private:
 	DISALLOW_COPY_AND_ASSIGN(ShellBrowser);
 
+	// Values used when sorting by name, type, size or date. These are computed once for each item,
+	// so that comparing two items doesn't require any strings to be built. The keys are never
+	// modified once they've been built, which allows them to be shared with a background sort.
+	struct SortKeys
+	{
+		std::string name;
+		std::string displayName;
+
+		// Only set once the folder has been sorted by type, since retrieving the type of an item is
+		// comparatively expensive.
+		std::optional<std::string> type;
+
+		ULONGLONG size;
+		ULONGLONG creationTime;
+		ULONGLONG lastWriteTime;
+		ULONGLONG lastAccessTime;
+
+		bool isFolder;
+		bool isDrive;
+		bool isFindDataValid;
+
+		// The settings that affect the name keys. If any of these change, the keys will need to be
+		// rebuilt.
+		bool naturalSortOrder;
+		bool showExtensions;
+		bool hideLinkExtension;
+	};
+
 	struct ItemInfo_t
 	{
 		unique_pidl_absolute pidlComplete;
@@ -208,7 +256,40 @@ private:
 		when items need to be rearranged). */
 		int iRelativeSort;
 
-		ItemInfo_t() : wfd({}), isFindDataValid(false), iIcon(0), bDrive(FALSE)
+		// In thumbnails view, this is the image currently shown for the item. That will be an image
+		// based on the item's icon until the thumbnail has been retrieved.
+		std::optional<int> thumbnailIndex;
+		bool thumbnailRetrieved;
+
+		// The fields below are only used when the listview is in owner data mode. In that mode,
+		// the listview doesn't store any per-item data, so the icon, column text and cut state are
+		// stored here and provided whenever the listview requests them.
+		std::optional<int> iconIndex;
+		bool iconRequested;
+
+		// A column that has been requested, but whose result hasn't been received yet, will have
+		// an entry without a value.
+		std::unordered_map<ColumnType, std::optional<std::wstring>> columnText;
+
+		bool cut;
+
+		// Removed whenever the item is updated (e.g. when it's renamed), since the item is
+		// replaced with a new ItemInfo_t.
+		std::shared_ptr<const SortKeys> sortKeys;
+
+		// The index of the first color rule that matches the item. This is set whenever the item
+		// is added or updated, as well as whenever the color rules change, so that drawing the
+		// item doesn't require the rules to be evaluated.
+		std::optional<int> colorRuleIndex;
+
+		ItemInfo_t() :
+			wfd({}),
+			isFindDataValid(false),
+			iIcon(0),
+			bDrive(FALSE),
+			thumbnailRetrieved(false),
+			iconRequested(false),
+			cut(false)
 		{
 		}
 	};
@@ -261,12 +342,42 @@ private:
 		std::wstring columnText;
 	};
 
+	// Identifies the text for a single cell in details view. Only one task for each cell will be
+	// queued at any one time.
+	struct ColumnTaskKey
+	{
+		int itemInternalIndex;
+		ColumnType columnType;
+
+		bool operator==(const ColumnTaskKey &other) const
+		{
+			return itemInternalIndex == other.itemInternalIndex && columnType == other.columnType;
+		}
+	};
+
+	struct ColumnTaskKeyHash
+	{
+		std::size_t operator()(const ColumnTaskKey &key) const
+		{
+			return std::hash<int>()(key.itemInternalIndex)
+				^ (std::hash<int>()(static_cast<int>(key.columnType)) << 1);
+		}
+	};
+
+	// The bitmap will be empty if the thumbnail couldn't be retrieved.
 	struct ThumbnailResult_t
 	{
 		int itemInternalIndex;
 		wil::unique_hbitmap bitmap;
 	};
 
+	// The items shown in thumbnails view, including any partially visible rows.
+	struct VisibleItemRange
+	{
+		int firstIndex;
+		int numItems;
+	};
+
 	struct InfoTipResult
 	{
 		int itemInternalIndex;
@@ -296,15 +407,27 @@ private:
 		int relativeSortPosition;
 		int numItems;
 
-		ListViewGroup(int id, const GroupInfo &groupInfo) :
+		// These are computed when the group is created, so that comparing two groups doesn't
+		// require any string processing. Groups with a relative sort position of INT_MIN or
+		// INT_MAX are placed before (bucket -1) or after (bucket 1) all other groups.
+		int sortBucket;
+		std::string nameSortKey;
+
+		ListViewGroup(int id, const GroupInfo &groupInfo, std::string nameSortKey) :
 			id(id),
 			name(groupInfo.name),
 			relativeSortPosition(groupInfo.relativeSortPosition),
-			numItems(0)
+			numItems(0),
+			sortBucket(groupInfo.relativeSortPosition == INT_MIN
+					? -1
+					: (groupInfo.relativeSortPosition == INT_MAX ? 1 : 0)),
+			nameSortKey(std::move(nameSortKey))
 		{
 		}
 	};
 
+	struct GroupingContext;
+
 	enum class GroupByDateType
 	{
 		Created,
@@ -326,6 +449,26 @@ private:
 
 		std::unordered_set<int> filteredItemsList;
 
+		// In owner data mode, this stores the internal index of each item shown in the listview,
+		// in display order.
+		std::vector<int> ownerDataItems;
+
+		// Lookup indexes for the items in m_itemInfoMap, used so that items referenced by change
+		// notifications (or by name) can be found without scanning every item. The pidl index is
+		// keyed on a hash of the bytes that make up each item's pidl, while the parsing name
+		// index is keyed on the upper-cased parsing name of each item. Entries are added and
+		// removed alongside the corresponding entries in m_itemInfoMap.
+		std::unordered_multimap<std::wstring, int> filenameIndex;
+		std::unordered_multimap<std::size_t, int> pidlIndex;
+		std::unordered_multimap<std::wstring, int> parsingNameIndex;
+
+		// Tracks the position of each item in the listview. Items inserted into or removed from
+		// the listview are added to or removed from the index directly. When the items are
+		// reordered (e.g. when sorting), the index is instead rebuilt lazily the first time it's
+		// needed.
+		mutable ItemPositionIndex itemPositions;
+		mutable bool itemPositionsValid;
+
 		int numItems;
 		int numFilesSelected;
 		int numFoldersSelected;
@@ -337,9 +480,14 @@ private:
 
 		std::vector<ShellChangeNotification> shellChangeNotifications;
 
+		/* Items that should be selected once the folder has
+		been fully enumerated. */
+		std::vector<unique_pidl_absolute> pendingSelection;
+
 		DirectoryState() :
 			virtualFolder(false),
 			itemIDCounter(0),
+			itemPositionsValid(false),
 			numItems(0),
 			numFilesSelected(0),
 			numFoldersSelected(0),
@@ -349,6 +497,156 @@ private:
 		}
 	};
 
+	// The settings that determine the order of the items, captured so that the items can be
+	// sorted on a background thread.
+	struct SortOptions
+	{
+		SortMode sortMode;
+		bool sortAscending;
+		bool separateFolders;
+	};
+
+	struct SortState;
+
+	// Processes a range of the requests in a SortState on a background thread.
+	using BackgroundSortTask = void (*)(
+		HWND listView, SortState &sortState, size_t first, size_t last);
+
+	struct SortRecord
+	{
+		int internalIndex;
+
+		// Shared with the item, so that the keys don't have to be copied.
+		std::shared_ptr<const SortKeys> sortKeys;
+	};
+
+	// An item that didn't have current keys when the sort started. The keys for the item are
+	// built on a background thread, then stored back in the item once the sort has finished,
+	// provided the item's keys haven't been replaced in the meantime.
+	struct SortKeyRequest
+	{
+		size_t recordIndex;
+		int internalIndex;
+		BasicItemInfo_t basicItemInfo;
+		std::shared_ptr<const SortKeys> previousSortKeys;
+
+		// If the previous keys are current, only the type key needs to be added.
+		bool previousSortKeysCurrent;
+
+		std::shared_ptr<const SortKeys> sortKeys;
+	};
+
+	// Shared between the UI thread and the background threads that sort the items in a folder.
+	// The background threads build any keys that are missing, then sort the records and the UI
+	// thread applies the resulting order to the listview in a single step.
+	struct SortState
+	{
+		const int sortId;
+		const SortOptions options;
+		const GlobalFolderSettings globalFolderSettings;
+
+		// Used to retrieve the type of each item when sorting by type.
+		const std::shared_ptr<ColumnValueCache> columnValueCache;
+
+		std::vector<SortRecord> records;
+		std::vector<SortKeyRequest> keyRequests;
+
+		// Set when the column values needed to sort the items are being retrieved, rather than
+		// the items being sorted in the background. Once the values have been retrieved, the
+		// items are sorted on the UI thread.
+		std::optional<ColumnType> prefetchColumn;
+		std::vector<std::pair<int, BasicItemInfo_t>> prefetchItems;
+
+		// The number of background tasks that haven't finished yet. The last of those tasks to
+		// finish either sorts the records or, if values are being prefetched, notifies the UI
+		// thread.
+		std::atomic<size_t> numPendingTasks;
+
+		std::atomic<bool> cancelled;
+		std::atomic<bool> finished;
+
+		SortState(int sortId, const SortOptions &options,
+			const GlobalFolderSettings &globalFolderSettings,
+			std::shared_ptr<ColumnValueCache> columnValueCache) :
+			sortId(sortId),
+			options(options),
+			globalFolderSettings(globalFolderSettings),
+			columnValueCache(std::move(columnValueCache)),
+			numPendingTasks(0),
+			cancelled(false),
+			finished(false)
+		{
+		}
+	};
+
+	// Shared between the UI thread and the background tasks that determine the groups for a set of
+	// items. Once every task has finished, the UI thread moves each item into its group.
+	struct GroupingState
+	{
+		const int groupingId;
+		const std::shared_ptr<const GroupingContext> context;
+
+		std::vector<int> internalIndexes;
+		std::vector<BasicItemInfo_t> items;
+		std::vector<std::optional<GroupInfo>> groupInfos;
+
+		// The number of background tasks that haven't finished yet. The last of those tasks to
+		// finish notifies the UI thread.
+		std::atomic<size_t> numPendingTasks;
+
+		std::atomic<bool> cancelled;
+
+		GroupingState(int groupingId, std::shared_ptr<const GroupingContext> context) :
+			groupingId(groupingId),
+			context(std::move(context)),
+			numPendingTasks(0),
+			cancelled(false)
+		{
+		}
+	};
+
+	// Shared between the UI thread and the background thread that enumerates a folder. Items are
+	// accumulated by the background thread and handed to the UI thread in batches.
+	struct EnumerationState
+	{
+		const int enumerationId;
+		const unique_pidl_absolute pidlDirectory;
+		const SHCONTF enumFlags;
+		const bool isRecycleBin;
+
+		// When set, the items are read directly from the file system (using the parsing path in
+		// directory), rather than through the shell folder's enumerator.
+		const std::wstring directory;
+		const bool useItemSource;
+
+		std::atomic<bool> cancelled;
+		wil::unique_event_nothrow stateChanged;
+
+		// The members below are protected by the mutex.
+		std::mutex mutex;
+		std::vector<ItemInfo_t> pendingItems;
+		HRESULT result;
+		bool started;
+		bool finished;
+		bool batchPosted;
+
+		EnumerationState(int enumerationId, PCIDLIST_ABSOLUTE pidlDirectory, SHCONTF enumFlags,
+			bool isRecycleBin, const std::wstring &directory, bool useItemSource) :
+			enumerationId(enumerationId),
+			pidlDirectory(ILCloneFull(pidlDirectory)),
+			enumFlags(enumFlags),
+			isRecycleBin(isRecycleBin),
+			directory(directory),
+			useItemSource(useItemSource),
+			cancelled(false),
+			result(S_OK),
+			started(false),
+			finished(false),
+			batchPosted(false)
+		{
+		}
+	};
+
 	// clang-format off
 	using ListViewGroupSet = boost::multi_index_container<ListViewGroup,
 		boost::multi_index::indexed_by<
@@ -368,6 +666,10 @@ private:
 	static const UINT WM_APP_THUMBNAIL_RESULT_READY = WM_APP + 151;
 	static const UINT WM_APP_INFO_TIP_READY = WM_APP + 152;
 	static const UINT WM_APP_SHELL_NOTIFY = WM_APP + 153;
+	static const UINT WM_APP_ENUMERATION_BATCH_READY = WM_APP + 154;
+	static const UINT WM_APP_SORT_RESULT_READY = WM_APP + 155;
+	static const UINT WM_APP_GROUPING_RESULT_READY = WM_APP + 156;
+	static const UINT WM_APP_ENUMERATION_FAILED = WM_APP + 157;
 
 	static const int THUMBNAIL_ITEM_WIDTH = 120;
 	static const int THUMBNAIL_ITEM_HEIGHT = 120;
@@ -375,6 +677,21 @@ private:
 	static const UINT PROCESS_SHELL_CHANGES_TIMER_ID = 1;
 	static const UINT PROCESS_SHELL_CHANGES_TIMEOUT = 100;
 
+	// When navigating, the UI thread will wait up to this long (in milliseconds) for the folder to
+	// be enumerated. Any items that arrive after that will be streamed into the listview.
+	static const ULONGLONG ENUMERATION_INITIAL_TIMEOUT = 150;
+
+	// The maximum time (in milliseconds) the UI thread will wait for the enumeration task to
+	// start. If the workers are all busy, the folder is shown straight away and the items are
+	// streamed in once the task does start.
+	static const ULONGLONG ENUMERATION_START_TIMEOUT = 500;
+
+	// The minimum interval between batches of enumerated items being sent to the UI thread.
+	static const ULONGLONG ENUMERATION_BATCH_INTERVAL = 100;
+
+	// The maximum number of items read from an ItemSource at a time.
+	static const std::size_t ITEM_SOURCE_BATCH_SIZE = 512;
+
 	ShellBrowser(int id, HWND hOwner, IExplorerplusplus *coreInterface,
 		TabNavigationInterface *tabNavigation, FileActionHandler *fileActionHandler,
 		const std::vector<std::unique_ptr<PreservedHistoryEntry>> &history, int currentEntry,
@@ -395,6 +712,21 @@ private:
 
 	/* Browsing support. */
 	HRESULT EnumerateFolder(PCIDLIST_ABSOLUTE pidlDirectory, bool addHistoryEntry);
+	bool CanUseItemSource(PCIDLIST_ABSOLUTE pidlDirectory, SFGAOF attributes,
+		const std::wstring &parsingPath, bool isRecycleBin) const;
+	static void EnumerateFolderAsync(HWND listView, HWND owner, EnumerationState &state);
+	static void EnumerateFileSystemItems(HWND listView, EnumerationState &state,
+		IShellFolder *shellFolder, ItemSource &itemSource);
+	static void StartEnumeration(EnumerationState &state);
+	static void AddEnumeratedItem(
+		HWND listView, EnumerationState &state, ItemInfo_t itemInfo, ULONGLONG &lastBatchTime);
+	static void FinishEnumeration(HWND listView, EnumerationState &state, HRESULT result);
+	static HRESULT WaitForInitialEnumerationResults(EnumerationState &state);
+	bool TakeEnumeratedItems();
+	void OnEnumerationBatchReady(int enumerationId);
+	void OnEnumerationFailed(int folderId, HRESULT hr);
+	void CancelEnumeration();
+	bool IsEnumerationInProgress() const;
 	void PrepareToChangeFolders();
 	void ClearPendingResults();
 	void ResetFolderState();
@@ -406,6 +738,11 @@ private:
 	int AddItemInternal(int itemIndex, ItemInfo_t itemInfo, BOOL setPosition);
 	std::optional<ItemInfo_t> GetItemInformation(
 		IShellFolder *shellFolder, PCIDLIST_ABSOLUTE pidlDirectory, PCITEMID_CHILD pidlChild);
+	static std::optional<ItemInfo_t> GetItemInformation(IShellFolder *shellFolder,
+		PCIDLIST_ABSOLUTE pidlDirectory, PCITEMID_CHILD pidlChild, bool isRecycleBin);
+	static std::optional<ItemInfo_t> GetFileSystemItemInformation(
+		IShellFolder *shellFolder, const EnumerationState &state, const FileSystemItem &item);
+	static bool RequiresShellItemInformation(const WIN32_FIND_DATA &wfd);
 	static HRESULT ExtractFindDataUsingPropertyStore(
 		IShellFolder *shellFolder, PCITEMID_CHILD pidlChild, WIN32_FIND_DATA &output);
 	void SetViewModeInternal(ViewMode viewMode);
@@ -439,7 +776,6 @@ private:
 		int internalIndex, const BasicItemInfo_t &basicItemInfo, const Config &config,
 		HINSTANCE instance, bool virtualFolder);
 	void ProcessInfoTipResult(int infoTipResultId);
-	void OnListViewItemInserted(const NMLISTVIEW *itemData);
 	void OnListViewItemChanged(const NMLISTVIEW *changeData);
 	void UpdateFileSelectionInfo(int internalIndex, BOOL selected);
 	void OnListViewKeyDown(const NMLVKEYDOWN *lvKeyDown);
@@ -468,18 +804,61 @@ private:
 
 	/* Sorting. */
 	int CALLBACK Sort(int InternalIndex1, int InternalIndex2) const;
+	static std::optional<int> CompareSortKeyValues(
+		const SortKeys &sortKeys1, const SortKeys &sortKeys2, SortMode sortMode);
+	int SortUsingItemInfo(int InternalIndex1, int InternalIndex2) const;
+	static std::optional<ColumnType> GetCachedSortColumn(SortMode sortMode);
+	int SortUsingColumnValues(int internalIndex1, int internalIndex2, ColumnType columnType) const;
+	int SortUsingFileFacts(int internalIndex1, int internalIndex2, ColumnType columnType) const;
+	bool PrefetchSortColumnValues();
+	static void PrefetchColumnValuesAsync(
+		HWND listView, SortState &sortState, size_t first, size_t last);
+	void SortItemsDirectly();
+	void UpdateSortKeys(int internalIndex);
+	void UpdateAllSortKeys();
+	static std::shared_ptr<const SortKeys> BuildSortKeys(
+		const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings);
+	static std::shared_ptr<const SortKeys> AddTypeSortKey(const SortKeys &sortKeys,
+		int internalIndex, const BasicItemInfo_t &basicItemInfo,
+		ColumnValueCache &columnValueCache, const GlobalFolderSettings &globalFolderSettings);
+	bool AreSortKeysCurrent(const ItemInfo_t &itemInfo) const;
+	const SortKeys &GetSortKeysForComparison(
+		int internalIndex, std::shared_ptr<const SortKeys> &builtKeys) const;
+	bool CanSortInBackground() const;
+	void StartBackgroundSort();
+	SortOptions GetSortOptions() const;
+	void PushBackgroundSortTasks(const std::shared_ptr<SortState> &sortState, size_t numRequests,
+		size_t minRequestsPerTask, BackgroundSortTask task);
+	static void BuildSortKeysAsync(HWND listView, SortState &sortState, size_t first, size_t last);
+	static void SortItemsAsync(HWND listView, SortState &sortState);
+	bool IsBackgroundSortInProgress() const;
+	static int CompareSortRecords(
+		const SortRecord &record1, const SortRecord &record2, const SortOptions &options);
+	void CancelBackgroundSort();
+	void OnSortResultReady(int sortId);
+	void MergeAppendedItems(int firstAppendedItem);
+	void ApplyItemOrder(const std::vector<int> &sortedItems);
+	static int CALLBACK SortByRankStub(LPARAM lParam1, LPARAM lParam2, LPARAM lParamSort);
 
 	/* Listview column support. */
 	void SetUpListViewColumns();
 	void QueueColumnTask(int itemInternalIndex, ColumnType columnType);
-	static ColumnResult_t GetColumnTextAsync(HWND listView, int columnResultId,
-		ColumnType columnType, int internalIndex, const BasicItemInfo_t &basicItemInfo,
-		const GlobalFolderSettings &globalFolderSettings);
+	static int CalculateColumnTaskPriority(int index, int topIndex, int countPerPage);
+	void RescheduleColumnTasks();
+	void ClearColumnTasks();
+	void UpdateColumnConcurrencyLimit();
+	int GetColumnConcurrencyLimit(VolumeType volumeType) const;
+	static ColumnResult_t GetColumnTextAsync(ResultBatcher<int> &resultBatcher,
+		int columnResultId, ColumnType columnType, int internalIndex,
+		const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings,
+		ColumnValueCache &columnValueCache);
 	void InsertColumn(ColumnType columnType, int columnIndex, int width);
 	void SetActiveColumnSet();
+	void UpdateColumnValueCacheColumns();
 	void GetColumnInternal(ColumnType columnType, Column_t *pci) const;
 	Column_t GetFirstCheckedColumn();
 	void SaveColumnWidths();
+	void ProcessColumnResultBatch();
 	void ProcessColumnResult(int columnResultId);
 	std::optional<int> GetColumnIndexByType(ColumnType columnType) const;
 	std::optional<ColumnType> GetColumnTypeByIndex(int index) const;
@@ -508,16 +887,22 @@ private:
 	void RenameItem(int internalIndex, PCIDLIST_ABSOLUTE pidlNew);
 	void InvalidateAllColumnsForItem(int itemIndex);
 	void InvalidateIconForItem(int itemIndex);
-	int DetermineItemSortedPosition(LPARAM lParam) const;
+	int DetermineItemSortedPosition(LPARAM lParam);
+	int FindSortedPosition(int internalIndex, int ignoredIndex);
+	int MoveItemToSortedPosition(int index);
 
 	/* Filtering support. */
 	void UpdateFiltering();
 	void RemoveFilteredItems();
-	void RemoveFilteredItem(int iItem, int iItemInternal);
-	BOOL IsFilenameFiltered(const TCHAR *FileName) const;
+	void RemoveFilteredItem(int iItem);
+	void RemoveFilteredItemsAtIndexes(const std::vector<int> &indexes);
+	void RemoveFilteredItemsInBulk(const std::vector<int> &indexes);
+	BOOL IsFilenameFiltered(const ItemInfo_t &itemInfo) const;
+	void UpdateFilterExpression();
 	void UnfilterAllItems();
 	void UnfilterItem(int internalIndex);
 	void RestoreFilteredItem(int internalIndex);
+	void RestoreFilteredItems(const std::vector<int> &internalIndexes);
 	void ApplyFilteringBackgroundImage(bool apply);
 
 	/* Listview group support. */
@@ -525,17 +910,31 @@ private:
 	int GroupComparison(int id1, int id2);
 	int GroupNameComparison(const ListViewGroup &group1, const ListViewGroup &group2);
 	int GroupRelativePositionComparison(const ListViewGroup &group1, const ListViewGroup &group2);
-	const ListViewGroup GetListViewGroupById(int groupId);
+	const ListViewGroup &GetListViewGroupById(int groupId) const;
+	static bool DoesGroupingAccessItems(SortMode sortMode);
 	int DetermineItemGroup(int iItemInternal);
-	std::optional<GroupInfo> DetermineItemNameGroup(const BasicItemInfo_t &itemInfo) const;
-	std::optional<GroupInfo> DetermineItemSizeGroup(const BasicItemInfo_t &itemInfo) const;
-	std::optional<GroupInfo> DetermineItemTotalSizeGroup(const BasicItemInfo_t &itemInfo) const;
+	std::vector<int> DetermineItemGroups(const std::vector<int> &internalIndexes);
+	bool ShouldDetermineGroupsInBackground(size_t numItems) const;
+	void StartBackgroundGrouping(const std::vector<int> &internalIndexes);
+	void DetermineItemGroupsAsync(GroupingState &groupingState, size_t first, size_t last) const;
+	void OnGroupingResultReady(int groupingId);
+	void CancelBackgroundGrouping();
+	std::unique_ptr<GroupingContext> CreateGroupingContext() const;
+	std::optional<GroupInfo> DetermineItemGroupInfo(
+		const BasicItemInfo_t &itemInfo, const GroupingContext &context) const;
+	std::optional<GroupInfo> DetermineItemNameGroup(
+		const BasicItemInfo_t &itemInfo, const GroupingContext &context) const;
+	std::optional<GroupInfo> DetermineItemSizeGroup(
+		const BasicItemInfo_t &itemInfo, const GroupingContext &context) const;
+	std::optional<GroupInfo> DetermineItemTotalSizeGroup(
+		const BasicItemInfo_t &itemInfo, const GroupingContext &context) const;
 	std::optional<GroupInfo> DetermineItemTypeGroupVirtual(const BasicItemInfo_t &itemInfo) const;
-	std::optional<GroupInfo> DetermineItemDateGroup(
-		const BasicItemInfo_t &itemInfo, GroupByDateType dateType) const;
+	std::optional<GroupInfo> DetermineItemDateGroup(const BasicItemInfo_t &itemInfo,
+		GroupByDateType dateType, const GroupingContext &context) const;
 	std::optional<GroupInfo> DetermineItemSummaryGroup(const BasicItemInfo_t &itemInfo,
 		const SHCOLUMNID *pscid, const GlobalFolderSettings &globalFolderSettings) const;
-	std::optional<GroupInfo> DetermineItemFreeSpaceGroup(const BasicItemInfo_t &itemInfo) const;
+	std::optional<GroupInfo> DetermineItemFreeSpaceGroup(
+		const BasicItemInfo_t &itemInfo, const GroupingContext &context) const;
 	std::optional<GroupInfo> DetermineItemAttributeGroup(const BasicItemInfo_t &itemInfo) const;
 	std::optional<GroupInfo> DetermineItemOwnerGroup(const BasicItemInfo_t &itemInfo) const;
 	std::optional<GroupInfo> DetermineItemVersionGroup(
@@ -548,13 +947,17 @@ private:
 
 	/* Other grouping support. */
 	int GetOrCreateListViewGroup(const GroupInfo &groupInfo);
+	int GetOrCreateItemGroup(
+		const std::optional<GroupInfo> &groupInfo, const GroupingContext &context);
 	void MoveItemsIntoGroups();
 	void InsertItemIntoGroup(int index, int groupId);
 	void EnsureGroupExistsInListView(int groupId);
 	void InsertGroupIntoListView(const ListViewGroup &listViewGroup);
 	void RemoveGroupFromListView(const ListViewGroup &listViewGroup);
 	void UpdateGroupHeader(const ListViewGroup &listViewGroup);
+	void UpdateGroupHeaders(const std::unordered_set<int> &groupIds);
 	std::wstring GenerateGroupHeader(const ListViewGroup &listViewGroup);
+	const ListViewGroup &ChangeGroupItemCount(int groupId, int change);
 	void OnItemRemovedFromGroup(int groupId);
 	void OnItemAddedToGroup(int groupId);
 	std::optional<int> GetItemGroupId(int index);
@@ -565,14 +968,26 @@ private:
 
 	/* Thumbnails view. */
 	void QueueThumbnailTask(int internalIndex);
-	std::optional<int> GetCachedThumbnailIndex(const ItemInfo_t &itemInfo);
+	VisibleItemRange GetVisibleThumbnailRange() const;
+	int CalculateThumbnailTaskPriority(int index, const VisibleItemRange &visibleRange) const;
+	static bool IsNearVisibleThumbnailRange(int index, const VisibleItemRange &visibleRange);
+	void RescheduleThumbnailTasks();
+	void PrefetchThumbnails(const VisibleItemRange &visibleRange);
+	void ClearThumbnailTasks();
 	static wil::unique_hbitmap GetThumbnail(PIDLIST_ABSOLUTE pidl, WTS_FLAGS flags);
+	void ProcessThumbnailResultBatch();
 	void ProcessThumbnailResult(int thumbnailResultId);
 	void SetupThumbnailsView();
 	void RemoveThumbnailsView();
-	int GetIconThumbnail(int iInternalIndex) const;
-	int GetExtractedThumbnail(HBITMAP hThumbnailBitmap) const;
-	int GetThumbnailInternal(int iType, int iInternalIndex, HBITMAP hThumbnailBitmap) const;
+	void ResetItemThumbnails();
+	HIMAGELIST CreateThumbnailImageList(int numItems);
+	void ResetThumbnailSlots();
+	std::size_t GetThumbnailSlotCapacity() const;
+	int AcquireThumbnailSlot(int internalIndex);
+	void OnThumbnailSlotEvicted(int internalIndex);
+	int GetIconThumbnail(int iInternalIndex);
+	int GetExtractedThumbnail(int iInternalIndex, HBITMAP hThumbnailBitmap);
+	int GetThumbnailInternal(int iType, int iInternalIndex, HBITMAP hThumbnailBitmap);
 	void DrawIconThumbnailInternal(HDC hdcBacking, int iInternalIndex) const;
 	void DrawThumbnailInternal(HDC hdcBacking, HBITMAP hThumbnailBitmap) const;
 
@@ -581,6 +996,7 @@ private:
 	void DeleteTileViewColumns();
 	void SetTileViewInfo();
 	void SetTileViewItemInfo(int iItem, int iItemInternal);
+	std::wstring GetTileViewItemText(int iItemInternal, int column);
 
 	void UpdateCurrentClipboardObject(wil::com_ptr_nothrow<IDataObject> clipboardDataObject);
 	void OnClipboardUpdate();
@@ -597,14 +1013,39 @@ private:
 
 	void OnApplicationShuttingDown();
 
+	/* Color rules. */
+	void UpdateItemColorRule(ItemInfo_t &itemInfo) const;
+	void OnColorRulesChanged();
+
 	/* Miscellaneous. */
 	BOOL CompareVirtualFolders(UINT uFolderCSIDL) const;
 	int LocateFileItemInternalIndex(const TCHAR *szFileName) const;
 	std::optional<int> GetItemIndexForPidl(PCIDLIST_ABSOLUTE pidl) const;
 	std::optional<int> GetItemInternalIndexForPidl(PCIDLIST_ABSOLUTE pidl) const;
 	std::optional<int> LocateItemByInternalIndex(int internalIndex) const;
+	void AddItemToLookupIndexes(int internalIndex, const ItemInfo_t &itemInfo);
+	void RemoveItemFromLookupIndexes(int internalIndex, const ItemInfo_t &itemInfo);
+	void InvalidateItemPositions();
+	void OnItemPositionInserted(int index, int internalIndex);
+	void OnItemPositionRemoved(int internalIndex);
+	void RebuildItemPositions() const;
 	void ApplyHeaderSortArrow();
 
+	/* Owner data (virtual) listview support. */
+	void InsertAwaitingItemsOwnerData();
+	void SetOwnerDataItems(std::vector<int> items);
+	void SortOwnerDataItems();
+	void RemoveOwnerDataItem(int index);
+	void MoveOwnerDataItem(int index, int newIndex);
+	void GetOwnerDataItemDisplayInfo(LVITEM *item);
+	std::wstring GetOwnerDataItemText(int internalIndex, int subItem);
+	int GetOwnerDataItemImage(int internalIndex);
+	UINT GetOwnerDataItemState(int index, const ItemInfo_t &itemInfo) const;
+	int OnListViewFindItem(const NMLVFINDITEM *findItem) const;
+	void RecalculateSelectionInfo();
+	void RedrawItem(int index);
+	void ResetOwnerDataColumnRequests();
+
 	int m_iRefCount;
 
 	HWND m_hListView;
@@ -636,23 +1077,47 @@ private:
 	as display name. */
 	std::unordered_map<int, ItemInfo_t> m_itemInfoMap;
 
-	ctpl::thread_pool m_columnThreadPool;
+	// The tasks for each tab run on the shared executor. See SetTaskPriorityClass().
+	std::unique_ptr<TaskQueue> m_enumerationTaskQueue;
+	std::shared_ptr<EnumerationState> m_enumerationState;
+	int m_enumerationIdCounter;
+
+	PriorityTaskScheduler<ColumnTaskKey, ColumnTaskKeyHash> m_columnTaskScheduler;
 	std::unordered_map<int, std::future<ColumnResult_t>> m_columnResults;
+	std::unordered_map<ColumnTaskKey, int, ColumnTaskKeyHash> m_queuedColumnTasks;
 	int m_columnResultIDCounter;
+	std::shared_ptr<ResultBatcher<int>> m_columnResultBatcher;
+	PersistentItemCache *m_persistentItemCache;
+	std::shared_ptr<ColumnValueCache> m_columnValueCache;
 
 	std::unique_ptr<IconFetcher> m_iconFetcher;
 	CachedIcons *m_cachedIcons;
 
 	IconResourceLoader *m_iconResourceLoader;
+	ColorRuleSet *m_colorRuleSet;
 
-	ctpl::thread_pool m_thumbnailThreadPool;
-	std::unordered_map<int, std::future<std::optional<ThumbnailResult_t>>> m_thumbnailResults;
+	// Thumbnail tasks are keyed by the internal index of the item.
+	PriorityTaskScheduler<int> m_thumbnailTaskScheduler;
+	std::unordered_map<int, std::future<ThumbnailResult_t>> m_thumbnailResults;
+	std::unordered_map<int, int> m_queuedThumbnailTasks;
 	int m_thumbnailResultIDCounter;
+	std::shared_ptr<ResultBatcher<int>> m_thumbnailResultBatcher;
+	int m_lastFirstVisibleThumbnail;
+	int m_thumbnailScrollDirection;
+
+	// Each item shown in thumbnails view occupies one image in the thumbnail image list. Once the
+	// configured memory limit is reached, images belonging to items far from the visible area are
+	// reused.
+	LruSlotManager m_thumbnailSlots;
 
-	ctpl::thread_pool m_infoTipsThreadPool;
+	std::unique_ptr<TaskQueue> m_infoTipsTaskQueue;
 	std::unordered_map<int, std::future<std::optional<InfoTipResult>>> m_infoTipResults;
 	int m_infoTipResultIDCounter;
 
+	std::unique_ptr<TaskQueue> m_sortTaskQueue;
+	std::shared_ptr<SortState> m_sortState;
+	int m_sortIdCounter;
+
 	/* Internal state. */
 	const HINSTANCE m_hResourceModule;
 	BOOL m_bFolderVisited;
@@ -670,6 +1135,23 @@ private:
 	const Config *m_config;
 	FolderSettings m_folderSettings;
 
+	// The compiled form of the filter. This is rebuilt whenever the filter, or its case
+	// sensitivity, changes.
+	std::optional<FilterExpression> m_filterExpression;
+
+	// Whether the listview was created with LVS_OWNERDATA. This is fixed for the lifetime of the
+	// listview. Groups can't be shown in owner data mode, so a regular listview is used whenever
+	// the tab is initially shown in groups.
+	const bool m_ownerDataListView;
+
+	// Set while the set of items in an owner data listview is being replaced, so that the
+	// individual selection changes can be ignored.
+	bool m_updatingOwnerDataItems;
+
+	// Set while an item is being moved within the listview, so that the removal and
+	// re-insertion of the item aren't treated as changes to the selection or to the groups.
+	bool m_movingItem;
+
 	/* ID. */
 	const int m_ID;
 
@@ -729,4 +1211,14 @@ private:
 
 	ListViewGroupSet m_listViewGroups;
 	int m_groupIdCounter;
+
+	// When determining the groups requires the items to be accessed, the groups are determined in
+	// the background. The items aren't in any group (and so aren't shown) until then.
+	std::unique_ptr<TaskQueue> m_groupingTaskQueue;
+	std::unordered_map<int, std::shared_ptr<GroupingState>> m_groupingStates;
+	int m_groupingIdCounter;
+
+	// Maps each item whose group is being determined in the background to the ID of the most
+	// recent grouping request for it. Only the result of that request is applied.
+	std::unordered_map<int, int> m_pendingItemGroups;
 };
\ No newline at end of file
@@ -207,13 +207,13 @@ int SortByAttributes(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &it
 	return StrCmpLogicalW(attributeString1.c_str(), attributeString2.c_str());
 }
 
-int SortByRealSize(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2)
+int SortByRealSize(const FileFacts &fileFacts1, const FileFacts &fileFacts2)
 {
 	ULARGE_INTEGER realFileSize1;
-	bool res1 = GetRealSizeColumnRawData(itemInfo1, realFileSize1);
+	bool res1 = GetRealSizeColumnRawData(fileFacts1, realFileSize1);
 
 	ULARGE_INTEGER realFileSize2;
-	bool res2 = GetRealSizeColumnRawData(itemInfo2, realFileSize2);
+	bool res2 = GetRealSizeColumnRawData(fileFacts2, realFileSize2);
 
 	if (res1 && !res2)
 	{
@@ -240,31 +240,14 @@ int SortByRealSize(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &item
 	return 0;
 }
 
-int SortByShortName(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2)
+int SortByShortName(const FileFacts &fileFacts1, const FileFacts &fileFacts2)
 {
-	std::wstring shortName1 = GetShortNameColumnText(itemInfo1);
-	std::wstring shortName2 = GetShortNameColumnText(itemInfo2);
+	std::wstring shortName1 = GetShortNameColumnText(fileFacts1);
+	std::wstring shortName2 = GetShortNameColumnText(fileFacts2);
 
 	return StrCmpLogicalW(shortName1.c_str(), shortName2.c_str());
 }
 
-int SortByOwner(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2)
-{
-	std::wstring owner1 = GetOwnerColumnText(itemInfo1);
-	std::wstring owner2 = GetOwnerColumnText(itemInfo2);
-
-	return StrCmpLogicalW(owner1.c_str(), owner2.c_str());
-}
-
-int SortByVersionInfo(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	VersionInfoType versionInfoType)
-{
-	std::wstring versionInfo1 = GetVersionColumnText(itemInfo1, versionInfoType);
-	std::wstring versionInfo2 = GetVersionColumnText(itemInfo2, versionInfoType);
-
-	return StrCmpLogicalW(versionInfo1.c_str(), versionInfo2.c_str());
-}
-
 int SortByShortcutTo(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2)
 {
 	std::wstring resolvedLinkPath1 = GetShortcutToColumnText(itemInfo1);
@@ -273,10 +256,10 @@ int SortByShortcutTo(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &it
 	return StrCmpLogicalW(resolvedLinkPath1.c_str(), resolvedLinkPath2.c_str());
 }
 
-int SortByHardlinks(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2)
+int SortByHardlinks(const FileFacts &fileFacts1, const FileFacts &fileFacts2)
 {
-	DWORD numHardLinks1 = GetHardLinksColumnRawData(itemInfo1);
-	DWORD numHardLinks2 = GetHardLinksColumnRawData(itemInfo2);
+	DWORD numHardLinks1 = GetHardLinksColumnRawData(fileFacts1);
+	DWORD numHardLinks2 = GetHardLinksColumnRawData(fileFacts2);
 
 	return numHardLinks1 - numHardLinks2;
 }
@@ -289,44 +272,6 @@ int SortByExtension(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &ite
 	return StrCmpLogicalW(extension1.c_str(), extension2.c_str());
 }
 
-int SortByItemDetails(
-	const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, const SHCOLUMNID *pscid)
-{
-	VARIANT vt1;
-	HRESULT hr1 = GetItemDetailsRawData(itemInfo1, pscid, &vt1);
-
-	VARIANT vt2;
-	HRESULT hr2 = GetItemDetailsRawData(itemInfo2, pscid, &vt2);
-
-	int ret = 0;
-
-	if (SUCCEEDED(hr1) && SUCCEEDED(hr2) && vt1.vt == vt2.vt)
-	{
-		ret = VariantCompare(vt1, vt2);
-	}
-
-	if (SUCCEEDED(hr1))
-	{
-		VariantClear(&vt1);
-	}
-
-	if (SUCCEEDED(hr2))
-	{
-		VariantClear(&vt2);
-	}
-
-	return ret;
-}
-
-int SortByImageProperty(
-	const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, PROPID PropertyId)
-{
-	std::wstring imageProperty1 = GetImageColumnText(itemInfo1, PropertyId);
-	std::wstring imageProperty2 = GetImageColumnText(itemInfo2, PropertyId);
-
-	return StrCmpLogicalW(imageProperty1.c_str(), imageProperty2.c_str());
-}
-
 int SortByVirtualComments(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2)
 {
 	std::wstring comments1 = GetControlPanelCommentsColumnText(itemInfo1);
@@ -360,11 +305,25 @@ int SortByNetworkAdapterStatus(const BasicItemInfo_t &itemInfo1, const BasicItem
 	return StrCmpLogicalW(status1.c_str(), status2.c_str());
 }
 
-int SortByMediaMetadata(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	MediaMetadataType mediaMetadataType)
+int SortByColumnText(const ColumnValue &columnValue1, const ColumnValue &columnValue2)
 {
-	std::wstring mediaMetadata1 = GetMediaMetadataColumnText(itemInfo1, mediaMetadataType);
-	std::wstring mediaMetadata2 = GetMediaMetadataColumnText(itemInfo2, mediaMetadataType);
+	return StrCmpLogicalW(columnValue1.text.c_str(), columnValue2.text.c_str());
+}
+
+int SortByItemDetails(const ColumnValue &columnValue1, const ColumnValue &columnValue2)
+{
+	if (!columnValue1.rawData || !columnValue2.rawData)
+	{
+		return 0;
+	}
+
+	const VARIANT &vt1 = *columnValue1.rawData;
+	const VARIANT &vt2 = *columnValue2.rawData;
+
+	if (vt1.vt != vt2.vt)
+	{
+		return 0;
+	}
 
-	return StrCmpLogicalW(mediaMetadata1.c_str(), mediaMetadata2.c_str());
+	return VariantCompare(vt1, vt2);
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "ColumnDataRetrieval.h"
+#include "ColumnValueCache.h"
 #include "FolderSettings.h"
 #include "ItemData.h"
 
@@ -24,22 +25,15 @@ int SortByDate(
 int SortByTotalSize(
 	const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, bool TotalSize);
 int SortByAttributes(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByRealSize(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByShortName(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByOwner(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByVersionInfo(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	VersionInfoType versionInfoType);
+int SortByRealSize(const FileFacts &fileFacts1, const FileFacts &fileFacts2);
+int SortByShortName(const FileFacts &fileFacts1, const FileFacts &fileFacts2);
 int SortByShortcutTo(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByHardlinks(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
+int SortByHardlinks(const FileFacts &fileFacts1, const FileFacts &fileFacts2);
 int SortByExtension(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByItemDetails(
-	const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, const SHCOLUMNID *pscid);
-int SortByImageProperty(
-	const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, PROPID PropertyId);
 int SortByVirtualComments(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
 int SortByFileSystem(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
 int SortByPrinterProperty(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
 	PrinterInformationType printerInformationType);
 int SortByNetworkAdapterStatus(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByMediaMetadata(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	MediaMetadataType mediaMetadataType);
\ No newline at end of file
+int SortByColumnText(const ColumnValue &columnValue1, const ColumnValue &columnValue2);
+int SortByItemDetails(const ColumnValue &columnValue1, const ColumnValue &columnValue2);
\ No newline at end of file
@@ -8,13 +8,33 @@
 #include "SortHelper.h"
 #include "SortModes.h"
 #include "ViewModes.h"
+#include "../Helper/ParallelSort.h"
+#include "../Helper/SortKey.h"
+#include "../Helper/TimeHelper.h"
+#include <wil/common.h>
 #include <propkey.h>
+#include <algorithm>
 #include <cassert>
+#include <iterator>
+
+// Folders with fewer items than this are sorted directly on the UI thread, since they can be sorted
+// quickly enough that there's no benefit in using a background thread.
+const int BACKGROUND_SORT_MIN_ITEMS = 5000;
+
+// Each task that builds sort keys in the background should have at least this many keys to build.
+const size_t BACKGROUND_SORT_MIN_KEYS_PER_TASK = 256;
+
+// Retrieving a column value is much more expensive than building a set of keys, so the values are
+// split across tasks more finely.
+const size_t BACKGROUND_PREFETCH_MIN_ITEMS_PER_TASK = 16;
 
 void ShellBrowser::SortFolder(SortMode sortMode)
 {
 	m_folderSettings.sortMode = sortMode;
 
+	// Any sort still running in the background is now out of date.
+	CancelBackgroundSort();
+
 	if (m_folderSettings.showInGroups)
 	{
 		ListView_EnableGroupView(m_hListView, FALSE);
@@ -24,8 +44,17 @@ void ShellBrowser::SortFolder(SortMode sortMode)
 		SetShowInGroups(TRUE);
 	}
 
-	SendMessage(m_hListView, LVM_SORTITEMS, reinterpret_cast<WPARAM>(this),
-		reinterpret_cast<LPARAM>(SortStub));
+	if (CanSortInBackground())
+	{
+		// Any keys that are missing will be built as part of the background sort.
+		StartBackgroundSort();
+	}
+	else if (!PrefetchSortColumnValues())
+	{
+		// If any column values needed to be retrieved, the items will be sorted once that's
+		// finished.
+		SortItemsDirectly();
+	}
 
 	/* If in details view, the column sort
 	arrow will need to be changed to reflect
@@ -36,6 +65,26 @@ void ShellBrowser::SortFolder(SortMode sortMode)
 	}
 }
 
+// Sorts the items on the UI thread, which is only suitable when the sort can be carried out
+// without any expensive values needing to be retrieved.
+void ShellBrowser::SortItemsDirectly()
+{
+	// Keys for the new sort mode (or for any items that don't yet have keys) are built up front,
+	// so that every comparison made during the sort can use them.
+	UpdateAllSortKeys();
+
+	if (m_ownerDataListView)
+	{
+		SortOwnerDataItems();
+	}
+	else
+	{
+		SendMessage(m_hListView, LVM_SORTITEMS, reinterpret_cast<WPARAM>(this),
+			reinterpret_cast<LPARAM>(SortStub));
+		InvalidateItemPositions();
+	}
+}
+
 int CALLBACK ShellBrowser::SortStub(LPARAM lParam1, LPARAM lParam2, LPARAM lParamSort)
 {
 	auto *pShellBrowser = reinterpret_cast<ShellBrowser *>(lParamSort);
@@ -47,17 +96,19 @@ int CALLBACK ShellBrowser::Sort(int InternalIndex1, int InternalIndex2) const
 {
 	int comparisonResult = 0;
 
-	BasicItemInfo_t basicItemInfo1 = getBasicItemInfo(InternalIndex1);
-	BasicItemInfo_t basicItemInfo2 = getBasicItemInfo(InternalIndex2);
+	const ItemInfo_t &itemInfo1 = m_itemInfoMap.at(InternalIndex1);
+	const ItemInfo_t &itemInfo2 = m_itemInfoMap.at(InternalIndex2);
 
-	bool isFolder1 = ((basicItemInfo1.wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-						 == FILE_ATTRIBUTE_DIRECTORY)
-		? true
-		: false;
-	bool isFolder2 = ((basicItemInfo2.wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-						 == FILE_ATTRIBUTE_DIRECTORY)
-		? true
-		: false;
+	// Every comparison made during a sort has to use the same ordering (natural or plain), so
+	// items are always compared using keys, even if that means building temporary keys for an
+	// item.
+	std::shared_ptr<const SortKeys> builtSortKeys1;
+	std::shared_ptr<const SortKeys> builtSortKeys2;
+	const SortKeys &sortKeys1 = GetSortKeysForComparison(InternalIndex1, builtSortKeys1);
+	const SortKeys &sortKeys2 = GetSortKeysForComparison(InternalIndex2, builtSortKeys2);
+
+	bool isFolder1 = WI_IsFlagSet(itemInfo1.wfd.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY);
+	bool isFolder2 = WI_IsFlagSet(itemInfo2.wfd.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY);
 
 	/* Folders will by default be sorted separately from files,
 	except in the recycle bin. */
@@ -73,299 +124,16 @@ int CALLBACK ShellBrowser::Sort(int InternalIndex1, int InternalIndex2) const
 	}
 	else
 	{
-		switch (m_folderSettings.sortMode)
+		auto keyComparisonResult =
+			CompareSortKeyValues(sortKeys1, sortKeys2, m_folderSettings.sortMode);
+
+		if (keyComparisonResult)
+		{
+			comparisonResult = *keyComparisonResult;
+		}
+		else
 		{
-		case SortMode::Name:
-			comparisonResult =
-				SortByName(basicItemInfo1, basicItemInfo2, m_config->globalFolderSettings);
-			break;
-
-		case SortMode::Type:
-			comparisonResult = SortByType(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::Size:
-			comparisonResult = SortBySize(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::DateModified:
-			comparisonResult = SortByDate(basicItemInfo1, basicItemInfo2, DateType::Modified);
-			break;
-
-		case SortMode::TotalSize:
-			comparisonResult = SortByTotalSize(basicItemInfo1, basicItemInfo2, TRUE);
-			break;
-
-		case SortMode::FreeSpace:
-			comparisonResult = SortByTotalSize(basicItemInfo1, basicItemInfo2, FALSE);
-			break;
-
-		case SortMode::DateDeleted:
-			comparisonResult =
-				SortByItemDetails(basicItemInfo1, basicItemInfo2, &SCID_DATE_DELETED);
-			break;
-
-		case SortMode::OriginalLocation:
-			comparisonResult =
-				SortByItemDetails(basicItemInfo1, basicItemInfo2, &SCID_ORIGINAL_LOCATION);
-			break;
-
-		case SortMode::Attributes:
-			comparisonResult = SortByAttributes(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::RealSize:
-			comparisonResult = SortByRealSize(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::ShortName:
-			comparisonResult = SortByShortName(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::Owner:
-			comparisonResult = SortByOwner(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::ProductName:
-			comparisonResult =
-				SortByVersionInfo(basicItemInfo1, basicItemInfo2, VersionInfoType::ProductName);
-			break;
-
-		case SortMode::Company:
-			comparisonResult =
-				SortByVersionInfo(basicItemInfo1, basicItemInfo2, VersionInfoType::Company);
-			break;
-
-		case SortMode::Description:
-			comparisonResult =
-				SortByVersionInfo(basicItemInfo1, basicItemInfo2, VersionInfoType::Description);
-			break;
-
-		case SortMode::FileVersion:
-			comparisonResult =
-				SortByVersionInfo(basicItemInfo1, basicItemInfo2, VersionInfoType::FileVersion);
-			break;
-
-		case SortMode::ProductVersion:
-			comparisonResult =
-				SortByVersionInfo(basicItemInfo1, basicItemInfo2, VersionInfoType::ProductVersion);
-			break;
-
-		case SortMode::ShortcutTo:
-			comparisonResult = SortByShortcutTo(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::HardLinks:
-			comparisonResult = SortByHardlinks(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::Extension:
-			comparisonResult = SortByExtension(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::Created:
-			comparisonResult = SortByDate(basicItemInfo1, basicItemInfo2, DateType::Created);
-			break;
-
-		case SortMode::Accessed:
-			comparisonResult = SortByDate(basicItemInfo1, basicItemInfo2, DateType::Accessed);
-			break;
-
-		case SortMode::Title:
-			comparisonResult = SortByItemDetails(basicItemInfo1, basicItemInfo2, &PKEY_Title);
-			break;
-
-		case SortMode::Subject:
-			comparisonResult = SortByItemDetails(basicItemInfo1, basicItemInfo2, &PKEY_Subject);
-			break;
-
-		case SortMode::Authors:
-			comparisonResult = SortByItemDetails(basicItemInfo1, basicItemInfo2, &PKEY_Author);
-			break;
-
-		case SortMode::Keywords:
-			comparisonResult = SortByItemDetails(basicItemInfo1, basicItemInfo2, &PKEY_Keywords);
-			break;
-
-		case SortMode::Comments:
-			comparisonResult = SortByItemDetails(basicItemInfo1, basicItemInfo2, &PKEY_Comment);
-			break;
-
-		case SortMode::CameraModel:
-			comparisonResult =
-				SortByImageProperty(basicItemInfo1, basicItemInfo2, PropertyTagEquipModel);
-			break;
-
-		case SortMode::DateTaken:
-			comparisonResult =
-				SortByImageProperty(basicItemInfo1, basicItemInfo2, PropertyTagDateTime);
-			break;
-
-		case SortMode::Width:
-			comparisonResult =
-				SortByImageProperty(basicItemInfo1, basicItemInfo2, PropertyTagImageWidth);
-			break;
-
-		case SortMode::Height:
-			comparisonResult =
-				SortByImageProperty(basicItemInfo1, basicItemInfo2, PropertyTagImageHeight);
-			break;
-
-		case SortMode::VirtualComments:
-			comparisonResult = SortByVirtualComments(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::FileSystem:
-			comparisonResult = SortByFileSystem(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::NumPrinterDocuments:
-			comparisonResult = SortByPrinterProperty(
-				basicItemInfo1, basicItemInfo2, PrinterInformationType::NumJobs);
-			break;
-
-		case SortMode::PrinterStatus:
-			comparisonResult = SortByPrinterProperty(
-				basicItemInfo1, basicItemInfo2, PrinterInformationType::Status);
-			break;
-
-		case SortMode::PrinterComments:
-			comparisonResult = SortByPrinterProperty(
-				basicItemInfo1, basicItemInfo2, PrinterInformationType::Comments);
-			break;
-
-		case SortMode::PrinterLocation:
-			comparisonResult = SortByPrinterProperty(
-				basicItemInfo1, basicItemInfo2, PrinterInformationType::Location);
-			break;
-
-		case SortMode::NetworkAdapterStatus:
-			comparisonResult = SortByNetworkAdapterStatus(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::MediaBitrate:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Bitrate);
-			break;
-
-		case SortMode::MediaCopyright:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Copyright);
-			break;
-
-		case SortMode::MediaDuration:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Duration);
-			break;
-
-		case SortMode::MediaProtected:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Protected);
-			break;
-
-		case SortMode::MediaRating:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Rating);
-			break;
-
-		case SortMode::MediaAlbumArtist:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::AlbumArtist);
-			break;
-
-		case SortMode::MediaAlbum:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::AlbumTitle);
-			break;
-
-		case SortMode::MediaBeatsPerMinute:
-			comparisonResult = SortByMediaMetadata(
-				basicItemInfo1, basicItemInfo2, MediaMetadataType::BeatsPerMinute);
-			break;
-
-		case SortMode::MediaComposer:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Composer);
-			break;
-
-		case SortMode::MediaConductor:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Conductor);
-			break;
-
-		case SortMode::MediaDirector:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Director);
-			break;
-
-		case SortMode::MediaGenre:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Genre);
-			break;
-
-		case SortMode::MediaLanguage:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Language);
-			break;
-
-		case SortMode::MediaBroadcastDate:
-			comparisonResult = SortByMediaMetadata(
-				basicItemInfo1, basicItemInfo2, MediaMetadataType::BroadcastDate);
-			break;
-
-		case SortMode::MediaChannel:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Channel);
-			break;
-
-		case SortMode::MediaStationName:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::StationName);
-			break;
-
-		case SortMode::MediaMood:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Mood);
-			break;
-
-		case SortMode::MediaParentalRating:
-			comparisonResult = SortByMediaMetadata(
-				basicItemInfo1, basicItemInfo2, MediaMetadataType::ParentalRating);
-			break;
-
-		case SortMode::MediaParentalRatingReason:
-			comparisonResult = SortByMediaMetadata(
-				basicItemInfo1, basicItemInfo2, MediaMetadataType::ParentalRatingReason);
-			break;
-
-		case SortMode::MediaPeriod:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Period);
-			break;
-
-		case SortMode::MediaProducer:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Producer);
-			break;
-
-		case SortMode::MediaPublisher:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Publisher);
-			break;
-
-		case SortMode::MediaWriter:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Writer);
-			break;
-
-		case SortMode::MediaYear:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Year);
-			break;
-
-		default:
-			assert(false);
-			break;
+			comparisonResult = SortUsingItemInfo(InternalIndex1, InternalIndex2);
 		}
 	}
 
@@ -373,21 +141,975 @@ int CALLBACK ShellBrowser::Sort(int InternalIndex1, int InternalIndex2) const
 	{
 		/* By default, items that are equal will be sub-sorted
 		by their display names. */
-		if (m_config->globalFolderSettings.useNaturalSortOrder)
+		comparisonResult = CompareSortKeys(sortKeys1.displayName, sortKeys2.displayName);
+	}
+
+	if (!m_folderSettings.sortAscending)
+	{
+		comparisonResult = -comparisonResult;
+	}
+
+	return comparisonResult;
+}
+
+// Compares two items using their precomputed sort keys. Returns an empty value if the specified
+// sort mode doesn't use keys.
+std::optional<int> ShellBrowser::CompareSortKeyValues(
+	const SortKeys &sortKeys1, const SortKeys &sortKeys2, SortMode sortMode)
+{
+	auto compareValues = [](ULONGLONG value1, ULONGLONG value2) {
+		return (value1 > value2) - (value1 < value2);
+	};
+
+	// The checks below mirror those in SortByName, SortByType, SortBySize and SortByDate.
+	switch (sortMode)
+	{
+	case SortMode::Name:
+		if (sortKeys1.isDrive != sortKeys2.isDrive)
 		{
-			comparisonResult =
-				StrCmpLogicalW(basicItemInfo1.szDisplayName, basicItemInfo2.szDisplayName);
+			return sortKeys1.isDrive ? -1 : 1;
 		}
-		else
+
+		return CompareSortKeys(sortKeys1.name, sortKeys2.name);
+
+	case SortMode::Type:
+		if (!sortKeys1.type || !sortKeys2.type)
+		{
+			return std::nullopt;
+		}
+
+		if (sortKeys1.isDrive != sortKeys2.isDrive)
 		{
-			comparisonResult = StrCmpIW(basicItemInfo1.szDisplayName, basicItemInfo2.szDisplayName);
+			return sortKeys1.isDrive ? -1 : 1;
 		}
+
+		return CompareSortKeys(*sortKeys1.type, *sortKeys2.type);
+
+	case SortMode::Size:
+	case SortMode::DateModified:
+	case SortMode::Created:
+	case SortMode::Accessed:
+		break;
+
+	default:
+		return std::nullopt;
 	}
 
-	if (!m_folderSettings.sortAscending)
+	if (!sortKeys1.isFindDataValid || !sortKeys2.isFindDataValid)
+	{
+		return static_cast<int>(sortKeys1.isFindDataValid)
+			- static_cast<int>(sortKeys2.isFindDataValid);
+	}
+
+	switch (sortMode)
+	{
+	case SortMode::Size:
+		// Folder sizes aren't currently taken into account.
+		if (sortKeys1.isFolder && sortKeys2.isFolder)
+		{
+			return 0;
+		}
+
+		return compareValues(sortKeys1.size, sortKeys2.size);
+
+	case SortMode::DateModified:
+		return compareValues(sortKeys1.lastWriteTime, sortKeys2.lastWriteTime);
+
+	case SortMode::Created:
+		return compareValues(sortKeys1.creationTime, sortKeys2.creationTime);
+
+	case SortMode::Accessed:
+		return compareValues(sortKeys1.lastAccessTime, sortKeys2.lastAccessTime);
+
+	default:
+		assert(false);
+		break;
+	}
+
+	return std::nullopt;
+}
+
+int ShellBrowser::SortUsingItemInfo(int InternalIndex1, int InternalIndex2) const
+{
+	int comparisonResult = 0;
+
+	auto cachedColumn = GetCachedSortColumn(m_folderSettings.sortMode);
+
+	if (cachedColumn)
+	{
+		return SortUsingColumnValues(InternalIndex1, InternalIndex2, *cachedColumn);
+	}
+
+	BasicItemInfo_t basicItemInfo1 = getBasicItemInfo(InternalIndex1);
+	BasicItemInfo_t basicItemInfo2 = getBasicItemInfo(InternalIndex2);
+
+	switch (m_folderSettings.sortMode)
+	{
+	case SortMode::Name:
+		comparisonResult =
+			SortByName(basicItemInfo1, basicItemInfo2, m_config->globalFolderSettings);
+		break;
+
+	case SortMode::Type:
+		comparisonResult = SortByType(basicItemInfo1, basicItemInfo2);
+		break;
+
+	case SortMode::Size:
+		comparisonResult = SortBySize(basicItemInfo1, basicItemInfo2);
+		break;
+
+	case SortMode::DateModified:
+		comparisonResult = SortByDate(basicItemInfo1, basicItemInfo2, DateType::Modified);
+		break;
+
+	case SortMode::TotalSize:
+		comparisonResult = SortByTotalSize(basicItemInfo1, basicItemInfo2, TRUE);
+		break;
+
+	case SortMode::FreeSpace:
+		comparisonResult = SortByTotalSize(basicItemInfo1, basicItemInfo2, FALSE);
+		break;
+
+	case SortMode::Attributes:
+		comparisonResult = SortByAttributes(basicItemInfo1, basicItemInfo2);
+		break;
+
+	case SortMode::ShortcutTo:
+		comparisonResult = SortByShortcutTo(basicItemInfo1, basicItemInfo2);
+		break;
+
+	case SortMode::Extension:
+		comparisonResult = SortByExtension(basicItemInfo1, basicItemInfo2);
+		break;
+
+	case SortMode::Created:
+		comparisonResult = SortByDate(basicItemInfo1, basicItemInfo2, DateType::Created);
+		break;
+
+	case SortMode::Accessed:
+		comparisonResult = SortByDate(basicItemInfo1, basicItemInfo2, DateType::Accessed);
+		break;
+
+	case SortMode::VirtualComments:
+		comparisonResult = SortByVirtualComments(basicItemInfo1, basicItemInfo2);
+		break;
+
+	case SortMode::FileSystem:
+		comparisonResult = SortByFileSystem(basicItemInfo1, basicItemInfo2);
+		break;
+
+	case SortMode::NumPrinterDocuments:
+		comparisonResult = SortByPrinterProperty(
+			basicItemInfo1, basicItemInfo2, PrinterInformationType::NumJobs);
+		break;
+
+	case SortMode::PrinterStatus:
+		comparisonResult = SortByPrinterProperty(
+			basicItemInfo1, basicItemInfo2, PrinterInformationType::Status);
+		break;
+
+	case SortMode::PrinterComments:
+		comparisonResult = SortByPrinterProperty(
+			basicItemInfo1, basicItemInfo2, PrinterInformationType::Comments);
+		break;
+
+	case SortMode::PrinterLocation:
+		comparisonResult = SortByPrinterProperty(
+			basicItemInfo1, basicItemInfo2, PrinterInformationType::Location);
+		break;
+
+	case SortMode::NetworkAdapterStatus:
+		comparisonResult = SortByNetworkAdapterStatus(basicItemInfo1, basicItemInfo2);
+		break;
+
+	default:
+		assert(false);
+		break;
+	}
+
+	return comparisonResult;
+}
+
+// Returns the column whose values are used when sorting by the specified sort mode, if those values
+// are stored in the column value cache.
+std::optional<ColumnType> ShellBrowser::GetCachedSortColumn(SortMode sortMode)
+{
+	switch (sortMode)
+	{
+	case SortMode::DateDeleted:
+		return ColumnType::DateDeleted;
+
+	case SortMode::OriginalLocation:
+		return ColumnType::OriginalLocation;
+
+	case SortMode::Owner:
+		return ColumnType::Owner;
+
+	case SortMode::RealSize:
+		return ColumnType::RealSize;
+
+	case SortMode::ShortName:
+		return ColumnType::ShortName;
+
+	case SortMode::HardLinks:
+		return ColumnType::HardLinks;
+
+	case SortMode::ProductName:
+		return ColumnType::ProductName;
+
+	case SortMode::Company:
+		return ColumnType::Company;
+
+	case SortMode::Description:
+		return ColumnType::Description;
+
+	case SortMode::FileVersion:
+		return ColumnType::FileVersion;
+
+	case SortMode::ProductVersion:
+		return ColumnType::ProductVersion;
+
+	case SortMode::Title:
+		return ColumnType::Title;
+
+	case SortMode::Subject:
+		return ColumnType::Subject;
+
+	case SortMode::Authors:
+		return ColumnType::Authors;
+
+	case SortMode::Keywords:
+		return ColumnType::Keywords;
+
+	case SortMode::Comments:
+		return ColumnType::Comment;
+
+	case SortMode::CameraModel:
+		return ColumnType::CameraModel;
+
+	case SortMode::DateTaken:
+		return ColumnType::DateTaken;
+
+	case SortMode::Width:
+		return ColumnType::Width;
+
+	case SortMode::Height:
+		return ColumnType::Height;
+
+	case SortMode::MediaBitrate:
+		return ColumnType::MediaBitrate;
+
+	case SortMode::MediaCopyright:
+		return ColumnType::MediaCopyright;
+
+	case SortMode::MediaDuration:
+		return ColumnType::MediaDuration;
+
+	case SortMode::MediaProtected:
+		return ColumnType::MediaProtected;
+
+	case SortMode::MediaRating:
+		return ColumnType::MediaRating;
+
+	case SortMode::MediaAlbumArtist:
+		return ColumnType::MediaAlbumArtist;
+
+	case SortMode::MediaAlbum:
+		return ColumnType::MediaAlbum;
+
+	case SortMode::MediaBeatsPerMinute:
+		return ColumnType::MediaBeatsPerMinute;
+
+	case SortMode::MediaComposer:
+		return ColumnType::MediaComposer;
+
+	case SortMode::MediaConductor:
+		return ColumnType::MediaConductor;
+
+	case SortMode::MediaDirector:
+		return ColumnType::MediaDirector;
+
+	case SortMode::MediaGenre:
+		return ColumnType::MediaGenre;
+
+	case SortMode::MediaLanguage:
+		return ColumnType::MediaLanguage;
+
+	case SortMode::MediaBroadcastDate:
+		return ColumnType::MediaBroadcastDate;
+
+	case SortMode::MediaChannel:
+		return ColumnType::MediaChannel;
+
+	case SortMode::MediaStationName:
+		return ColumnType::MediaStationName;
+
+	case SortMode::MediaMood:
+		return ColumnType::MediaMood;
+
+	case SortMode::MediaParentalRating:
+		return ColumnType::MediaParentalRating;
+
+	case SortMode::MediaParentalRatingReason:
+		return ColumnType::MediaParentalRatingReason;
+
+	case SortMode::MediaPeriod:
+		return ColumnType::MediaPeriod;
+
+	case SortMode::MediaProducer:
+		return ColumnType::MediaProducer;
+
+	case SortMode::MediaPublisher:
+		return ColumnType::MediaPublisher;
+
+	case SortMode::MediaWriter:
+		return ColumnType::MediaWriter;
+
+	case SortMode::MediaYear:
+		return ColumnType::MediaYear;
+
+	default:
+		return std::nullopt;
+	}
+}
+
+int ShellBrowser::SortUsingColumnValues(
+	int internalIndex1, int internalIndex2, ColumnType columnType) const
+{
+	switch (columnType)
+	{
+	case ColumnType::RealSize:
+	case ColumnType::ShortName:
+	case ColumnType::HardLinks:
+		return SortUsingFileFacts(internalIndex1, internalIndex2, columnType);
+
+	default:
+		break;
+	}
+
+	auto getColumnValue = [this, columnType](int internalIndex) {
+		auto columnValue = m_columnValueCache->GetValue(internalIndex, columnType);
+
+		if (columnValue)
+		{
+			return columnValue;
+		}
+
+		return m_columnValueCache->GetOrRetrieveValue(internalIndex, columnType,
+			getBasicItemInfo(internalIndex), m_config->globalFolderSettings);
+	};
+
+	auto columnValue1 = getColumnValue(internalIndex1);
+	auto columnValue2 = getColumnValue(internalIndex2);
+
+	if (columnValue1->rawData || columnValue2->rawData)
+	{
+		return SortByItemDetails(*columnValue1, *columnValue2);
+	}
+
+	return SortByColumnText(*columnValue1, *columnValue2);
+}
+
+// These columns are compared using the underlying facts, rather than the column text (e.g. so that
+// sizes are compared numerically).
+int ShellBrowser::SortUsingFileFacts(
+	int internalIndex1, int internalIndex2, ColumnType columnType) const
+{
+	FileFact facts = GetFileFactsForColumn(columnType);
+
+	auto fileFacts1 = m_columnValueCache->GetOrRetrieveFileFacts(
+		internalIndex1, facts, getBasicItemInfo(internalIndex1));
+	auto fileFacts2 = m_columnValueCache->GetOrRetrieveFileFacts(
+		internalIndex2, facts, getBasicItemInfo(internalIndex2));
+
+	switch (columnType)
+	{
+	case ColumnType::RealSize:
+		return SortByRealSize(*fileFacts1, *fileFacts2);
+
+	case ColumnType::ShortName:
+		return SortByShortName(*fileFacts1, *fileFacts2);
+
+	case ColumnType::HardLinks:
+		return SortByHardlinks(*fileFacts1, *fileFacts2);
+
+	default:
+		assert(false);
+		return 0;
+	}
+}
+
+// Retrieves the values needed to sort by an expensive column (e.g. the owner or version columns)
+// in the background, split across several tasks, before the sort starts. Otherwise, the values
+// would be retrieved one at a time on the UI thread, as items were compared. Returns true if any
+// values need to be retrieved, in which case the items will be sorted once all the values are
+// available.
+bool ShellBrowser::PrefetchSortColumnValues()
+{
+	auto cachedColumn = GetCachedSortColumn(m_folderSettings.sortMode);
+
+	if (!cachedColumn)
+	{
+		return false;
+	}
+
+	auto sortState = std::make_shared<SortState>(m_sortIdCounter++, GetSortOptions(),
+		m_config->globalFolderSettings, m_columnValueCache);
+	sortState->prefetchColumn = cachedColumn;
+
+	int numItems = ListView_GetItemCount(m_hListView);
+
+	for (int i = 0; i < numItems; i++)
+	{
+		int internalIndex = GetItemInternalIndex(i);
+
+		if (m_columnValueCache->GetValue(internalIndex, *cachedColumn))
+		{
+			continue;
+		}
+
+		sortState->prefetchItems.emplace_back(internalIndex, getBasicItemInfo(internalIndex));
+	}
+
+	if (sortState->prefetchItems.empty())
+	{
+		return false;
+	}
+
+	m_sortState = sortState;
+
+	PushBackgroundSortTasks(sortState, sortState->prefetchItems.size(),
+		BACKGROUND_PREFETCH_MIN_ITEMS_PER_TASK, PrefetchColumnValuesAsync);
+
+	return true;
+}
+
+void ShellBrowser::PrefetchColumnValuesAsync(
+	HWND listView, SortState &sortState, size_t first, size_t last)
+{
+	for (size_t i = first; i < last && !sortState.cancelled; i++)
+	{
+		const auto &[internalIndex, basicItemInfo] = sortState.prefetchItems[i];
+		sortState.columnValueCache->GetOrRetrieveValue(internalIndex, *sortState.prefetchColumn,
+			basicItemInfo, sortState.globalFolderSettings);
+	}
+
+	if (--sortState.numPendingTasks == 0 && !sortState.cancelled)
+	{
+		sortState.finished = true;
+		PostMessage(listView, WM_APP_SORT_RESULT_READY, sortState.sortId, 0);
+	}
+}
+
+bool ShellBrowser::AreSortKeysCurrent(const ItemInfo_t &itemInfo) const
+{
+	if (!itemInfo.sortKeys)
+	{
+		return false;
+	}
+
+	const auto &globalFolderSettings = m_config->globalFolderSettings;
+
+	return itemInfo.sortKeys->naturalSortOrder == globalFolderSettings.useNaturalSortOrder
+		&& itemInfo.sortKeys->showExtensions == globalFolderSettings.showExtensions
+		&& itemInfo.sortKeys->hideLinkExtension == globalFolderSettings.hideLinkExtension;
+}
+
+// Returns the current sort keys for an item. If the item's keys are missing or out of date (or
+// don't include the type key when it's needed), temporary keys are built and stored in builtKeys.
+const ShellBrowser::SortKeys &ShellBrowser::GetSortKeysForComparison(
+	int internalIndex, std::shared_ptr<const SortKeys> &builtKeys) const
+{
+	const ItemInfo_t &itemInfo = m_itemInfoMap.at(internalIndex);
+	bool needsTypeKey = (m_folderSettings.sortMode == SortMode::Type);
+
+	if (AreSortKeysCurrent(itemInfo) && (!needsTypeKey || itemInfo.sortKeys->type))
+	{
+		return *itemInfo.sortKeys;
+	}
+
+	BasicItemInfo_t basicItemInfo = getBasicItemInfo(internalIndex);
+	builtKeys = AreSortKeysCurrent(itemInfo)
+		? itemInfo.sortKeys
+		: BuildSortKeys(basicItemInfo, m_config->globalFolderSettings);
+
+	if (needsTypeKey && !builtKeys->type)
+	{
+		builtKeys = AddTypeSortKey(*builtKeys, internalIndex, basicItemInfo, *m_columnValueCache,
+			m_config->globalFolderSettings);
+	}
+
+	return *builtKeys;
+}
+
+// Builds the sort keys for an item, if they haven't already been built (or are out of date). The
+// type key is only built when the folder is being sorted by type.
+void ShellBrowser::UpdateSortKeys(int internalIndex)
+{
+	ItemInfo_t &itemInfo = m_itemInfoMap.at(internalIndex);
+
+	if (!AreSortKeysCurrent(itemInfo))
+	{
+		itemInfo.sortKeys =
+			BuildSortKeys(getBasicItemInfo(internalIndex), m_config->globalFolderSettings);
+	}
+
+	if (m_folderSettings.sortMode == SortMode::Type && !itemInfo.sortKeys->type)
+	{
+		itemInfo.sortKeys = AddTypeSortKey(*itemInfo.sortKeys, internalIndex,
+			getBasicItemInfo(internalIndex), *m_columnValueCache, m_config->globalFolderSettings);
+	}
+}
+
+// Builds every key other than the type key. Can be called from any thread.
+std::shared_ptr<const ShellBrowser::SortKeys> ShellBrowser::BuildSortKeys(
+	const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings)
+{
+	/* Drives are sorted by drive letter, rather than display name. */
+	std::wstring name = basicItemInfo.isRoot
+		? basicItemInfo.getFullPath()
+		: GetNameColumnText(basicItemInfo, globalFolderSettings);
+
+	auto sortKeys = std::make_shared<SortKeys>();
+	sortKeys->name = CreateSortKey(name, globalFolderSettings.useNaturalSortOrder);
+	sortKeys->displayName =
+		CreateSortKey(basicItemInfo.szDisplayName, globalFolderSettings.useNaturalSortOrder);
+
+	const WIN32_FIND_DATA &wfd = basicItemInfo.wfd;
+	ULARGE_INTEGER fileSize = { wfd.nFileSizeLow, wfd.nFileSizeHigh };
+	sortKeys->size = fileSize.QuadPart;
+
+	sortKeys->creationTime = FileTimeToUInt64(wfd.ftCreationTime);
+	sortKeys->lastWriteTime = FileTimeToUInt64(wfd.ftLastWriteTime);
+	sortKeys->lastAccessTime = FileTimeToUInt64(wfd.ftLastAccessTime);
+
+	sortKeys->isFolder = WI_IsFlagSet(wfd.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY);
+	sortKeys->isDrive = basicItemInfo.isRoot;
+	sortKeys->isFindDataValid = basicItemInfo.isFindDataValid;
+
+	sortKeys->naturalSortOrder = globalFolderSettings.useNaturalSortOrder;
+	sortKeys->showExtensions = globalFolderSettings.showExtensions;
+	sortKeys->hideLinkExtension = globalFolderSettings.hideLinkExtension;
+
+	return sortKeys;
+}
+
+// Returns a copy of the keys that includes the type key. The existing keys may be shared with a
+// background sort, so they're left unchanged. Can be called from any thread.
+std::shared_ptr<const ShellBrowser::SortKeys> ShellBrowser::AddTypeSortKey(
+	const SortKeys &sortKeys, int internalIndex, const BasicItemInfo_t &basicItemInfo,
+	ColumnValueCache &columnValueCache, const GlobalFolderSettings &globalFolderSettings)
+{
+	// Types are always compared using natural ordering (see SortByType). The type is retrieved
+	// through the column value cache, so that it can be loaded from the persistent cache.
+	auto typeValue = columnValueCache.GetOrRetrieveValue(
+		internalIndex, ColumnType::Type, basicItemInfo, globalFolderSettings);
+
+	auto updatedSortKeys = std::make_shared<SortKeys>(sortKeys);
+	updatedSortKeys->type = CreateSortKey(typeValue->text, true);
+	return updatedSortKeys;
+}
+
+void ShellBrowser::UpdateAllSortKeys()
+{
+	for (const auto &item : m_itemInfoMap)
+	{
+		UpdateSortKeys(item.first);
+	}
+}
+
+bool ShellBrowser::CanSortInBackground() const
+{
+	// Only the sort modes that can be handled entirely using the precomputed keys are supported.
+	switch (m_folderSettings.sortMode)
+	{
+	case SortMode::Name:
+	case SortMode::Type:
+	case SortMode::Size:
+	case SortMode::DateModified:
+	case SortMode::Created:
+	case SortMode::Accessed:
+		break;
+
+	default:
+		return false;
+	}
+
+	int numItems = ListView_GetItemCount(m_hListView);
+
+	if (numItems >= BACKGROUND_SORT_MIN_ITEMS)
+	{
+		return true;
+	}
+
+	if (m_folderSettings.sortMode != SortMode::Type)
+	{
+		return false;
+	}
+
+	// Retrieving the type of an item requires the shell to be queried, so if any of the types
+	// are missing, the sort is run in the background, regardless of how many items there are.
+	for (int i = 0; i < numItems; i++)
+	{
+		const ItemInfo_t &itemInfo = m_itemInfoMap.at(GetItemInternalIndex(i));
+
+		if (!AreSortKeysCurrent(itemInfo) || !itemInfo.sortKeys->type)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Takes a reference to the sort keys for each item in the listview and sorts them on a background
+// thread. Since the keys are never modified once built, changes made to the items on the UI thread
+// while the sort is running won't affect the sort. Items without current keys (or without a type
+// key, when sorting by type) have their keys built in the background as well, split across
+// several tasks.
+void ShellBrowser::StartBackgroundSort()
+{
+	SortOptions options = GetSortOptions();
+
+	auto sortState = std::make_shared<SortState>(
+		m_sortIdCounter++, options, m_config->globalFolderSettings, m_columnValueCache);
+
+	int numItems = ListView_GetItemCount(m_hListView);
+	sortState->records.reserve(numItems);
+
+	for (int i = 0; i < numItems; i++)
+	{
+		int internalIndex = GetItemInternalIndex(i);
+		const ItemInfo_t &itemInfo = m_itemInfoMap.at(internalIndex);
+		bool keysCurrent = AreSortKeysCurrent(itemInfo);
+
+		if (keysCurrent && (options.sortMode != SortMode::Type || itemInfo.sortKeys->type))
+		{
+			sortState->records.push_back({ internalIndex, itemInfo.sortKeys });
+			continue;
+		}
+
+		sortState->records.push_back({ internalIndex, nullptr });
+		sortState->keyRequests.push_back({ sortState->records.size() - 1, internalIndex,
+			getBasicItemInfo(internalIndex), itemInfo.sortKeys, keysCurrent, nullptr });
+	}
+
+	m_sortState = sortState;
+
+	size_t numKeyRequests = sortState->keyRequests.size();
+
+	if (numKeyRequests == 0)
+	{
+		m_sortTaskQueue->PushTask(
+			[listView = m_hListView, sortState]() { SortItemsAsync(listView, *sortState); });
+		return;
+	}
+
+	PushBackgroundSortTasks(
+		sortState, numKeyRequests, BACKGROUND_SORT_MIN_KEYS_PER_TASK, BuildSortKeysAsync);
+}
+
+ShellBrowser::SortOptions ShellBrowser::GetSortOptions() const
+{
+	SortOptions options;
+	options.sortMode = m_folderSettings.sortMode;
+	options.sortAscending = m_folderSettings.sortAscending;
+	options.separateFolders = !m_config->globalFolderSettings.displayMixedFilesAndFolders
+		&& !CompareVirtualFolders(CSIDL_BITBUCKET);
+	return options;
+}
+
+// Splits the specified number of requests into ranges and pushes a task that processes each range
+// to the sort queue. Each task should decrement the number of pending tasks once it's finished.
+void ShellBrowser::PushBackgroundSortTasks(const std::shared_ptr<SortState> &sortState,
+	size_t numRequests, size_t minRequestsPerTask, BackgroundSortTask task)
+{
+	size_t maxTasks = (std::max)(std::thread::hardware_concurrency(), 1U);
+	size_t numTasks = std::clamp<size_t>(numRequests / minRequestsPerTask, 1, maxTasks);
+	size_t requestsPerTask = (numRequests + numTasks - 1) / numTasks;
+	sortState->numPendingTasks = (numRequests + requestsPerTask - 1) / requestsPerTask;
+
+	for (size_t first = 0; first < numRequests; first += requestsPerTask)
+	{
+		size_t last = (std::min)(first + requestsPerTask, numRequests);
+
+		m_sortTaskQueue->PushTask([listView = m_hListView, sortState, task, first, last]() {
+			task(listView, *sortState, first, last);
+		});
+	}
+}
+
+void ShellBrowser::BuildSortKeysAsync(
+	HWND listView, SortState &sortState, size_t first, size_t last)
+{
+	for (size_t i = first; i < last && !sortState.cancelled; i++)
+	{
+		auto &request = sortState.keyRequests[i];
+
+		std::shared_ptr<const SortKeys> sortKeys = request.previousSortKeysCurrent
+			? request.previousSortKeys
+			: BuildSortKeys(request.basicItemInfo, sortState.globalFolderSettings);
+
+		if (sortState.options.sortMode == SortMode::Type && !sortKeys->type)
+		{
+			sortKeys = AddTypeSortKey(*sortKeys, request.internalIndex, request.basicItemInfo,
+				*sortState.columnValueCache, sortState.globalFolderSettings);
+		}
+
+		request.sortKeys = sortKeys;
+		sortState.records[request.recordIndex].sortKeys = std::move(sortKeys);
+	}
+
+	// The records can only be sorted once all the keys have been built, so the last task to
+	// finish is responsible for sorting them.
+	if (--sortState.numPendingTasks == 0)
+	{
+		SortItemsAsync(listView, sortState);
+	}
+}
+
+void ShellBrowser::SortItemsAsync(HWND listView, SortState &sortState)
+{
+	// If the sort was cancelled while the keys were being built, some of the keys may be missing.
+	if (sortState.cancelled)
+	{
+		return;
+	}
+
+	const SortOptions &options = sortState.options;
+
+	bool res = ParallelMergeSort(
+		sortState.records.begin(), sortState.records.end(),
+		[&options](const SortRecord &record1, const SortRecord &record2) {
+			return CompareSortRecords(record1, record2, options) < 0;
+		},
+		sortState.cancelled, std::thread::hardware_concurrency());
+
+	if (!res)
+	{
+		return;
+	}
+
+	sortState.finished = true;
+
+	PostMessage(listView, WM_APP_SORT_RESULT_READY, sortState.sortId, 0);
+}
+
+// Equivalent to Sort(), for items whose keys are current and whose sort mode is supported by
+// CanSortInBackground().
+int ShellBrowser::CompareSortRecords(
+	const SortRecord &record1, const SortRecord &record2, const SortOptions &options)
+{
+	const SortKeys &sortKeys1 = *record1.sortKeys;
+	const SortKeys &sortKeys2 = *record2.sortKeys;
+
+	int comparisonResult;
+
+	if (options.separateFolders && sortKeys1.isFolder != sortKeys2.isFolder)
+	{
+		comparisonResult = sortKeys1.isFolder ? -1 : 1;
+	}
+	else
+	{
+		comparisonResult =
+			CompareSortKeyValues(sortKeys1, sortKeys2, options.sortMode).value_or(0);
+	}
+
+	if (comparisonResult == 0)
+	{
+		comparisonResult = CompareSortKeys(sortKeys1.displayName, sortKeys2.displayName);
+	}
+
+	if (!options.sortAscending)
 	{
 		comparisonResult = -comparisonResult;
 	}
 
 	return comparisonResult;
+}
+
+void ShellBrowser::CancelBackgroundSort()
+{
+	if (m_sortState)
+	{
+		m_sortState->cancelled = true;
+		m_sortState.reset();
+	}
+}
+
+// While a sort is running in the background, the listview is still in the previous order, so
+// items can't be inserted into their sorted position. Any items added or updated in the meantime
+// are moved into position once the sort has finished.
+bool ShellBrowser::IsBackgroundSortInProgress() const
+{
+	return m_sortState != nullptr;
+}
+
+void ShellBrowser::OnSortResultReady(int sortId)
+{
+	if (!m_sortState || m_sortState->sortId != sortId || !m_sortState->finished)
+	{
+		return;
+	}
+
+	auto sortState = std::move(m_sortState);
+
+	// The values needed to sort the items have now been retrieved, so the items can be sorted
+	// directly. Any values retrieved for items that have since been updated will have been
+	// discarded, but there should be few of those.
+	if (sortState->prefetchColumn)
+	{
+		if (sortState->options.sortMode == m_folderSettings.sortMode)
+		{
+			SendMessage(m_hListView, WM_SETREDRAW, FALSE, NULL);
+			SortItemsDirectly();
+			SendMessage(m_hListView, WM_SETREDRAW, TRUE, NULL);
+		}
+
+		return;
+	}
+
+	if (sortState->options.sortMode != m_folderSettings.sortMode
+		|| sortState->options.sortAscending != m_folderSettings.sortAscending)
+	{
+		return;
+	}
+
+	// Keys built in the background are stored back in each item, unless the item has been updated
+	// since the sort started.
+	for (auto &request : sortState->keyRequests)
+	{
+		auto itr = m_itemInfoMap.find(request.internalIndex);
+
+		if (itr != m_itemInfoMap.end() && itr->second.sortKeys == request.previousSortKeys)
+		{
+			itr->second.sortKeys = std::move(request.sortKeys);
+		}
+	}
+
+	int numItems = ListView_GetItemCount(m_hListView);
+	std::vector<int> currentItems;
+	currentItems.reserve(numItems);
+
+	std::vector<bool> shown(m_directoryState.itemIDCounter, false);
+
+	for (int i = 0; i < numItems; i++)
+	{
+		int internalIndex = GetItemInternalIndex(i);
+		currentItems.push_back(internalIndex);
+		shown[internalIndex] = true;
+	}
+
+	// Items may have been added, removed or updated while the sort was running. Items that were
+	// removed are skipped, while items that were added or updated are inserted individually.
+	std::vector<int> sortedItems;
+	sortedItems.reserve(numItems);
+
+	std::vector<bool> placed(m_directoryState.itemIDCounter, false);
+
+	for (const auto &record : sortState->records)
+	{
+		if (!shown[record.internalIndex])
+		{
+			continue;
+		}
+
+		// If the item's keys have changed, the item was updated after the sort started.
+		if (m_itemInfoMap.at(record.internalIndex).sortKeys != record.sortKeys)
+		{
+			continue;
+		}
+
+		sortedItems.push_back(record.internalIndex);
+		placed[record.internalIndex] = true;
+	}
+
+	for (int internalIndex : currentItems)
+	{
+		if (placed[internalIndex])
+		{
+			continue;
+		}
+
+		UpdateSortKeys(internalIndex);
+
+		auto itr = std::lower_bound(sortedItems.begin(), sortedItems.end(), internalIndex,
+			[this](int internalIndex1, int internalIndex2) {
+				return Sort(internalIndex1, internalIndex2) < 0;
+			});
+		sortedItems.insert(itr, internalIndex);
+	}
+
+	if (m_ownerDataListView)
+	{
+		SetOwnerDataItems(std::move(sortedItems));
+		return;
+	}
+
+	SendMessage(m_hListView, WM_SETREDRAW, FALSE, NULL);
+	ApplyItemOrder(sortedItems);
+	SendMessage(m_hListView, WM_SETREDRAW, TRUE, NULL);
+}
+
+// Sorts the items from the specified index onwards (which will have just been appended to the
+// listview) and merges them in with the items before them, which are assumed to already be in
+// sorted order. That's significantly cheaper than sorting the entire listview again.
+void ShellBrowser::MergeAppendedItems(int firstAppendedItem)
+{
+	int numItems = ListView_GetItemCount(m_hListView);
+
+	if (firstAppendedItem >= numItems || IsBackgroundSortInProgress())
+	{
+		return;
+	}
+
+	std::vector<int> existingItems;
+	existingItems.reserve(firstAppendedItem);
+
+	for (int i = 0; i < firstAppendedItem; i++)
+	{
+		existingItems.push_back(GetItemInternalIndex(i));
+	}
+
+	std::vector<int> appendedItems;
+	appendedItems.reserve(numItems - firstAppendedItem);
+
+	for (int i = firstAppendedItem; i < numItems; i++)
+	{
+		appendedItems.push_back(GetItemInternalIndex(i));
+	}
+
+	auto compare = [this](int internalIndex1, int internalIndex2) {
+		return Sort(internalIndex1, internalIndex2) < 0;
+	};
+
+	std::stable_sort(appendedItems.begin(), appendedItems.end(), compare);
+
+	std::vector<int> sortedItems;
+	sortedItems.reserve(numItems);
+	std::merge(existingItems.begin(), existingItems.end(), appendedItems.begin(),
+		appendedItems.end(), std::back_inserter(sortedItems), compare);
+
+	ApplyItemOrder(sortedItems);
+}
+
+// Reorders the listview so that the items appear in the specified order. The listview can only be
+// reordered by sorting it, so each item is sorted by its position in the list.
+void ShellBrowser::ApplyItemOrder(const std::vector<int> &sortedItems)
+{
+	std::vector<int> ranks(m_directoryState.itemIDCounter, 0);
+
+	for (size_t i = 0; i < sortedItems.size(); i++)
+	{
+		ranks[sortedItems[i]] = static_cast<int>(i);
+	}
+
+	ListView_SortItems(m_hListView, SortByRankStub, reinterpret_cast<LPARAM>(&ranks));
+	InvalidateItemPositions();
+}
+
+int CALLBACK ShellBrowser::SortByRankStub(LPARAM lParam1, LPARAM lParam2, LPARAM lParamSort)
+{
+	const auto *ranks = reinterpret_cast<const std::vector<int> *>(lParamSort);
+	return (*ranks)[lParam1] - (*ranks)[lParam2];
 }
\ No newline at end of file
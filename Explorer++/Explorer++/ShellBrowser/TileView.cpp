@@ -37,31 +37,24 @@ void ShellBrowser::DeleteTileViewColumns()
 
 void ShellBrowser::SetTileViewInfo()
 {
-	LVITEM lvItem;
-	BOOL bRes;
-	int nItems;
-	int i = 0;
+	// In owner data mode, the tile information is provided through LVN_GETDISPINFO.
+	if (m_ownerDataListView)
+	{
+		InvalidateRect(m_hListView, nullptr, TRUE);
+		return;
+	}
 
-	nItems = ListView_GetItemCount(m_hListView);
+	int nItems = ListView_GetItemCount(m_hListView);
 
-	for (i = 0; i < nItems; i++)
+	for (int i = 0; i < nItems; i++)
 	{
-		lvItem.mask = LVIF_PARAM;
-		lvItem.iItem = i;
-		lvItem.iSubItem = 0;
-		bRes = ListView_GetItem(m_hListView, &lvItem);
-
-		if (bRes)
-		{
-			SetTileViewItemInfo(i, (int) lvItem.lParam);
-		}
+		SetTileViewItemInfo(i, GetItemInternalIndex(i));
 	}
 }
 
 /* TODO: Make this function configurable. */
 void ShellBrowser::SetTileViewItemInfo(int iItem, int iItemInternal)
 {
-	SHFILEINFO shfi;
 	LVTILEINFO lvti;
 	UINT uColumns[2] = { 1, 2 };
 	int columnFormats[2] = { LVCFMT_LEFT, LVCFMT_LEFT };
@@ -73,25 +66,51 @@ void ShellBrowser::SetTileViewItemInfo(int iItem, int iItemInternal)
 	lvti.piColFmt = columnFormats;
 	ListView_SetTileInfo(m_hListView, &lvti);
 
-	std::wstring fullFileName = GetItemFullName(iItem);
-
-	SHGetFileInfo(fullFileName.c_str(), 0, &shfi, sizeof(SHFILEINFO), SHGFI_TYPENAME);
-
-	ListView_SetItemText(m_hListView, iItem, 1, shfi.szTypeName);
+	std::wstring typeName = GetTileViewItemText(iItemInternal, 1);
+	ListView_SetItemText(m_hListView, iItem, 1, typeName.data());
 
 	if ((m_itemInfoMap.at(iItemInternal).wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
 		!= FILE_ATTRIBUTE_DIRECTORY)
+	{
+		std::wstring size = GetTileViewItemText(iItemInternal, 2);
+		ListView_SetItemText(m_hListView, iItem, 2, size.data());
+	}
+}
+
+/* Returns the text shown in the specified tile column
+(1 is the type name, 2 is the size). */
+std::wstring ShellBrowser::GetTileViewItemText(int iItemInternal, int column)
+{
+	const auto &itemInfo = m_itemInfoMap.at(iItemInternal);
+
+	if (column == 1)
+	{
+		SHFILEINFO shfi;
+		DWORD_PTR res = SHGetFileInfo(
+			itemInfo.parsingName.c_str(), 0, &shfi, sizeof(SHFILEINFO), SHGFI_TYPENAME);
+
+		if (res == 0)
+		{
+			return L"";
+		}
+
+		return shfi.szTypeName;
+	}
+	else if (column == 2
+		&& (itemInfo.wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != FILE_ATTRIBUTE_DIRECTORY)
 	{
 		TCHAR lpszFileSize[32];
 		ULARGE_INTEGER lFileSize;
 
-		lFileSize.LowPart = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeLow;
-		lFileSize.HighPart = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeHigh;
+		lFileSize.LowPart = itemInfo.wfd.nFileSizeLow;
+		lFileSize.HighPart = itemInfo.wfd.nFileSizeHigh;
 
 		FormatSizeString(lFileSize, lpszFileSize, SIZEOF_ARRAY(lpszFileSize),
 			m_config->globalFolderSettings.forceSize,
 			m_config->globalFolderSettings.sizeDisplayFormat);
 
-		ListView_SetItemText(m_hListView, iItem, 2, lpszFileSize);
+		return lpszFileSize;
 	}
+
+	return L"";
 }
\ No newline at end of file
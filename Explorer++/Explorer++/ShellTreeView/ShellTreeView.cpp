@@ -46,11 +46,11 @@ ShellTreeView::ShellTreeView(HWND hParent, IExplorerplusplus *coreInterface,
 	m_iRefCount(1),
 	m_itemIDCounter(0),
 	m_bDragDropRegistered(FALSE),
-	m_iconThreadPool(
-		1, std::bind(CoInitializeEx, nullptr, COINIT_APARTMENTTHREADED), CoUninitialize),
+	m_iconTaskQueue(coreInterface->GetTaskExecutor()->CreateQueue(
+		L"Treeview icons", TaskPriorityClass::Foreground)),
 	m_iconResultIDCounter(0),
-	m_subfoldersThreadPool(
-		1, std::bind(CoInitializeEx, nullptr, COINIT_APARTMENTTHREADED), CoUninitialize),
+	m_subfoldersTaskQueue(coreInterface->GetTaskExecutor()->CreateQueue(
+		L"Treeview subfolders", TaskPriorityClass::Foreground)),
 	m_subfoldersResultIDCounter(0),
 	m_cutItem(nullptr)
 {
@@ -116,7 +116,7 @@ ShellTreeView::~ShellTreeView()
 {
 	DeleteCriticalSection(&m_cs);
 
-	m_iconThreadPool.clear_queue();
+	m_iconTaskQueue->Clear();
 }
 
 void ShellTreeView::OnApplicationShuttingDown()
@@ -413,13 +413,10 @@ void ShellTreeView::QueueIconTask(HTREEITEM item, int internalIndex)
 
 	int iconResultID = m_iconResultIDCounter++;
 
-	auto result =
-		m_iconThreadPool.push([this, iconResultID, item, internalIndex, basicItemInfo](int id) {
-			UNREFERENCED_PARAMETER(id);
-
-			return FindIconAsync(
-				m_hTreeView, iconResultID, item, internalIndex, basicItemInfo.pidl.get());
-		});
+	auto result = m_iconTaskQueue->Push([this, iconResultID, item, internalIndex, basicItemInfo]() {
+		return FindIconAsync(
+			m_hTreeView, iconResultID, item, internalIndex, basicItemInfo.pidl.get());
+	});
 
 	m_iconResults.insert({ iconResultID, std::move(result) });
 }
@@ -495,13 +492,10 @@ void ShellTreeView::QueueSubfoldersTask(HTREEITEM item)
 
 	int subfoldersResultID = m_subfoldersResultIDCounter++;
 
-	auto result =
-		m_subfoldersThreadPool.push([this, subfoldersResultID, item, basicItemInfo](int id) {
-			UNREFERENCED_PARAMETER(id);
-
-			return CheckSubfoldersAsync(
-				m_hTreeView, subfoldersResultID, item, basicItemInfo.pidl.get());
-		});
+	auto result = m_subfoldersTaskQueue->Push([this, subfoldersResultID, item, basicItemInfo]() {
+		return CheckSubfoldersAsync(
+			m_hTreeView, subfoldersResultID, item, basicItemInfo.pidl.get());
+	});
 
 	m_subfoldersResults.insert({ subfoldersResultID, std::move(result) });
 }
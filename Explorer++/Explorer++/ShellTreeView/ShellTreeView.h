@@ -6,9 +6,9 @@
 
 #include "../Helper/DropHandler.h"
 #include "../Helper/ShellHelper.h"
+#include "../Helper/TaskExecutor.h"
 #include "../Helper/WindowSubclassWrapper.h"
 #include "../Helper/iDirectoryMonitor.h"
-#include "../ThirdParty/CTPL/cpl_stl.h"
 #include <boost/signals2.hpp>
 #include <wil/com.h>
 #include <optional>
@@ -227,11 +227,11 @@ private:
 	TabContainer *m_tabContainer;
 	FileActionHandler *m_fileActionHandler;
 
-	ctpl::thread_pool m_iconThreadPool;
+	std::unique_ptr<TaskQueue> m_iconTaskQueue;
 	std::unordered_map<int, std::future<std::optional<IconResult>>> m_iconResults;
 	int m_iconResultIDCounter;
 
-	ctpl::thread_pool m_subfoldersThreadPool;
+	std::unique_ptr<TaskQueue> m_subfoldersTaskQueue;
 	std::unordered_map<int, std::future<std::optional<SubfoldersResult>>> m_subfoldersResults;
 	int m_subfoldersResultIDCounter;
 
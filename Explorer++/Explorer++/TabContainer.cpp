@@ -27,6 +27,7 @@
 #include "../Helper/MenuHelper.h"
 #include "../Helper/ShellHelper.h"
 #include "../Helper/TabHelper.h"
+#include "../Helper/TaskExecutor.h"
 #include "../Helper/WindowHelper.h"
 #include "../Helper/iDirectoryMonitor.h"
 #include <boost/algorithm/string.hpp>
@@ -64,7 +65,7 @@ TabContainer::TabContainer(HWND parent, TabNavigationInterface *tabNavigation,
 	m_config(config),
 	m_bTabBeenDragged(FALSE),
 	m_iPreviousTabSelectionId(-1),
-	m_iconFetcher(m_hwnd, cachedIcons),
+	m_iconFetcher(m_hwnd, cachedIcons, expp->GetIconRequestCoalescer(), expp->GetTaskExecutor()),
 	m_defaultFolderIconSystemImageListIndex(GetDefaultFolderIconIndex())
 {
 	Initialize(parent);
@@ -722,8 +723,19 @@ void TabContainer::OnTabSelected(const Tab &tab)
 	if (m_iPreviousTabSelectionId != -1)
 	{
 		m_tabSelectionHistory.push_back(m_iPreviousTabSelectionId);
+
+		// Work for the previous tab is no longer visible, so it can wait until the work for the
+		// newly selected tab has been done.
+		Tab *previousTab = GetTabOptional(m_iPreviousTabSelectionId);
+
+		if (previousTab && previousTab != &tab)
+		{
+			previousTab->GetShellBrowser()->SetTaskPriorityClass(TaskPriorityClass::Background);
+		}
 	}
 
+	tab.GetShellBrowser()->SetTaskPriorityClass(TaskPriorityClass::Foreground);
+
 	m_iPreviousTabSelectionId = tab.GetId();
 }
 
@@ -1118,6 +1130,13 @@ bool TabContainer::CloseTab(const Tab &tab)
 
 	tabPreRemovalSignal.m_signal(tab);
 
+	RemoveTab(tab);
+
+	return true;
+}
+
+void TabContainer::RemoveTab(const Tab &tab)
+{
 	RemoveTabFromControl(tab);
 
 	if (!m_config->registerForShellNotifications)
@@ -1136,8 +1155,6 @@ bool TabContainer::CloseTab(const Tab &tab)
 	m_tabs.erase(tab.GetId());
 
 	tabRemovedSignal.m_signal(tabId);
-
-	return true;
 }
 
 void TabContainer::RemoveTabFromControl(const Tab &tab)
@@ -1380,4 +1397,20 @@ void TabContainer::DuplicateTab(const Tab &tab)
 {
 	std::wstring currentDirectory = tab.GetShellBrowser()->GetDirectory();
 	CreateNewTab(currentDirectory.c_str());
+}
+
+// Replaces the tab with a new, selected, tab in the same position, with the same history, name and
+// lock state, but with the specified folder settings. This is needed when a change to the folder
+// settings requires a different type of listview (e.g. showing groups, which can't be done in an
+// owner data listview), since a listview's style can't be changed once it's been created. The
+// original tab isn't treated as having been closed, so it won't be added to the list of closed
+// tabs.
+void TabContainer::RecreateTab(const Tab &tab, const FolderSettings &folderSettings)
+{
+	PreservedTab preservedTab(tab, GetTabIndex(tab));
+	preservedTab.preservedFolderState.folderSettings = folderSettings;
+
+	CreateNewTab(preservedTab);
+
+	RemoveTab(tab);
 }
\ No newline at end of file
@@ -100,6 +100,7 @@ public:
 	int GetNumTabs() const;
 	int MoveTab(const Tab &tab, int newIndex);
 	void DuplicateTab(const Tab &tab);
+	void RecreateTab(const Tab &tab, const FolderSettings &folderSettings);
 	bool CloseTab(const Tab &tab);
 
 	// Eventually, this should be removed.
@@ -200,6 +201,7 @@ private:
 	void InsertNewTab(int index, int tabId, PCIDLIST_ABSOLUTE pidlDirectory,
 		std::optional<std::wstring> customName);
 
+	void RemoveTab(const Tab &tab);
 	void RemoveTabFromControl(const Tab &tab);
 
 	wil::unique_hfont m_tabFont;
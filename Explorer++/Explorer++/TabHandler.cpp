@@ -268,6 +268,7 @@ void Explorerplusplus::OnTabListViewSelectionChanged(const Tab &tab)
 		if (item.iTabId == tab.GetId())
 		{
 			item.bValid = FALSE;
+			*item.cancelled = true;
 		}
 	}
 
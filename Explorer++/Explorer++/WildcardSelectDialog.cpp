@@ -12,6 +12,7 @@
 #include "../Helper/ListViewHelper.h"
 #include "../Helper/Macros.h"
 #include "../Helper/RegistrySettings.h"
+#include "../Helper/WildcardMatcher.h"
 #include "../Helper/XMLSettings.h"
 
 const TCHAR WildcardSelectDialogPersistentSettings::SETTINGS_KEY[] = _T("WildcardSelect");
@@ -139,12 +140,13 @@ void WildcardSelectDialog::SelectItems(TCHAR *szPattern)
 	HWND hListView = m_pexpp->GetActiveListView();
 
 	int nItems = ListView_GetItemCount(hListView);
+	WildcardMatcher wildcardMatcher(szPattern, false);
 
 	for (int i = 0; i < nItems; i++)
 	{
 		std::wstring filename = m_pexpp->GetActiveShellBrowser()->GetItemName(i);
 
-		if (CheckWildcardMatch(szPattern, filename.c_str(), FALSE) == 1)
+		if (wildcardMatcher.Matches(filename))
 		{
 			ListViewHelper::SelectItem(hListView, i, m_bSelect);
 		}
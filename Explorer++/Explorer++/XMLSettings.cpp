@@ -116,6 +116,16 @@ will need to be changed correspondingly. */
 #define HASH_DISPLAY_MIXED_FILES_AND_FOLDERS 1168704423
 #define HASH_USE_NATURAL_SORT_ORDER 528323501
 #define HASH_OPEN_TABS_IN_FOREGROUND 2957281235
+#define HASH_OWNER_DATA_LIST_VIEW 2718980001
+#define HASH_COLUMN_CONCURRENCY_SOLID_STATE 296748794
+#define HASH_COLUMN_CONCURRENCY_ROTATIONAL 784356091
+#define HASH_COLUMN_CONCURRENCY_REMOVABLE 3305542107
+#define HASH_COLUMN_CONCURRENCY_NETWORK 3124107528
+#define HASH_COLUMN_CONCURRENCY_OTHER 4141789184
+#define HASH_THUMBNAIL_MEMORY_LIMIT 1965687937
+#define HASH_SHARE_ICONS_BY_TYPE 4170647569
+#define HASH_PER_FILE_ICON_EXTENSIONS 744753189
+#define HASH_ITEM_CACHE_SIZE_LIMIT 3097787362
 
 struct ColumnXMLSaveData
 {
@@ -738,6 +748,50 @@ void Explorerplusplus::SaveGenericSettingsToXML(IXMLDOMDocument *pXMLDom, IXMLDO
 	NXMLSettings::WriteStandardSetting(pXMLDom, pe.get(), _T("Setting"), _T("OpenTabsInForeground"),
 		NXMLSettings::EncodeBoolValue(m_config->openTabsInForeground));
 
+	NXMLSettings::AddWhiteSpaceToNode(pXMLDom, bstr_wsntt.get(), pe.get());
+	NXMLSettings::WriteStandardSetting(pXMLDom, pe.get(), _T("Setting"), _T("OwnerDataListView"),
+		NXMLSettings::EncodeBoolValue(m_config->ownerDataListView));
+
+	NXMLSettings::AddWhiteSpaceToNode(pXMLDom, bstr_wsntt.get(), pe.get());
+	NXMLSettings::WriteStandardSetting(pXMLDom, pe.get(), _T("Setting"),
+		_T("ColumnConcurrencySolidState"),
+		NXMLSettings::EncodeIntValue(m_config->columnConcurrencySolidState));
+
+	NXMLSettings::AddWhiteSpaceToNode(pXMLDom, bstr_wsntt.get(), pe.get());
+	NXMLSettings::WriteStandardSetting(pXMLDom, pe.get(), _T("Setting"),
+		_T("ColumnConcurrencyRotational"),
+		NXMLSettings::EncodeIntValue(m_config->columnConcurrencyRotational));
+
+	NXMLSettings::AddWhiteSpaceToNode(pXMLDom, bstr_wsntt.get(), pe.get());
+	NXMLSettings::WriteStandardSetting(pXMLDom, pe.get(), _T("Setting"),
+		_T("ColumnConcurrencyRemovable"),
+		NXMLSettings::EncodeIntValue(m_config->columnConcurrencyRemovable));
+
+	NXMLSettings::AddWhiteSpaceToNode(pXMLDom, bstr_wsntt.get(), pe.get());
+	NXMLSettings::WriteStandardSetting(pXMLDom, pe.get(), _T("Setting"),
+		_T("ColumnConcurrencyNetwork"),
+		NXMLSettings::EncodeIntValue(m_config->columnConcurrencyNetwork));
+
+	NXMLSettings::AddWhiteSpaceToNode(pXMLDom, bstr_wsntt.get(), pe.get());
+	NXMLSettings::WriteStandardSetting(pXMLDom, pe.get(), _T("Setting"),
+		_T("ColumnConcurrencyOther"),
+		NXMLSettings::EncodeIntValue(m_config->columnConcurrencyOther));
+
+	NXMLSettings::AddWhiteSpaceToNode(pXMLDom, bstr_wsntt.get(), pe.get());
+	NXMLSettings::WriteStandardSetting(pXMLDom, pe.get(), _T("Setting"),
+		_T("ThumbnailMemoryLimit"), NXMLSettings::EncodeIntValue(m_config->thumbnailMemoryLimit));
+
+	NXMLSettings::AddWhiteSpaceToNode(pXMLDom, bstr_wsntt.get(), pe.get());
+	NXMLSettings::WriteStandardSetting(pXMLDom, pe.get(), _T("Setting"), _T("ShareIconsByType"),
+		NXMLSettings::EncodeBoolValue(m_config->shareIconsByType));
+	NXMLSettings::AddWhiteSpaceToNode(pXMLDom, bstr_wsntt.get(), pe.get());
+	NXMLSettings::WriteStandardSetting(pXMLDom, pe.get(), _T("Setting"),
+		_T("PerFileIconExtensions"), m_config->perFileIconExtensions.c_str());
+
+	NXMLSettings::AddWhiteSpaceToNode(pXMLDom, bstr_wsntt.get(), pe.get());
+	NXMLSettings::WriteStandardSetting(pXMLDom, pe.get(), _T("Setting"),
+		_T("ItemCacheSizeLimit"), NXMLSettings::EncodeIntValue(m_config->itemCacheSizeLimit));
+
 	auto bstr_wsnt = wil::make_bstr_nothrow(L"\n\t");
 	NXMLSettings::AddWhiteSpaceToNode(pXMLDom, bstr_wsnt.get(), pe.get());
 
@@ -1830,6 +1884,46 @@ void Explorerplusplus::MapAttributeToValue(IXMLDOMNode *pNode, WCHAR *wszName, W
 	case HASH_OPEN_TABS_IN_FOREGROUND:
 		m_config->openTabsInForeground = NXMLSettings::DecodeBoolValue(wszValue);
 		break;
+
+	case HASH_OWNER_DATA_LIST_VIEW:
+		m_config->ownerDataListView = NXMLSettings::DecodeBoolValue(wszValue);
+		break;
+
+	case HASH_COLUMN_CONCURRENCY_SOLID_STATE:
+		m_config->columnConcurrencySolidState = NXMLSettings::DecodeIntValue(wszValue);
+		break;
+
+	case HASH_COLUMN_CONCURRENCY_ROTATIONAL:
+		m_config->columnConcurrencyRotational = NXMLSettings::DecodeIntValue(wszValue);
+		break;
+
+	case HASH_COLUMN_CONCURRENCY_REMOVABLE:
+		m_config->columnConcurrencyRemovable = NXMLSettings::DecodeIntValue(wszValue);
+		break;
+
+	case HASH_COLUMN_CONCURRENCY_NETWORK:
+		m_config->columnConcurrencyNetwork = NXMLSettings::DecodeIntValue(wszValue);
+		break;
+
+	case HASH_COLUMN_CONCURRENCY_OTHER:
+		m_config->columnConcurrencyOther = NXMLSettings::DecodeIntValue(wszValue);
+		break;
+
+	case HASH_THUMBNAIL_MEMORY_LIMIT:
+		m_config->thumbnailMemoryLimit = NXMLSettings::DecodeIntValue(wszValue);
+		break;
+
+	case HASH_SHARE_ICONS_BY_TYPE:
+		m_config->shareIconsByType = NXMLSettings::DecodeBoolValue(wszValue);
+		break;
+
+	case HASH_PER_FILE_ICON_EXTENSIONS:
+		m_config->perFileIconExtensions = wszValue;
+		break;
+
+	case HASH_ITEM_CACHE_SIZE_LIMIT:
+		m_config->itemCacheSizeLimit = NXMLSettings::DecodeIntValue(wszValue);
+		break;
 	}
 }
 
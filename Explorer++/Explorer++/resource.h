@@ -182,6 +182,8 @@
 #define IDS_BACKGROUND_CONTEXT_MENU_VIEW 365
 #define IDS_BACKGROUND_CONTEXT_MENU_SORT_BY 366
 #define IDS_BACKGROUND_CONTEXT_MENU_GROUP_BY 367
+#define IDS_ADVANCED_OPTION_OWNER_DATA_LIST_VIEW_NAME 368
+#define IDS_ADVANCED_OPTION_OWNER_DATA_LIST_VIEW_DESCRIPTION 369
 #define IDC_DEFAULTCOLUMNS_DESCRIPTION  1001
 #define IDC_COLUMNS_DESCRIPTION         1001
 #define IDC_SETTINGS_CHECK_EXTENSIONS   1002
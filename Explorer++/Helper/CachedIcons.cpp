@@ -6,7 +6,9 @@
 #include "CachedIcons.h"
 #include "ShellHelper.h"
 
-CachedIcons::CachedIcons(std::size_t maxItems) : m_maxItems(maxItems)
+CachedIcons::CachedIcons(std::size_t maxItems) :
+	m_maxItems(maxItems),
+	m_iconClassRules(DoesFileTypeUseCustomIcons)
 {
 }
 
@@ -62,4 +64,29 @@ CachedIcons::iterator CachedIcons::findByPath(const std::wstring &filePath)
 {
 	CachedIconSetByPath &pathIndex = m_cachedIconSet.get<1>();
 	return pathIndex.find(filePath);
+}
+
+void CachedIcons::addOrUpdateClassIcon(const std::wstring &iconClass, int iconIndex)
+{
+	std::scoped_lock lock(m_classIconsMutex);
+	m_classIcons[iconClass] = iconIndex;
+}
+
+std::optional<int> CachedIcons::findByClass(const std::wstring &iconClass) const
+{
+	std::scoped_lock lock(m_classIconsMutex);
+
+	auto itr = m_classIcons.find(iconClass);
+
+	if (itr == m_classIcons.end())
+	{
+		return std::nullopt;
+	}
+
+	return itr->second;
+}
+
+IconClassRules &CachedIcons::getIconClassRules()
+{
+	return m_iconClassRules;
 }
\ No newline at end of file
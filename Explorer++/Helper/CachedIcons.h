@@ -4,10 +4,14 @@
 
 #pragma once
 
+#include "IconClassRules.h"
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/sequenced_index.hpp>
 #include <boost/multi_index_container.hpp>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 
 struct CachedIcon
 {
@@ -36,7 +40,20 @@ public:
 	void replace(CachedIconSetByPath::iterator itr, const CachedIcon &cachedIcon);
 	iterator findByPath(const std::wstring &filePath);
 
+	// Icons shared by every file in an icon class (see IconClassRules). Unlike the per-file icons
+	// above, these can be accessed from any thread. There's one entry per file type, so these
+	// entries are never evicted.
+	void addOrUpdateClassIcon(const std::wstring &iconClass, int iconIndex);
+	std::optional<int> findByClass(const std::wstring &iconClass) const;
+
+	IconClassRules &getIconClassRules();
+
 private:
 	CachedIconSet m_cachedIconSet;
 	std::size_t m_maxItems;
+
+	mutable std::mutex m_classIconsMutex;
+	std::unordered_map<std::wstring, int> m_classIcons;
+
+	IconClassRules m_iconClassRules;
 };
\ No newline at end of file
@@ -3,10 +3,55 @@
 // See LICENSE in the top level directory
 
 #include "stdafx.h"
+#include "DriveInfo.h"
 #include "FileOperations.h"
 #include "Helper.h"
 #include "Macros.h"
+#include <wil/resource.h>
+#include <winioctl.h>
+#include <optional>
 
+namespace
+{
+	// Returns whether or not the device that backs the specified volume incurs a seek penalty.
+	// volumeName should be a volume GUID path (e.g. \\?\Volume{...}\).
+	std::optional<bool> IncursSeekPenalty(const std::wstring &volumeName)
+	{
+		// Without the trailing backslash, the volume itself is opened, rather than its root
+		// directory. No access rights are needed to query the device properties.
+		std::wstring devicePath = volumeName;
+
+		if (!devicePath.empty() && devicePath.back() == '\\')
+		{
+			devicePath.pop_back();
+		}
+
+		wil::unique_hfile device(CreateFile(devicePath.c_str(), 0,
+			FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr));
+
+		if (!device)
+		{
+			return std::nullopt;
+		}
+
+		STORAGE_PROPERTY_QUERY query = {};
+		query.PropertyId = StorageDeviceSeekPenaltyProperty;
+		query.QueryType = PropertyStandardQuery;
+
+		DEVICE_SEEK_PENALTY_DESCRIPTOR descriptor = {};
+		DWORD bytesReturned;
+		BOOL res = DeviceIoControl(device.get(), IOCTL_STORAGE_QUERY_PROPERTY, &query,
+			sizeof(query), &descriptor, sizeof(descriptor), &bytesReturned, nullptr);
+
+		if (!res || bytesReturned < sizeof(descriptor))
+		{
+			return std::nullopt;
+		}
+
+		return descriptor.IncursSeekPenalty != FALSE;
+	}
+}
+
 BOOL GetClusterSize(const TCHAR *drive, DWORD *pdwClusterSize)
 {
 	DWORD dwSectorsPerCluster;
@@ -44,4 +89,49 @@ TCHAR GetDriveLetterFromMask(ULONG unitmask)
 	}
 
 	return (TCHAR) bitNum + 'A';
+}
+
+VolumeType GetVolumeType(const std::wstring &path)
+{
+	TCHAR volumePath[MAX_PATH];
+	BOOL res = GetVolumePathName(path.c_str(), volumePath, SIZEOF_ARRAY(volumePath));
+
+	if (!res)
+	{
+		return VolumeType::Other;
+	}
+
+	switch (GetDriveType(volumePath))
+	{
+	case DRIVE_REMOTE:
+		return VolumeType::Network;
+
+	case DRIVE_REMOVABLE:
+		return VolumeType::Removable;
+
+	case DRIVE_FIXED:
+		break;
+
+	default:
+		return VolumeType::Other;
+	}
+
+	TCHAR volumeName[MAX_PATH];
+	res = GetVolumeNameForVolumeMountPoint(volumePath, volumeName, SIZEOF_ARRAY(volumeName));
+
+	if (!res)
+	{
+		return VolumeType::Rotational;
+	}
+
+	// If the seek penalty can't be determined, the disk is treated as rotational, since that's
+	// the more conservative choice.
+	auto seekPenalty = IncursSeekPenalty(volumeName);
+
+	if (!seekPenalty || *seekPenalty)
+	{
+		return VolumeType::Rotational;
+	}
+
+	return VolumeType::SolidState;
 }
\ No newline at end of file
@@ -5,6 +5,23 @@
 #pragma once
 
 #include <Windows.h>
+#include <string>
+
+enum class VolumeType
+{
+	// A fixed disk without a seek penalty (e.g. an SSD).
+	SolidState,
+
+	// A fixed disk with a seek penalty (e.g. a hard disk).
+	Rotational,
+
+	Removable,
+	Network,
+
+	// Optical drives, RAM disks and anything that can't be identified.
+	Other
+};
 
 BOOL GetClusterSize(const TCHAR *drive, DWORD *pdwClusterSize);
-TCHAR GetDriveLetterFromMask(ULONG unitmask);
\ No newline at end of file
+TCHAR GetDriveLetterFromMask(ULONG unitmask);
+VolumeType GetVolumeType(const std::wstring &path);
\ No newline at end of file
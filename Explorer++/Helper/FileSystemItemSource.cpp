@@ -0,0 +1,372 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+// This file doesn't use the precompiled header, so that it can also be built (along with its tests)
+// on platforms other than Windows.
+#include "FileSystemItemSource.h"
+#include <string_view>
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include <wil/resource.h>
+#else
+	#include <dirent.h>
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <cerrno>
+	#include <filesystem>
+#endif
+
+namespace
+{
+	bool IsDotOrDotDot(std::wstring_view name)
+	{
+		return name == L"." || name == L"..";
+	}
+
+#ifdef _WIN32
+
+	std::uint64_t LargeIntegerToUInt64(const LARGE_INTEGER &value)
+	{
+		return static_cast<std::uint64_t>(value.QuadPart);
+	}
+
+	// Uses GetFileInformationByHandleEx to retrieve the directory contents. Each call fills a
+	// large buffer with the full details (name, attributes, size and times) for as many items as
+	// will fit.
+	class Win32ItemSource : public ItemSource
+	{
+	public:
+		static std::unique_ptr<ItemSource> Create(const std::wstring &directory)
+		{
+			wil::unique_hfile directoryHandle(CreateFile(directory.c_str(), FILE_LIST_DIRECTORY,
+				FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+				FILE_FLAG_BACKUP_SEMANTICS, nullptr));
+
+			if (!directoryHandle)
+			{
+				return nullptr;
+			}
+
+			return std::unique_ptr<ItemSource>(new Win32ItemSource(std::move(directoryHandle)));
+		}
+
+		bool ReadBatch(std::vector<FileSystemItem> &items, std::size_t maxItems) override
+		{
+			std::size_t numRead = 0;
+
+			while (numRead < maxItems)
+			{
+				if (!m_currentEntry && !ReadNextBlock())
+				{
+					return false;
+				}
+
+				const FILE_FULL_DIR_INFO *entry = m_currentEntry;
+
+				if (entry->NextEntryOffset != 0)
+				{
+					m_currentEntry = reinterpret_cast<const FILE_FULL_DIR_INFO *>(
+						reinterpret_cast<const BYTE *>(entry) + entry->NextEntryOffset);
+				}
+				else
+				{
+					m_currentEntry = nullptr;
+				}
+
+				std::wstring_view name(entry->FileName, entry->FileNameLength / sizeof(WCHAR));
+
+				if (IsDotOrDotDot(name))
+				{
+					continue;
+				}
+
+				FileSystemItem item;
+				item.name = name;
+				item.attributes = entry->FileAttributes;
+				item.size = LargeIntegerToUInt64(entry->EndOfFile);
+				item.creationTime = LargeIntegerToUInt64(entry->CreationTime);
+				item.lastAccessTime = LargeIntegerToUInt64(entry->LastAccessTime);
+				item.lastWriteTime = LargeIntegerToUInt64(entry->LastWriteTime);
+				items.push_back(std::move(item));
+
+				numRead++;
+			}
+
+			return true;
+		}
+
+		std::error_code GetError() const override
+		{
+			return m_error;
+		}
+
+	private:
+		// Large enough to hold several hundred entries.
+		static const std::size_t BUFFER_SIZE = 64 * 1024;
+
+		explicit Win32ItemSource(wil::unique_hfile directoryHandle) :
+			m_directoryHandle(std::move(directoryHandle)),
+			m_buffer(BUFFER_SIZE / sizeof(LONGLONG)),
+			m_currentEntry(nullptr),
+			m_firstBlock(true),
+			m_finished(false)
+		{
+		}
+
+		bool ReadNextBlock()
+		{
+			if (m_finished)
+			{
+				return false;
+			}
+
+			FILE_INFO_BY_HANDLE_CLASS infoClass =
+				m_firstBlock ? FileFullDirectoryRestartInfo : FileFullDirectoryInfo;
+			m_firstBlock = false;
+
+			BOOL res = GetFileInformationByHandleEx(m_directoryHandle.get(), infoClass,
+				m_buffer.data(), static_cast<DWORD>(m_buffer.size() * sizeof(LONGLONG)));
+
+			if (!res)
+			{
+				m_finished = true;
+
+				// ERROR_NO_MORE_FILES simply indicates that all the items have been returned. Any
+				// other error (e.g. the device being removed, or a network folder becoming
+				// unavailable) means that the listing is incomplete.
+				DWORD error = GetLastError();
+
+				if (error != ERROR_NO_MORE_FILES)
+				{
+					m_error = std::error_code(static_cast<int>(error), std::system_category());
+				}
+
+				return false;
+			}
+
+			m_currentEntry = reinterpret_cast<const FILE_FULL_DIR_INFO *>(m_buffer.data());
+
+			return true;
+		}
+
+		wil::unique_hfile m_directoryHandle;
+
+		// The entries in the buffer need to be 8-byte aligned.
+		std::vector<LONGLONG> m_buffer;
+		const FILE_FULL_DIR_INFO *m_currentEntry;
+		bool m_firstBlock;
+		bool m_finished;
+		std::error_code m_error;
+	};
+
+#else
+
+	// The number of 100-nanosecond intervals between January 1, 1601 and January 1, 1970.
+	constexpr std::uint64_t FILETIME_UNIX_EPOCH_OFFSET = 116444736000000000ULL;
+
+	std::uint64_t UnixTimeToFileTime(std::int64_t seconds, std::uint32_t nanoseconds)
+	{
+		return FILETIME_UNIX_EPOCH_OFFSET + static_cast<std::uint64_t>(seconds) * 10000000ULL
+			+ nanoseconds / 100;
+	}
+
+	struct ItemStatus
+	{
+		bool isDirectory = false;
+		bool isSymbolicLink = false;
+		bool isWritable = false;
+		std::uint64_t size = 0;
+
+		// Zero if the file system doesn't record the time an item was created.
+		std::uint64_t creationTime = 0;
+
+		std::uint64_t lastAccessTime = 0;
+		std::uint64_t lastWriteTime = 0;
+	};
+
+	// Retrieves the details for an item, relative to the open directory (so that the path doesn't
+	// need to be resolved again). stat() has no creation time (st_ctim is the time the inode was
+	// last changed), so statx() is used where it's available.
+	bool GetItemStatus(int directoryFd, const char *name, bool followLinks, ItemStatus &status)
+	{
+	#ifdef STATX_BTIME
+		struct statx info;
+
+		if (statx(directoryFd, name, followLinks ? 0 : AT_SYMLINK_NOFOLLOW,
+				STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_ATIME | STATX_MTIME | STATX_BTIME,
+				&info)
+			!= 0)
+		{
+			return false;
+		}
+
+		status.isDirectory = S_ISDIR(info.stx_mode);
+		status.isSymbolicLink = S_ISLNK(info.stx_mode);
+		status.isWritable = (info.stx_mode & S_IWUSR) != 0;
+		status.size = info.stx_size;
+		status.creationTime = (info.stx_mask & STATX_BTIME)
+			? UnixTimeToFileTime(info.stx_btime.tv_sec, info.stx_btime.tv_nsec)
+			: 0;
+		status.lastAccessTime = UnixTimeToFileTime(info.stx_atime.tv_sec, info.stx_atime.tv_nsec);
+		status.lastWriteTime = UnixTimeToFileTime(info.stx_mtime.tv_sec, info.stx_mtime.tv_nsec);
+	#else
+		struct stat info;
+
+		if (fstatat(directoryFd, name, &info, followLinks ? 0 : AT_SYMLINK_NOFOLLOW) != 0)
+		{
+			return false;
+		}
+
+		status.isDirectory = S_ISDIR(info.st_mode);
+		status.isSymbolicLink = S_ISLNK(info.st_mode);
+		status.isWritable = (info.st_mode & S_IWUSR) != 0;
+		status.size = static_cast<std::uint64_t>(info.st_size);
+		status.creationTime = 0;
+		status.lastAccessTime = UnixTimeToFileTime(info.st_atim.tv_sec, info.st_atim.tv_nsec);
+		status.lastWriteTime = UnixTimeToFileTime(info.st_mtim.tv_sec, info.st_mtim.tv_nsec);
+	#endif
+
+		return true;
+	}
+
+	// Uses readdir to retrieve the names and GetItemStatus to retrieve the details for each item.
+	class PosixItemSource : public ItemSource
+	{
+	public:
+		static std::unique_ptr<ItemSource> Create(const std::wstring &directory)
+		{
+			DIR *dir = opendir(std::filesystem::path(directory).c_str());
+
+			if (!dir)
+			{
+				return nullptr;
+			}
+
+			return std::unique_ptr<ItemSource>(new PosixItemSource(dir));
+		}
+
+		~PosixItemSource()
+		{
+			closedir(m_dir);
+		}
+
+		bool ReadBatch(std::vector<FileSystemItem> &items, std::size_t maxItems) override
+		{
+			std::size_t numRead = 0;
+
+			while (numRead < maxItems)
+			{
+				// readdir() returns nullptr both at the end of the directory and on error. The
+				// two can only be distinguished through errno.
+				errno = 0;
+				const dirent *entry = readdir(m_dir);
+
+				if (!entry)
+				{
+					if (errno != 0)
+					{
+						m_error = std::error_code(errno, std::system_category());
+					}
+
+					return false;
+				}
+
+				std::wstring name = std::filesystem::path(entry->d_name).wstring();
+
+				if (IsDotOrDotDot(name))
+				{
+					continue;
+				}
+
+				ItemStatus status;
+
+				// The item may have been deleted since the directory was read, in which case
+				// it's skipped.
+				if (!GetItemStatus(dirfd(m_dir), entry->d_name, false, status))
+				{
+					continue;
+				}
+
+				std::uint32_t attributes = 0;
+
+				if (status.isSymbolicLink)
+				{
+					attributes |= FileSystemItemAttributes::REPARSE_POINT;
+
+					// As on Windows, the details reported for a link are those of its target
+					// (when the target exists).
+					ItemStatus targetStatus;
+
+					if (GetItemStatus(dirfd(m_dir), entry->d_name, true, targetStatus))
+					{
+						status = targetStatus;
+					}
+				}
+
+				if (status.isDirectory)
+				{
+					attributes |= FileSystemItemAttributes::DIRECTORY;
+				}
+
+				if (entry->d_name[0] == '.')
+				{
+					attributes |= FileSystemItemAttributes::HIDDEN;
+				}
+
+				if (!status.isWritable)
+				{
+					attributes |= FileSystemItemAttributes::READ_ONLY;
+				}
+
+				if (attributes == 0)
+				{
+					attributes = FileSystemItemAttributes::NORMAL;
+				}
+
+				FileSystemItem item;
+				item.name = std::move(name);
+				item.attributes = attributes;
+				item.size = status.isDirectory ? 0 : status.size;
+				item.creationTime = status.creationTime;
+				item.lastAccessTime = status.lastAccessTime;
+				item.lastWriteTime = status.lastWriteTime;
+				items.push_back(std::move(item));
+
+				numRead++;
+			}
+
+			return true;
+		}
+
+		std::error_code GetError() const override
+		{
+			return m_error;
+		}
+
+	private:
+		explicit PosixItemSource(DIR *dir) : m_dir(dir)
+		{
+		}
+
+		DIR *m_dir;
+		std::error_code m_error;
+	};
+
+#endif
+}
+
+bool FileSystemItem::IsDirectory() const
+{
+	return (attributes & FileSystemItemAttributes::DIRECTORY) != 0;
+}
+
+std::unique_ptr<ItemSource> CreateFileSystemItemSource(const std::wstring &directory)
+{
+#ifdef _WIN32
+	return Win32ItemSource::Create(directory);
+#else
+	return PosixItemSource::Create(directory);
+#endif
+}
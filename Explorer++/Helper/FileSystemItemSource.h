@@ -0,0 +1,61 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// A single directory entry. Attributes use the FileSystemItemAttributes values and times are
+// stored in FILETIME units (100-nanosecond intervals since January 1, 1601 UTC), so that an entry
+// can be converted directly into a WIN32_FIND_DATA structure.
+struct FileSystemItem
+{
+	std::wstring name;
+	std::uint32_t attributes = 0;
+	std::uint64_t size = 0;
+	std::uint64_t creationTime = 0;
+	std::uint64_t lastAccessTime = 0;
+	std::uint64_t lastWriteTime = 0;
+
+	bool IsDirectory() const;
+};
+
+// Provides the items within a directory, a batch at a time.
+class ItemSource
+{
+public:
+	virtual ~ItemSource() = default;
+
+	// Appends up to maxItems items to the provided vector. Returns false once there are no items
+	// left to read (or if an error occurred), though any items appended on that call are still
+	// valid.
+	virtual bool ReadBatch(std::vector<FileSystemItem> &items, std::size_t maxItems) = 0;
+
+	// Once ReadBatch() has returned false, this indicates whether every item was read (an empty
+	// error code) or whether reading stopped because of an error. The error is a system error
+	// (i.e. a Win32 error code on Windows and an errno value elsewhere).
+	virtual std::error_code GetError() const = 0;
+};
+
+namespace FileSystemItemAttributes
+{
+	// These match the equivalent FILE_ATTRIBUTE_* values. They're defined here so that the POSIX
+	// implementation can produce the same values.
+	constexpr std::uint32_t READ_ONLY = 0x1;
+	constexpr std::uint32_t HIDDEN = 0x2;
+	constexpr std::uint32_t SYSTEM = 0x4;
+	constexpr std::uint32_t DIRECTORY = 0x10;
+	constexpr std::uint32_t NORMAL = 0x80;
+	constexpr std::uint32_t REPARSE_POINT = 0x400;
+}
+
+// Creates an item source that reads the contents of the specified directory using a bulk native
+// API (GetFileInformationByHandleEx on Windows, readdir/fstatat elsewhere). The names, attributes,
+// sizes and times for many items are retrieved with each call, rather than one item at a time.
+// The "." and ".." entries are never returned. Returns nullptr if the directory can't be opened.
+std::unique_ptr<ItemSource> CreateFileSystemItemSource(const std::wstring &directory);
@@ -0,0 +1,976 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "FilterExpression.h"
+#include "TimeHelper.h"
+#include <algorithm>
+#include <cwctype>
+#include <optional>
+
+namespace
+{
+	constexpr ULONGLONG TICKS_PER_HOUR = 10000000ULL * 60 * 60;
+	constexpr ULONGLONG TICKS_PER_DAY = TICKS_PER_HOUR * 24;
+
+	enum class Field
+	{
+		Name,
+		Extension,
+		Size,
+		Modified,
+		Created,
+		Accessed,
+		Attributes
+	};
+
+	struct Token
+	{
+		enum class Type
+		{
+			Word,
+			Comparison,
+			And,
+			Or,
+			Not,
+			OpenParen,
+			CloseParen,
+			End
+		};
+
+		Type type;
+
+		// For a word, the pattern. For a comparison, the value being compared against.
+		std::wstring text;
+
+		Field field = Field::Name;
+		std::wstring_view comparisonOperator;
+	};
+
+	std::wstring ToLower(std::wstring_view str)
+	{
+		std::wstring lowercaseStr(str);
+		std::transform(lowercaseStr.begin(), lowercaseStr.end(), lowercaseStr.begin(),
+			[](wchar_t ch) { return static_cast<wchar_t>(std::towlower(ch)); });
+		return lowercaseStr;
+	}
+
+	std::optional<Field> ParseField(std::wstring_view identifier)
+	{
+		std::wstring lowercaseIdentifier = ToLower(identifier);
+
+		if (lowercaseIdentifier == L"name")
+		{
+			return Field::Name;
+		}
+		else if (lowercaseIdentifier == L"ext")
+		{
+			return Field::Extension;
+		}
+		else if (lowercaseIdentifier == L"size")
+		{
+			return Field::Size;
+		}
+		else if (lowercaseIdentifier == L"modified")
+		{
+			return Field::Modified;
+		}
+		else if (lowercaseIdentifier == L"created")
+		{
+			return Field::Created;
+		}
+		else if (lowercaseIdentifier == L"accessed")
+		{
+			return Field::Accessed;
+		}
+		else if (lowercaseIdentifier == L"attr")
+		{
+			return Field::Attributes;
+		}
+
+		return std::nullopt;
+	}
+
+	Token ClassifyWord(std::wstring word, bool quoted)
+	{
+		if (!quoted)
+		{
+			std::wstring lowercaseWord = ToLower(word);
+
+			if (lowercaseWord == L"and")
+			{
+				return { Token::Type::And };
+			}
+			else if (lowercaseWord == L"or")
+			{
+				return { Token::Type::Or };
+			}
+			else if (lowercaseWord == L"not")
+			{
+				return { Token::Type::Not };
+			}
+		}
+
+		// A comparison is a field name, followed immediately by an operator.
+		std::size_t identifierLength = 0;
+
+		while (identifierLength < word.size()
+			&& ((word[identifierLength] >= 'a' && word[identifierLength] <= 'z')
+				|| (word[identifierLength] >= 'A' && word[identifierLength] <= 'Z')))
+		{
+			identifierLength++;
+		}
+
+		auto field = ParseField(std::wstring_view(word).substr(0, identifierLength));
+
+		if (field)
+		{
+			static constexpr std::wstring_view OPERATORS[] = { L"!=", L"<=", L">=", L"<", L">",
+				L"=", L":" };
+			std::wstring_view remainder = std::wstring_view(word).substr(identifierLength);
+
+			for (auto comparisonOperator : OPERATORS)
+			{
+				if (remainder.substr(0, comparisonOperator.size()) == comparisonOperator)
+				{
+					Token token = { Token::Type::Comparison };
+					token.text = remainder.substr(comparisonOperator.size());
+					token.field = *field;
+					token.comparisonOperator = comparisonOperator;
+					return token;
+				}
+			}
+		}
+
+		return { Token::Type::Word, std::move(word) };
+	}
+
+	std::optional<std::vector<Token>> Tokenize(std::wstring_view text)
+	{
+		std::vector<Token> tokens;
+		std::size_t pos = 0;
+
+		while (true)
+		{
+			while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t'))
+			{
+				pos++;
+			}
+
+			if (pos == text.size())
+			{
+				tokens.push_back({ Token::Type::End });
+				break;
+			}
+
+			if (text[pos] == '(')
+			{
+				tokens.push_back({ Token::Type::OpenParen });
+				pos++;
+				continue;
+			}
+			else if (text[pos] == ')')
+			{
+				tokens.push_back({ Token::Type::CloseParen });
+				pos++;
+				continue;
+			}
+
+			// Quoted sections can appear anywhere within a word and can contain any character
+			// other than a quote.
+			std::wstring word;
+			bool quoted = false;
+
+			while (pos < text.size() && text[pos] != ' ' && text[pos] != '\t' && text[pos] != '('
+				&& text[pos] != ')')
+			{
+				if (text[pos] == '"')
+				{
+					std::size_t closingQuote = text.find('"', pos + 1);
+
+					if (closingQuote == std::wstring_view::npos)
+					{
+						return std::nullopt;
+					}
+
+					word += text.substr(pos + 1, closingQuote - pos - 1);
+					pos = closingQuote + 1;
+					quoted = true;
+					continue;
+				}
+
+				word.push_back(text[pos]);
+				pos++;
+			}
+
+			tokens.push_back(ClassifyWord(std::move(word), quoted));
+		}
+
+		return tokens;
+	}
+
+	// Parses a non-negative decimal number from the start of the string, returning the number and
+	// the number of characters consumed.
+	std::optional<std::pair<double, std::size_t>> ParseNumber(std::wstring_view str)
+	{
+		double number = 0;
+		std::size_t pos = 0;
+
+		while (pos < str.size() && str[pos] >= '0' && str[pos] <= '9')
+		{
+			number = number * 10 + (str[pos] - '0');
+			pos++;
+		}
+
+		std::size_t numIntegerDigits = pos;
+		std::size_t numFractionalDigits = 0;
+
+		if (pos < str.size() && str[pos] == '.')
+		{
+			pos++;
+			double scale = 0.1;
+
+			while (pos < str.size() && str[pos] >= '0' && str[pos] <= '9')
+			{
+				number += (str[pos] - '0') * scale;
+				scale /= 10;
+				pos++;
+				numFractionalDigits++;
+			}
+		}
+
+		if (numIntegerDigits == 0 && numFractionalDigits == 0)
+		{
+			return std::nullopt;
+		}
+
+		return std::make_pair(number, pos);
+	}
+
+	std::optional<std::uint64_t> ParseSize(std::wstring_view value)
+	{
+		auto number = ParseNumber(value);
+
+		if (!number)
+		{
+			return std::nullopt;
+		}
+
+		std::wstring unit = ToLower(value.substr(number->second));
+		double multiplier;
+
+		if (unit.empty() || unit == L"b")
+		{
+			multiplier = 1;
+		}
+		else if (unit == L"k" || unit == L"kb")
+		{
+			multiplier = 1024.0;
+		}
+		else if (unit == L"m" || unit == L"mb")
+		{
+			multiplier = 1024.0 * 1024;
+		}
+		else if (unit == L"g" || unit == L"gb")
+		{
+			multiplier = 1024.0 * 1024 * 1024;
+		}
+		else if (unit == L"t" || unit == L"tb")
+		{
+			multiplier = 1024.0 * 1024 * 1024 * 1024;
+		}
+		else
+		{
+			return std::nullopt;
+		}
+
+		return static_cast<std::uint64_t>(number->first * multiplier + 0.5);
+	}
+
+	// Returns the duration, in 100-nanosecond intervals.
+	std::optional<ULONGLONG> ParseDuration(std::wstring_view value)
+	{
+		auto number = ParseNumber(value);
+
+		if (!number)
+		{
+			return std::nullopt;
+		}
+
+		std::wstring unit = ToLower(value.substr(number->second));
+		ULONGLONG unitTicks;
+
+		if (unit == L"h")
+		{
+			unitTicks = TICKS_PER_HOUR;
+		}
+		else if (unit == L"d")
+		{
+			unitTicks = TICKS_PER_DAY;
+		}
+		else if (unit == L"w")
+		{
+			unitTicks = TICKS_PER_DAY * 7;
+		}
+		else if (unit == L"y")
+		{
+			unitTicks = TICKS_PER_DAY * 365;
+		}
+		else
+		{
+			return std::nullopt;
+		}
+
+		return static_cast<ULONGLONG>(number->first * unitTicks);
+	}
+
+	// Parses a date in the form YYYY-MM-DD and returns the start and end of that day (in local
+	// time), as UTC times.
+	std::optional<std::pair<ULONGLONG, ULONGLONG>> ParseDate(std::wstring_view value)
+	{
+		if (value.size() != 10 || value[4] != '-' || value[7] != '-')
+		{
+			return std::nullopt;
+		}
+
+		auto parseDigits = [value](std::size_t start, std::size_t length) -> std::optional<WORD> {
+			WORD result = 0;
+
+			for (std::size_t i = start; i < start + length; i++)
+			{
+				if (value[i] < '0' || value[i] > '9')
+				{
+					return std::nullopt;
+				}
+
+				result = static_cast<WORD>(result * 10 + (value[i] - '0'));
+			}
+
+			return result;
+		};
+
+		auto year = parseDigits(0, 4);
+		auto month = parseDigits(5, 2);
+		auto day = parseDigits(8, 2);
+
+		if (!year || !month || !day)
+		{
+			return std::nullopt;
+		}
+
+		SYSTEMTIME startOfDay = {};
+		startOfDay.wYear = *year;
+		startOfDay.wMonth = *month;
+		startOfDay.wDay = *day;
+
+		// The following day is found by treating the local time as if it were UTC, so that the
+		// calculation isn't affected by daylight saving transitions.
+		FILETIME startOfDayUnadjusted;
+
+		if (!SystemTimeToFileTime(&startOfDay, &startOfDayUnadjusted))
+		{
+			return std::nullopt;
+		}
+
+		FILETIME startOfNextDayUnadjusted =
+			UInt64ToFileTime(FileTimeToUInt64(startOfDayUnadjusted) + TICKS_PER_DAY);
+		SYSTEMTIME startOfNextDay;
+
+		if (!FileTimeToSystemTime(&startOfNextDayUnadjusted, &startOfNextDay))
+		{
+			return std::nullopt;
+		}
+
+		FILETIME start;
+		FILETIME end;
+
+		if (!LocalSystemTimeToFileTime(&startOfDay, &start)
+			|| !LocalSystemTimeToFileTime(&startOfNextDay, &end))
+		{
+			return std::nullopt;
+		}
+
+		return std::make_pair(FileTimeToUInt64(start), FileTimeToUInt64(end));
+	}
+
+	std::optional<DWORD> ParseAttributes(std::wstring_view value)
+	{
+		if (value.empty())
+		{
+			return std::nullopt;
+		}
+
+		DWORD attributes = 0;
+
+		for (wchar_t ch : value)
+		{
+			switch (std::towlower(ch))
+			{
+			case 'r':
+				attributes |= FILE_ATTRIBUTE_READONLY;
+				break;
+
+			case 'h':
+				attributes |= FILE_ATTRIBUTE_HIDDEN;
+				break;
+
+			case 's':
+				attributes |= FILE_ATTRIBUTE_SYSTEM;
+				break;
+
+			case 'a':
+				attributes |= FILE_ATTRIBUTE_ARCHIVE;
+				break;
+
+			case 'd':
+				attributes |= FILE_ATTRIBUTE_DIRECTORY;
+				break;
+
+			case 'c':
+				attributes |= FILE_ATTRIBUTE_COMPRESSED;
+				break;
+
+			case 'e':
+				attributes |= FILE_ATTRIBUTE_ENCRYPTED;
+				break;
+
+			default:
+				return std::nullopt;
+			}
+		}
+
+		return attributes;
+	}
+
+	std::wstring_view GetExtension(std::wstring_view fileName)
+	{
+		std::size_t dotPosition = fileName.find_last_of('.');
+
+		if (dotPosition == std::wstring_view::npos)
+		{
+			return {};
+		}
+
+		return fileName.substr(dotPosition + 1);
+	}
+}
+
+// A recursive descent parser, which emits instructions as each part of the expression is parsed.
+// The grammar is:
+//
+// or-expression  = and-expression *("or" and-expression)
+// and-expression = unary *(["and"] unary)
+// unary          = "not" unary / primary
+// primary        = "(" or-expression ")" / comparison / pattern
+class FilterExpression::Parser
+{
+public:
+	Parser(const std::vector<Token> &tokens, bool caseSensitive, ULONGLONG currentTime,
+		std::vector<Instruction> &instructions, std::vector<WildcardMatcher> &matchers) :
+		m_tokens(tokens),
+		m_caseSensitive(caseSensitive),
+		m_currentTime(currentTime),
+		m_instructions(instructions),
+		m_matchers(matchers)
+	{
+	}
+
+	bool Parse()
+	{
+		if (!ParseOr() || m_tokens[m_position].type != Token::Type::End)
+		{
+			return false;
+		}
+
+		return m_maxStackDepth <= MAX_STACK_DEPTH;
+	}
+
+	// Returns true if at least one field comparison (e.g. size>1MB) appeared in the expression.
+	bool HasComparison() const
+	{
+		return m_hasComparison;
+	}
+
+private:
+	bool ParseOr()
+	{
+		if (!ParseAnd())
+		{
+			return false;
+		}
+
+		while (Peek() == Token::Type::Or)
+		{
+			m_position++;
+
+			if (!ParseAnd())
+			{
+				return false;
+			}
+
+			Emit({ OpCode::Or });
+		}
+
+		return true;
+	}
+
+	bool ParseAnd()
+	{
+		if (!ParseUnary())
+		{
+			return false;
+		}
+
+		while (Peek() != Token::Type::Or && Peek() != Token::Type::CloseParen
+			&& Peek() != Token::Type::End)
+		{
+			if (Peek() == Token::Type::And)
+			{
+				m_position++;
+			}
+
+			if (!ParseUnary())
+			{
+				return false;
+			}
+
+			Emit({ OpCode::And });
+		}
+
+		return true;
+	}
+
+	bool ParseUnary()
+	{
+		if (Peek() == Token::Type::Not)
+		{
+			m_position++;
+
+			if (!ParseUnary())
+			{
+				return false;
+			}
+
+			Emit({ OpCode::Not });
+			return true;
+		}
+
+		return ParsePrimary();
+	}
+
+	bool ParsePrimary()
+	{
+		const Token &token = m_tokens[m_position];
+
+		switch (token.type)
+		{
+		case Token::Type::OpenParen:
+			m_position++;
+
+			if (!ParseOr() || Peek() != Token::Type::CloseParen)
+			{
+				return false;
+			}
+
+			m_position++;
+			return true;
+
+		case Token::Type::Comparison:
+			m_position++;
+			m_hasComparison = true;
+			return EmitComparison(token);
+
+		case Token::Type::Word:
+			m_position++;
+			EmitMatch(OpCode::MatchName, token.text);
+			return true;
+
+		default:
+			return false;
+		}
+	}
+
+	bool EmitComparison(const Token &token)
+	{
+		auto comparisonOperator = ParseComparisonOperator(token.comparisonOperator);
+
+		switch (token.field)
+		{
+		case Field::Name:
+		case Field::Extension:
+		case Field::Attributes:
+			if (comparisonOperator != ComparisonOperator::Equal
+				&& comparisonOperator != ComparisonOperator::NotEqual)
+			{
+				return false;
+			}
+
+			if (token.field == Field::Attributes)
+			{
+				auto attributes = ParseAttributes(token.text);
+
+				if (!attributes)
+				{
+					return false;
+				}
+
+				Instruction instruction = { OpCode::HasAttributes };
+				instruction.value = *attributes;
+				Emit(instruction);
+			}
+			else
+			{
+				EmitMatch(token.field == Field::Name ? OpCode::MatchName : OpCode::MatchExtension,
+					token.text);
+			}
+
+			if (comparisonOperator == ComparisonOperator::NotEqual)
+			{
+				Emit({ OpCode::Not });
+			}
+
+			return true;
+
+		case Field::Size:
+		{
+			auto size = ParseSize(token.text);
+
+			if (!size)
+			{
+				return false;
+			}
+
+			Instruction instruction = { OpCode::CompareSize, comparisonOperator };
+			instruction.value = *size;
+			Emit(instruction);
+			return true;
+		}
+
+		case Field::Modified:
+		case Field::Created:
+		case Field::Accessed:
+			return EmitTimeComparison(token, comparisonOperator);
+		}
+
+		return false;
+	}
+
+	// A duration is compared against the age of the item (so modified<7d matches an item modified
+	// less than seven days ago), whereas a date is compared against the item's timestamp. Either
+	// way, the comparison is converted to one or more comparisons on the timestamp.
+	bool EmitTimeComparison(const Token &token, ComparisonOperator comparisonOperator)
+	{
+		TimeField timeField = TimeField::Modified;
+
+		if (token.field == Field::Created)
+		{
+			timeField = TimeField::Created;
+		}
+		else if (token.field == Field::Accessed)
+		{
+			timeField = TimeField::Accessed;
+		}
+
+		auto emitCompareTime = [this, timeField](ComparisonOperator timeOperator, ULONGLONG time) {
+			Instruction instruction = { OpCode::CompareTime, timeOperator, timeField };
+			instruction.value = time;
+			Emit(instruction);
+		};
+
+		auto duration = ParseDuration(token.text);
+
+		if (duration)
+		{
+			ULONGLONG threshold = (std::max)(m_currentTime, *duration) - *duration;
+
+			switch (comparisonOperator)
+			{
+			case ComparisonOperator::Less:
+				emitCompareTime(ComparisonOperator::Greater, threshold);
+				break;
+
+			case ComparisonOperator::LessOrEqual:
+			case ComparisonOperator::Equal:
+				emitCompareTime(ComparisonOperator::GreaterOrEqual, threshold);
+				break;
+
+			case ComparisonOperator::Greater:
+				emitCompareTime(ComparisonOperator::Less, threshold);
+				break;
+
+			case ComparisonOperator::GreaterOrEqual:
+				emitCompareTime(ComparisonOperator::LessOrEqual, threshold);
+				break;
+
+			case ComparisonOperator::NotEqual:
+				emitCompareTime(ComparisonOperator::Less, threshold);
+				break;
+			}
+
+			return true;
+		}
+
+		auto day = ParseDate(token.text);
+
+		if (!day)
+		{
+			return false;
+		}
+
+		auto [startOfDay, endOfDay] = *day;
+
+		switch (comparisonOperator)
+		{
+		case ComparisonOperator::Equal:
+		case ComparisonOperator::NotEqual:
+			emitCompareTime(ComparisonOperator::GreaterOrEqual, startOfDay);
+			emitCompareTime(ComparisonOperator::Less, endOfDay);
+			Emit({ OpCode::And });
+
+			if (comparisonOperator == ComparisonOperator::NotEqual)
+			{
+				Emit({ OpCode::Not });
+			}
+			break;
+
+		case ComparisonOperator::Less:
+			emitCompareTime(ComparisonOperator::Less, startOfDay);
+			break;
+
+		case ComparisonOperator::LessOrEqual:
+			emitCompareTime(ComparisonOperator::Less, endOfDay);
+			break;
+
+		case ComparisonOperator::Greater:
+			emitCompareTime(ComparisonOperator::GreaterOrEqual, endOfDay);
+			break;
+
+		case ComparisonOperator::GreaterOrEqual:
+			emitCompareTime(ComparisonOperator::GreaterOrEqual, startOfDay);
+			break;
+		}
+
+		return true;
+	}
+
+	void EmitMatch(OpCode opCode, const std::wstring &pattern)
+	{
+		Instruction instruction = { opCode };
+		instruction.value = m_matchers.size();
+		m_matchers.emplace_back(pattern, m_caseSensitive);
+		Emit(instruction);
+	}
+
+	void Emit(const Instruction &instruction)
+	{
+		switch (instruction.opCode)
+		{
+		case OpCode::And:
+		case OpCode::Or:
+			m_stackDepth--;
+			break;
+
+		case OpCode::Not:
+			break;
+
+		default:
+			m_stackDepth++;
+			m_maxStackDepth = (std::max)(m_maxStackDepth, m_stackDepth);
+			break;
+		}
+
+		m_instructions.push_back(instruction);
+	}
+
+	static ComparisonOperator ParseComparisonOperator(std::wstring_view comparisonOperator)
+	{
+		if (comparisonOperator == L"!=")
+		{
+			return ComparisonOperator::NotEqual;
+		}
+		else if (comparisonOperator == L"<")
+		{
+			return ComparisonOperator::Less;
+		}
+		else if (comparisonOperator == L"<=")
+		{
+			return ComparisonOperator::LessOrEqual;
+		}
+		else if (comparisonOperator == L">")
+		{
+			return ComparisonOperator::Greater;
+		}
+		else if (comparisonOperator == L">=")
+		{
+			return ComparisonOperator::GreaterOrEqual;
+		}
+
+		// Both "=" and ":" test for equality.
+		return ComparisonOperator::Equal;
+	}
+
+	Token::Type Peek() const
+	{
+		return m_tokens[m_position].type;
+	}
+
+	const std::vector<Token> &m_tokens;
+	std::size_t m_position = 0;
+	const bool m_caseSensitive;
+	const ULONGLONG m_currentTime;
+	std::vector<Instruction> &m_instructions;
+	std::vector<WildcardMatcher> &m_matchers;
+	std::size_t m_stackDepth = 0;
+	std::size_t m_maxStackDepth = 0;
+	bool m_hasComparison = false;
+};
+
+FilterExpression::FilterExpression(std::wstring_view filter, bool caseSensitive) :
+	FilterExpression(filter, caseSensitive, [] {
+		FILETIME currentTime;
+		GetSystemTimeAsFileTime(&currentTime);
+		return FileTimeToUInt64(currentTime);
+	}())
+{
+}
+
+FilterExpression::FilterExpression(
+	std::wstring_view filter, bool caseSensitive, ULONGLONG currentTime)
+{
+	auto tokens = Tokenize(filter);
+
+	if (tokens)
+	{
+		Parser parser(*tokens, caseSensitive, currentTime, m_instructions, m_matchers);
+
+		// Filters like "Rock and Roll*" are valid expressions, but are almost certainly meant as
+		// patterns. So, a filter is only treated as an expression if it compares a field.
+		if (parser.Parse() && parser.HasComparison())
+		{
+			m_isExpression = true;
+			return;
+		}
+	}
+
+	m_instructions.clear();
+	m_matchers.clear();
+
+	m_matchers.emplace_back(filter, caseSensitive);
+	m_instructions.push_back({ OpCode::MatchName });
+}
+
+bool FilterExpression::Matches(std::wstring_view name, const WIN32_FIND_DATA &findData) const
+{
+	bool results[MAX_STACK_DEPTH];
+	std::size_t depth = 0;
+
+	for (const auto &instruction : m_instructions)
+	{
+		switch (instruction.opCode)
+		{
+		case OpCode::Not:
+			results[depth - 1] = !results[depth - 1];
+			break;
+
+		case OpCode::And:
+			results[depth - 2] = results[depth - 2] && results[depth - 1];
+			depth--;
+			break;
+
+		case OpCode::Or:
+			results[depth - 2] = results[depth - 2] || results[depth - 1];
+			depth--;
+			break;
+
+		default:
+			results[depth] = EvaluateInstruction(instruction, name, findData);
+			depth++;
+			break;
+		}
+	}
+
+	return results[0];
+}
+
+bool FilterExpression::EvaluateInstruction(
+	const Instruction &instruction, std::wstring_view name, const WIN32_FIND_DATA &findData) const
+{
+	switch (instruction.opCode)
+	{
+	case OpCode::MatchName:
+		return m_matchers[instruction.value].Matches(name);
+
+	case OpCode::MatchExtension:
+	{
+		// The name shown may not include the extension, so the real filename is used if it's
+		// available.
+		std::wstring_view fileName = (findData.cFileName[0] != '\0') ? findData.cFileName : name;
+		return m_matchers[instruction.value].Matches(GetExtension(fileName));
+	}
+
+	case OpCode::CompareSize:
+	{
+		ULARGE_INTEGER size = { findData.nFileSizeLow, findData.nFileSizeHigh };
+		return Compare(size.QuadPart, instruction.comparisonOperator, instruction.value);
+	}
+
+	case OpCode::CompareTime:
+	{
+		const FILETIME *time = &findData.ftLastWriteTime;
+
+		if (instruction.timeField == TimeField::Created)
+		{
+			time = &findData.ftCreationTime;
+		}
+		else if (instruction.timeField == TimeField::Accessed)
+		{
+			time = &findData.ftLastAccessTime;
+		}
+
+		return Compare(
+			FileTimeToUInt64(*time), instruction.comparisonOperator, instruction.value);
+	}
+
+	case OpCode::HasAttributes:
+	{
+		auto attributes = static_cast<DWORD>(instruction.value);
+		return (findData.dwFileAttributes & attributes) == attributes;
+	}
+
+	default:
+		return false;
+	}
+}
+
+bool FilterExpression::Compare(
+	std::uint64_t value1, ComparisonOperator comparisonOperator, std::uint64_t value2)
+{
+	switch (comparisonOperator)
+	{
+	case ComparisonOperator::Equal:
+		return value1 == value2;
+
+	case ComparisonOperator::NotEqual:
+		return value1 != value2;
+
+	case ComparisonOperator::Less:
+		return value1 < value2;
+
+	case ComparisonOperator::LessOrEqual:
+		return value1 <= value2;
+
+	case ComparisonOperator::Greater:
+		return value1 > value2;
+
+	case ComparisonOperator::GreaterOrEqual:
+		return value1 >= value2;
+	}
+
+	return false;
+}
+
+bool FilterExpression::IsExpression() const
+{
+	return m_isExpression;
+}
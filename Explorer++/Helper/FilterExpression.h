@@ -0,0 +1,107 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "WildcardMatcher.h"
+#include <windows.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A filter that can test an item against its name, extension, size, timestamps and attributes.
+// Everything is evaluated using the item's WIN32_FIND_DATA, so no additional I/O is needed.
+//
+// The filter is made up of terms, which can be combined using "and", "or", "not" and parentheses.
+// Terms next to each other are implicitly combined using "and", with "and" having a higher
+// precedence than "or". Each term is either a wildcard pattern, which is matched against the name,
+// or a comparison:
+//
+// name:<pattern>     name=<pattern>     name!=<pattern>
+// ext:<pattern>      (the extension, without the leading dot)
+// size>100MB         (<, <=, >, >=, = and != are all supported; units are B, KB, MB, GB and TB)
+// modified<7d        (modified within the last seven days; units are h, d, w and y)
+// modified>=2024-01-31
+// created, accessed  (the same as modified)
+// attr:hs            (has all the listed attributes: r, h, s, a, d, c and e)
+//
+// For example, "size>100MB modified<7d not *.tmp".
+//
+// Relative times are measured from the point at which the filter is constructed. Values that
+// contain spaces or parentheses can be quoted (e.g. name:"My file*").
+//
+// Text that isn't a valid expression, or that doesn't contain at least one comparison, is treated
+// as a single wildcard pattern, exactly as filters always have been. That means that existing
+// filters, like "*.h: *.cpp" and "Rock and Roll*", continue to work.
+class FilterExpression
+{
+public:
+	FilterExpression(std::wstring_view filter, bool caseSensitive);
+	FilterExpression(std::wstring_view filter, bool caseSensitive, ULONGLONG currentTime);
+
+	bool Matches(std::wstring_view name, const WIN32_FIND_DATA &findData) const;
+
+	// Returns true if the filter was compiled as an expression, rather than a wildcard pattern.
+	bool IsExpression() const;
+
+private:
+	enum class OpCode : std::uint8_t
+	{
+		MatchName,
+		MatchExtension,
+		CompareSize,
+		CompareTime,
+		HasAttributes,
+		Not,
+		And,
+		Or
+	};
+
+	enum class ComparisonOperator : std::uint8_t
+	{
+		Equal,
+		NotEqual,
+		Less,
+		LessOrEqual,
+		Greater,
+		GreaterOrEqual
+	};
+
+	enum class TimeField : std::uint8_t
+	{
+		Modified,
+		Created,
+		Accessed
+	};
+
+	// The expression is compiled to a sequence of instructions in postfix order. Each instruction
+	// either pushes the result of a test onto a stack of results, or combines the results at the
+	// top of the stack.
+	struct Instruction
+	{
+		OpCode opCode;
+		ComparisonOperator comparisonOperator = ComparisonOperator::Equal;
+		TimeField timeField = TimeField::Modified;
+
+		// The size, time (in 100-nanosecond intervals), attribute mask or matcher index,
+		// depending on the opcode.
+		std::uint64_t value = 0;
+	};
+
+	// The maximum depth of the result stack. Expressions that would need a deeper stack are
+	// treated as wildcard patterns.
+	static constexpr std::size_t MAX_STACK_DEPTH = 64;
+
+	class Parser;
+
+	static bool Compare(std::uint64_t value1, ComparisonOperator comparisonOperator,
+		std::uint64_t value2);
+	bool EvaluateInstruction(const Instruction &instruction, std::wstring_view name,
+		const WIN32_FIND_DATA &findData) const;
+
+	bool m_isExpression = false;
+	std::vector<Instruction> m_instructions;
+	std::vector<WildcardMatcher> m_matchers;
+};
@@ -2,57 +2,396 @@
 // SPDX-License-Identifier: GPL-3.0-only
 // See LICENSE in the top level directory
 
-#include "stdafx.h"
+// This file doesn't use the precompiled header, so that it can also be built (along with its tests)
+// on platforms other than Windows.
 #include "FolderSize.h"
-#include <filesystem>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
 
-FolderInfo GetFolderInfo(const std::wstring &path)
+namespace
 {
-	FolderInfo folderInfo = {};
-	std::error_code error;
+	// The number of entries that are processed between each check of the cancellation flag (and
+	// each progress update) while listing a directory.
+	constexpr int ENTRIES_PER_CHECK = 256;
 
-	for (const auto &entry : std::filesystem::directory_iterator(path, error))
+	struct DirectoryNode
 	{
-		if (std::filesystem::is_directory(entry.status()))
+		DirectoryNode(std::filesystem::path path, DirectoryNode *parent) :
+			path(std::move(path)),
+			parent(parent)
 		{
-			folderInfo.numFolders++;
+		}
+
+		const std::filesystem::path path;
+		DirectoryNode *const parent;
+
+		// One for the listing of the directory itself, plus one for each subdirectory that hasn't
+		// been completed yet. Once this reaches 0, the totals below are final.
+		std::atomic<int> numPending = 1;
 
-			FolderInfo subFolderInfo = GetFolderInfo(entry.path());
+		std::atomic<std::uintmax_t> size = 0;
+		std::atomic<int> numFolders = 0;
+		std::atomic<int> numFiles = 0;
+	};
 
-			folderInfo.size += subFolderInfo.size;
-			folderInfo.numFolders += subFolderInfo.numFolders;
-			folderInfo.numFiles += subFolderInfo.numFiles;
+	// Each thread has its own queue of directories waiting to be listed. A thread adds the
+	// subdirectories it finds to the back of its own queue and takes work from there as well, so
+	// that it walks its part of the tree depth-first. When its queue is empty, it steals from the
+	// front of another thread's queue, which is where the largest unvisited subtrees will be.
+	class FolderSizeWalker
+	{
+	public:
+		FolderSizeWalker(const FolderSizeOptions &options) :
+			m_options(options),
+			m_queues((std::max)(options.numThreads, 1U)),
+			m_numOutstanding(0),
+			m_numQueued(0),
+			m_numIdle(0),
+			m_totalSize(0),
+			m_totalFolders(0),
+			m_totalFiles(0),
+			m_lastProgressTime(std::chrono::steady_clock::now())
+		{
 		}
-		else
+
+		std::optional<FolderInfo> Walk(const std::filesystem::path &path)
 		{
-			std::error_code sizeErrorCode;
-			const auto size = std::filesystem::file_size(entry.path(), sizeErrorCode);
+			PushWork(0, new DirectoryNode(path, nullptr));
+
+			std::vector<std::future<void>> workers;
+
+			for (std::size_t i = 1; i < m_queues.size(); i++)
+			{
+				workers.push_back(
+					std::async(std::launch::async, &FolderSizeWalker::RunWorker, this, i));
+			}
+
+			RunWorker(0);
+
+			for (auto &worker : workers)
+			{
+				worker.get();
+			}
 
-			// If the size can't be retrieved, the error will be ignored and the current file will
-			// effectively be skipped over.
-			if (!sizeErrorCode)
+			if (IsCancelled())
 			{
-				folderInfo.size += size;
-				folderInfo.numFiles++;
+				return std::nullopt;
 			}
+
+			return m_result;
 		}
-	}
 
-	return folderInfo;
-}
+	private:
+		struct WorkQueue
+		{
+			std::mutex mutex;
+			std::deque<DirectoryNode *> directories;
+		};
 
-DWORD WINAPI Thread_CalculateFolderSize(LPVOID lpParameter)
-{
-	FolderSize_t *pFolderSize = reinterpret_cast<FolderSize_t *>(lpParameter);
+		void RunWorker(std::size_t workerIndex)
+		{
+			// Every directory is completed before it stops being outstanding, so once there's
+			// nothing outstanding, the root has been completed.
+			while (m_numOutstanding > 0)
+			{
+				DirectoryNode *node = TakeWork(workerIndex);
 
-	auto folderInfo = GetFolderInfo(pFolderSize->szPath);
+				if (!node)
+				{
+					// Other threads are still listing directories, which may yet produce more
+					// work.
+					WaitForWork(workerIndex);
+					MaybeReportProgress(workerIndex);
+					continue;
+				}
 
-	ULARGE_INTEGER size;
-	size.QuadPart = folderInfo.size;
+				ProcessDirectory(workerIndex, node);
 
-	pFolderSize->pfnCallback(folderInfo.numFolders, folderInfo.numFiles, &size, pFolderSize->pData);
+				if (--m_numOutstanding == 0)
+				{
+					// Any idle threads can now exit.
+					std::scoped_lock lock(m_idleMutex);
+					m_workAvailable.notify_all();
+				}
 
-	free(pFolderSize);
+				MaybeReportProgress(workerIndex);
+			}
+		}
+
+		// Blocks until there's a directory waiting to be listed, or the walk has finished. The
+		// calling thread also wakes periodically, so that it can continue to report progress.
+		void WaitForWork(std::size_t workerIndex)
+		{
+			auto canContinue = [this]() { return m_numQueued > 0 || m_numOutstanding == 0; };
+
+			std::unique_lock lock(m_idleMutex);
+			m_numIdle++;
+
+			if (workerIndex == 0 && m_options.progressCallback)
+			{
+				m_workAvailable.wait_for(lock, m_options.progressInterval, canContinue);
+			}
+			else
+			{
+				m_workAvailable.wait(lock, canContinue);
+			}
+
+			m_numIdle--;
+		}
+
+		void PushWork(std::size_t workerIndex, DirectoryNode *node)
+		{
+			m_numOutstanding++;
+
+			{
+				auto &queue = m_queues[workerIndex];
+				std::scoped_lock lock(queue.mutex);
+				queue.directories.push_back(node);
+				m_numQueued++;
+			}
+
+			// An idle thread increments the idle count before checking whether there's any work,
+			// so if no thread is idle at this point, any thread that becomes idle will see the
+			// work that was just queued.
+			if (m_numIdle > 0)
+			{
+				std::scoped_lock lock(m_idleMutex);
+				m_workAvailable.notify_one();
+			}
+		}
+
+		DirectoryNode *TakeWork(std::size_t workerIndex)
+		{
+			{
+				auto &queue = m_queues[workerIndex];
+				std::scoped_lock lock(queue.mutex);
+
+				if (!queue.directories.empty())
+				{
+					DirectoryNode *node = queue.directories.back();
+					queue.directories.pop_back();
+					m_numQueued--;
+					return node;
+				}
+			}
+
+			for (std::size_t i = 1; i < m_queues.size(); i++)
+			{
+				auto &queue = m_queues[(workerIndex + i) % m_queues.size()];
+				std::scoped_lock lock(queue.mutex);
+
+				if (!queue.directories.empty())
+				{
+					DirectoryNode *node = queue.directories.front();
+					queue.directories.pop_front();
+					m_numQueued--;
+					return node;
+				}
+			}
+
+			return nullptr;
+		}
+
+		void ProcessDirectory(std::size_t workerIndex, DirectoryNode *node)
+		{
+			// Once the walk has been cancelled, any remaining directories are completed without
+			// being listed, which allows them to be freed without needing any additional
+			// bookkeeping.
+			if (!IsCancelled())
+			{
+				ListDirectory(workerIndex, node);
+			}
+
+			CompleteDirectory(node);
+		}
 
-	return 1;
-}
\ No newline at end of file
+		void ListDirectory(std::size_t workerIndex, DirectoryNode *node)
+		{
+			// The counts are only added to the totals periodically, to limit the amount of
+			// contention between threads.
+			FolderInfo pendingCounts = {};
+			FolderInfo directoryCounts = {};
+			int numEntriesSinceCheck = 0;
+
+			std::error_code error;
+			std::filesystem::directory_iterator itr(
+				node->path, std::filesystem::directory_options::skip_permission_denied, error);
+
+			for (; !error && itr != std::filesystem::directory_iterator(); itr.increment(error))
+			{
+				const auto &entry = *itr;
+
+				// The status, like the size below, is retrieved from the information cached when
+				// the directory was enumerated, where that's available, rather than by querying
+				// each entry again.
+				std::error_code entryError;
+				auto symlinkStatus = entry.symlink_status(entryError);
+
+				if (std::filesystem::is_directory(symlinkStatus))
+				{
+					pendingCounts.numFolders++;
+
+					node->numPending++;
+					PushWork(workerIndex, new DirectoryNode(entry.path(), node));
+				}
+				else if (entry.is_directory(entryError))
+				{
+					// A link to a directory. Following it could result in a cycle, or in the same
+					// files being counted more than once.
+					pendingCounts.numFolders++;
+				}
+				else
+				{
+					std::error_code sizeError;
+					auto size = entry.file_size(sizeError);
+
+					// If the size can't be retrieved, the error will be ignored and the current
+					// file will effectively be skipped over.
+					if (!sizeError)
+					{
+						pendingCounts.size += size;
+						pendingCounts.numFiles++;
+					}
+				}
+
+				if (++numEntriesSinceCheck == ENTRIES_PER_CHECK)
+				{
+					numEntriesSinceCheck = 0;
+					AddCounts(pendingCounts, directoryCounts);
+
+					if (IsCancelled())
+					{
+						break;
+					}
+
+					MaybeReportProgress(workerIndex);
+				}
+			}
+
+			AddCounts(pendingCounts, directoryCounts);
+
+			node->size += directoryCounts.size;
+			node->numFolders += directoryCounts.numFolders;
+			node->numFiles += directoryCounts.numFiles;
+		}
+
+		void AddCounts(FolderInfo &pendingCounts, FolderInfo &directoryCounts)
+		{
+			m_totalSize.fetch_add(pendingCounts.size, std::memory_order_relaxed);
+			m_totalFolders.fetch_add(pendingCounts.numFolders, std::memory_order_relaxed);
+			m_totalFiles.fetch_add(pendingCounts.numFiles, std::memory_order_relaxed);
+
+			directoryCounts.size += pendingCounts.size;
+			directoryCounts.numFolders += pendingCounts.numFolders;
+			directoryCounts.numFiles += pendingCounts.numFiles;
+
+			pendingCounts = {};
+		}
+
+		// Marks one of the directory's pending items as done. If that was the last one, the
+		// directory's totals are passed to its parent, which may in turn complete. This is done
+		// in a loop, rather than recursively, so that it works regardless of the depth of the
+		// tree.
+		void CompleteDirectory(DirectoryNode *node)
+		{
+			while (node && --node->numPending == 0)
+			{
+				FolderInfo folderInfo = { node->size, node->numFolders, node->numFiles };
+
+				if (m_options.directoryCallback && !IsCancelled())
+				{
+					std::scoped_lock lock(m_callbackMutex);
+					m_options.directoryCallback(node->path, folderInfo);
+				}
+
+				DirectoryNode *parent = node->parent;
+
+				if (parent)
+				{
+					parent->size += folderInfo.size;
+					parent->numFolders += folderInfo.numFolders;
+					parent->numFiles += folderInfo.numFiles;
+				}
+				else
+				{
+					m_result = folderInfo;
+				}
+
+				delete node;
+				node = parent;
+			}
+		}
+
+		// Progress is only reported from the calling thread.
+		void MaybeReportProgress(std::size_t workerIndex)
+		{
+			if (workerIndex != 0 || !m_options.progressCallback || IsCancelled())
+			{
+				return;
+			}
+
+			auto now = std::chrono::steady_clock::now();
+
+			if ((now - m_lastProgressTime) < m_options.progressInterval)
+			{
+				return;
+			}
+
+			m_lastProgressTime = now;
+
+			FolderInfo totals = { m_totalSize.load(std::memory_order_relaxed),
+				m_totalFolders.load(std::memory_order_relaxed),
+				m_totalFiles.load(std::memory_order_relaxed) };
+			m_options.progressCallback(totals);
+		}
+
+		bool IsCancelled() const
+		{
+			return m_options.cancelled && *m_options.cancelled;
+		}
+
+		const FolderSizeOptions &m_options;
+		std::vector<WorkQueue> m_queues;
+
+		// The number of directories that have been queued, but not yet processed.
+		std::atomic<std::size_t> m_numOutstanding;
+
+		// The number of directories that are currently sitting in one of the queues. Only
+		// modified while the lock for the queue in question is held.
+		std::atomic<std::size_t> m_numQueued;
+
+		// Threads with nothing to do wait on the condition variable, rather than polling the
+		// queues.
+		std::mutex m_idleMutex;
+		std::condition_variable m_workAvailable;
+		std::atomic<int> m_numIdle;
+
+		// Running totals for the whole tree, used to report progress.
+		std::atomic<std::uintmax_t> m_totalSize;
+		std::atomic<int> m_totalFolders;
+		std::atomic<int> m_totalFiles;
+
+		std::mutex m_callbackMutex;
+		std::chrono::steady_clock::time_point m_lastProgressTime;
+
+		FolderInfo m_result = {};
+	};
+}
+
+std::optional<FolderInfo> CalculateFolderInfo(
+	const std::filesystem::path &path, const FolderSizeOptions &options)
+{
+	FolderSizeWalker walker(options);
+	return walker.Walk(path);
+}
+
+FolderInfo GetFolderInfo(const std::wstring &path)
+{
+	// Without a cancellation flag, the walk always runs to completion.
+	return *CalculateFolderInfo(path, FolderSizeOptions());
+}
@@ -4,6 +4,14 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+
 struct FolderInfo
 {
 	std::uintmax_t size;
@@ -11,13 +19,38 @@ struct FolderInfo
 	int numFiles;
 };
 
-FolderInfo GetFolderInfo(const std::wstring &path);
-
-typedef struct
+struct FolderSizeOptions
 {
-	TCHAR szPath[MAX_PATH];
-	LPVOID pData;
-	void (*pfnCallback)(int nFolders, int nFiles, PULARGE_INTEGER lTotalFolderSize, LPVOID pData);
-} FolderSize_t;
+	// The number of threads used to walk the tree, including the calling thread. Each thread
+	// lists one directory at a time, with idle threads taking subdirectories that are waiting to
+	// be listed by other threads.
+	unsigned int numThreads = 1;
+
+	// If set, this is checked regularly and, once it's true, the walk stops as soon as possible.
+	const std::atomic<bool> *cancelled = nullptr;
+
+	// Called on the calling thread, roughly once every progressInterval, with the totals
+	// accumulated so far.
+	std::function<void(const FolderInfo &totals)> progressCallback;
+	std::chrono::milliseconds progressInterval = std::chrono::milliseconds(250);
 
-DWORD WINAPI Thread_CalculateFolderSize(LPVOID lpParameter);
\ No newline at end of file
+	// Called once a directory, and everything within it, has been walked, with the totals for
+	// that directory. This is called for every directory in the tree, including the root, and
+	// always for a directory after its subdirectories. Calls are never made concurrently, but can
+	// come from any of the threads.
+	std::function<void(const std::filesystem::path &directory, const FolderInfo &folderInfo)>
+		directoryCallback;
+};
+
+// Calculates the total size of the files within the specified directory, as well as the number
+// of files and folders it contains. Symbolic links (and junctions) to directories are counted as
+// folders, but aren't followed. Files and directories that can't be accessed are skipped.
+//
+// The tree is walked iteratively, so its depth isn't limited by the size of the stack. Returns
+// std::nullopt if the walk was cancelled.
+std::optional<FolderInfo> CalculateFolderInfo(
+	const std::filesystem::path &path, const FolderSizeOptions &options);
+
+// Equivalent to calling CalculateFolderInfo with the default options (i.e. a single thread, with
+// no cancellation or callbacks).
+FolderInfo GetFolderInfo(const std::wstring &path);
@@ -0,0 +1,46 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "FolderSizeThread.h"
+#include "FolderSize.h"
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+	// The maximum number of threads used when calculating a folder size for the display window.
+	// Beyond this, additional threads mostly just compete for the same disk.
+	constexpr unsigned int DISPLAY_WINDOW_MAX_THREADS = 8;
+}
+
+DWORD WINAPI Thread_CalculateFolderSize(LPVOID lpParameter)
+{
+	std::unique_ptr<FolderSize_t> folderSize(reinterpret_cast<FolderSize_t *>(lpParameter));
+
+	FolderSizeOptions options;
+	options.numThreads =
+		(std::min)(std::thread::hardware_concurrency(), DISPLAY_WINDOW_MAX_THREADS);
+	options.cancelled = folderSize->cancelled.get();
+
+	if (folderSize->pfnProgressCallback)
+	{
+		options.progressCallback = [&folderSize](const FolderInfo &totals) {
+			ULARGE_INTEGER size;
+			size.QuadPart = totals.size;
+
+			folderSize->pfnProgressCallback(
+				totals.numFolders, totals.numFiles, &size, folderSize->pData);
+		};
+	}
+
+	auto folderInfo = CalculateFolderInfo(folderSize->szPath, options).value_or(FolderInfo());
+
+	ULARGE_INTEGER size;
+	size.QuadPart = folderInfo.size;
+
+	folderSize->pfnCallback(folderInfo.numFolders, folderInfo.numFiles, &size, folderSize->pData);
+
+	return 1;
+}
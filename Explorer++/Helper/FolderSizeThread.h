@@ -0,0 +1,29 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+// Should be allocated with new. Thread_CalculateFolderSize takes ownership.
+struct FolderSize_t
+{
+	TCHAR szPath[MAX_PATH];
+	LPVOID pData;
+
+	// Always called once the calculation has finished. If the calculation was cancelled, the
+	// values passed will be 0.
+	void (*pfnCallback)(int nFolders, int nFiles, PULARGE_INTEGER lTotalFolderSize, LPVOID pData);
+
+	// Optional. Called periodically, on the background thread, with the totals so far.
+	void (*pfnProgressCallback)(
+		int nFolders, int nFiles, PULARGE_INTEGER lTotalFolderSize, LPVOID pData);
+
+	// Optional. Once set, the calculation stops as soon as possible.
+	std::shared_ptr<std::atomic<bool>> cancelled;
+};
+
+// Calculates the size of a folder (using CalculateFolderInfo), for use with CreateThread.
+DWORD WINAPI Thread_CalculateFolderSize(LPVOID lpParameter);
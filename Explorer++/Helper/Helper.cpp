@@ -251,16 +251,26 @@ BOOL GetFileOwner(const TCHAR *szFile, TCHAR *szOwner, size_t cchMax)
 
 	if (file)
 	{
-		PSID pSidOwner = nullptr;
-		PSECURITY_DESCRIPTOR pSD = nullptr;
-		DWORD dwRet = GetSecurityInfo(file.get(), SE_FILE_OBJECT, OWNER_SECURITY_INFORMATION,
-			&pSidOwner, nullptr, nullptr, nullptr, &pSD);
+		success = GetFileOwner(file.get(), szOwner, cchMax);
+	}
 
-		if (dwRet == ERROR_SUCCESS)
-		{
-			success = FormatUserName(pSidOwner, szOwner, cchMax);
-			LocalFree(pSD);
-		}
+	return success;
+}
+
+// The handle needs to have been opened with READ_CONTROL access.
+BOOL GetFileOwner(HANDLE file, TCHAR *szOwner, size_t cchMax)
+{
+	BOOL success = FALSE;
+
+	PSID pSidOwner = nullptr;
+	PSECURITY_DESCRIPTOR pSD = nullptr;
+	DWORD dwRet = GetSecurityInfo(file, SE_FILE_OBJECT, OWNER_SECURITY_INFORMATION, &pSidOwner,
+		nullptr, nullptr, nullptr, &pSD);
+
+	if (dwRet == ERROR_SUCCESS)
+	{
+		success = FormatUserName(pSidOwner, szOwner, cchMax);
+		LocalFree(pSD);
 	}
 
 	return success;
@@ -519,6 +529,54 @@ BOOL GetVersionInfoString(
 		nullptr, nullptr, szVersionInfo, szVersionBuffer, cchMax);
 }
 
+// Equivalent to calling GetVersionInfoString() once for each name, except that the version
+// information is only loaded once. Each entry in the returned vector corresponds to the name at
+// the same position and will be empty if that value couldn't be retrieved.
+std::vector<std::optional<std::wstring>> GetVersionInfoStrings(
+	const TCHAR *szFullFileName, const std::vector<std::wstring> &versionInfoNames)
+{
+	std::vector<std::optional<std::wstring>> versionInfoStrings(versionInfoNames.size());
+
+	DWORD dwLen = GetFileVersionInfoSize(szFullFileName, nullptr);
+
+	if (dwLen == 0)
+	{
+		return versionInfoStrings;
+	}
+
+	std::vector<BYTE> block(dwLen);
+	BOOL bRet = GetFileVersionInfo(szFullFileName, NULL, dwLen, block.data());
+
+	if (!bRet)
+	{
+		return versionInfoStrings;
+	}
+
+	LangAndCodePage *plcp = nullptr;
+	UINT uLen;
+	bRet = VerQueryValue(block.data(), _T("\\VarFileInfo\\Translation"),
+		reinterpret_cast<LPVOID *>(&plcp), &uLen);
+
+	if (!bRet || uLen < sizeof(LangAndCodePage))
+	{
+		return versionInfoStrings;
+	}
+
+	for (size_t i = 0; i < versionInfoNames.size(); i++)
+	{
+		TCHAR versionInfo[512];
+		BOOL res = GetStringTableValue(block.data(), plcp, uLen / sizeof(LangAndCodePage),
+			versionInfoNames[i].c_str(), versionInfo, SIZEOF_ARRAY(versionInfo));
+
+		if (res)
+		{
+			versionInfoStrings[i] = versionInfo;
+		}
+	}
+
+	return versionInfoStrings;
+}
+
 BOOL GetFileVersionValue(const TCHAR *szFullFileName, VersionSubBlockType subBlockType,
 	WORD *pwLanguage, DWORD *pdwProductVersionLS, DWORD *pdwProductVersionMS,
 	const TCHAR *szVersionInfo, TCHAR *szVersionBuffer, UINT cchMax)
@@ -12,6 +12,7 @@
 #include <list>
 #include <optional>
 #include <string>
+#include <vector>
 
 struct LangAndCodePage
 {
@@ -39,6 +40,7 @@ BOOL CompareFileTypes(const TCHAR *pszFile1, const TCHAR *pszFile2);
 HRESULT BuildFileAttributeString(const TCHAR *lpszFileName, TCHAR *szOutput, size_t cchMax);
 HRESULT BuildFileAttributeString(DWORD dwFileAttributes, TCHAR *szOutput, size_t cchMax);
 BOOL GetFileOwner(const TCHAR *szFile, TCHAR *szOwner, size_t cchMax);
+BOOL GetFileOwner(HANDLE file, TCHAR *szOwner, size_t cchMax);
 DWORD GetNumFileHardLinks(const TCHAR *lpszFileName);
 BOOL ReadImageProperty(const TCHAR *lpszImage, PROPID propId, TCHAR *szProperty, int cchMax);
 HRESULT GetMediaMetadata(const TCHAR *szFileName, const TCHAR *szAttribute, BYTE **pszOutput);
@@ -48,6 +50,8 @@ BOOL GetFileProductVersion(
 BOOL GetFileLanguage(const TCHAR *szFullFileName, WORD *pwLanguage);
 BOOL GetVersionInfoString(
 	const TCHAR *szFullFileName, const TCHAR *szVersionInfo, TCHAR *szVersionBuffer, UINT cchMax);
+std::vector<std::optional<std::wstring>> GetVersionInfoStrings(
+	const TCHAR *szFullFileName, const std::vector<std::wstring> &versionInfoNames);
 
 /* Ownership and access. */
 BOOL CheckGroupMembership(GroupType groupType);
@@ -0,0 +1,174 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "IconClassRules.h"
+#include <algorithm>
+#include <cwctype>
+
+IconClassRules::IconClassRules(CustomIconCheck customIconCheck) :
+	m_customIconCheck(customIconCheck),
+	m_enabled(true)
+{
+	SetPerFileExtensions(ParseExtensionList(DEFAULT_PER_FILE_EXTENSIONS));
+}
+
+std::vector<std::wstring> IconClassRules::ParseExtensionList(std::wstring_view extensionList)
+{
+	std::vector<std::wstring> extensions;
+	std::size_t start = 0;
+
+	while (start <= extensionList.size())
+	{
+		std::size_t end = extensionList.find(L';', start);
+
+		if (end == std::wstring_view::npos)
+		{
+			end = extensionList.size();
+		}
+
+		std::wstring_view extension = extensionList.substr(start, end - start);
+
+		while (!extension.empty() && std::iswspace(extension.front()))
+		{
+			extension.remove_prefix(1);
+		}
+
+		while (!extension.empty() && std::iswspace(extension.back()))
+		{
+			extension.remove_suffix(1);
+		}
+
+		if (!extension.empty() && extension != L".")
+		{
+			std::wstring normalizedExtension = ToLowerCase(extension);
+
+			if (normalizedExtension.front() != L'.')
+			{
+				normalizedExtension.insert(normalizedExtension.begin(), L'.');
+			}
+
+			extensions.push_back(normalizedExtension);
+		}
+
+		start = end + 1;
+	}
+
+	return extensions;
+}
+
+void IconClassRules::SetEnabled(bool enabled)
+{
+	std::scoped_lock lock(m_mutex);
+	m_enabled = enabled;
+}
+
+bool IconClassRules::IsEnabled() const
+{
+	std::scoped_lock lock(m_mutex);
+	return m_enabled;
+}
+
+void IconClassRules::SetPerFileExtensions(const std::vector<std::wstring> &extensions)
+{
+	std::scoped_lock lock(m_mutex);
+
+	m_perFileExtensions.clear();
+
+	for (const auto &extension : extensions)
+	{
+		m_perFileExtensions.insert(ToLowerCase(extension));
+	}
+}
+
+std::vector<std::wstring> IconClassRules::GetPerFileExtensions() const
+{
+	std::scoped_lock lock(m_mutex);
+
+	std::vector<std::wstring> extensions(m_perFileExtensions.begin(), m_perFileExtensions.end());
+	std::sort(extensions.begin(), extensions.end());
+	return extensions;
+}
+
+std::optional<std::wstring> IconClassRules::GetIconClass(
+	std::wstring_view path, bool isFolder) const
+{
+	// Folders can be customized individually (through desktop.ini), so they're never grouped.
+	if (isFolder)
+	{
+		return std::nullopt;
+	}
+
+	std::wstring extension = ToLowerCase(GetExtension(path));
+
+	{
+		std::scoped_lock lock(m_mutex);
+
+		if (!m_enabled || m_perFileExtensions.count(extension) > 0)
+		{
+			return std::nullopt;
+		}
+	}
+
+	if (!extension.empty() && UsesCustomIcons(extension))
+	{
+		return std::nullopt;
+	}
+
+	return extension;
+}
+
+bool IconClassRules::UsesCustomIcons(const std::wstring &extension) const
+{
+	if (!m_customIconCheck)
+	{
+		return false;
+	}
+
+	{
+		std::scoped_lock lock(m_mutex);
+
+		auto itr = m_customIconResults.find(extension);
+
+		if (itr != m_customIconResults.end())
+		{
+			return itr->second;
+		}
+	}
+
+	// The check may need to query the registry, so it's run without holding the lock. If two
+	// threads check the same extension at once, they'll both arrive at the same result.
+	bool usesCustomIcons = m_customIconCheck(extension);
+
+	std::scoped_lock lock(m_mutex);
+	m_customIconResults.insert({ extension, usesCustomIcons });
+
+	return usesCustomIcons;
+}
+
+std::wstring IconClassRules::ToLowerCase(std::wstring_view str)
+{
+	std::wstring lowerCaseStr(str);
+	std::transform(lowerCaseStr.begin(), lowerCaseStr.end(), lowerCaseStr.begin(),
+		[](wchar_t c) { return static_cast<wchar_t>(std::towlower(c)); });
+	return lowerCaseStr;
+}
+
+std::wstring_view IconClassRules::GetExtension(std::wstring_view path)
+{
+	auto lastSeparator = path.find_last_of(L"\\/");
+	std::wstring_view fileName =
+		(lastSeparator == std::wstring_view::npos) ? path : path.substr(lastSeparator + 1);
+
+	auto lastPeriod = fileName.rfind(L'.');
+
+	// As with PathFindExtension(), a name like ".gitignore" is treated as being entirely an
+	// extension.
+	if (lastPeriod == std::wstring_view::npos)
+	{
+		return {};
+	}
+
+	return fileName.substr(lastPeriod);
+}
@@ -0,0 +1,63 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Decides which files can share an icon. Most files have an icon that's determined entirely by
+// their extension (i.e. the icon of the associated file type), so there's no need to look up the
+// icon for each file individually. Files with those extensions are grouped into an icon class,
+// identified by the lowercase extension.
+//
+// Some types (e.g. executables and shortcuts) can have a different icon for every file, so files
+// of those types don't belong to any class. That's the case for the extensions in the per-file
+// list, as well as for any extension the custom icon check reports as having custom icons.
+//
+// This class is thread-safe.
+class IconClassRules
+{
+public:
+	// Returns true if files with the specified extension (e.g. ".txt") may each have their own
+	// icon. The result is cached for each extension.
+	using CustomIconCheck = std::function<bool(const std::wstring &extension)>;
+
+	static inline const wchar_t DEFAULT_PER_FILE_EXTENSIONS[] = L".exe;.ico;.lnk;.url";
+
+	explicit IconClassRules(CustomIconCheck customIconCheck = nullptr);
+
+	// Parses a semicolon-separated list of extensions. Each extension is converted to lowercase
+	// and given a leading period, if it doesn't already have one.
+	static std::vector<std::wstring> ParseExtensionList(std::wstring_view extensionList);
+
+	void SetEnabled(bool enabled);
+	bool IsEnabled() const;
+
+	void SetPerFileExtensions(const std::vector<std::wstring> &extensions);
+	std::vector<std::wstring> GetPerFileExtensions() const;
+
+	// Returns the icon class the item belongs to, or nothing if the item's icon needs to be
+	// retrieved individually. Files without an extension all belong to the same (empty) class.
+	std::optional<std::wstring> GetIconClass(std::wstring_view path, bool isFolder) const;
+
+private:
+	static std::wstring ToLowerCase(std::wstring_view str);
+	static std::wstring_view GetExtension(std::wstring_view path);
+
+	bool UsesCustomIcons(const std::wstring &extension) const;
+
+	const CustomIconCheck m_customIconCheck;
+
+	mutable std::mutex m_mutex;
+	bool m_enabled;
+	std::unordered_set<std::wstring> m_perFileExtensions;
+	mutable std::unordered_map<std::wstring, bool> m_customIconResults;
+};
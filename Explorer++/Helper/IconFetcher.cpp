@@ -6,12 +6,21 @@
 #include "IconFetcher.h"
 #include "CachedIcons.h"
 #include "WindowSubclassWrapper.h"
+#include <wil/com.h>
 
-IconFetcher::IconFetcher(HWND hwnd, CachedIcons *cachedIcons) :
+IconRequestCoalescer::IconRequestCoalescer() :
+	RequestCoalescer(FAILED_REQUEST_TIMEOUT, MAX_FAILED_REQUESTS)
+{
+}
+
+IconFetcher::IconFetcher(HWND hwnd, CachedIcons *cachedIcons,
+	IconRequestCoalescer *requestCoalescer, TaskExecutor *taskExecutor,
+	TaskPriorityClass priorityClass) :
 	m_hwnd(hwnd),
+	m_resultBatcher([hwnd]() { PostMessage(hwnd, WM_APP_ICON_RESULT_READY, 0, 0); }),
+	m_iconTaskQueue(taskExecutor->CreateQueue(L"Icons", priorityClass)),
+	m_requestCoalescer(requestCoalescer),
 	m_cachedIcons(cachedIcons),
-	m_iconThreadPool(
-		1, std::bind(CoInitializeEx, nullptr, COINIT_APARTMENTTHREADED), CoUninitialize),
 	m_iconResultIDCounter(0)
 {
 	m_windowSubclasses.push_back(std::make_unique<WindowSubclassWrapper>(
@@ -20,7 +29,9 @@ IconFetcher::IconFetcher(HWND hwnd, CachedIcons *cachedIcons) :
 
 IconFetcher::~IconFetcher()
 {
-	m_iconThreadPool.clear_queue();
+	// The coalescer is shared, so any callbacks from this fetcher need to be removed from it.
+	ClearQueue();
+	m_iconTaskQueue->Shutdown();
 }
 
 LRESULT CALLBACK IconFetcher::WindowSubclassStub(
@@ -38,7 +49,7 @@ LRESULT CALLBACK IconFetcher::WindowSubclass(HWND hwnd, UINT msg, WPARAM wParam,
 	switch (msg)
 	{
 	case WM_APP_ICON_RESULT_READY:
-		ProcessIconResult(static_cast<int>(wParam));
+		ProcessIconResultBatch();
 		return 0;
 		break;
 	}
@@ -46,14 +57,23 @@ LRESULT CALLBACK IconFetcher::WindowSubclass(HWND hwnd, UINT msg, WPARAM wParam,
 	return DefSubclassProc(hwnd, msg, wParam, lParam);
 }
 
+// Multiple requests for the same item (e.g. when an item is redrawn before its icon has been
+// retrieved, or when the same folder is shown in several windows) share a single task, with every
+// callback being run once that task completes. The task may belong to another fetcher.
 void IconFetcher::QueueIconTask(std::wstring_view path, Callback callback)
 {
-	int iconResultID = m_iconResultIDCounter++;
+	IconRequestKey requestKey = std::wstring(path);
+	auto addResult = m_requestCoalescer->AddRequest(requestKey, { this, std::move(callback) });
+
+	if (addResult != IconRequestCoalescer::AddResult::NewRequest)
+	{
+		return;
+	}
 
-	auto iconResult = m_iconThreadPool.push(
-		[this, iconResultID, copiedPath = std::wstring(path)](int id) -> std::optional<IconResult> {
-			UNREFERENCED_PARAMETER(id);
+	int iconResultID = m_iconResultIDCounter++;
 
+	auto iconResult = m_iconTaskQueue->Push(
+		[this, iconResultID, copiedPath = std::wstring(path)]() -> std::optional<IconResult> {
 			// SHGetFileInfo will fail for non-filesystem paths that are passed in
 			// as strings. For example, attempting to retrieve the icon for the
 			// recycle bin will fail if you pass the parsing path (i.e.
@@ -64,74 +84,192 @@ void IconFetcher::QueueIconTask(std::wstring_view path, Callback callback)
 			HRESULT hr =
 				SHParseDisplayName(copiedPath.c_str(), nullptr, wil::out_param(pidl), 0, nullptr);
 
+			// Failures are reported as well, so that the request is no longer considered to be in
+			// flight.
 			if (FAILED(hr))
 			{
+				m_resultBatcher.AddResult(iconResultID);
 				return std::nullopt;
 			}
 
-			auto iconIndex = FindIconAsync(pidl.get());
+			auto result = FindIconAsync(pidl.get());
 
-			if (!iconIndex)
+			if (result)
 			{
-				return std::nullopt;
+				result->path = copiedPath;
 			}
 
-			IconResult result;
-			result.iconIndex = *iconIndex;
-			result.path = copiedPath;
-
-			PostMessage(m_hwnd, WM_APP_ICON_RESULT_READY, iconResultID, 0);
+			m_resultBatcher.AddResult(iconResultID);
 
 			return result;
 		});
 
-	FutureResult futureResult;
-	futureResult.callback = callback;
-	futureResult.iconResult = std::move(iconResult);
-	m_iconResults.insert({ iconResultID, std::move(futureResult) });
+	TrackRequest(std::move(requestKey), iconResultID, std::move(iconResult));
 }
 
 void IconFetcher::QueueIconTask(PCIDLIST_ABSOLUTE pidl, Callback callback)
 {
+	IconRequestKey requestKey = GetRequestKey(pidl);
+	auto addResult = m_requestCoalescer->AddRequest(requestKey, { this, std::move(callback) });
+
+	if (addResult != IconRequestCoalescer::AddResult::NewRequest)
+	{
+		return;
+	}
+
 	int iconResultID = m_iconResultIDCounter++;
 
 	BasicItemInfo basicItemInfo;
 	basicItemInfo.pidl.reset(ILCloneFull(pidl));
 
-	auto iconResult = m_iconThreadPool.push(
-		[this, iconResultID, basicItemInfo](int id) -> std::optional<IconResult> {
-			UNREFERENCED_PARAMETER(id);
+	auto iconResult =
+		m_iconTaskQueue->Push([this, iconResultID, basicItemInfo]() -> std::optional<IconResult> {
+			auto result = FindIconAsync(basicItemInfo.pidl.get());
 
-			auto iconIndex = FindIconAsync(basicItemInfo.pidl.get());
-
-			if (!iconIndex)
-			{
-				return std::nullopt;
-			}
+			m_resultBatcher.AddResult(iconResultID);
 
-			IconResult result;
-			result.iconIndex = *iconIndex;
+			return result;
+		});
 
-			std::wstring filePath;
-			HRESULT hr = GetDisplayName(basicItemInfo.pidl.get(), SHGDN_FORPARSING, filePath);
+	TrackRequest(std::move(requestKey), iconResultID, std::move(iconResult));
+}
 
-			if (SUCCEEDED(hr))
-			{
-				result.path = filePath;
-			}
+IconRequestKey IconFetcher::GetRequestKey(PCIDLIST_ABSOLUTE pidl)
+{
+	return std::string(reinterpret_cast<const char *>(pidl), ILGetSize(pidl));
+}
 
-			PostMessage(m_hwnd, WM_APP_ICON_RESULT_READY, iconResultID, 0);
+// Queues a request using a key that was previously generated from a path or pidl.
+void IconFetcher::QueueRequest(const IconRequestKey &requestKey, Callback callback)
+{
+	if (const auto *path = std::get_if<std::wstring>(&requestKey))
+	{
+		QueueIconTask(*path, std::move(callback));
+		return;
+	}
 
-			return result;
-		});
+	const auto &pidlData = std::get<std::string>(requestKey);
+	QueueIconTask(reinterpret_cast<PCIDLIST_ABSOLUTE>(pidlData.data()), std::move(callback));
+}
 
+void IconFetcher::TrackRequest(IconRequestKey requestKey, int iconResultId,
+	std::future<std::optional<IconResult>> iconResult)
+{
 	FutureResult futureResult;
-	futureResult.callback = callback;
+	futureResult.requestKey = std::move(requestKey);
 	futureResult.iconResult = std::move(iconResult);
-	m_iconResults.insert({ iconResultID, std::move(futureResult) });
+	m_iconResults.insert({ iconResultId, std::move(futureResult) });
 }
 
-std::optional<int> IconFetcher::FindIconAsync(PCIDLIST_ABSOLUTE pidl)
+std::optional<IconFetcher::IconResult> IconFetcher::FindIconAsync(PCIDLIST_ABSOLUTE pidl) const
+{
+	auto classResult = FindClassIconAsync(pidl);
+
+	if (classResult)
+	{
+		return classResult;
+	}
+
+	auto iconIndex = FindItemIconAsync(pidl);
+
+	if (!iconIndex)
+	{
+		return std::nullopt;
+	}
+
+	IconResult result;
+	result.iconIndex = *iconIndex;
+
+	std::wstring filePath;
+	HRESULT hr = GetDisplayName(pidl, SHGDN_FORPARSING, filePath);
+
+	if (SUCCEEDED(hr))
+	{
+		result.path = filePath;
+	}
+
+	return result;
+}
+
+// For files whose icon depends only on their type, the icon is looked up once per type and shared.
+// The overlay still needs to be retrieved for each item, but that's significantly cheaper than
+// having SHGetFileInfo() extract a full icon.
+std::optional<IconFetcher::IconResult> IconFetcher::FindClassIconAsync(
+	PCIDLIST_ABSOLUTE pidl) const
+{
+	wil::com_ptr_nothrow<IShellFolder> parent;
+	PCITEMID_CHILD child;
+	HRESULT hr = SHBindToParent(pidl, IID_PPV_ARGS(&parent), &child);
+
+	if (FAILED(hr))
+	{
+		return std::nullopt;
+	}
+
+	SFGAOF attributes = SFGAO_FOLDER | SFGAO_FILESYSTEM;
+	hr = parent->GetAttributesOf(1, &child, &attributes);
+
+	// Only files are grouped. The icon of a virtual item is determined by the folder it's in,
+	// rather than by its type.
+	if (FAILED(hr) || WI_IsFlagClear(attributes, SFGAO_FILESYSTEM))
+	{
+		return std::nullopt;
+	}
+
+	std::wstring path;
+	hr = GetDisplayName(pidl, SHGDN_FORPARSING, path);
+
+	if (FAILED(hr))
+	{
+		return std::nullopt;
+	}
+
+	auto iconClass = m_cachedIcons->getIconClassRules().GetIconClass(
+		path, WI_IsFlagSet(attributes, SFGAO_FOLDER));
+
+	if (!iconClass)
+	{
+		return std::nullopt;
+	}
+
+	auto classIconIndex = m_cachedIcons->findByClass(*iconClass);
+
+	if (!classIconIndex)
+	{
+		classIconIndex = GetFileTypeIconIndex(*iconClass);
+
+		if (!classIconIndex)
+		{
+			return std::nullopt;
+		}
+
+		m_cachedIcons->addOrUpdateClassIcon(*iconClass, *classIconIndex);
+	}
+
+	int overlayIndex = 0;
+	auto iconOverlay = parent.try_query<IShellIconOverlay>();
+
+	if (iconOverlay)
+	{
+		int index = OI_DEFAULT;
+		hr = iconOverlay->GetOverlayIndex(child, &index);
+
+		if (hr == S_OK)
+		{
+			overlayIndex = index;
+		}
+	}
+
+	// This matches the layout used by SHGFI_OVERLAYINDEX, with the overlay index stored in the
+	// upper eight bits.
+	IconResult result;
+	result.iconIndex = (*classIconIndex & 0x00FFFFFF) | (overlayIndex << 24);
+	result.path = path;
+	result.iconClass = iconClass;
+	return result;
+}
+
+std::optional<int> IconFetcher::FindItemIconAsync(PCIDLIST_ABSOLUTE pidl)
 {
 	// Must use SHGFI_ICON here, rather than SHGFO_SYSICONINDEX, or else
 	// icon overlays won't be applied.
@@ -149,6 +287,13 @@ std::optional<int> IconFetcher::FindIconAsync(PCIDLIST_ABSOLUTE pidl)
 	return shfi.iIcon;
 }
 
+// Results are delivered in batches, so that a large number of icons finishing at once results in
+// a single message (and a single repaint), rather than one message per icon.
+void IconFetcher::ProcessIconResultBatch()
+{
+	m_resultBatcher.ProcessBatch([this](int iconResultId) { ProcessIconResult(iconResultId); });
+}
+
 void IconFetcher::ProcessIconResult(int iconResultId)
 {
 	auto itr = m_iconResults.find(iconResultId);
@@ -158,8 +303,14 @@ void IconFetcher::ProcessIconResult(int iconResultId)
 		return;
 	}
 
-	auto &futureResult = itr->second;
+	// The entry is removed before any callbacks are run, since a callback may queue further
+	// requests.
+	FutureResult futureResult = std::move(itr->second);
+	m_iconResults.erase(itr);
+
 	auto result = futureResult.iconResult.get();
+	auto requests =
+		m_requestCoalescer->CompleteRequest(futureResult.requestKey, result.has_value());
 
 	if (!result)
 	{
@@ -167,16 +318,52 @@ void IconFetcher::ProcessIconResult(int iconResultId)
 		return;
 	}
 
-	if (!result->path.empty())
+	// Icons that are shared by an entire class have already been cached. Caching them for each
+	// individual path would only waste space.
+	if (!result->path.empty() && !result->iconClass)
 	{
 		m_cachedIcons->addOrUpdateFileIcon(result->path, result->iconIndex);
 	}
 
-	futureResult.callback(result->iconIndex);
+	for (const auto &request : requests)
+	{
+		request.callback(result->iconIndex);
+	}
 }
 
 void IconFetcher::ClearQueue()
 {
-	m_iconThreadPool.clear_queue();
+	m_iconTaskQueue->Clear();
+
+	// Requests made through other fetchers may be waiting on the tasks started here. Since those
+	// tasks are being abandoned, the requests are handed back to the fetchers they came from.
+	std::vector<std::pair<IconRequestKey, IconRequest>> orphanedRequests;
+
+	for (const auto &[iconResultId, futureResult] : m_iconResults)
+	{
+		for (auto &request : m_requestCoalescer->CancelRequest(futureResult.requestKey))
+		{
+			if (request.fetcher != this)
+			{
+				orphanedRequests.emplace_back(futureResult.requestKey, std::move(request));
+			}
+		}
+	}
+
 	m_iconResults.clear();
-}
\ No newline at end of file
+	m_resultBatcher.Clear();
+
+	// Requests made through this fetcher may also be waiting on tasks started by other fetchers.
+	m_requestCoalescer->RemoveCallbacks(
+		[this](const IconRequest &request) { return request.fetcher == this; });
+
+	for (auto &[requestKey, request] : orphanedRequests)
+	{
+		request.fetcher->QueueRequest(requestKey, std::move(request.callback));
+	}
+}
+
+void IconFetcher::SetPriorityClass(TaskPriorityClass priorityClass)
+{
+	m_iconTaskQueue->SetPriorityClass(priorityClass);
+}
@@ -4,15 +4,20 @@
 
 #pragma once
 
+#include "RequestCoalescer.h"
+#include "ResultBatcher.h"
 #include "ShellHelper.h"
-#include "../ThirdParty/CTPL/cpl_stl.h"
+#include "TaskExecutor.h"
 #include <ShlObj.h>
 #include <functional>
 #include <future>
 #include <optional>
+#include <string>
 #include <unordered_map>
+#include <variant>
 
 class CachedIcons;
+class IconFetcher;
 class WindowSubclassWrapper;
 
 class IconFetcherInterface
@@ -25,16 +30,49 @@ public:
 	virtual void ClearQueue() = 0;
 };
 
+// Requests are keyed either by path or by the raw bytes of the pidl. There's no cheap way of
+// telling whether a path and a pidl refer to the same item, so the two are kept distinct.
+using IconRequestKey = std::variant<std::wstring, std::string>;
+
+struct IconRequest
+{
+	// The fetcher the request was made through.
+	IconFetcher *fetcher;
+
+	IconFetcherInterface::Callback callback;
+};
+
+// Tracks the icon requests in flight across every IconFetcher. A single instance is shared between
+// all of the fetchers (e.g. those used by the listview, the tab bar and the bookmarks), so that an
+// item requested by several of them at once is only looked up once. As with the fetchers, this
+// should only be used from the UI thread.
+class IconRequestCoalescer : public RequestCoalescer<IconRequestKey, IconRequest>
+{
+public:
+	IconRequestCoalescer();
+
+private:
+	// Once the icon for an item couldn't be retrieved, further requests for it are dropped for
+	// this long.
+	static constexpr std::chrono::seconds FAILED_REQUEST_TIMEOUT{ 5 };
+	static const std::size_t MAX_FAILED_REQUESTS = 1024;
+};
+
 class IconFetcher : public IconFetcherInterface
 {
 public:
-	IconFetcher(HWND hwnd, CachedIcons *cachedIcons);
+	// The request coalescer needs to outlive the fetcher.
+	IconFetcher(HWND hwnd, CachedIcons *cachedIcons, IconRequestCoalescer *requestCoalescer,
+		TaskExecutor *taskExecutor,
+		TaskPriorityClass priorityClass = TaskPriorityClass::Foreground);
 	virtual ~IconFetcher();
 
 	void QueueIconTask(std::wstring_view path, Callback callback) override;
 	void QueueIconTask(PCIDLIST_ABSOLUTE pidl, Callback callback) override;
 	void ClearQueue() override;
 
+	void SetPriorityClass(TaskPriorityClass priorityClass);
+
 private:
 	static const UINT_PTR SUBCLASS_ID = 0;
 
@@ -60,11 +98,15 @@ private:
 	{
 		int iconIndex;
 		std::wstring path;
+
+		// Set if the icon is shared by all files in the class, rather than belonging to this
+		// specific item.
+		std::optional<std::wstring> iconClass;
 	};
 
 	struct FutureResult
 	{
-		Callback callback;
+		IconRequestKey requestKey;
 		std::future<std::optional<IconResult>> iconResult;
 	};
 
@@ -72,14 +114,27 @@ private:
 		UINT_PTR uIdSubclass, DWORD_PTR dwRefData);
 	LRESULT CALLBACK WindowSubclass(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
-	static std::optional<int> FindIconAsync(PCIDLIST_ABSOLUTE pidl);
+	static IconRequestKey GetRequestKey(PCIDLIST_ABSOLUTE pidl);
+	void QueueRequest(const IconRequestKey &requestKey, Callback callback);
+	void TrackRequest(IconRequestKey requestKey, int iconResultId,
+		std::future<std::optional<IconResult>> iconResult);
+
+	std::optional<IconResult> FindIconAsync(PCIDLIST_ABSOLUTE pidl) const;
+	std::optional<IconResult> FindClassIconAsync(PCIDLIST_ABSOLUTE pidl) const;
+	static std::optional<int> FindItemIconAsync(PCIDLIST_ABSOLUTE pidl);
+	void ProcessIconResultBatch();
 	void ProcessIconResult(int iconResultId);
 
 	const HWND m_hwnd;
 	std::vector<std::unique_ptr<WindowSubclassWrapper>> m_windowSubclasses;
 
-	ctpl::thread_pool m_iconThreadPool;
+	// This is declared before the task queue, so that it remains valid until any running tasks
+	// have finished.
+	ResultBatcher<int> m_resultBatcher;
+
+	std::unique_ptr<TaskQueue> m_iconTaskQueue;
 	std::unordered_map<int, FutureResult> m_iconResults;
+	IconRequestCoalescer *const m_requestCoalescer;
 	int m_iconResultIDCounter;
 	CachedIcons *m_cachedIcons;
 	std::function<void(int data)> m_callback;
@@ -4,6 +4,7 @@
 
 #include "stdafx.h"
 #include "ImageHelper.h"
+#include "PixelKernels.h"
 #include <wil/com.h>
 
 wil::unique_hbitmap ImageHelper::ImageListIconToBitmap(IImageList *imageList, int iconIndex)
@@ -76,27 +77,13 @@ HRESULT ImageHelper::ConvertToPARGB32(
 		if (GetDIBits(hdc, hbmp, 0, bmi.bmiHeader.biHeight, pvBits, &bmi, DIB_RGB_COLORS)
 			== bmi.bmiHeader.biHeight)
 		{
-			ULONG cxDelta = cxRow - bmi.bmiHeader.biWidth;
-			ARGB *pargbMask = static_cast<ARGB *>(pvBits);
-
-			for (ULONG y = bmi.bmiHeader.biHeight; y; --y)
-			{
-				for (ULONG x = bmi.bmiHeader.biWidth; x; --x)
-				{
-					if (*pargbMask++)
-					{
-						// transparent pixel
-						*pargb++ = 0;
-					}
-					else
-					{
-						// opaque pixel
-						*pargb++ |= 0xFF000000;
-					}
-				}
-
-				pargb += cxDelta;
-			}
+			// Pixels set in the mask are transparent, all others are opaque. ARGB is a DWORD,
+			// which is the same size as a std::uint32_t, but a distinct type.
+			PixelBuffer buffer = { reinterpret_cast<std::uint32_t *>(pargb), sizImage.cx,
+				sizImage.cy, cxRow };
+			ConstPixelBuffer mask = { static_cast<const std::uint32_t *>(pvBits), sizImage.cx,
+				sizImage.cy, sizImage.cx };
+			PixelKernels::ApplyMaskToAlpha(buffer, mask);
 
 			hr = S_OK;
 		}
@@ -109,21 +96,9 @@ HRESULT ImageHelper::ConvertToPARGB32(
 
 bool ImageHelper::HasAlpha(__in ARGB *pargb, SIZE &sizImage, int cxRow)
 {
-	ULONG cxDelta = cxRow - sizImage.cx;
-	for (ULONG y = sizImage.cy; y; --y)
-	{
-		for (ULONG x = sizImage.cx; x; --x)
-		{
-			if (*pargb++ & 0xFF000000)
-			{
-				return true;
-			}
-		}
-
-		pargb += cxDelta;
-	}
-
-	return false;
+	ConstPixelBuffer buffer = { reinterpret_cast<const std::uint32_t *>(pargb), sizImage.cx,
+		sizImage.cy, cxRow };
+	return PixelKernels::HasAlpha(buffer);
 }
 
 HRESULT ImageHelper::ConvertBufferToPARGB32(
@@ -0,0 +1,233 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "ItemPositionIndex.h"
+#include <cassert>
+
+ItemPositionIndex::ItemPositionIndex() : m_root(nullptr)
+{
+}
+
+void ItemPositionIndex::Assign(const std::vector<int> &items)
+{
+	Clear();
+
+	m_nodes.reserve(items.size());
+
+	// The tree is built in a single pass, with the stack holding the right spine of the tree built
+	// so far. Once a node is popped from the stack, nothing else will be added beneath it, so its
+	// size can be calculated at that point.
+	std::vector<Node *> rightSpine;
+
+	for (int item : items)
+	{
+		auto [itr, inserted] = m_nodes.try_emplace(item);
+		assert(inserted);
+
+		if (!inserted)
+		{
+			continue;
+		}
+
+		Node *node = &itr->second;
+		*node = { item, static_cast<std::uint32_t>(m_random()), 1, nullptr, nullptr, nullptr };
+
+		Node *lastPopped = nullptr;
+
+		while (!rightSpine.empty() && rightSpine.back()->priority < node->priority)
+		{
+			lastPopped = rightSpine.back();
+			rightSpine.pop_back();
+			UpdateNode(lastPopped);
+		}
+
+		node->left = lastPopped;
+
+		if (!rightSpine.empty())
+		{
+			rightSpine.back()->right = node;
+		}
+
+		rightSpine.push_back(node);
+	}
+
+	Node *root = rightSpine.empty() ? nullptr : rightSpine.front();
+
+	while (!rightSpine.empty())
+	{
+		UpdateNode(rightSpine.back());
+		rightSpine.pop_back();
+	}
+
+	SetRoot(root);
+}
+
+void ItemPositionIndex::Insert(int position, int item)
+{
+	Remove(item);
+
+	auto [itr, inserted] = m_nodes.try_emplace(item);
+	Node *node = &itr->second;
+	*node = { item, static_cast<std::uint32_t>(m_random()), 1, nullptr, nullptr, nullptr };
+
+	std::size_t count = (position < 0) ? 0 : static_cast<std::size_t>(position);
+
+	Node *left;
+	Node *right;
+	Split(m_root, count, left, right);
+	SetRoot(Merge(Merge(left, node), right));
+}
+
+void ItemPositionIndex::Remove(int item)
+{
+	auto position = GetPosition(item);
+
+	if (!position)
+	{
+		return;
+	}
+
+	Node *left;
+	Node *rest;
+	Split(m_root, *position, left, rest);
+
+	Node *removed;
+	Node *right;
+	Split(rest, 1, removed, right);
+	assert(removed && removed->item == item);
+
+	SetRoot(Merge(left, right));
+
+	m_nodes.erase(item);
+}
+
+std::optional<int> ItemPositionIndex::GetPosition(int item) const
+{
+	auto itr = m_nodes.find(item);
+
+	if (itr == m_nodes.end())
+	{
+		return std::nullopt;
+	}
+
+	const Node *node = &itr->second;
+	std::size_t position = GetSubtreeSize(node->left);
+
+	// Every ancestor that this node is to the right of comes before it, along with everything in
+	// that ancestor's left subtree.
+	while (node->parent)
+	{
+		if (node == node->parent->right)
+		{
+			position += GetSubtreeSize(node->parent->left) + 1;
+		}
+
+		node = node->parent;
+	}
+
+	return static_cast<int>(position);
+}
+
+std::size_t ItemPositionIndex::GetSize() const
+{
+	return m_nodes.size();
+}
+
+void ItemPositionIndex::Clear()
+{
+	m_nodes.clear();
+	m_root = nullptr;
+}
+
+std::size_t ItemPositionIndex::GetSubtreeSize(const Node *node)
+{
+	return node ? node->size : 0;
+}
+
+// Recalculates the size of the node and points its children back at it.
+void ItemPositionIndex::UpdateNode(Node *node)
+{
+	node->size = GetSubtreeSize(node->left) + GetSubtreeSize(node->right) + 1;
+
+	if (node->left)
+	{
+		node->left->parent = node;
+	}
+
+	if (node->right)
+	{
+		node->right->parent = node;
+	}
+}
+
+// Splits the tree rooted at the node, so that the first count items end up in the left tree and
+// the remaining items end up in the right tree.
+void ItemPositionIndex::Split(Node *node, std::size_t count, Node *&left, Node *&right)
+{
+	if (!node)
+	{
+		left = nullptr;
+		right = nullptr;
+		return;
+	}
+
+	if (GetSubtreeSize(node->left) < count)
+	{
+		Split(node->right, count - GetSubtreeSize(node->left) - 1, node->right, right);
+		left = node;
+	}
+	else
+	{
+		Split(node->left, count, left, node->left);
+		right = node;
+	}
+
+	UpdateNode(node);
+
+	if (left)
+	{
+		left->parent = nullptr;
+	}
+
+	if (right)
+	{
+		right->parent = nullptr;
+	}
+}
+
+// Joins two trees, where every item in the left tree comes before every item in the right tree.
+ItemPositionIndex::Node *ItemPositionIndex::Merge(Node *left, Node *right)
+{
+	if (!left)
+	{
+		return right;
+	}
+
+	if (!right)
+	{
+		return left;
+	}
+
+	if (left->priority > right->priority)
+	{
+		left->right = Merge(left->right, right);
+		UpdateNode(left);
+		return left;
+	}
+
+	right->left = Merge(left, right->left);
+	UpdateNode(right);
+	return right;
+}
+
+void ItemPositionIndex::SetRoot(Node *root)
+{
+	m_root = root;
+
+	if (m_root)
+	{
+		m_root->parent = nullptr;
+	}
+}
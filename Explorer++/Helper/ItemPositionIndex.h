@@ -0,0 +1,64 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+// Tracks the position of each item in an ordered list (e.g. the items in a listview), where items
+// can be inserted and removed at any position. Storing the positions directly would mean updating
+// the position of every later item each time the list changed. Here, the items are held in a
+// randomized binary tree (a treap), with each node storing the size of its subtree, so looking up,
+// inserting and removing an item are all O(log n) on average.
+//
+// Each item can only appear in the list once.
+class ItemPositionIndex
+{
+public:
+	ItemPositionIndex();
+
+	// Replaces the contents of the index with the specified items, in order. This is O(n).
+	void Assign(const std::vector<int> &items);
+
+	// Inserts the item at the specified position, with every item at or after that position
+	// moving back by one. A position past the end of the list appends the item. If the item is
+	// already present, it's moved to the new position.
+	void Insert(int position, int item);
+
+	// Removes the item (if it's present), with every item after it moving forward by one.
+	void Remove(int item);
+
+	std::optional<int> GetPosition(int item) const;
+	std::size_t GetSize() const;
+	void Clear();
+
+private:
+	struct Node
+	{
+		int item;
+		std::uint32_t priority;
+		std::size_t size;
+		Node *left;
+		Node *right;
+		Node *parent;
+	};
+
+	static std::size_t GetSubtreeSize(const Node *node);
+	static void UpdateNode(Node *node);
+	static void Split(Node *node, std::size_t count, Node *&left, Node *&right);
+	static Node *Merge(Node *left, Node *right);
+
+	void SetRoot(Node *root);
+
+	// Node pointers remain valid when an unordered_map rehashes, so the nodes can reference each
+	// other directly.
+	std::unordered_map<int, Node> m_nodes;
+	Node *m_root;
+	std::minstd_rand m_random;
+};
@@ -315,6 +315,60 @@ BOOL ListViewHelper::SwapItems(HWND hListView, int iItem1, int iItem2, BOOL bSwa
 	return TRUE;
 }
 
+/* Moves an item (along with its state, image, group
+and column text) so that it ends up at index iTo. iTo
+is the item's final index, so it's interpreted after
+the item has been removed from its current position. */
+BOOL ListViewHelper::MoveItem(HWND hListView, int iFrom, int iTo)
+{
+	if(iFrom == iTo)
+	{
+		return TRUE;
+	}
+
+	UINT mask = LVIF_IMAGE | LVIF_INDENT | LVIF_STATE | LVIF_TEXT | LVIF_PARAM | LVIF_GROUPID;
+	UINT stateMask = static_cast<UINT>(-1);
+
+	LVITEM lvItem;
+	TCHAR szText[512];
+	BOOL bRet = GetListViewItem(hListView, &lvItem, mask, stateMask, iFrom, 0, szText,
+		SIZEOF_ARRAY(szText));
+
+	if(!bRet)
+	{
+		return FALSE;
+	}
+
+	HWND hHeader = ListView_GetHeader(hListView);
+	int nColumns = Header_GetItemCount(hHeader);
+
+	std::vector<std::wstring> columnText;
+
+	for(int i = 1; i < nColumns; i++)
+	{
+		TCHAR szColumn[512];
+		ListView_GetItemText(hListView, iFrom, i, szColumn, SIZEOF_ARRAY(szColumn));
+		columnText.emplace_back(szColumn);
+	}
+
+	ListView_DeleteItem(hListView, iFrom);
+
+	lvItem.iItem = iTo;
+	int iItem = ListView_InsertItem(hListView, &lvItem);
+
+	if(iItem == -1)
+	{
+		return FALSE;
+	}
+
+	for(int i = 1; i < nColumns; i++)
+	{
+		ListView_SetItemText(hListView, iItem, i, columnText[i - 1].data());
+	}
+
+	return TRUE;
+}
+
 void ListViewHelper::PositionInsertMark(HWND hListView,const POINT *ppt)
 {
 	/* Remove the insertion mark. */
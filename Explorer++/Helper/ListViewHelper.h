@@ -16,5 +16,6 @@ namespace ListViewHelper
 	void	AddRemoveExtendedStyle(HWND hListView,DWORD dwStyle,BOOL bAdd);
 	BOOL	SetBackgroundImage(HWND hListView,UINT uImage);
 	BOOL	SwapItems(HWND hListView,int iItem1,int iItem2,BOOL bSwapLPARAM);
+	BOOL	MoveItem(HWND hListView,int iFrom,int iTo);
 	void	PositionInsertMark(HWND hListView,const POINT *ppt);
 }
\ No newline at end of file
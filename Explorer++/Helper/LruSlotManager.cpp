@@ -0,0 +1,133 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "LruSlotManager.h"
+
+LruSlotManager::LruSlotManager(std::size_t capacity) : m_capacity(capacity)
+{
+}
+
+std::optional<int> LruSlotManager::Find(int key) const
+{
+	const auto &keyIndex = m_assignedSlots.get<1>();
+	auto itr = keyIndex.find(key);
+
+	if (itr == keyIndex.end())
+	{
+		return std::nullopt;
+	}
+
+	return itr->slot;
+}
+
+void LruSlotManager::Touch(int key)
+{
+	auto &keyIndex = m_assignedSlots.get<1>();
+	auto itr = keyIndex.find(key);
+
+	if (itr == keyIndex.end())
+	{
+		return;
+	}
+
+	m_assignedSlots.relocate(m_assignedSlots.begin(), m_assignedSlots.project<0>(itr));
+}
+
+LruSlotManager::Allocation LruSlotManager::Acquire(int key, const EvictionPredicate &canEvict)
+{
+	auto &keyIndex = m_assignedSlots.get<1>();
+	auto existingItr = keyIndex.find(key);
+
+	if (existingItr != keyIndex.end())
+	{
+		m_assignedSlots.relocate(m_assignedSlots.begin(), m_assignedSlots.project<0>(existingItr));
+		return { existingItr->slot, std::nullopt };
+	}
+
+	Allocation allocation;
+
+	if (!m_releasedSlots.empty())
+	{
+		allocation.slot = m_releasedSlots.back();
+		m_releasedSlots.pop_back();
+	}
+	else if (m_capacity == 0 || m_counters.numSlots < m_capacity)
+	{
+		allocation.slot = CreateSlot();
+	}
+	else
+	{
+		// Walk from the least recently used key towards the most recently used key.
+		auto evictItr = m_assignedSlots.rbegin();
+
+		while (evictItr != m_assignedSlots.rend() && !canEvict(evictItr->key))
+		{
+			++evictItr;
+		}
+
+		if (evictItr != m_assignedSlots.rend())
+		{
+			allocation.slot = evictItr->slot;
+			allocation.evictedKey = evictItr->key;
+			m_assignedSlots.erase(std::next(evictItr).base());
+
+			m_counters.numEvictions++;
+		}
+		else
+		{
+			allocation.slot = CreateSlot();
+
+			m_counters.numOverCapacity++;
+		}
+	}
+
+	m_assignedSlots.push_front({ key, allocation.slot });
+	m_counters.numAssigned = m_assignedSlots.size();
+
+	return allocation;
+}
+
+void LruSlotManager::Release(int key)
+{
+	auto &keyIndex = m_assignedSlots.get<1>();
+	auto itr = keyIndex.find(key);
+
+	if (itr == keyIndex.end())
+	{
+		return;
+	}
+
+	m_releasedSlots.push_back(itr->slot);
+	keyIndex.erase(itr);
+	m_counters.numAssigned = m_assignedSlots.size();
+}
+
+void LruSlotManager::Clear()
+{
+	m_assignedSlots.clear();
+	m_releasedSlots.clear();
+	m_counters.numSlots = 0;
+	m_counters.numAssigned = 0;
+}
+
+void LruSlotManager::SetCapacity(std::size_t capacity)
+{
+	m_capacity = capacity;
+}
+
+std::size_t LruSlotManager::GetCapacity() const
+{
+	return m_capacity;
+}
+
+LruSlotManagerCounters LruSlotManager::GetCounters() const
+{
+	return m_counters;
+}
+
+int LruSlotManager::CreateSlot()
+{
+	return static_cast<int>(m_counters.numSlots++);
+}
@@ -0,0 +1,101 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index_container.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+struct LruSlotManagerCounters
+{
+	// The number of slots that have been created. Slots are never destroyed (other than by
+	// Clear()), so this is also the size of whatever storage backs the slots.
+	std::size_t numSlots = 0;
+
+	// The number of slots currently assigned to a key.
+	std::size_t numAssigned = 0;
+
+	// The number of times a slot was taken from one key and given to another.
+	std::uint64_t numEvictions = 0;
+
+	// The number of slots that were created beyond the capacity, because none of the existing
+	// slots could be evicted.
+	std::uint64_t numOverCapacity = 0;
+};
+
+// Assigns a fixed number of slots (e.g. the images in an image list) to a larger set of keys. Once
+// all the slots are in use, the slot belonging to the least recently used key is reassigned,
+// provided the caller agrees to the key being evicted.
+//
+// Slots are numbered contiguously from 0, in the order they're created, so a newly created slot
+// always has an index equal to the number of slots that existed before it.
+class LruSlotManager
+{
+public:
+	struct Allocation
+	{
+		int slot;
+
+		// Set if the slot was previously assigned to another key. That key no longer has a slot.
+		std::optional<int> evictedKey;
+	};
+
+	using EvictionPredicate = std::function<bool(int key)>;
+
+	// A capacity of 0 means there's no limit.
+	explicit LruSlotManager(std::size_t capacity);
+
+	// Returns the slot assigned to the key, without affecting the order in which keys are evicted.
+	std::optional<int> Find(int key) const;
+
+	// Marks the key as the most recently used.
+	void Touch(int key);
+
+	// Returns the slot assigned to the key (marking it as the most recently used). If the key
+	// doesn't have a slot, it will be given a released slot if there is one, or a new slot if the
+	// capacity hasn't been reached. Otherwise, the slot belonging to the least recently used key
+	// that canEvict returns true for is reassigned. If no key can be evicted, a new slot is created
+	// anyway, so the capacity may be exceeded.
+	Allocation Acquire(int key, const EvictionPredicate &canEvict);
+
+	// Returns the slot assigned to the key (if any) to the pool of unassigned slots.
+	void Release(int key);
+
+	// Removes all slots.
+	void Clear();
+
+	// Applies to slots created from this point on. Existing slots aren't removed.
+	void SetCapacity(std::size_t capacity);
+	std::size_t GetCapacity() const;
+
+	LruSlotManagerCounters GetCounters() const;
+
+private:
+	struct AssignedSlot
+	{
+		int key;
+		int slot;
+	};
+
+	// The front of the sequence holds the most recently used key.
+	typedef boost::multi_index_container<AssignedSlot,
+		boost::multi_index::indexed_by<boost::multi_index::sequenced<>,
+			boost::multi_index::hashed_unique<
+				boost::multi_index::member<AssignedSlot, int, &AssignedSlot::key>>>>
+		AssignedSlotSet;
+
+	int CreateSlot();
+
+	AssignedSlotSet m_assignedSlots;
+	std::vector<int> m_releasedSlots;
+	std::size_t m_capacity;
+	LruSlotManagerCounters m_counters;
+};
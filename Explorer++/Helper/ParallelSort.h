@@ -0,0 +1,114 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+// Below this size, splitting the range up isn't worth the cost of starting threads.
+constexpr std::size_t PARALLEL_SORT_MIN_ITEMS_PER_THREAD = 4096;
+
+// Performs a stable merge sort of the range, using up to numThreads threads. The range is split
+// into chunks that are sorted concurrently, after which adjacent chunks are merged (again
+// concurrently) until a single sorted range remains.
+//
+// The cancelled flag is checked between each stage. If it's set, the sort stops early and false is
+// returned, in which case the range will be left in an unspecified order. The comparison function
+// can be called from several threads at once, so it shouldn't modify any shared state.
+template <class RandomIt, class Compare>
+bool ParallelMergeSort(RandomIt first, RandomIt last, Compare comp,
+	const std::atomic<bool> &cancelled, unsigned int numThreads)
+{
+	auto numItems = static_cast<std::size_t>(std::distance(first, last));
+	std::size_t numChunks = (std::max)(numThreads, 1U);
+
+	while (numChunks > 1 && (numItems / numChunks) < PARALLEL_SORT_MIN_ITEMS_PER_THREAD)
+	{
+		numChunks--;
+	}
+
+	if (numChunks == 1)
+	{
+		if (cancelled)
+		{
+			return false;
+		}
+
+		std::stable_sort(first, last, comp);
+		return !cancelled;
+	}
+
+	std::vector<RandomIt> boundaries;
+	boundaries.reserve(numChunks + 1);
+
+	for (std::size_t i = 0; i < numChunks; i++)
+	{
+		boundaries.push_back(first + (numItems * i) / numChunks);
+	}
+
+	boundaries.push_back(last);
+
+	std::vector<std::future<void>> tasks;
+
+	for (std::size_t i = 0; i < numChunks; i++)
+	{
+		tasks.push_back(std::async(std::launch::async,
+			[chunkFirst = boundaries[i], chunkLast = boundaries[i + 1], &comp] {
+				std::stable_sort(chunkFirst, chunkLast, comp);
+			}));
+	}
+
+	for (auto &task : tasks)
+	{
+		task.get();
+	}
+
+	// Each pass merges pairs of adjacent chunks, halving the number of chunks.
+	while (boundaries.size() > 2)
+	{
+		if (cancelled)
+		{
+			return false;
+		}
+
+		tasks.clear();
+
+		std::vector<RandomIt> mergedBoundaries;
+		mergedBoundaries.push_back(boundaries[0]);
+
+		std::size_t i = 0;
+
+		for (; i + 2 < boundaries.size(); i += 2)
+		{
+			tasks.push_back(std::async(std::launch::async,
+				[chunkFirst = boundaries[i], chunkMiddle = boundaries[i + 1],
+					chunkLast = boundaries[i + 2], &comp] {
+					std::inplace_merge(chunkFirst, chunkMiddle, chunkLast, comp);
+				}));
+
+			mergedBoundaries.push_back(boundaries[i + 2]);
+		}
+
+		// With an odd number of chunks, the last chunk is carried over to the next pass as-is.
+		if (i + 1 < boundaries.size())
+		{
+			mergedBoundaries.push_back(boundaries[i + 1]);
+		}
+
+		for (auto &task : tasks)
+		{
+			task.get();
+		}
+
+		boundaries = std::move(mergedBoundaries);
+	}
+
+	return !cancelled;
+}
@@ -0,0 +1,564 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "PersistentItemCache.h"
+#include "Logging.h"
+#include <algorithm>
+
+using namespace PersistentItemCacheFormat;
+
+PersistentItemCache::PersistentItemCache(const std::wstring &filePath, std::uint64_t maxFileSize) :
+	m_filePath(filePath),
+	m_maxFileSize(maxFileSize)
+{
+	std::scoped_lock fileLock(m_fileMutex);
+	std::unique_lock lock(m_mutex);
+	Open();
+
+	if (NeedsCompaction())
+	{
+		Compact(lock);
+	}
+}
+
+PersistentItemCache::~PersistentItemCache()
+{
+	Flush();
+}
+
+std::optional<std::wstring> PersistentItemCache::GetValue(const ItemKey &key, std::uint32_t fieldId)
+{
+	std::scoped_lock lock(m_mutex);
+
+	auto itr = m_entries.find(key.path);
+
+	if (itr == m_entries.end() || itr->second.size != key.size
+		|| itr->second.lastWriteTime != key.lastWriteTime)
+	{
+		m_counters.numMisses++;
+		return std::nullopt;
+	}
+
+	Entry &entry = itr->second;
+	std::optional<std::wstring> value;
+
+	auto fieldItr = entry.fields.find(fieldId);
+
+	if (fieldItr != entry.fields.end())
+	{
+		value = fieldItr->second;
+	}
+	else if (entry.mappedRecordOffset)
+	{
+		value = ReadField(m_view.get(), *entry.mappedRecordOffset, fieldId);
+	}
+
+	if (!value)
+	{
+		m_counters.numMisses++;
+		return std::nullopt;
+	}
+
+	MarkUsed(entry);
+	m_counters.numHits++;
+
+	return value;
+}
+
+void PersistentItemCache::SetValue(
+	const ItemKey &key, std::uint32_t fieldId, const std::wstring &value)
+{
+	std::unique_lock lock(m_mutex);
+
+	Entry &entry = GetEntryForKey(key);
+	MarkUsed(entry);
+
+	if (entry.mappedRecordOffset && !entry.fields.count(fieldId)
+		&& ReadField(m_view.get(), *entry.mappedRecordOffset, fieldId) == value)
+	{
+		return;
+	}
+
+	auto [fieldItr, inserted] = entry.fields.insert({ fieldId, value });
+
+	if (!inserted)
+	{
+		if (fieldItr->second == value)
+		{
+			return;
+		}
+
+		fieldItr->second = value;
+	}
+
+	if (!entry.dirty)
+	{
+		entry.dirty = true;
+		m_numDirtyEntries++;
+	}
+
+	if (m_numDirtyEntries < AUTO_FLUSH_THRESHOLD)
+	{
+		return;
+	}
+
+	lock.unlock();
+
+	// If another thread is already writing to the file, there's no need to wait for it. Any values
+	// it didn't pick up will be written by a later flush.
+	std::unique_lock fileLock(m_fileMutex, std::try_to_lock);
+
+	if (fileLock.owns_lock())
+	{
+		FlushInternal();
+	}
+}
+
+void PersistentItemCache::Flush()
+{
+	std::scoped_lock fileLock(m_fileMutex);
+	FlushInternal();
+}
+
+PersistentItemCacheCounters PersistentItemCache::GetCounters() const
+{
+	std::scoped_lock lock(m_mutex);
+
+	PersistentItemCacheCounters counters = m_counters;
+	counters.numItems = m_entries.size();
+	counters.fileSize = m_fileSize;
+	return counters;
+}
+
+void PersistentItemCache::Open()
+{
+	m_entries.clear();
+	m_numDirtyEntries = 0;
+	m_fileSize = 0;
+	m_liveBytes = 0;
+
+	m_file.reset(CreateFile(m_filePath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+		nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr));
+
+	if (!m_file)
+	{
+		LOG(warning) << L"Unable to open the item cache file " << m_filePath
+					 << L". Items will only be cached for this session.";
+		return;
+	}
+
+	LARGE_INTEGER fileSize;
+
+	if (!GetFileSizeEx(m_file.get(), &fileSize) || !MapFile(fileSize.QuadPart))
+	{
+		CloseFile();
+		return;
+	}
+
+	ScanResult scanResult = Scan(m_view.get(), static_cast<std::size_t>(m_fileSize));
+
+	if (!scanResult.validHeader)
+	{
+		// Either the file was just created, or it's in an unknown format. In both cases, it's
+		// started again from scratch.
+		std::vector<std::uint8_t> header;
+		WriteHeader(header);
+
+		UnmapFile();
+
+		if (!ResizeFile(0) || !WriteToFile(header))
+		{
+			CloseFile();
+			return;
+		}
+
+		m_fileSize = header.size();
+
+		return;
+	}
+
+	if (scanResult.validLength < m_fileSize)
+	{
+		// The last write didn't complete, so the partial record needs to be removed before any
+		// further records are appended.
+		UnmapFile();
+
+		if (!ResizeFile(scanResult.validLength) || !MapFile(scanResult.validLength))
+		{
+			CloseFile();
+			return;
+		}
+	}
+
+	// Records are stored in the order they were written, so later records supersede earlier ones
+	// and are treated as having been used more recently.
+	for (auto &location : scanResult.records)
+	{
+		Entry &entry = m_entries[location.key.path];
+
+		m_liveBytes -= entry.recordSize;
+		m_liveBytes += location.size;
+
+		entry.size = location.key.size;
+		entry.lastWriteTime = location.key.lastWriteTime;
+		entry.mappedRecordOffset = location.offset;
+		entry.recordSize = location.size;
+		entry.lastUsed = m_useCounter++;
+	}
+}
+
+bool PersistentItemCache::MapFile(std::uint64_t size)
+{
+	m_fileSize = size;
+
+	if (size == 0)
+	{
+		return true;
+	}
+
+	m_fileMapping.reset(CreateFileMapping(m_file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+
+	if (!m_fileMapping)
+	{
+		return false;
+	}
+
+	m_view.reset(
+		static_cast<std::uint8_t *>(MapViewOfFile(m_fileMapping.get(), FILE_MAP_READ, 0, 0, 0)));
+
+	return m_view != nullptr;
+}
+
+void PersistentItemCache::UnmapFile()
+{
+	for (auto &[path, entry] : m_entries)
+	{
+		entry.mappedRecordOffset.reset();
+	}
+
+	m_view.reset();
+	m_fileMapping.reset();
+}
+
+bool PersistentItemCache::ResizeFile(std::uint64_t size)
+{
+	LARGE_INTEGER position;
+	position.QuadPart = size;
+
+	if (!SetFilePointerEx(m_file.get(), position, nullptr, FILE_BEGIN)
+		|| !SetEndOfFile(m_file.get()))
+	{
+		return false;
+	}
+
+	m_fileSize = size;
+
+	return true;
+}
+
+bool PersistentItemCache::WriteToFile(const std::vector<std::uint8_t> &data)
+{
+	LARGE_INTEGER position = {};
+
+	if (!SetFilePointerEx(m_file.get(), position, nullptr, FILE_END))
+	{
+		return false;
+	}
+
+	DWORD numBytesWritten;
+	BOOL res = WriteFile(m_file.get(), data.data(), static_cast<DWORD>(data.size()),
+		&numBytesWritten, nullptr);
+
+	return res && numBytesWritten == data.size();
+}
+
+void PersistentItemCache::CloseFile()
+{
+	UnmapFile();
+	m_file.reset();
+	m_fileSize = 0;
+	m_liveBytes = 0;
+}
+
+void PersistentItemCache::FlushInternal()
+{
+	std::unique_lock lock(m_mutex);
+
+	if (m_numDirtyEntries == 0)
+	{
+		return;
+	}
+
+	std::vector<std::uint8_t> output;
+
+	for (auto &[path, entry] : m_entries)
+	{
+		if (!entry.dirty)
+		{
+			continue;
+		}
+
+		std::size_t start = output.size();
+
+		Record record;
+		record.key = { path, entry.size, entry.lastWriteTime };
+		record.fields = GetAllFields(entry);
+		WriteRecord(output, record);
+
+		// The values are now all held in memory, since the new record isn't part of the mapped
+		// view.
+		entry.fields = std::move(record.fields);
+		entry.mappedRecordOffset.reset();
+
+		m_liveBytes -= entry.recordSize;
+		entry.recordSize = output.size() - start;
+		m_liveBytes += entry.recordSize;
+
+		entry.dirty = false;
+	}
+
+	m_numDirtyEntries = 0;
+
+	if (!m_file)
+	{
+		return;
+	}
+
+	// The values are all held in memory at this point, so they can still be retrieved while the
+	// records are being written.
+	lock.unlock();
+	bool written = WriteToFile(output);
+	lock.lock();
+
+	if (!written)
+	{
+		// Any partial record will be removed the next time the file is opened.
+		LOG(warning) << L"Unable to write to the item cache file " << m_filePath;
+		CloseFile();
+		return;
+	}
+
+	m_fileSize += output.size();
+
+	if (NeedsCompaction())
+	{
+		Compact(lock);
+	}
+}
+
+bool PersistentItemCache::NeedsCompaction() const
+{
+	if (m_fileSize > m_maxFileSize)
+	{
+		return true;
+	}
+
+	return m_fileSize > MIN_COMPACTION_SIZE && m_liveBytes < m_fileSize / 2;
+}
+
+// Rewrites the file so that it only contains the most recent record for each item. If those
+// records would still take up most of the maximum size, the least recently used items are dropped,
+// so that the file doesn't have to be compacted again shortly afterwards.
+//
+// The compacted file is written with the lock released. Values set in the meantime aren't part of
+// the compacted file, so they're kept in memory until the next flush.
+void PersistentItemCache::Compact(std::unique_lock<std::mutex> &lock)
+{
+	struct CompactedRecord
+	{
+		std::wstring path;
+		std::vector<std::uint8_t> data;
+		std::size_t offset = 0;
+	};
+
+	std::vector<std::pair<std::uint64_t, const std::wstring *>> itemsByUse;
+
+	for (const auto &[path, entry] : m_entries)
+	{
+		itemsByUse.emplace_back(entry.lastUsed, &path);
+	}
+
+	std::sort(itemsByUse.begin(), itemsByUse.end(),
+		[](const auto &item1, const auto &item2) { return item1.first > item2.first; });
+
+	std::uint64_t targetSize = m_maxFileSize / 4 * 3;
+	std::vector<CompactedRecord> records;
+	std::uint64_t totalSize = HEADER_SIZE;
+
+	for (const auto &[lastUsed, path] : itemsByUse)
+	{
+		const Entry &entry = m_entries.at(*path);
+
+		Record record;
+		record.key = { *path, entry.size, entry.lastWriteTime };
+		record.fields = GetAllFields(entry);
+
+		CompactedRecord compactedRecord;
+		compactedRecord.path = *path;
+		WriteRecord(compactedRecord.data, record);
+
+		if (totalSize + compactedRecord.data.size() > targetSize)
+		{
+			break;
+		}
+
+		totalSize += compactedRecord.data.size();
+		records.push_back(std::move(compactedRecord));
+	}
+
+	// The least recently used items are written first, so that they'll also be the first to be
+	// dropped the next time the file is compacted.
+	std::vector<std::uint8_t> output;
+	output.reserve(static_cast<std::size_t>(totalSize));
+	WriteHeader(output);
+
+	for (auto itr = records.rbegin(); itr != records.rend(); ++itr)
+	{
+		itr->offset = output.size();
+		output.insert(output.end(), itr->data.begin(), itr->data.end());
+	}
+
+	LOG(debug) << L"Compacting item cache: " << m_entries.size() << L" items, " << m_fileSize
+			   << L" bytes -> " << records.size() << L" items, " << output.size() << L" bytes";
+
+	std::wstring tempFilePath = m_filePath + L".tmp";
+
+	lock.unlock();
+	bool written = WriteCompactedFile(tempFilePath, output);
+	lock.lock();
+
+	// The values that were set while the compacted file was being written need to be read out of
+	// the existing file before it's closed.
+	for (auto &[path, entry] : m_entries)
+	{
+		if (entry.dirty)
+		{
+			entry.fields = GetAllFields(entry);
+		}
+	}
+
+	CloseFile();
+
+	if (!written
+		|| !MoveFileEx(tempFilePath.c_str(), m_filePath.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFile(tempFilePath.c_str());
+		m_entries.clear();
+		m_numDirtyEntries = 0;
+		return;
+	}
+
+	m_file.reset(CreateFile(m_filePath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
+
+	if (!m_file || !MapFile(output.size()))
+	{
+		CloseFile();
+		m_entries.clear();
+		m_numDirtyEntries = 0;
+		return;
+	}
+
+	m_counters.numCompactions++;
+
+	// The location of each record is already known, so the compacted file doesn't need to be
+	// scanned. Items that aren't in the file are dropped, unless they've since been modified.
+	for (auto &[path, entry] : m_entries)
+	{
+		entry.recordSize = 0;
+	}
+
+	for (const auto &record : records)
+	{
+		Entry &entry = m_entries.at(record.path);
+		entry.recordSize = record.data.size();
+		m_liveBytes += entry.recordSize;
+
+		if (!entry.dirty)
+		{
+			entry.mappedRecordOffset = record.offset;
+			entry.fields.clear();
+		}
+	}
+
+	for (auto itr = m_entries.begin(); itr != m_entries.end();)
+	{
+		if (!itr->second.dirty && itr->second.recordSize == 0)
+		{
+			itr = m_entries.erase(itr);
+		}
+		else
+		{
+			++itr;
+		}
+	}
+}
+
+bool PersistentItemCache::WriteCompactedFile(
+	const std::wstring &filePath, const std::vector<std::uint8_t> &data)
+{
+	wil::unique_hfile file(CreateFile(filePath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL, nullptr));
+
+	if (!file)
+	{
+		return false;
+	}
+
+	DWORD numBytesWritten;
+	BOOL res = WriteFile(
+		file.get(), data.data(), static_cast<DWORD>(data.size()), &numBytesWritten, nullptr);
+
+	return res && numBytesWritten == data.size();
+}
+
+Fields PersistentItemCache::GetAllFields(const Entry &entry) const
+{
+	Fields fields;
+
+	if (entry.mappedRecordOffset)
+	{
+		fields = ReadFields(m_view.get(), *entry.mappedRecordOffset);
+	}
+
+	for (const auto &[fieldId, value] : entry.fields)
+	{
+		fields[fieldId] = value;
+	}
+
+	return fields;
+}
+
+PersistentItemCache::Entry &PersistentItemCache::GetEntryForKey(const ItemKey &key)
+{
+	auto [itr, inserted] = m_entries.try_emplace(key.path);
+	Entry &entry = itr->second;
+
+	if (inserted)
+	{
+		entry.size = key.size;
+		entry.lastWriteTime = key.lastWriteTime;
+		return entry;
+	}
+
+	if (entry.size == key.size && entry.lastWriteTime == key.lastWriteTime)
+	{
+		return entry;
+	}
+
+	// The item has been modified, so none of its existing values apply anymore. Its existing
+	// record is superseded once the item is next written out.
+	entry.size = key.size;
+	entry.lastWriteTime = key.lastWriteTime;
+	entry.mappedRecordOffset.reset();
+	entry.fields.clear();
+
+	return entry;
+}
+
+void PersistentItemCache::MarkUsed(Entry &entry)
+{
+	entry.lastUsed = m_useCounter++;
+}
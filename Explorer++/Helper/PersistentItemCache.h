@@ -0,0 +1,120 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "PersistentItemCacheFormat.h"
+#include <wil/resource.h>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+struct PersistentItemCacheCounters
+{
+	std::uint64_t numHits = 0;
+	std::uint64_t numMisses = 0;
+	std::size_t numItems = 0;
+	std::uint64_t fileSize = 0;
+	std::uint64_t numCompactions = 0;
+};
+
+// Stores values that are expensive to retrieve (e.g. metadata that's read from the file itself)
+// between sessions. Values are keyed by the path of the item, along
+// with its size and last write time, so the values for an item are ignored once it's modified.
+//
+// The cache file is memory-mapped when it's opened and values from previous sessions are read
+// directly from the mapping, as they're needed. Values set during the current session are held in
+// memory and appended to the file when Flush() is called. If the file grows beyond its maximum
+// size, or consists mostly of superseded records, it's compacted, with the least recently used
+// items being dropped.
+//
+// If the file can't be opened (for example, because another instance of the application is using
+// it), values are still cached, but only for the current session.
+//
+// This class is thread-safe.
+class PersistentItemCache
+{
+public:
+	using ItemKey = PersistentItemCacheFormat::ItemKey;
+
+	PersistentItemCache(const std::wstring &filePath, std::uint64_t maxFileSize);
+	~PersistentItemCache();
+
+	std::optional<std::wstring> GetValue(const ItemKey &key, std::uint32_t fieldId);
+	void SetValue(const ItemKey &key, std::uint32_t fieldId, const std::wstring &value);
+
+	// Writes any new values to the file.
+	void Flush();
+
+	PersistentItemCacheCounters GetCounters() const;
+
+private:
+	// Once this many items have unsaved values, they'll be written out automatically.
+	static const std::size_t AUTO_FLUSH_THRESHOLD = 4096;
+
+	// Files smaller than this aren't compacted just because they contain superseded records.
+	static const std::uint64_t MIN_COMPACTION_SIZE = 1024 * 1024;
+
+	struct Entry
+	{
+		std::uint64_t size;
+		std::uint64_t lastWriteTime;
+
+		// The offset of the item's record within the mapped view, if the item's values are stored
+		// there.
+		std::optional<std::size_t> mappedRecordOffset;
+
+		// The size of the most recent record written for this item, or 0 if there isn't one. Used
+		// to track how much of the file is taken up by superseded records.
+		std::size_t recordSize = 0;
+
+		// Values that aren't in the mapped view. Once an item has been written during this session,
+		// this will hold all of its values.
+		PersistentItemCacheFormat::Fields fields;
+
+		bool dirty = false;
+		std::uint64_t lastUsed = 0;
+	};
+
+	void Open();
+	bool MapFile(std::uint64_t size);
+	void UnmapFile();
+	bool ResizeFile(std::uint64_t size);
+	bool WriteToFile(const std::vector<std::uint8_t> &data);
+	void CloseFile();
+
+	void FlushInternal();
+	bool NeedsCompaction() const;
+	void Compact(std::unique_lock<std::mutex> &lock);
+	static bool WriteCompactedFile(
+		const std::wstring &filePath, const std::vector<std::uint8_t> &data);
+
+	PersistentItemCacheFormat::Fields GetAllFields(const Entry &entry) const;
+	Entry &GetEntryForKey(const ItemKey &key);
+	void MarkUsed(Entry &entry);
+
+	const std::wstring m_filePath;
+	const std::uint64_t m_maxFileSize;
+
+	// Held while the file is being written to or replaced, so that only one thread does that at a
+	// time. The file is written with m_mutex released, so that values can still be retrieved in the
+	// meantime. This is always acquired before m_mutex.
+	std::mutex m_fileMutex;
+
+	mutable std::mutex m_mutex;
+	wil::unique_hfile m_file;
+	wil::unique_handle m_fileMapping;
+	wil::unique_mapview_ptr<std::uint8_t> m_view;
+	std::uint64_t m_fileSize = 0;
+
+	// The number of bytes in the file taken up by records that haven't been superseded.
+	std::uint64_t m_liveBytes = 0;
+
+	std::unordered_map<std::wstring, Entry> m_entries;
+	std::size_t m_numDirtyEntries = 0;
+	std::uint64_t m_useCounter = 0;
+	PersistentItemCacheCounters m_counters;
+};
@@ -0,0 +1,270 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "PersistentItemCacheFormat.h"
+#include <cstring>
+
+namespace PersistentItemCacheFormat
+{
+	namespace
+	{
+		const std::uint32_t FILE_MAGIC = 0x43495845; // "EXIC"
+		const std::uint32_t FILE_VERSION = 1;
+
+		// recordSize, checksum, fileSize, lastWriteTime, pathLength and numFields.
+		const std::size_t RECORD_HEADER_SIZE = 4 + 4 + 8 + 8 + 4 + 4;
+
+		// fieldId and valueLength.
+		const std::size_t FIELD_HEADER_SIZE = 4 + 4;
+
+		// The offset of the data covered by the checksum.
+		const std::size_t CHECKSUM_START = 8;
+
+		std::uint32_t CalculateChecksum(const std::uint8_t *data, std::size_t size)
+		{
+			std::uint32_t hash = 2166136261;
+
+			for (std::size_t i = 0; i < size; i++)
+			{
+				hash ^= data[i];
+				hash *= 16777619;
+			}
+
+			return hash;
+		}
+
+		template <typename T>
+		void WriteValue(std::vector<std::uint8_t> &output, T value)
+		{
+			std::uint8_t bytes[sizeof(T)];
+			std::memcpy(bytes, &value, sizeof(T));
+			output.insert(output.end(), bytes, bytes + sizeof(T));
+		}
+
+		template <typename T>
+		T ReadValue(const std::uint8_t *data)
+		{
+			T value;
+			std::memcpy(&value, data, sizeof(T));
+			return value;
+		}
+
+		void WriteString(std::vector<std::uint8_t> &output, const std::wstring &str)
+		{
+			for (wchar_t c : str)
+			{
+				WriteValue(output, static_cast<std::uint16_t>(c));
+			}
+		}
+
+		std::wstring ReadString(const std::uint8_t *data, std::size_t length)
+		{
+			std::wstring str;
+			str.reserve(length);
+
+			for (std::size_t i = 0; i < length; i++)
+			{
+				str.push_back(static_cast<wchar_t>(ReadValue<std::uint16_t>(data + i * 2)));
+			}
+
+			return str;
+		}
+
+		// Checks that the record at the specified offset is complete and internally consistent.
+		// Returns the record's location if so.
+		std::optional<RecordLocation> ValidateRecord(
+			const std::uint8_t *data, std::size_t size, std::size_t offset)
+		{
+			std::size_t remaining = size - offset;
+
+			if (remaining < RECORD_HEADER_SIZE)
+			{
+				return std::nullopt;
+			}
+
+			const std::uint8_t *record = data + offset;
+			auto recordSize = ReadValue<std::uint32_t>(record);
+
+			if (recordSize < RECORD_HEADER_SIZE || recordSize > remaining)
+			{
+				return std::nullopt;
+			}
+
+			auto checksum = ReadValue<std::uint32_t>(record + 4);
+
+			if (checksum
+				!= CalculateChecksum(record + CHECKSUM_START, recordSize - CHECKSUM_START))
+			{
+				return std::nullopt;
+			}
+
+			auto pathLength = ReadValue<std::uint32_t>(record + 24);
+			auto numFields = ReadValue<std::uint32_t>(record + 28);
+			std::size_t position = RECORD_HEADER_SIZE;
+
+			if (pathLength > (recordSize - position) / 2)
+			{
+				return std::nullopt;
+			}
+
+			position += static_cast<std::size_t>(pathLength) * 2;
+
+			for (std::uint32_t i = 0; i < numFields; i++)
+			{
+				if (recordSize - position < FIELD_HEADER_SIZE)
+				{
+					return std::nullopt;
+				}
+
+				auto valueLength = ReadValue<std::uint32_t>(record + position + 4);
+				position += FIELD_HEADER_SIZE;
+
+				if (valueLength > (recordSize - position) / 2)
+				{
+					return std::nullopt;
+				}
+
+				position += static_cast<std::size_t>(valueLength) * 2;
+			}
+
+			if (position != recordSize)
+			{
+				return std::nullopt;
+			}
+
+			RecordLocation location;
+			location.key.size = ReadValue<std::uint64_t>(record + 8);
+			location.key.lastWriteTime = ReadValue<std::uint64_t>(record + 16);
+			location.key.path = ReadString(record + RECORD_HEADER_SIZE, pathLength);
+			location.offset = offset;
+			location.size = recordSize;
+			return location;
+		}
+
+		// Calls the callback with each field in the record, until the callback returns false.
+		template <typename Callback>
+		void ForEachField(const std::uint8_t *data, std::size_t recordOffset, Callback callback)
+		{
+			const std::uint8_t *record = data + recordOffset;
+			auto pathLength = ReadValue<std::uint32_t>(record + 24);
+			auto numFields = ReadValue<std::uint32_t>(record + 28);
+			std::size_t position = RECORD_HEADER_SIZE + static_cast<std::size_t>(pathLength) * 2;
+
+			for (std::uint32_t i = 0; i < numFields; i++)
+			{
+				auto fieldId = ReadValue<std::uint32_t>(record + position);
+				auto valueLength = ReadValue<std::uint32_t>(record + position + 4);
+				position += FIELD_HEADER_SIZE;
+
+				if (!callback(fieldId, record + position, valueLength))
+				{
+					return;
+				}
+
+				position += static_cast<std::size_t>(valueLength) * 2;
+			}
+		}
+	}
+
+	void WriteHeader(std::vector<std::uint8_t> &output)
+	{
+		WriteValue(output, FILE_MAGIC);
+		WriteValue(output, FILE_VERSION);
+	}
+
+	void WriteRecord(std::vector<std::uint8_t> &output, const Record &record)
+	{
+		std::size_t start = output.size();
+
+		// The size and checksum are filled in once the rest of the record has been written.
+		WriteValue<std::uint32_t>(output, 0);
+		WriteValue<std::uint32_t>(output, 0);
+		WriteValue(output, record.key.size);
+		WriteValue(output, record.key.lastWriteTime);
+		WriteValue(output, static_cast<std::uint32_t>(record.key.path.size()));
+		WriteValue(output, static_cast<std::uint32_t>(record.fields.size()));
+		WriteString(output, record.key.path);
+
+		for (const auto &[fieldId, value] : record.fields)
+		{
+			WriteValue(output, fieldId);
+			WriteValue(output, static_cast<std::uint32_t>(value.size()));
+			WriteString(output, value);
+		}
+
+		auto recordSize = static_cast<std::uint32_t>(output.size() - start);
+		std::memcpy(output.data() + start, &recordSize, sizeof(recordSize));
+
+		std::uint32_t checksum = CalculateChecksum(
+			output.data() + start + CHECKSUM_START, recordSize - CHECKSUM_START);
+		std::memcpy(output.data() + start + 4, &checksum, sizeof(checksum));
+	}
+
+	ScanResult Scan(const std::uint8_t *data, std::size_t size)
+	{
+		ScanResult result;
+
+		if (size < HEADER_SIZE || ReadValue<std::uint32_t>(data) != FILE_MAGIC
+			|| ReadValue<std::uint32_t>(data + 4) != FILE_VERSION)
+		{
+			return result;
+		}
+
+		result.validHeader = true;
+
+		std::size_t offset = HEADER_SIZE;
+
+		while (offset < size)
+		{
+			auto location = ValidateRecord(data, size, offset);
+
+			if (!location)
+			{
+				break;
+			}
+
+			offset += location->size;
+			result.records.push_back(std::move(*location));
+		}
+
+		result.validLength = offset;
+
+		return result;
+	}
+
+	std::optional<std::wstring> ReadField(
+		const std::uint8_t *data, std::size_t recordOffset, std::uint32_t fieldId)
+	{
+		std::optional<std::wstring> value;
+
+		ForEachField(data, recordOffset,
+			[fieldId, &value](std::uint32_t currentFieldId, const std::uint8_t *valueData,
+				std::size_t valueLength) {
+				if (currentFieldId != fieldId)
+				{
+					return true;
+				}
+
+				value = ReadString(valueData, valueLength);
+				return false;
+			});
+
+		return value;
+	}
+
+	Fields ReadFields(const std::uint8_t *data, std::size_t recordOffset)
+	{
+		Fields fields;
+
+		ForEachField(data, recordOffset,
+			[&fields](std::uint32_t fieldId, const std::uint8_t *valueData,
+				std::size_t valueLength) {
+				fields[fieldId] = ReadString(valueData, valueLength);
+				return true;
+			});
+
+		return fields;
+	}
+}
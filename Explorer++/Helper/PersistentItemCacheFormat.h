@@ -0,0 +1,84 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+// The on-disk format used by PersistentItemCache. The file consists of a header, followed by a
+// sequence of records. Records are only ever appended, so a later record for a path supersedes
+// any earlier record for the same path.
+//
+// Each record is laid out as follows (all values are little-endian):
+//
+// uint32 recordSize     The size of the entire record, in bytes.
+// uint32 checksum       An FNV-1a hash of every byte in the record that follows this field.
+// uint64 fileSize
+// uint64 lastWriteTime
+// uint32 pathLength     In UTF-16 code units.
+// uint32 numFields
+// uint16 path[pathLength]
+// numFields x { uint32 fieldId, uint32 valueLength, uint16 value[valueLength] }
+//
+// The checksum means that a record that was only partially written (e.g. because the application
+// was terminated) is detected. Everything from that record onwards is discarded.
+namespace PersistentItemCacheFormat
+{
+	struct ItemKey
+	{
+		std::wstring path;
+		std::uint64_t size;
+		std::uint64_t lastWriteTime;
+
+		bool operator==(const ItemKey &other) const
+		{
+			return path == other.path && size == other.size
+				&& lastWriteTime == other.lastWriteTime;
+		}
+	};
+
+	using Fields = std::map<std::uint32_t, std::wstring>;
+
+	struct Record
+	{
+		ItemKey key;
+		Fields fields;
+	};
+
+	// The position of a record found when scanning a file.
+	struct RecordLocation
+	{
+		ItemKey key;
+		std::size_t offset;
+		std::size_t size;
+	};
+
+	struct ScanResult
+	{
+		bool validHeader = false;
+
+		// The number of bytes, from the start of the data, that are made up of complete records.
+		// Anything after this point should be truncated before more records are appended.
+		std::size_t validLength = 0;
+
+		std::vector<RecordLocation> records;
+	};
+
+	inline constexpr std::size_t HEADER_SIZE = 8;
+
+	void WriteHeader(std::vector<std::uint8_t> &output);
+	void WriteRecord(std::vector<std::uint8_t> &output, const Record &record);
+
+	ScanResult Scan(const std::uint8_t *data, std::size_t size);
+
+	// These should only be called with the offset of a record returned by Scan().
+	std::optional<std::wstring> ReadField(
+		const std::uint8_t *data, std::size_t recordOffset, std::uint32_t fieldId);
+	Fields ReadFields(const std::uint8_t *data, std::size_t recordOffset);
+}
@@ -0,0 +1,667 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+// This file doesn't use the precompiled header, so that it can also be built (along with its tests)
+// on platforms other than Windows.
+#include "PixelKernels.h"
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+// The SSE2 and AVX2 implementations are only built for x86 targets. Everywhere else (e.g. ARM64),
+// only the scalar implementations are used.
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PIXEL_KERNELS_X86
+#endif
+
+#ifdef PIXEL_KERNELS_X86
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+
+// MSVC allows intrinsics for any instruction set to be used without any additional options.
+#define TARGET_SSE2
+#define TARGET_AVX2
+#else
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace PixelKernels
+{
+	namespace
+	{
+		constexpr std::uint32_t ALPHA_MASK = 0xFF000000;
+
+		// The largest number of pixels that can be added together without a 32-bit total
+		// overflowing.
+		constexpr std::uint64_t MAX_VECTORIZED_BOX_AREA = 0xFFFFFFFF / 0xFF;
+
+		struct ChannelSums
+		{
+			std::uint64_t blue = 0;
+			std::uint64_t green = 0;
+			std::uint64_t red = 0;
+			std::uint64_t alpha = 0;
+		};
+
+		// Equivalent to round(color * alpha / 255), without the division.
+		std::uint32_t MultiplyChannel(std::uint32_t color, std::uint32_t alpha)
+		{
+			std::uint32_t product = color * alpha + 128;
+			return (product + (product >> 8)) >> 8;
+		}
+
+		std::uint32_t AverageChannel(std::uint64_t sum, std::uint64_t count)
+		{
+			return static_cast<std::uint32_t>((sum + count / 2) / count);
+		}
+
+		bool HasAlphaScalar(const ConstPixelBuffer &buffer)
+		{
+			for (int y = 0; y < buffer.height; y++)
+			{
+				const std::uint32_t *row = buffer.GetRow(y);
+
+				for (int x = 0; x < buffer.width; x++)
+				{
+					if (row[x] & ALPHA_MASK)
+					{
+						return true;
+					}
+				}
+			}
+
+			return false;
+		}
+
+		void ApplyMaskToAlphaScalar(const PixelBuffer &buffer, const ConstPixelBuffer &mask)
+		{
+			for (int y = 0; y < buffer.height; y++)
+			{
+				std::uint32_t *row = buffer.GetRow(y);
+				const std::uint32_t *maskRow = mask.GetRow(y);
+
+				for (int x = 0; x < buffer.width; x++)
+				{
+					row[x] = maskRow[x] ? 0 : (row[x] | ALPHA_MASK);
+				}
+			}
+		}
+
+		void PremultiplyPixels(std::uint32_t *pixels, int count)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				std::uint32_t pixel = pixels[i];
+				std::uint32_t alpha = pixel >> 24;
+
+				pixels[i] = (alpha << 24) | (MultiplyChannel((pixel >> 16) & 0xFF, alpha) << 16)
+					| (MultiplyChannel((pixel >> 8) & 0xFF, alpha) << 8)
+					| MultiplyChannel(pixel & 0xFF, alpha);
+			}
+		}
+
+		void PremultiplyScalar(const PixelBuffer &buffer)
+		{
+			for (int y = 0; y < buffer.height; y++)
+			{
+				PremultiplyPixels(buffer.GetRow(y), buffer.width);
+			}
+		}
+
+		void SumPixels(const std::uint32_t *pixels, int count, ChannelSums &sums)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				std::uint32_t pixel = pixels[i];
+				sums.blue += pixel & 0xFF;
+				sums.green += (pixel >> 8) & 0xFF;
+				sums.red += (pixel >> 16) & 0xFF;
+				sums.alpha += pixel >> 24;
+			}
+		}
+
+		void BoxDownscaleScalar(const ConstPixelBuffer &source, const PixelBuffer &destination)
+		{
+			assert(destination.width <= source.width && destination.height <= source.height);
+
+			for (int dy = 0; dy < destination.height; dy++)
+			{
+				// Since the destination is no larger than the source, each destination pixel always
+				// covers at least one source pixel in each dimension.
+				int y0 = static_cast<int>(
+					static_cast<std::int64_t>(dy) * source.height / destination.height);
+				int y1 = static_cast<int>(
+					static_cast<std::int64_t>(dy + 1) * source.height / destination.height);
+
+				std::uint32_t *destinationRow = destination.GetRow(dy);
+
+				for (int dx = 0; dx < destination.width; dx++)
+				{
+					int x0 = static_cast<int>(
+						static_cast<std::int64_t>(dx) * source.width / destination.width);
+					int x1 = static_cast<int>(
+						static_cast<std::int64_t>(dx + 1) * source.width / destination.width);
+
+					ChannelSums sums;
+
+					for (int y = y0; y < y1; y++)
+					{
+						SumPixels(source.GetRow(y) + x0, x1 - x0, sums);
+					}
+
+					std::uint64_t count = static_cast<std::uint64_t>(x1 - x0) * (y1 - y0);
+
+					destinationRow[dx] = (AverageChannel(sums.alpha, count) << 24)
+						| (AverageChannel(sums.red, count) << 16)
+						| (AverageChannel(sums.green, count) << 8)
+						| AverageChannel(sums.blue, count);
+				}
+			}
+		}
+
+#ifdef PIXEL_KERNELS_X86
+		void AccumulateRow(const std::uint32_t *row, int width, std::uint32_t *columnSums)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				columnSums[x * 4] += row[x] & 0xFF;
+				columnSums[x * 4 + 1] += (row[x] >> 8) & 0xFF;
+				columnSums[x * 4 + 2] += (row[x] >> 16) & 0xFF;
+				columnSums[x * 4 + 3] += row[x] >> 24;
+			}
+		}
+
+		TARGET_SSE2 bool HasAlphaSSE2(const ConstPixelBuffer &buffer)
+		{
+			const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(ALPHA_MASK));
+			const __m128i zero = _mm_setzero_si128();
+
+			for (int y = 0; y < buffer.height; y++)
+			{
+				const std::uint32_t *row = buffer.GetRow(y);
+				__m128i combined = zero;
+				std::uint32_t combinedTail = 0;
+				int x = 0;
+
+				for (; x + 4 <= buffer.width; x += 4)
+				{
+					combined = _mm_or_si128(
+						combined, _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x)));
+				}
+
+				for (; x < buffer.width; x++)
+				{
+					combinedTail |= row[x];
+				}
+
+				__m128i alpha = _mm_and_si128(combined, alphaMask);
+
+				if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) != 0xFFFF
+					|| (combinedTail & ALPHA_MASK))
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		TARGET_SSE2 void ApplyMaskToAlphaSSE2(
+			const PixelBuffer &buffer, const ConstPixelBuffer &mask)
+		{
+			const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(ALPHA_MASK));
+			const __m128i zero = _mm_setzero_si128();
+
+			for (int y = 0; y < buffer.height; y++)
+			{
+				std::uint32_t *row = buffer.GetRow(y);
+				const std::uint32_t *maskRow = mask.GetRow(y);
+				int x = 0;
+
+				for (; x + 4 <= buffer.width; x += 4)
+				{
+					__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x));
+					__m128i maskPixels =
+						_mm_loadu_si128(reinterpret_cast<const __m128i *>(maskRow + x));
+
+					// All bits are set for pixels that are clear in the mask (i.e. are opaque).
+					__m128i opaque = _mm_cmpeq_epi32(maskPixels, zero);
+
+					pixels = _mm_and_si128(_mm_or_si128(pixels, alphaMask), opaque);
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(row + x), pixels);
+				}
+
+				for (; x < buffer.width; x++)
+				{
+					row[x] = maskRow[x] ? 0 : (row[x] | ALPHA_MASK);
+				}
+			}
+		}
+
+		// Premultiplies two pixels, each of which has been expanded to four 16-bit channels.
+		TARGET_SSE2 __m128i PremultiplyExpandedSSE2(__m128i pixels)
+		{
+			const __m128i colorMask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+			const __m128i alphaMultiplier = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+			const __m128i rounding = _mm_set1_epi16(128);
+
+			__m128i alpha = _mm_shufflehi_epi16(
+				_mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+			// The alpha channel is multiplied by 255, which leaves it unchanged.
+			__m128i multiplier = _mm_or_si128(_mm_and_si128(alpha, colorMask), alphaMultiplier);
+
+			__m128i product = _mm_add_epi16(_mm_mullo_epi16(pixels, multiplier), rounding);
+			return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+		}
+
+		TARGET_SSE2 void PremultiplySSE2(const PixelBuffer &buffer)
+		{
+			const __m128i zero = _mm_setzero_si128();
+
+			for (int y = 0; y < buffer.height; y++)
+			{
+				std::uint32_t *row = buffer.GetRow(y);
+				int x = 0;
+
+				for (; x + 4 <= buffer.width; x += 4)
+				{
+					__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x));
+					__m128i low = PremultiplyExpandedSSE2(_mm_unpacklo_epi8(pixels, zero));
+					__m128i high = PremultiplyExpandedSSE2(_mm_unpackhi_epi8(pixels, zero));
+					_mm_storeu_si128(
+						reinterpret_cast<__m128i *>(row + x), _mm_packus_epi16(low, high));
+				}
+
+				PremultiplyPixels(row + x, buffer.width - x);
+			}
+		}
+
+		// Adds each pixel in the row to the running per-channel totals for its column.
+		TARGET_SSE2 void AccumulateRowSSE2(
+			const std::uint32_t *row, int width, std::uint32_t *columnSums)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			int x = 0;
+
+			for (; x + 4 <= width; x += 4)
+			{
+				__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x));
+				__m128i low = _mm_unpacklo_epi8(pixels, zero);
+				__m128i high = _mm_unpackhi_epi8(pixels, zero);
+
+				__m128i channels[4] = { _mm_unpacklo_epi16(low, zero),
+					_mm_unpackhi_epi16(low, zero), _mm_unpacklo_epi16(high, zero),
+					_mm_unpackhi_epi16(high, zero) };
+
+				for (int i = 0; i < 4; i++)
+				{
+					auto *sums = reinterpret_cast<__m128i *>(columnSums + (x + i) * 4);
+					_mm_storeu_si128(sums, _mm_add_epi32(_mm_loadu_si128(sums), channels[i]));
+				}
+			}
+
+			AccumulateRow(row + x, width - x, columnSums + x * 4);
+		}
+
+		// Each column holds the four channel totals for one pixel, so summing a range of columns
+		// is a matter of adding one vector per column.
+		TARGET_SSE2 void SumColumnsSSE2(
+			const std::uint32_t *columnSums, int count, std::uint32_t (&totals)[4])
+		{
+			__m128i total = _mm_setzero_si128();
+
+			for (int i = 0; i < count; i++)
+			{
+				total = _mm_add_epi32(
+					total, _mm_loadu_si128(reinterpret_cast<const __m128i *>(columnSums + i * 4)));
+			}
+
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(totals), total);
+		}
+
+		// The source rows covered by each row of destination pixels are first added together,
+		// which can be done for the entire width of the image at once. Each destination pixel is
+		// then the sum of a range of those column totals.
+		template <typename AccumulateRowFunction>
+		void BoxDownscaleSeparable(const ConstPixelBuffer &source, const PixelBuffer &destination,
+			AccumulateRowFunction accumulateRow)
+		{
+			assert(destination.width <= source.width && destination.height <= source.height);
+
+			std::vector<std::uint32_t> columnSums(static_cast<std::size_t>(source.width) * 4);
+
+			for (int dy = 0; dy < destination.height; dy++)
+			{
+				int y0 = static_cast<int>(
+					static_cast<std::int64_t>(dy) * source.height / destination.height);
+				int y1 = static_cast<int>(
+					static_cast<std::int64_t>(dy + 1) * source.height / destination.height);
+
+				std::fill(columnSums.begin(), columnSums.end(), 0);
+
+				for (int y = y0; y < y1; y++)
+				{
+					accumulateRow(source.GetRow(y), source.width, columnSums.data());
+				}
+
+				std::uint32_t *destinationRow = destination.GetRow(dy);
+
+				for (int dx = 0; dx < destination.width; dx++)
+				{
+					int x0 = static_cast<int>(
+						static_cast<std::int64_t>(dx) * source.width / destination.width);
+					int x1 = static_cast<int>(
+						static_cast<std::int64_t>(dx + 1) * source.width / destination.width);
+
+					std::uint32_t totals[4];
+					SumColumnsSSE2(columnSums.data() + x0 * 4, x1 - x0, totals);
+
+					std::uint64_t count = static_cast<std::uint64_t>(x1 - x0) * (y1 - y0);
+
+					destinationRow[dx] = (AverageChannel(totals[3], count) << 24)
+						| (AverageChannel(totals[2], count) << 16)
+						| (AverageChannel(totals[1], count) << 8)
+						| AverageChannel(totals[0], count);
+				}
+			}
+		}
+
+		void BoxDownscaleSSE2(const ConstPixelBuffer &source, const PixelBuffer &destination)
+		{
+			BoxDownscaleSeparable(source, destination, AccumulateRowSSE2);
+		}
+
+		TARGET_AVX2 bool HasAlphaAVX2(const ConstPixelBuffer &buffer)
+		{
+			const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(ALPHA_MASK));
+
+			for (int y = 0; y < buffer.height; y++)
+			{
+				const std::uint32_t *row = buffer.GetRow(y);
+				__m256i combined = _mm256_setzero_si256();
+				std::uint32_t combinedTail = 0;
+				int x = 0;
+
+				for (; x + 8 <= buffer.width; x += 8)
+				{
+					combined = _mm256_or_si256(
+						combined, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x)));
+				}
+
+				for (; x < buffer.width; x++)
+				{
+					combinedTail |= row[x];
+				}
+
+				if (!_mm256_testz_si256(combined, alphaMask) || (combinedTail & ALPHA_MASK))
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		TARGET_AVX2 void ApplyMaskToAlphaAVX2(
+			const PixelBuffer &buffer, const ConstPixelBuffer &mask)
+		{
+			const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(ALPHA_MASK));
+			const __m256i zero = _mm256_setzero_si256();
+
+			for (int y = 0; y < buffer.height; y++)
+			{
+				std::uint32_t *row = buffer.GetRow(y);
+				const std::uint32_t *maskRow = mask.GetRow(y);
+				int x = 0;
+
+				for (; x + 8 <= buffer.width; x += 8)
+				{
+					__m256i pixels =
+						_mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x));
+					__m256i maskPixels =
+						_mm256_loadu_si256(reinterpret_cast<const __m256i *>(maskRow + x));
+					__m256i opaque = _mm256_cmpeq_epi32(maskPixels, zero);
+
+					pixels = _mm256_and_si256(_mm256_or_si256(pixels, alphaMask), opaque);
+					_mm256_storeu_si256(reinterpret_cast<__m256i *>(row + x), pixels);
+				}
+
+				for (; x < buffer.width; x++)
+				{
+					row[x] = maskRow[x] ? 0 : (row[x] | ALPHA_MASK);
+				}
+			}
+		}
+
+		// The AVX2 unpack and pack instructions operate on each 128-bit lane independently, so
+		// this works in the same way as the SSE2 version, just on two sets of pixels at once.
+		TARGET_AVX2 __m256i PremultiplyExpandedAVX2(__m256i pixels)
+		{
+			const __m256i colorMask = _mm256_set_epi16(
+				0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+			const __m256i alphaMultiplier =
+				_mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+			const __m256i rounding = _mm256_set1_epi16(128);
+
+			__m256i alpha = _mm256_shufflehi_epi16(
+				_mm256_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			__m256i multiplier =
+				_mm256_or_si256(_mm256_and_si256(alpha, colorMask), alphaMultiplier);
+
+			__m256i product =
+				_mm256_add_epi16(_mm256_mullo_epi16(pixels, multiplier), rounding);
+			return _mm256_srli_epi16(
+				_mm256_add_epi16(product, _mm256_srli_epi16(product, 8)), 8);
+		}
+
+		TARGET_AVX2 void PremultiplyAVX2(const PixelBuffer &buffer)
+		{
+			const __m256i zero = _mm256_setzero_si256();
+
+			for (int y = 0; y < buffer.height; y++)
+			{
+				std::uint32_t *row = buffer.GetRow(y);
+				int x = 0;
+
+				for (; x + 8 <= buffer.width; x += 8)
+				{
+					__m256i pixels =
+						_mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x));
+					__m256i low = PremultiplyExpandedAVX2(_mm256_unpacklo_epi8(pixels, zero));
+					__m256i high = PremultiplyExpandedAVX2(_mm256_unpackhi_epi8(pixels, zero));
+					_mm256_storeu_si256(
+						reinterpret_cast<__m256i *>(row + x), _mm256_packus_epi16(low, high));
+				}
+
+				PremultiplyPixels(row + x, buffer.width - x);
+			}
+		}
+
+		TARGET_AVX2 void AccumulateRowAVX2(
+			const std::uint32_t *row, int width, std::uint32_t *columnSums)
+		{
+			int x = 0;
+
+			// Each pair of pixels is widened to eight 32-bit channels, which keeps the channel
+			// totals in the same order as the pixels.
+			for (; x + 2 <= width; x += 2)
+			{
+				__m256i channels = _mm256_cvtepu8_epi32(
+					_mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + x)));
+
+				auto *sums = reinterpret_cast<__m256i *>(columnSums + x * 4);
+				_mm256_storeu_si256(sums, _mm256_add_epi32(_mm256_loadu_si256(sums), channels));
+			}
+
+			AccumulateRow(row + x, width - x, columnSums + x * 4);
+		}
+
+		void BoxDownscaleAVX2(const ConstPixelBuffer &source, const PixelBuffer &destination)
+		{
+			BoxDownscaleSeparable(source, destination, AccumulateRowAVX2);
+		}
+
+		InstructionSet DetectInstructionSet()
+		{
+#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 0);
+			int maxLeaf = info[0];
+
+			__cpuid(info, 1);
+			bool sse2 = (info[3] & (1 << 26)) != 0;
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool avx = (info[2] & (1 << 28)) != 0;
+
+			// AVX2 can only be used if the OS saves the AVX registers on a context switch.
+			if (osxsave && avx && maxLeaf >= 7 && (_xgetbv(0) & 0x6) == 0x6)
+			{
+				__cpuidex(info, 7, 0);
+
+				if (info[1] & (1 << 5))
+				{
+					return InstructionSet::AVX2;
+				}
+			}
+
+			return sse2 ? InstructionSet::SSE2 : InstructionSet::Scalar;
+#else
+			__builtin_cpu_init();
+
+			if (__builtin_cpu_supports("avx2"))
+			{
+				return InstructionSet::AVX2;
+			}
+
+			return __builtin_cpu_supports("sse2") ? InstructionSet::SSE2 : InstructionSet::Scalar;
+#endif
+		}
+#else
+		InstructionSet DetectInstructionSet()
+		{
+			return InstructionSet::Scalar;
+		}
+#endif
+
+		// Falls back to the scalar implementation if the requested instruction set isn't
+		// available.
+		InstructionSet ResolveInstructionSet(InstructionSet instructionSet)
+		{
+			return IsInstructionSetSupported(instructionSet) ? instructionSet
+															 : InstructionSet::Scalar;
+		}
+	}
+
+	InstructionSet GetBestInstructionSet()
+	{
+		static const InstructionSet bestInstructionSet = DetectInstructionSet();
+		return bestInstructionSet;
+	}
+
+	bool IsInstructionSetSupported(InstructionSet instructionSet)
+	{
+		return static_cast<int>(instructionSet) <= static_cast<int>(GetBestInstructionSet());
+	}
+
+	bool HasAlpha(const ConstPixelBuffer &buffer, InstructionSet instructionSet)
+	{
+		switch (ResolveInstructionSet(instructionSet))
+		{
+#ifdef PIXEL_KERNELS_X86
+		case InstructionSet::AVX2:
+			return HasAlphaAVX2(buffer);
+
+		case InstructionSet::SSE2:
+			return HasAlphaSSE2(buffer);
+#endif
+
+		default:
+			return HasAlphaScalar(buffer);
+		}
+	}
+
+	void ApplyMaskToAlpha(
+		const PixelBuffer &buffer, const ConstPixelBuffer &mask, InstructionSet instructionSet)
+	{
+		assert(mask.width >= buffer.width && mask.height >= buffer.height);
+
+		switch (ResolveInstructionSet(instructionSet))
+		{
+#ifdef PIXEL_KERNELS_X86
+		case InstructionSet::AVX2:
+			ApplyMaskToAlphaAVX2(buffer, mask);
+			break;
+
+		case InstructionSet::SSE2:
+			ApplyMaskToAlphaSSE2(buffer, mask);
+			break;
+#endif
+
+		default:
+			ApplyMaskToAlphaScalar(buffer, mask);
+			break;
+		}
+	}
+
+	void Premultiply(const PixelBuffer &buffer, InstructionSet instructionSet)
+	{
+		switch (ResolveInstructionSet(instructionSet))
+		{
+#ifdef PIXEL_KERNELS_X86
+		case InstructionSet::AVX2:
+			PremultiplyAVX2(buffer);
+			break;
+
+		case InstructionSet::SSE2:
+			PremultiplySSE2(buffer);
+			break;
+#endif
+
+		default:
+			PremultiplyScalar(buffer);
+			break;
+		}
+	}
+
+	void BoxDownscale(const ConstPixelBuffer &source, const PixelBuffer &destination,
+		InstructionSet instructionSet)
+	{
+		if (destination.width == 0 || destination.height == 0)
+		{
+			return;
+		}
+
+		// The vectorized implementations hold each channel total in 32 bits. That's only an issue
+		// for extreme reductions, which are left to the scalar implementation.
+		std::uint64_t maxBoxWidth = source.width / destination.width + 1;
+		std::uint64_t maxBoxHeight = source.height / destination.height + 1;
+
+		if (maxBoxWidth * maxBoxHeight > MAX_VECTORIZED_BOX_AREA)
+		{
+			instructionSet = InstructionSet::Scalar;
+		}
+
+		switch (ResolveInstructionSet(instructionSet))
+		{
+#ifdef PIXEL_KERNELS_X86
+		case InstructionSet::AVX2:
+			BoxDownscaleAVX2(source, destination);
+			break;
+
+		case InstructionSet::SSE2:
+			BoxDownscaleSSE2(source, destination);
+			break;
+#endif
+
+		default:
+			BoxDownscaleScalar(source, destination);
+			break;
+		}
+	}
+}
@@ -0,0 +1,68 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <cstdint>
+
+// A view onto a block of 32-bit pixels, in the layout used by 32bpp DIBs (blue in the low byte,
+// alpha in the high byte). The view doesn't own the pixels.
+template <typename Pixel>
+struct BasicPixelBuffer
+{
+	Pixel *pixels;
+	int width;
+	int height;
+
+	// The number of pixels (not bytes) between the start of one row and the start of the next.
+	int stride;
+
+	Pixel *GetRow(int y) const
+	{
+		return pixels + static_cast<std::intptr_t>(y) * stride;
+	}
+};
+
+using PixelBuffer = BasicPixelBuffer<std::uint32_t>;
+using ConstPixelBuffer = BasicPixelBuffer<const std::uint32_t>;
+
+// Operations that are run on every pixel of every icon and thumbnail that's drawn. Each operation
+// has a scalar implementation, along with SSE2 and AVX2 implementations that are used when the
+// processor supports them. All implementations produce identical results.
+namespace PixelKernels
+{
+	enum class InstructionSet
+	{
+		Scalar,
+		SSE2,
+		AVX2
+	};
+
+	// Returns the most capable instruction set supported by the processor (and the OS). This is
+	// what each operation uses by default.
+	InstructionSet GetBestInstructionSet();
+	bool IsInstructionSetSupported(InstructionSet instructionSet);
+
+	// Returns true if any pixel has a non-zero alpha value.
+	bool HasAlpha(
+		const ConstPixelBuffer &buffer, InstructionSet instructionSet = GetBestInstructionSet());
+
+	// Uses a monochrome mask (expanded to 32 bits per pixel) to set the alpha channel of an image
+	// that doesn't have one. Pixels that are set in the mask become fully transparent (and are
+	// cleared), while all other pixels become opaque. The mask must be at least as large as the
+	// buffer.
+	void ApplyMaskToAlpha(const PixelBuffer &buffer, const ConstPixelBuffer &mask,
+		InstructionSet instructionSet = GetBestInstructionSet());
+
+	// Multiplies the color channels of each pixel by its alpha value, as required by AlphaBlend()
+	// and image lists.
+	void Premultiply(
+		const PixelBuffer &buffer, InstructionSet instructionSet = GetBestInstructionSet());
+
+	// Shrinks the source image into the destination, with each destination pixel being the average
+	// of the source pixels it covers. The destination can't be larger than the source in either
+	// dimension.
+	void BoxDownscale(const ConstPixelBuffer &source, const PixelBuffer &destination,
+		InstructionSet instructionSet = GetBestInstructionSet());
+}
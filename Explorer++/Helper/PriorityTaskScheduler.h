@@ -0,0 +1,431 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "TaskExecutor.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct PriorityTaskSchedulerCounters
+{
+	// The number of tasks currently waiting to run, along with the largest number of tasks that
+	// have been waiting at any one time.
+	std::size_t queueDepth = 0;
+	std::size_t maxQueueDepth = 0;
+
+	std::uint64_t numQueued = 0;
+
+	// The number of requests that were merged into a task that was already waiting.
+	std::uint64_t numDeduplicated = 0;
+
+	// The number of tasks that were removed before they ran.
+	std::uint64_t numDropped = 0;
+
+	std::uint64_t numCompleted = 0;
+
+	// The number of tasks currently running, along with the largest number of tasks that have
+	// been running at any one time.
+	std::size_t numRunning = 0;
+	std::size_t maxRunning = 0;
+
+	// The latency of a task is the time between it being queued and it starting to run.
+	std::chrono::microseconds totalLatency = std::chrono::microseconds::zero();
+	std::chrono::microseconds maxLatency = std::chrono::microseconds::zero();
+
+	std::chrono::microseconds GetAverageLatency() const
+	{
+		std::uint64_t numStarted = numQueued - numDropped - queueDepth;
+
+		if (numStarted == 0)
+		{
+			return std::chrono::microseconds::zero();
+		}
+
+		return totalLatency / numStarted;
+	}
+};
+
+// Runs tasks on a fixed set of worker threads, in order of priority. Tasks with a lower priority
+// value run first, while tasks with the same priority run in the order they were queued.
+//
+// Each task is identified by a key. If a task is queued while a task with the same key is still
+// waiting, no new task is added. Instead, the existing task is kept and its priority is updated.
+// Waiting tasks can also be reprioritized or dropped at any time (e.g. once the item they're for
+// is no longer visible).
+//
+// The worker threads can either be owned by the scheduler, or shared, by running the tasks on a
+// TaskQueue. In the latter case, each call to Queue() pushes a task onto the TaskQueue that runs
+// whichever task currently has the highest priority.
+//
+// The number of tasks that run at the same time can also be limited (e.g. so that a slow device
+// isn't overwhelmed by concurrent requests), independently of the number of worker threads.
+template <typename Key, typename Hash = std::hash<Key>>
+class PriorityTaskScheduler
+{
+public:
+	using Task = std::function<void()>;
+
+	// threadStart and threadExit are optional and are called on each worker thread when it starts
+	// and exits (e.g. to initialize COM).
+	PriorityTaskScheduler(int numThreads, std::function<void()> threadStart = nullptr,
+		std::function<void()> threadExit = nullptr)
+	{
+		for (int i = 0; i < numThreads; i++)
+		{
+			m_threads.emplace_back([this, threadStart, threadExit]() {
+				if (threadStart)
+				{
+					threadStart();
+				}
+
+				RunTasks();
+
+				if (threadExit)
+				{
+					threadExit();
+				}
+			});
+		}
+	}
+
+	explicit PriorityTaskScheduler(std::unique_ptr<TaskQueue> taskQueue) :
+		m_taskQueue(std::move(taskQueue))
+	{
+	}
+
+	// Any tasks that are still waiting are dropped. Tasks that are running will be allowed to
+	// finish.
+	~PriorityTaskScheduler()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+
+		m_condition.notify_all();
+
+		for (auto &thread : m_threads)
+		{
+			thread.join();
+		}
+
+		if (m_taskQueue)
+		{
+			m_taskQueue->Shutdown();
+		}
+	}
+
+	PriorityTaskScheduler(const PriorityTaskScheduler &) = delete;
+	PriorityTaskScheduler &operator=(const PriorityTaskScheduler &) = delete;
+
+	// Returns true if the task was queued, or false if a task with the same key was already
+	// waiting (in which case, the provided task is discarded).
+	bool Queue(const Key &key, int priority, Task task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			auto itr = m_tasks.find(key);
+
+			if (itr != m_tasks.end())
+			{
+				SetPriority(key, itr->second, priority);
+				m_counters.numDeduplicated++;
+				return false;
+			}
+
+			QueuedTask queuedTask;
+			queuedTask.priority = priority;
+			queuedTask.sequence = m_sequenceCounter++;
+			queuedTask.task = std::move(task);
+			queuedTask.queueTime = Clock::now();
+
+			m_order.insert({ { queuedTask.priority, queuedTask.sequence }, key });
+			m_tasks.insert({ key, std::move(queuedTask) });
+
+			m_counters.numQueued++;
+			UpdateQueueDepth();
+		}
+
+		if (m_taskQueue)
+		{
+			PushRunners();
+		}
+		else
+		{
+			m_condition.notify_one();
+		}
+
+		return true;
+	}
+
+	// Calls getPriority for each waiting task. The function should return the new priority for
+	// the task, or an empty value if the task should be dropped. The keys of the tasks that were
+	// dropped are returned. The function is called while an internal lock is held, so it shouldn't
+	// call back into the scheduler.
+	template <typename GetPriority>
+	std::vector<Key> Reprioritize(GetPriority getPriority)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		std::vector<Key> droppedKeys;
+
+		for (auto itr = m_tasks.begin(); itr != m_tasks.end();)
+		{
+			std::optional<int> priority = getPriority(itr->first);
+
+			if (!priority)
+			{
+				m_order.erase({ itr->second.priority, itr->second.sequence });
+				droppedKeys.push_back(itr->first);
+				itr = m_tasks.erase(itr);
+				continue;
+			}
+
+			SetPriority(itr->first, itr->second, *priority);
+			++itr;
+		}
+
+		m_counters.numDropped += droppedKeys.size();
+		UpdateQueueDepth();
+
+		return droppedKeys;
+	}
+
+	// Drops all waiting tasks. Tasks that are already running aren't affected.
+	void Clear()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_counters.numDropped += m_tasks.size();
+
+		m_tasks.clear();
+		m_order.clear();
+		UpdateQueueDepth();
+	}
+
+	PriorityTaskSchedulerCounters GetCounters() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_counters;
+	}
+
+	// Limits the number of tasks that can run at the same time. An empty value removes the limit,
+	// so that the number of running tasks is only limited by the number of worker threads.
+	void SetConcurrencyLimit(std::optional<int> concurrencyLimit)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_concurrencyLimit = concurrencyLimit;
+		}
+
+		if (m_taskQueue)
+		{
+			PushRunners();
+		}
+		else
+		{
+			m_condition.notify_all();
+		}
+	}
+
+	std::optional<int> GetConcurrencyLimit() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_concurrencyLimit;
+	}
+
+	// Only applicable when the tasks are run on a TaskQueue.
+	void SetPriorityClass(TaskPriorityClass priorityClass)
+	{
+		if (m_taskQueue)
+		{
+			m_taskQueue->SetPriorityClass(priorityClass);
+		}
+	}
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	// Tasks are ordered by priority, then by the order in which they were queued.
+	using TaskOrder = std::pair<int, std::uint64_t>;
+
+	struct QueuedTask
+	{
+		int priority;
+		std::uint64_t sequence;
+		Task task;
+		Clock::time_point queueTime;
+	};
+
+	void RunTasks()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		while (true)
+		{
+			m_condition.wait(
+				lock, [this]() { return m_stop || (!m_order.empty() && HasCapacity()); });
+
+			if (m_stop)
+			{
+				break;
+			}
+
+			RunHighestPriorityTask(lock);
+
+			if (m_concurrencyLimit)
+			{
+				// Another worker may have been waiting for this task to finish.
+				m_condition.notify_one();
+			}
+		}
+	}
+
+	// Pushes enough runners onto the TaskQueue to start as many of the waiting tasks as the
+	// concurrency limit allows. Each runner starts a single task (if there's still one waiting
+	// by the time the runner is called).
+	void PushRunners()
+	{
+		int numRunners;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (m_stop)
+			{
+				return;
+			}
+
+			std::size_t numStartable = m_tasks.size();
+
+			if (m_concurrencyLimit)
+			{
+				std::size_t capacity = static_cast<std::size_t>(
+					(std::max)(*m_concurrencyLimit - static_cast<int>(m_counters.numRunning), 0));
+				numStartable = (std::min)(numStartable, capacity);
+			}
+
+			numRunners = static_cast<int>(numStartable) - m_numPendingRunners;
+
+			if (numRunners <= 0)
+			{
+				return;
+			}
+
+			m_numPendingRunners += numRunners;
+		}
+
+		for (int i = 0; i < numRunners; i++)
+		{
+			m_taskQueue->PushTask([this]() { RunNextTask(); });
+		}
+	}
+
+	// Called on the TaskQueue. The task that's run may not be the one that was queued alongside
+	// this call. If tasks have been dropped, there may be nothing left to run.
+	void RunNextTask()
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_numPendingRunners--;
+
+			if (m_stop || m_order.empty() || !HasCapacity())
+			{
+				return;
+			}
+
+			RunHighestPriorityTask(lock);
+		}
+
+		// If there's a concurrency limit, there may be tasks waiting that can only be started
+		// now that this task has finished.
+		PushRunners();
+	}
+
+	// Should be called with the lock held.
+	bool HasCapacity() const
+	{
+		return !m_concurrencyLimit
+			|| static_cast<int>(m_counters.numRunning) < (std::max)(*m_concurrencyLimit, 1);
+	}
+
+	// Should be called with the lock held. The lock is released while the task runs.
+	void RunHighestPriorityTask(std::unique_lock<std::mutex> &lock)
+	{
+		auto orderItr = m_order.begin();
+		auto taskItr = m_tasks.find(orderItr->second);
+		QueuedTask queuedTask = std::move(taskItr->second);
+		m_order.erase(orderItr);
+		m_tasks.erase(taskItr);
+
+		auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+			Clock::now() - queuedTask.queueTime);
+		m_counters.totalLatency += latency;
+		m_counters.maxLatency = (std::max)(m_counters.maxLatency, latency);
+		UpdateQueueDepth();
+
+		m_counters.numRunning++;
+		m_counters.maxRunning = (std::max)(m_counters.maxRunning, m_counters.numRunning);
+
+		lock.unlock();
+		queuedTask.task();
+		queuedTask.task = nullptr;
+		lock.lock();
+
+		m_counters.numRunning--;
+		m_counters.numCompleted++;
+	}
+
+	// Should be called with the lock held.
+	void SetPriority(const Key &key, QueuedTask &queuedTask, int priority)
+	{
+		if (queuedTask.priority == priority)
+		{
+			return;
+		}
+
+		m_order.erase({ queuedTask.priority, queuedTask.sequence });
+		queuedTask.priority = priority;
+		m_order.insert({ { queuedTask.priority, queuedTask.sequence }, key });
+	}
+
+	// Should be called with the lock held.
+	void UpdateQueueDepth()
+	{
+		m_counters.queueDepth = m_tasks.size();
+		m_counters.maxQueueDepth = (std::max)(m_counters.maxQueueDepth, m_counters.queueDepth);
+	}
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::unordered_map<Key, QueuedTask, Hash> m_tasks;
+	std::map<TaskOrder, Key> m_order;
+	std::uint64_t m_sequenceCounter = 0;
+	bool m_stop = false;
+	std::optional<int> m_concurrencyLimit;
+	PriorityTaskSchedulerCounters m_counters;
+
+	std::unique_ptr<TaskQueue> m_taskQueue;
+
+	// The number of runners that have been pushed onto the TaskQueue, but haven't started yet.
+	int m_numPendingRunners = 0;
+
+	// This is declared last, so that the threads are started once everything else has been
+	// initialized.
+	std::vector<std::thread> m_threads;
+};
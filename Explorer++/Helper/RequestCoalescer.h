@@ -0,0 +1,186 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct RequestCoalescerCounters
+{
+	// The number of requests that were dropped because the same key recently failed.
+	std::uint64_t numFailureHits = 0;
+
+	// The number of requests that were attached to a request for the same key that was already
+	// in flight.
+	std::uint64_t numCoalesced = 0;
+
+	// The number of requests that required a new job.
+	std::uint64_t numMisses = 0;
+};
+
+// Tracks the requests that are currently in flight, so that multiple requests for the same key
+// can share a single job, with every caller's callback being run once that job completes.
+//
+// Keys whose job failed are remembered for a short period, during which any further requests for
+// them are dropped. That prevents a failing item from being retried every time it's redrawn.
+//
+// This class isn't thread-safe. It's designed to be used from the UI thread, with jobs being
+// started and completed there.
+template <typename Key, typename Callback, typename Clock = std::chrono::steady_clock>
+class RequestCoalescer
+{
+public:
+	enum class AddResult
+	{
+		// No request for the key was in flight. The caller should start a job for it.
+		NewRequest,
+
+		// The callback was attached to the request already in flight.
+		Coalesced,
+
+		// The key failed recently. The callback has been dropped.
+		RecentlyFailed
+	};
+
+	// Once more than maxFailedKeys have failed, the oldest failures may be forgotten early.
+	RequestCoalescer(typename Clock::duration failureTimeout, std::size_t maxFailedKeys) :
+		m_failureTimeout(failureTimeout),
+		m_maxFailedKeys(maxFailedKeys)
+	{
+	}
+
+	RequestCoalescer(const RequestCoalescer &) = delete;
+	RequestCoalescer &operator=(const RequestCoalescer &) = delete;
+
+	AddResult AddRequest(const Key &key, Callback callback)
+	{
+		auto failedItr = m_failedKeys.find(key);
+
+		if (failedItr != m_failedKeys.end())
+		{
+			if (Clock::now() < failedItr->second)
+			{
+				m_counters.numFailureHits++;
+				return AddResult::RecentlyFailed;
+			}
+
+			m_failedKeys.erase(failedItr);
+		}
+
+		auto [itr, inserted] = m_inFlightRequests.try_emplace(key);
+		itr->second.push_back(std::move(callback));
+
+		if (!inserted)
+		{
+			m_counters.numCoalesced++;
+			return AddResult::Coalesced;
+		}
+
+		m_counters.numMisses++;
+		return AddResult::NewRequest;
+	}
+
+	// Removes the request for the key and returns the callbacks that were waiting on it. If the
+	// job failed, the key will be treated as having recently failed until the timeout elapses.
+	std::vector<Callback> CompleteRequest(const Key &key, bool succeeded)
+	{
+		std::vector<Callback> callbacks;
+		auto itr = m_inFlightRequests.find(key);
+
+		if (itr != m_inFlightRequests.end())
+		{
+			callbacks = std::move(itr->second);
+			m_inFlightRequests.erase(itr);
+		}
+
+		if (!succeeded)
+		{
+			AddFailedKey(key);
+		}
+
+		return callbacks;
+	}
+
+	// Removes the request for the key, without treating it as having failed, and returns the
+	// callbacks that were waiting on it. Used when the job for a request is abandoned.
+	std::vector<Callback> CancelRequest(const Key &key)
+	{
+		return CompleteRequest(key, true);
+	}
+
+	// Removes every callback that matches the predicate, regardless of which request it's waiting
+	// on. The requests themselves remain in flight, even if they're left without any callbacks.
+	template <typename Predicate>
+	void RemoveCallbacks(Predicate predicate)
+	{
+		for (auto &[key, callbacks] : m_inFlightRequests)
+		{
+			callbacks.erase(std::remove_if(callbacks.begin(), callbacks.end(), predicate),
+				callbacks.end());
+		}
+	}
+
+	bool IsInFlight(const Key &key) const
+	{
+		return m_inFlightRequests.count(key) > 0;
+	}
+
+	// Forgets about every request in flight. Recent failures are retained.
+	void Clear()
+	{
+		m_inFlightRequests.clear();
+	}
+
+	RequestCoalescerCounters GetCounters() const
+	{
+		return m_counters;
+	}
+
+private:
+	void AddFailedKey(const Key &key)
+	{
+		auto now = Clock::now();
+
+		if (m_failedKeys.size() >= m_maxFailedKeys)
+		{
+			for (auto itr = m_failedKeys.begin(); itr != m_failedKeys.end();)
+			{
+				if (now >= itr->second)
+				{
+					itr = m_failedKeys.erase(itr);
+				}
+				else
+				{
+					++itr;
+				}
+			}
+
+			// Every failure is still current. Failures are only an optimization, so it's safe to
+			// simply forget them.
+			if (m_failedKeys.size() >= m_maxFailedKeys)
+			{
+				m_failedKeys.clear();
+			}
+		}
+
+		m_failedKeys[key] = now + m_failureTimeout;
+	}
+
+	const typename Clock::duration m_failureTimeout;
+	const std::size_t m_maxFailedKeys;
+
+	std::unordered_map<Key, std::vector<Callback>> m_inFlightRequests;
+
+	// Maps each key to the time at which its failure expires.
+	std::unordered_map<Key, typename Clock::time_point> m_failedKeys;
+
+	RequestCoalescerCounters m_counters;
+};
@@ -0,0 +1,138 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <utility>
+
+// The default amount of time that can be spent processing a single batch of results. This is
+// roughly half of a frame at 60Hz, which leaves time for the window to be repainted.
+constexpr std::chrono::milliseconds RESULT_BATCH_DEFAULT_TIME_BUDGET(8);
+
+// Gathers results produced on background threads, so that they can be processed in batches on
+// the UI thread, rather than one at a time.
+//
+// The notify function is called when the first result is added to an empty batch. It would
+// typically post a message to a window, with that message then being handled by calling
+// ProcessBatch(). Any results added before the message is handled join the same batch, so a
+// single message is posted for the entire batch.
+template <typename T>
+class ResultBatcher
+{
+public:
+	explicit ResultBatcher(std::function<void()> notify) : m_notify(std::move(notify))
+	{
+	}
+
+	ResultBatcher(const ResultBatcher &) = delete;
+	ResultBatcher &operator=(const ResultBatcher &) = delete;
+
+	// Can be called from any thread.
+	void AddResult(T result)
+	{
+		bool notify = false;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_pendingResults.push_back(std::move(result));
+
+			if (!m_notificationPending)
+			{
+				m_notificationPending = true;
+				notify = true;
+			}
+		}
+
+		if (notify)
+		{
+			m_notify();
+		}
+	}
+
+	// Calls processResult for each pending result, in the order the results were added. Once
+	// timeBudget has elapsed, processing stops (though at least one result will always be
+	// processed), and the notify function will be called again, so that the remaining results can
+	// be processed in a later batch. Returns the number of results that were processed.
+	template <typename ProcessResult>
+	std::size_t ProcessBatch(ProcessResult processResult,
+		std::chrono::steady_clock::duration timeBudget = RESULT_BATCH_DEFAULT_TIME_BUDGET)
+	{
+		std::deque<T> results;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			results.swap(m_pendingResults);
+			m_notificationPending = false;
+		}
+
+		auto startTime = std::chrono::steady_clock::now();
+		std::size_t numProcessed = 0;
+
+		while (!results.empty())
+		{
+			if (numProcessed > 0 && (std::chrono::steady_clock::now() - startTime) >= timeBudget)
+			{
+				break;
+			}
+
+			processResult(results.front());
+			results.pop_front();
+			numProcessed++;
+		}
+
+		if (!results.empty())
+		{
+			ReturnUnprocessedResults(std::move(results));
+		}
+
+		return numProcessed;
+	}
+
+	// Discards any pending results.
+	void Clear()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pendingResults.clear();
+	}
+
+private:
+	void ReturnUnprocessedResults(std::deque<T> results)
+	{
+		bool notify = false;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			// The unprocessed results were added first, so they're placed ahead of any results
+			// added while this batch was being processed.
+			results.insert(results.end(), std::make_move_iterator(m_pendingResults.begin()),
+				std::make_move_iterator(m_pendingResults.end()));
+			m_pendingResults = std::move(results);
+
+			if (!m_notificationPending)
+			{
+				m_notificationPending = true;
+				notify = true;
+			}
+		}
+
+		if (notify)
+		{
+			m_notify();
+		}
+	}
+
+	const std::function<void()> m_notify;
+	std::mutex m_mutex;
+	std::deque<T> m_pendingResults;
+	bool m_notificationPending = false;
+};
@@ -379,6 +379,68 @@ int GetDefaultIcon(DefaultIconType defaultIconType)
 	return shfi.iIcon;
 }
 
+// Returns true if the icon for each file of the specified type may be different. That's the case
+// if the type has an icon handler, or if the default icon is extracted from the file itself
+// (which is indicated by a default icon of "%1").
+bool DoesFileTypeUseCustomIcons(const std::wstring &extension)
+{
+	wil::unique_hkey classKey;
+	HRESULT hr = AssocQueryKey(ASSOCF_INIT_IGNOREUNKNOWN, ASSOCKEY_CLASS, extension.c_str(),
+		nullptr, wil::out_param(classKey));
+
+	if (FAILED(hr))
+	{
+		// There's no association, so files of this type will all have the generic file icon.
+		return false;
+	}
+
+	wil::unique_hkey iconHandlerKey;
+	LONG res = RegOpenKeyEx(classKey.get(), _T("shellex\\IconHandler"), 0, KEY_READ,
+		wil::out_param(iconHandlerKey));
+
+	if (res == ERROR_SUCCESS)
+	{
+		return true;
+	}
+
+	TCHAR defaultIcon[MAX_PATH];
+	DWORD defaultIconLength = SIZEOF_ARRAY(defaultIcon);
+	hr = AssocQueryString(ASSOCF_INIT_IGNOREUNKNOWN, ASSOCSTR_DEFAULTICON, extension.c_str(),
+		nullptr, defaultIcon, &defaultIconLength);
+
+	if (hr == E_POINTER)
+	{
+		// The default icon string is unusually long. Rather than trying to interpret it, files of
+		// this type will simply have their icons retrieved individually.
+		return true;
+	}
+
+	if (FAILED(hr))
+	{
+		return false;
+	}
+
+	return StrStrI(defaultIcon, _T("%1")) != nullptr;
+}
+
+// Returns the icon shown for files of the specified type, without reference to any particular
+// file. An empty extension will result in the generic file icon.
+std::optional<int> GetFileTypeIconIndex(const std::wstring &extension)
+{
+	std::wstring fileName = L"file" + extension;
+
+	SHFILEINFO shfi;
+	DWORD_PTR res = SHGetFileInfo(fileName.c_str(), FILE_ATTRIBUTE_NORMAL, &shfi, sizeof(shfi),
+		SHGFI_SYSICONINDEX | SHGFI_USEFILEATTRIBUTES);
+
+	if (res == 0)
+	{
+		return std::nullopt;
+	}
+
+	return shfi.iIcon;
+}
+
 BOOL MyExpandEnvironmentStrings(const TCHAR *szSrc, TCHAR *szExpandedPath, DWORD nSize)
 {
 	HANDLE hProcess;
@@ -1360,6 +1422,31 @@ HRESULT CreateSimplePidl(const std::wstring &path, PIDLIST_ABSOLUTE *pidl, IShel
 	return S_OK;
 }
 
+// Builds the child pidl for a filesystem item directly from its find data. Because the find data
+// is supplied through the bind context, the item doesn't need to be queried on disk.
+HRESULT CreateChildPidlFromFindData(
+	IShellFolder *parent, const WIN32_FIND_DATA &wfd, PITEMID_CHILD *pidl)
+{
+	wil::com_ptr_nothrow<IBindCtx> bindCtx;
+	RETURN_IF_FAILED(CreateBindCtx(0, &bindCtx));
+
+	BIND_OPTS opts = { sizeof(opts), 0, STGM_CREATE, 0 };
+	RETURN_IF_FAILED(bindCtx->SetBindOptions(&opts));
+
+	auto fsBindData = FileSystemBindData::Create(&wfd);
+
+	RETURN_IF_FAILED(
+		bindCtx->RegisterObjectParam(const_cast<PWSTR>(STR_FILE_SYS_BIND_DATA), fsBindData.get()));
+
+	unique_pidl_relative pidlRelative;
+	RETURN_IF_FAILED(parent->ParseDisplayName(nullptr, bindCtx.get(),
+		const_cast<LPWSTR>(wfd.cFileName), nullptr, wil::out_param(pidlRelative), nullptr));
+
+	*pidl = ILCloneChild(ILFindLastID(pidlRelative.get()));
+
+	return *pidl ? S_OK : E_OUTOFMEMORY;
+}
+
 // This performs the same function as SHGetRealIDL, which is deprecated.
 HRESULT SimplePidlToFullPidl(PCIDLIST_ABSOLUTE simplePidl, PIDLIST_ABSOLUTE *fullPidl)
 {
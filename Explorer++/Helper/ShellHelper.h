@@ -99,6 +99,8 @@ bool IsChildOfLibrariesFolder(PCIDLIST_ABSOLUTE pidl);
 HRESULT CreateSimplePidl(
 	const std::wstring &path, PIDLIST_ABSOLUTE *pidl, IShellFolder *parent = nullptr);
 HRESULT SimplePidlToFullPidl(PCIDLIST_ABSOLUTE simplePidl, PIDLIST_ABSOLUTE *fullPidl);
+HRESULT CreateChildPidlFromFindData(
+	IShellFolder *parent, const WIN32_FIND_DATA &wfd, PITEMID_CHILD *pidl);
 std::vector<unique_pidl_absolute> DeepCopyPidls(const std::vector<PCIDLIST_ABSOLUTE> &pidls);
 std::vector<unique_pidl_absolute> DeepCopyPidls(const std::vector<unique_pidl_absolute> &pidls);
 std::vector<PCIDLIST_ABSOLUTE> ShallowCopyPidls(const std::vector<unique_pidl_absolute> &pidls);
@@ -112,6 +114,10 @@ int GetDefaultFolderIconIndex();
 int GetDefaultFileIconIndex();
 int GetDefaultIcon(DefaultIconType defaultIconType);
 
+/* File type icons. */
+bool DoesFileTypeUseCustomIcons(const std::wstring &extension);
+std::optional<int> GetFileTypeIconIndex(const std::wstring &extension);
+
 /* Infotips. */
 HRESULT GetItemInfoTip(const TCHAR *szItemPath, TCHAR *szInfoTip, size_t cchMax);
 HRESULT GetItemInfoTip(PCIDLIST_ABSOLUTE pidlComplete, TCHAR *szInfoTip, size_t cchMax);
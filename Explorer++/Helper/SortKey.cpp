@@ -0,0 +1,72 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "SortKey.h"
+#include <wil/common.h>
+
+namespace
+{
+	// Used if a linguistic key can't be generated. The string is upper-cased and stored in
+	// big-endian order, so that a byte comparison is equivalent to an ordinal, case-insensitive
+	// comparison.
+	std::string CreateOrdinalSortKey(const std::wstring &str)
+	{
+		std::wstring upperCaseStr = str;
+		CharUpperBuff(upperCaseStr.data(), static_cast<DWORD>(upperCaseStr.size()));
+
+		std::string key;
+		key.reserve(upperCaseStr.size() * 2);
+
+		for (wchar_t ch : upperCaseStr)
+		{
+			key.push_back(static_cast<char>((ch >> 8) & 0xFF));
+			key.push_back(static_cast<char>(ch & 0xFF));
+		}
+
+		return key;
+	}
+}
+
+std::string CreateSortKey(const std::wstring &str, bool naturalSort)
+{
+	DWORD flags = LCMAP_SORTKEY | NORM_IGNORECASE;
+
+	if (naturalSort)
+	{
+		WI_SetFlag(flags, SORT_DIGITSASNUMBERS);
+	}
+
+	// When LCMAP_SORTKEY is specified, the sizes passed to and returned from LCMapStringEx are in
+	// bytes. The returned size includes a terminating null byte.
+	int size = LCMapStringEx(LOCALE_NAME_USER_DEFAULT, flags, str.c_str(),
+		static_cast<int>(str.size()), nullptr, 0, nullptr, nullptr, 0);
+
+	if (size == 0)
+	{
+		return CreateOrdinalSortKey(str);
+	}
+
+	std::string key(size, '\0');
+	size = LCMapStringEx(LOCALE_NAME_USER_DEFAULT, flags, str.c_str(),
+		static_cast<int>(str.size()), reinterpret_cast<LPWSTR>(key.data()), size, nullptr,
+		nullptr, 0);
+
+	if (size == 0)
+	{
+		return CreateOrdinalSortKey(str);
+	}
+
+	key.resize(size - 1);
+
+	return key;
+}
+
+int CompareSortKeys(const std::string &key1, const std::string &key2)
+{
+	// std::char_traits<char>::compare compares characters as unsigned char values, so this is
+	// equivalent to memcmp (with the shorter key being ordered first when one key is a prefix of
+	// the other).
+	return key1.compare(key2);
+}
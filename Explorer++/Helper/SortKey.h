@@ -0,0 +1,20 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <string>
+
+// A sort key is a binary representation of a string, built so that comparing two keys byte by byte
+// gives the same ordering as comparing the original strings linguistically (ignoring case). When
+// naturalSort is set, runs of digits are ordered by their numeric value (so that "2" comes before
+// "10"), in the same way as StrCmpLogicalW. Otherwise, the ordering matches StrCmpIW.
+//
+// Building a key is comparatively expensive, but comparing keys is cheap and doesn't allocate, so
+// keys are useful when the same strings are going to be compared many times (e.g. when sorting).
+std::string CreateSortKey(const std::wstring &str, bool naturalSort);
+
+// Returns a negative value, zero or a positive value, depending on whether key1 is ordered before,
+// the same as, or after key2.
+int CompareSortKeys(const std::string &key1, const std::string &key2);
@@ -7,9 +7,6 @@
 #include "Macros.h"
 #include <codecvt>
 
-BOOL CheckWildcardMatchInternal(
-	const TCHAR *szWildcard, const TCHAR *szString, BOOL bCaseSensitive);
-
 void FormatSizeString(ULARGE_INTEGER lFileSize, TCHAR *pszFileSize, size_t cchBuf)
 {
 	FormatSizeString(lFileSize, pszFileSize, cchBuf, FALSE, SizeDisplayFormat::None);
@@ -159,142 +156,6 @@ TCHAR *PrintCommaLargeNum(LARGE_INTEGER lPrint)
 	return p;
 }
 
-BOOL CheckWildcardMatch(const TCHAR *szWildcard, const TCHAR *szString, BOOL bCaseSensitive)
-{
-	/* Handles multiple wildcard patterns. If the wildcard pattern contains ':',
-	split the pattern into multiple subpatterns.
-	For example "*.h: *.cpp" would match against "*.h" and "*.cpp" */
-	BOOL bMultiplePattern = FALSE;
-
-	for (int i = 0; i < lstrlen(szWildcard); i++)
-	{
-		if (szWildcard[i] == ':')
-		{
-			bMultiplePattern = TRUE;
-			break;
-		}
-	}
-
-	if (!bMultiplePattern)
-	{
-		return CheckWildcardMatchInternal(szWildcard, szString, bCaseSensitive);
-	}
-	else
-	{
-		TCHAR szWildcardPattern[512];
-		TCHAR *szSinglePattern = nullptr;
-		TCHAR *szSearchPattern = nullptr;
-		TCHAR *szRemainingPattern = nullptr;
-
-		StringCchCopy(szWildcardPattern, SIZEOF_ARRAY(szWildcardPattern), szWildcard);
-
-		szSinglePattern = wcstok_s(szWildcardPattern, _T(":"), &szRemainingPattern);
-		PathRemoveBlanks(szSinglePattern);
-
-		while (szSinglePattern != nullptr)
-		{
-			if (CheckWildcardMatchInternal(szSinglePattern, szString, bCaseSensitive))
-			{
-				return TRUE;
-			}
-
-			szSearchPattern = szRemainingPattern;
-			szSinglePattern = wcstok_s(szSearchPattern, _T(":"), &szRemainingPattern);
-			PathRemoveBlanks(szSinglePattern);
-		}
-	}
-
-	return FALSE;
-}
-
-BOOL CheckWildcardMatchInternal(const TCHAR *szWildcard, const TCHAR *szString, BOOL bCaseSensitive)
-{
-	BOOL bMatched;
-	BOOL bCurrentMatch = TRUE;
-
-	while (*szWildcard != '\0' && *szString != '\0' && bCurrentMatch)
-	{
-		switch (*szWildcard)
-		{
-			/* Match against the next part of the wildcard string.
-			If there is a match, then return true, else consume
-			the next character, and check again. */
-		case '*':
-			bMatched = FALSE;
-
-			if (*(szWildcard + 1) != '\0')
-			{
-				bMatched = CheckWildcardMatch(++szWildcard, szString, bCaseSensitive);
-			}
-
-			while (*szWildcard != '\0' && *szString != '\0' && !bMatched)
-			{
-				/* Consume one more character on the input string,
-				and keep (recursively) trying to match. */
-				bMatched = CheckWildcardMatch(szWildcard, ++szString, bCaseSensitive);
-			}
-
-			if (bMatched)
-			{
-				while (*szWildcard != '\0')
-				{
-					szWildcard++;
-				}
-
-				szWildcard--;
-
-				while (*szString != '\0')
-				{
-					szString++;
-				}
-			}
-
-			bCurrentMatch = bMatched;
-			break;
-
-		case '?':
-			szString++;
-			break;
-
-		default:
-			if (bCaseSensitive)
-			{
-				bCurrentMatch = (*szWildcard == *szString);
-			}
-			else
-			{
-				TCHAR szCharacter1[1];
-				LCMapString(LOCALE_USER_DEFAULT, LCMAP_LOWERCASE, szWildcard, 1, szCharacter1,
-					SIZEOF_ARRAY(szCharacter1));
-
-				TCHAR szCharacter2[1];
-				LCMapString(LOCALE_USER_DEFAULT, LCMAP_LOWERCASE, szString, 1, szCharacter2,
-					SIZEOF_ARRAY(szCharacter2));
-
-				bCurrentMatch = (szCharacter1[0] == szCharacter2[0]);
-			}
-
-			szString++;
-			break;
-		}
-
-		szWildcard++;
-	}
-
-	/* Skip past any trailing wildcards. */
-	while (*szWildcard == '*')
-	{
-		szWildcard++;
-	}
-
-	if (*szWildcard == '\0' && *szString == '\0' && bCurrentMatch)
-	{
-		return TRUE;
-	}
-
-	return FALSE;
-}
-
 void ReplaceCharacter(TCHAR *str, TCHAR ch, TCHAR chReplacement)
 {
 	int i = 0;
@@ -24,7 +24,6 @@ void FormatSizeString(ULARGE_INTEGER lFileSize, TCHAR *pszFileSize, size_t cchBu
 	SizeDisplayFormat sdf);
 TCHAR *PrintComma(unsigned long nPrint);
 TCHAR *PrintCommaLargeNum(LARGE_INTEGER lPrint);
-BOOL CheckWildcardMatch(const TCHAR *szWildcard, const TCHAR *szString, BOOL bCaseSensitive);
 void ReplaceCharacter(TCHAR *str, TCHAR ch, TCHAR chReplacement);
 void ReplaceCharacterWithString(const TCHAR *szBaseString, TCHAR *szOutput, UINT cchMax,
 	TCHAR chToReplace, const TCHAR *szReplacement);
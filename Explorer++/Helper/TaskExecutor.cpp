@@ -0,0 +1,358 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "TaskExecutor.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+
+// This is shared between the executor and each of its queues, so that a queue remains usable even
+// if the executor is destroyed first.
+struct TaskExecutorState
+{
+	std::mutex mutex;
+
+	// Signaled when a task is pushed, or when the executor is stopping.
+	std::condition_variable taskAvailable;
+
+	// Signaled when a running task finishes.
+	std::condition_variable taskFinished;
+
+	std::vector<TaskQueue *> queues;
+	std::size_t numWaitingTasks = 0;
+	std::size_t nextQueueIndex = 0;
+	std::uint64_t queueIdCounter = 0;
+	bool stop = false;
+};
+
+namespace
+{
+	// The exit handlers registered on the current worker thread.
+	thread_local std::vector<std::function<void()>> threadExitHandlers;
+
+	// The queue whose task is currently running on this thread, if any.
+	thread_local const TaskQueue *currentQueue = nullptr;
+}
+
+TaskExecutor::TaskExecutor(unsigned int numThreads, std::function<void()> threadStart,
+	std::function<void()> threadExit) :
+	m_state(std::make_shared<TaskExecutorState>())
+{
+	if (numThreads == 0)
+	{
+		numThreads = (std::max)(std::thread::hardware_concurrency(), 1U);
+	}
+
+	for (unsigned int i = 0; i < numThreads; i++)
+	{
+		m_threads.emplace_back([this, threadStart, threadExit]() {
+			if (threadStart)
+			{
+				threadStart();
+			}
+
+			RunTasks();
+
+			// As with destructors, handlers run in the reverse of the order they were added.
+			for (auto itr = threadExitHandlers.rbegin(); itr != threadExitHandlers.rend(); ++itr)
+			{
+				(*itr)();
+			}
+
+			threadExitHandlers.clear();
+
+			if (threadExit)
+			{
+				threadExit();
+			}
+		});
+	}
+}
+
+TaskExecutor::~TaskExecutor()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_state->mutex);
+		m_state->stop = true;
+	}
+
+	m_state->taskAvailable.notify_all();
+
+	for (auto &thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+std::unique_ptr<TaskQueue> TaskExecutor::CreateQueue(
+	const std::wstring &name, TaskPriorityClass priorityClass)
+{
+	std::lock_guard<std::mutex> lock(m_state->mutex);
+
+	auto queue = std::unique_ptr<TaskQueue>(
+		new TaskQueue(m_state, m_state->queueIdCounter++, name, priorityClass));
+	m_state->queues.push_back(queue.get());
+
+	return queue;
+}
+
+unsigned int TaskExecutor::GetNumThreads() const
+{
+	return static_cast<unsigned int>(m_threads.size());
+}
+
+std::vector<TaskQueueStatistics> TaskExecutor::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lock(m_state->mutex);
+
+	std::vector<TaskQueueStatistics> statistics;
+
+	for (const auto *queue : m_state->queues)
+	{
+		statistics.push_back(queue->m_statistics);
+	}
+
+	return statistics;
+}
+
+void TaskExecutor::AddThreadExitHandler(std::function<void()> handler)
+{
+	threadExitHandlers.push_back(std::move(handler));
+}
+
+void TaskExecutor::RunTasks()
+{
+	TaskExecutorState &state = *m_state;
+	std::unique_lock<std::mutex> lock(state.mutex);
+
+	// The queue this worker last ran a task from. This is stored as an ID, since the queue may be
+	// destroyed while the worker is waiting.
+	std::optional<std::uint64_t> affinityQueueId;
+
+	while (true)
+	{
+		state.taskAvailable.wait(
+			lock, [&state]() { return state.stop || state.numWaitingTasks > 0; });
+
+		if (state.stop)
+		{
+			break;
+		}
+
+		TaskQueue *queue = SelectQueue(state, affinityQueueId);
+
+		if (!queue)
+		{
+			continue;
+		}
+
+		TaskQueue::QueuedTask queuedTask = std::move(queue->m_tasks.front());
+		queue->m_tasks.pop_front();
+		state.numWaitingTasks--;
+
+		auto startTime = TaskQueue::Clock::now();
+		auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+			startTime - queuedTask.queueTime);
+
+		TaskQueueStatistics &statistics = queue->m_statistics;
+		statistics.totalLatency += latency;
+		statistics.maxLatency = (std::max)(statistics.maxLatency, latency);
+
+		if (affinityQueueId && *affinityQueueId != queue->m_id)
+		{
+			statistics.numStolen++;
+		}
+
+		queue->UpdateQueueDepth();
+		queue->m_numRunning++;
+		affinityQueueId = queue->m_id;
+
+		// The queue can't be destroyed while one of its tasks is running (see
+		// TaskQueue::Shutdown()), so it's safe to use the queue again once the task has finished.
+		lock.unlock();
+		currentQueue = queue;
+		queuedTask.task();
+		queuedTask.task = nullptr;
+		currentQueue = nullptr;
+		lock.lock();
+
+		statistics.totalRunTime += std::chrono::duration_cast<std::chrono::microseconds>(
+			TaskQueue::Clock::now() - startTime);
+		statistics.numCompleted++;
+		queue->m_numRunning--;
+
+		// Only a queue that's being shut down can have anything waiting on it.
+		if (queue->m_shutDown)
+		{
+			state.taskFinished.notify_all();
+		}
+	}
+}
+
+// Should be called with the executor lock held. Returns the queue the next task should be taken
+// from. The worker's own queue is preferred, provided there's nothing more important waiting
+// elsewhere.
+TaskQueue *TaskExecutor::SelectQueue(
+	TaskExecutorState &state, std::optional<std::uint64_t> affinityQueueId)
+{
+	bool found = false;
+	TaskPriorityClass bestPriorityClass = TaskPriorityClass::Background;
+	TaskQueue *affinityQueue = nullptr;
+
+	for (auto *queue : state.queues)
+	{
+		if (queue->m_tasks.empty())
+		{
+			continue;
+		}
+
+		TaskPriorityClass priorityClass = queue->m_statistics.priorityClass;
+
+		if (!found || priorityClass < bestPriorityClass)
+		{
+			bestPriorityClass = priorityClass;
+			found = true;
+		}
+
+		if (queue->m_id == affinityQueueId)
+		{
+			affinityQueue = queue;
+		}
+	}
+
+	if (!found)
+	{
+		return nullptr;
+	}
+
+	if (affinityQueue && affinityQueue->m_statistics.priorityClass == bestPriorityClass)
+	{
+		return affinityQueue;
+	}
+
+	std::size_t numQueues = state.queues.size();
+
+	for (std::size_t i = 0; i < numQueues; i++)
+	{
+		std::size_t index = (state.nextQueueIndex + i) % numQueues;
+		TaskQueue *queue = state.queues[index];
+
+		if (!queue->m_tasks.empty() && queue->m_statistics.priorityClass == bestPriorityClass)
+		{
+			state.nextQueueIndex = index + 1;
+			return queue;
+		}
+	}
+
+	return nullptr;
+}
+
+TaskQueue::TaskQueue(std::shared_ptr<TaskExecutorState> state, std::uint64_t id,
+	const std::wstring &name, TaskPriorityClass priorityClass) :
+	m_state(std::move(state)),
+	m_id(id)
+{
+	m_statistics.name = name;
+	m_statistics.priorityClass = priorityClass;
+}
+
+TaskQueue::~TaskQueue()
+{
+	// The worker still uses the queue once the task has returned.
+	assert(currentQueue != this);
+
+	Shutdown();
+
+	std::lock_guard<std::mutex> lock(m_state->mutex);
+	auto &queues = m_state->queues;
+	queues.erase(std::remove(queues.begin(), queues.end(), this), queues.end());
+}
+
+void TaskQueue::PushTask(Task task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_state->mutex);
+
+		if (m_shutDown)
+		{
+			return;
+		}
+
+		m_tasks.push_back({ std::move(task), Clock::now() });
+		m_state->numWaitingTasks++;
+
+		m_statistics.numQueued++;
+		UpdateQueueDepth();
+	}
+
+	m_state->taskAvailable.notify_one();
+}
+
+void TaskQueue::Clear()
+{
+	std::deque<QueuedTask> droppedTasks;
+
+	{
+		std::lock_guard<std::mutex> lock(m_state->mutex);
+		droppedTasks = TakeWaitingTasks();
+	}
+
+	// The tasks are destroyed here, once the lock has been released, since destroying a task
+	// will also destroy anything it captured.
+}
+
+void TaskQueue::Shutdown()
+{
+	std::deque<QueuedTask> droppedTasks;
+
+	{
+		std::unique_lock<std::mutex> lock(m_state->mutex);
+		m_shutDown = true;
+		droppedTasks = TakeWaitingTasks();
+
+		// When called from one of the queue's own tasks, that task can't finish until this
+		// returns, so only the other running tasks are waited for.
+		int numRunningOnThisThread = (currentQueue == this) ? 1 : 0;
+
+		m_state->taskFinished.wait(lock,
+			[this, numRunningOnThisThread]() { return m_numRunning == numRunningOnThisThread; });
+	}
+}
+
+void TaskQueue::SetPriorityClass(TaskPriorityClass priorityClass)
+{
+	std::lock_guard<std::mutex> lock(m_state->mutex);
+	m_statistics.priorityClass = priorityClass;
+}
+
+TaskPriorityClass TaskQueue::GetPriorityClass() const
+{
+	std::lock_guard<std::mutex> lock(m_state->mutex);
+	return m_statistics.priorityClass;
+}
+
+TaskQueueStatistics TaskQueue::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lock(m_state->mutex);
+	return m_statistics;
+}
+
+std::deque<TaskQueue::QueuedTask> TaskQueue::TakeWaitingTasks()
+{
+	std::deque<QueuedTask> waitingTasks;
+	waitingTasks.swap(m_tasks);
+
+	m_state->numWaitingTasks -= waitingTasks.size();
+	m_statistics.numDropped += waitingTasks.size();
+	UpdateQueueDepth();
+
+	return waitingTasks;
+}
+
+void TaskQueue::UpdateQueueDepth()
+{
+	m_statistics.queueDepth = m_tasks.size();
+	m_statistics.maxQueueDepth = (std::max)(m_statistics.maxQueueDepth, m_statistics.queueDepth);
+}
@@ -0,0 +1,178 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+struct TaskExecutorState;
+class TaskQueue;
+
+// Waiting tasks are always taken from the queues with the most important class first.
+enum class TaskPriorityClass
+{
+	// Work the UI thread is blocked on (e.g. starting the enumeration of a folder).
+	Interactive = 0,
+
+	// Work the user is currently looking at (e.g. the items shown in the selected tab).
+	Foreground = 1,
+
+	// Work that can wait (e.g. the items shown in a tab that isn't selected).
+	Background = 2
+};
+
+struct TaskQueueStatistics
+{
+	std::wstring name;
+	TaskPriorityClass priorityClass = TaskPriorityClass::Background;
+
+	// The number of tasks currently waiting to run, along with the largest number of tasks that
+	// have been waiting at any one time.
+	std::size_t queueDepth = 0;
+	std::size_t maxQueueDepth = 0;
+
+	std::uint64_t numQueued = 0;
+	std::uint64_t numCompleted = 0;
+
+	// The number of tasks that were removed before they ran.
+	std::uint64_t numDropped = 0;
+
+	// The number of tasks that were run by a worker that had previously been running tasks from a
+	// different queue.
+	std::uint64_t numStolen = 0;
+
+	// The latency of a task is the time between it being queued and it starting to run.
+	std::chrono::microseconds totalLatency = std::chrono::microseconds::zero();
+	std::chrono::microseconds maxLatency = std::chrono::microseconds::zero();
+
+	std::chrono::microseconds totalRunTime = std::chrono::microseconds::zero();
+};
+
+// Runs tasks from any number of queues on a single, shared set of worker threads. This allows
+// each component (or each tab) to have its own queue, without each queue needing its own threads.
+//
+// Each worker prefers to keep running tasks from the queue it last ran a task from. Once that queue
+// is empty, the worker will steal work from another queue. Queues are visited in a round-robin
+// fashion, so that one busy queue can't starve the others within the same priority class.
+class TaskExecutor
+{
+public:
+	// If numThreads is 0, one thread will be created per processor. threadStart and threadExit are
+	// optional and are called on each worker thread when it starts and exits (e.g. to initialize
+	// COM).
+	TaskExecutor(unsigned int numThreads, std::function<void()> threadStart = nullptr,
+		std::function<void()> threadExit = nullptr);
+
+	// Waits for any running tasks to finish. Tasks that are still waiting won't be run.
+	~TaskExecutor();
+
+	TaskExecutor(const TaskExecutor &) = delete;
+	TaskExecutor &operator=(const TaskExecutor &) = delete;
+
+	std::unique_ptr<TaskQueue> CreateQueue(
+		const std::wstring &name, TaskPriorityClass priorityClass);
+
+	unsigned int GetNumThreads() const;
+	std::vector<TaskQueueStatistics> GetStatistics() const;
+
+	// Registers a function that's called on the current worker thread when it exits, just before
+	// threadExit is called. This allows objects that a task creates once per worker and then reuses
+	// (e.g. COM objects) to be released while the thread is still initialized. Should only be
+	// called from within a task.
+	static void AddThreadExitHandler(std::function<void()> handler);
+
+private:
+	static TaskQueue *SelectQueue(
+		TaskExecutorState &state, std::optional<std::uint64_t> affinityQueueId);
+	void RunTasks();
+
+	std::shared_ptr<TaskExecutorState> m_state;
+	std::vector<std::thread> m_threads;
+};
+
+// A queue of tasks that are run by a TaskExecutor. Tasks within a single queue are started in the
+// order they were pushed, though multiple tasks from the same queue can run at the same time.
+//
+// A queue can safely outlive the executor that created it. Any tasks pushed after the executor has
+// been destroyed will simply never run.
+class TaskQueue
+{
+public:
+	using Task = std::function<void()>;
+
+	// Calls Shutdown(). The queue can't be destroyed from one of its own tasks.
+	~TaskQueue();
+
+	TaskQueue(const TaskQueue &) = delete;
+	TaskQueue &operator=(const TaskQueue &) = delete;
+
+	// Returns a future that can be used to retrieve the result of the function. If the task is
+	// dropped before it runs, the future will hold a std::future_error.
+	template <typename Function>
+	auto Push(Function &&function) -> std::future<std::invoke_result_t<std::decay_t<Function>>>
+	{
+		using Result = std::invoke_result_t<std::decay_t<Function>>;
+
+		// std::function requires a copyable target, so the packaged_task is shared.
+		auto task = std::make_shared<std::packaged_task<Result()>>(
+			std::forward<Function>(function));
+		auto future = task->get_future();
+		PushTask([task]() { (*task)(); });
+		return future;
+	}
+
+	void PushTask(Task task);
+
+	// Drops all waiting tasks. Tasks that are already running aren't affected.
+	void Clear();
+
+	// Drops all waiting tasks, then waits for any running tasks to finish. No tasks pushed after
+	// this call will be run. This allows tasks to safely reference the object that owns the queue,
+	// provided the queue is shut down (or destroyed) before the rest of the object.
+	// If called from one of the queue's own tasks, the calling task is the only one that may still
+	// be running once this returns.
+	void Shutdown();
+
+	void SetPriorityClass(TaskPriorityClass priorityClass);
+	TaskPriorityClass GetPriorityClass() const;
+
+	TaskQueueStatistics GetStatistics() const;
+
+private:
+	friend class TaskExecutor;
+
+	using Clock = std::chrono::steady_clock;
+
+	struct QueuedTask
+	{
+		Task task;
+		Clock::time_point queueTime;
+	};
+
+	TaskQueue(std::shared_ptr<TaskExecutorState> state, std::uint64_t id, const std::wstring &name,
+		TaskPriorityClass priorityClass);
+
+	// Should be called with the executor lock held.
+	std::deque<QueuedTask> TakeWaitingTasks();
+	void UpdateQueueDepth();
+
+	// All of the members below are protected by the executor lock.
+	const std::shared_ptr<TaskExecutorState> m_state;
+	const std::uint64_t m_id;
+	std::deque<QueuedTask> m_tasks;
+	int m_numRunning = 0;
+	bool m_shutDown = false;
+	TaskQueueStatistics m_statistics;
+};
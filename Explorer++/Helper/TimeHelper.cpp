@@ -44,4 +44,25 @@ void MergeDateTime(SYSTEMTIME *pstOutput, const SYSTEMTIME *pstDate, const SYSTE
 	pstOutput->wMinute = pstTime->wMinute;
 	pstOutput->wSecond = pstTime->wSecond;
 	pstOutput->wMilliseconds = pstTime->wMilliseconds;
+}
+
+FILETIME UInt64ToFileTime(ULONGLONG value)
+{
+	ULARGE_INTEGER largeInteger;
+	largeInteger.QuadPart = value;
+
+	FILETIME fileTime;
+	fileTime.dwLowDateTime = largeInteger.LowPart;
+	fileTime.dwHighDateTime = largeInteger.HighPart;
+
+	return fileTime;
+}
+
+ULONGLONG FileTimeToUInt64(const FILETIME &fileTime)
+{
+	ULARGE_INTEGER largeInteger;
+	largeInteger.LowPart = fileTime.dwLowDateTime;
+	largeInteger.HighPart = fileTime.dwHighDateTime;
+
+	return largeInteger.QuadPart;
 }
\ No newline at end of file
@@ -6,4 +6,6 @@
 
 BOOL LocalSystemTimeToFileTime(const SYSTEMTIME *lpLocalTime, FILETIME *lpFileTime);
 BOOL FileTimeToLocalSystemTime(const FILETIME *lpFileTime, SYSTEMTIME *lpLocalTime);
-void MergeDateTime(SYSTEMTIME *pstOutput, const SYSTEMTIME *pstDate, const SYSTEMTIME *pstTime);
\ No newline at end of file
+void MergeDateTime(SYSTEMTIME *pstOutput, const SYSTEMTIME *pstDate, const SYSTEMTIME *pstTime);
+FILETIME UInt64ToFileTime(ULONGLONG value);
+ULONGLONG FileTimeToUInt64(const FILETIME &fileTime);
\ No newline at end of file
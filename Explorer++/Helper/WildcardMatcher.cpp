@@ -0,0 +1,437 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "WildcardMatcher.h"
+#include <algorithm>
+
+namespace
+{
+	constexpr wchar_t PATTERN_SEPARATOR = ':';
+	constexpr std::size_t BITS_PER_WORD = 64;
+
+	// Lowercasing each code unit individually matches the way patterns have always been compared.
+	// Building the table means that LCMapString only has to be called once, rather than once per
+	// character compared.
+	std::vector<wchar_t> BuildLowercaseTable()
+	{
+		std::vector<wchar_t> table(0x10000);
+
+		for (std::size_t i = 0; i < table.size(); i++)
+		{
+			table[i] = static_cast<wchar_t>(i);
+		}
+
+		// The null character and surrogates (which can't be lowercased in isolation) are left
+		// mapped to themselves.
+		auto lowercaseRange = [&table](std::size_t first, std::size_t last)
+		{
+			int length = static_cast<int>(last - first + 1);
+			std::vector<wchar_t> output(length);
+			int res = LCMapString(LOCALE_USER_DEFAULT, LCMAP_LOWERCASE, &table[first], length,
+				output.data(), length);
+
+			if (res == length)
+			{
+				std::copy(output.begin(), output.end(), table.begin() + first);
+				return;
+			}
+
+			for (std::size_t i = first; i <= last; i++)
+			{
+				wchar_t lowercaseChar;
+				res = LCMapString(
+					LOCALE_USER_DEFAULT, LCMAP_LOWERCASE, &table[i], 1, &lowercaseChar, 1);
+
+				if (res == 1)
+				{
+					table[i] = lowercaseChar;
+				}
+			}
+		};
+
+		lowercaseRange(0x0001, 0xD7FF);
+		lowercaseRange(0xE000, 0xFFFF);
+
+		return table;
+	}
+
+	const wchar_t *GetLowercaseTable()
+	{
+		static const std::vector<wchar_t> table = BuildLowercaseTable();
+		return table.data();
+	}
+
+	// Splits a pattern that contains multiple alternatives, removing any leading and trailing
+	// spaces from each alternative.
+	std::vector<std::wstring_view> SplitMultiplePattern(std::wstring_view pattern)
+	{
+		std::vector<std::wstring_view> subpatterns;
+		std::size_t start = 0;
+
+		while (start <= pattern.size())
+		{
+			std::size_t end = pattern.find(PATTERN_SEPARATOR, start);
+
+			if (end == std::wstring_view::npos)
+			{
+				end = pattern.size();
+			}
+
+			auto subpattern = pattern.substr(start, end - start);
+			start = end + 1;
+
+			// Empty alternatives (e.g. "*.h::*.cpp") are skipped entirely, whereas an alternative
+			// made up of only spaces results in an empty pattern.
+			if (subpattern.empty())
+			{
+				continue;
+			}
+
+			std::size_t first = subpattern.find_first_not_of(' ');
+
+			if (first == std::wstring_view::npos)
+			{
+				subpatterns.push_back({});
+				continue;
+			}
+
+			std::size_t last = subpattern.find_last_not_of(' ');
+			subpatterns.push_back(subpattern.substr(first, last - first + 1));
+		}
+
+		return subpatterns;
+	}
+
+	void ShiftLeftByOne(std::vector<std::uint64_t> &words)
+	{
+		std::uint64_t carry = 0;
+
+		for (auto &word : words)
+		{
+			std::uint64_t nextCarry = word >> (BITS_PER_WORD - 1);
+			word = (word << 1) | carry;
+			carry = nextCarry;
+		}
+	}
+}
+
+WildcardMatcher::WildcardMatcher(std::wstring_view pattern, bool caseSensitive) :
+	m_pattern(pattern),
+	m_caseSensitive(caseSensitive),
+	m_lowercaseTable(caseSensitive ? nullptr : GetLowercaseTable())
+{
+	// A pattern with no separator is used exactly as given, spaces included. Spaces are only
+	// removed from the alternatives of a multiple pattern.
+	if (pattern.find(PATTERN_SEPARATOR) == std::wstring_view::npos)
+	{
+		m_compiledPatterns.push_back(Compile(pattern));
+		return;
+	}
+
+	for (auto subpattern : SplitMultiplePattern(pattern))
+	{
+		m_compiledPatterns.push_back(Compile(subpattern));
+	}
+}
+
+WildcardMatcher::CompiledPattern WildcardMatcher::Compile(std::wstring_view pattern) const
+{
+	// Consecutive stars are equivalent to a single star.
+	std::wstring normalizedPattern;
+	normalizedPattern.reserve(pattern.size());
+
+	for (wchar_t ch : pattern)
+	{
+		if (ch == '*' && !normalizedPattern.empty() && normalizedPattern.back() == '*')
+		{
+			continue;
+		}
+
+		normalizedPattern.push_back((ch == '*' || ch == '?') ? ch : FoldCase(ch));
+	}
+
+	CompiledPattern compiledPattern;
+
+	if (normalizedPattern.find('?') == std::wstring::npos)
+	{
+		auto numStars = std::count(normalizedPattern.begin(), normalizedPattern.end(), '*');
+
+		if (numStars == 0)
+		{
+			compiledPattern.type = MatchType::Exact;
+			compiledPattern.literal = normalizedPattern;
+			return compiledPattern;
+		}
+		else if (numStars == 1 && normalizedPattern.size() == 1)
+		{
+			compiledPattern.type = MatchType::All;
+			return compiledPattern;
+		}
+		else if (numStars == 1 && normalizedPattern.front() == '*')
+		{
+			compiledPattern.type = MatchType::Suffix;
+			compiledPattern.literal = normalizedPattern.substr(1);
+			return compiledPattern;
+		}
+		else if (numStars == 1 && normalizedPattern.back() == '*')
+		{
+			compiledPattern.type = MatchType::Prefix;
+			compiledPattern.literal = normalizedPattern.substr(0, normalizedPattern.size() - 1);
+			return compiledPattern;
+		}
+	}
+
+	return CompileAutomaton(normalizedPattern);
+}
+
+// The automaton has one state for each position in the pattern, plus an accepting state. State i
+// being active means that the string consumed so far matches the first i characters of the
+// pattern. Each state is represented by a single bit, which allows every state to be advanced at
+// once, using a handful of bitwise operations per character.
+WildcardMatcher::CompiledPattern WildcardMatcher::CompileAutomaton(const std::wstring &pattern)
+{
+	CompiledPattern compiledPattern;
+	compiledPattern.type = MatchType::Automaton;
+	compiledPattern.numWords = (pattern.size() + BITS_PER_WORD) / BITS_PER_WORD;
+	compiledPattern.acceptBit = pattern.size();
+	compiledPattern.starMask.resize(compiledPattern.numWords);
+	compiledPattern.anyCharMask.resize(compiledPattern.numWords);
+	compiledPattern.asciiMaskIndexes.fill(-1);
+
+	std::vector<wchar_t> otherChars;
+
+	for (std::size_t i = 0; i < pattern.size(); i++)
+	{
+		wchar_t ch = pattern[i];
+		std::uint64_t bit = std::uint64_t{ 1 } << (i % BITS_PER_WORD);
+		std::uint64_t nextBit = std::uint64_t{ 1 } << ((i + 1) % BITS_PER_WORD);
+		std::size_t nextWord = (i + 1) / BITS_PER_WORD;
+
+		if (ch == '*')
+		{
+			compiledPattern.starMask[i / BITS_PER_WORD] |= bit;
+			continue;
+		}
+		else if (ch == '?')
+		{
+			compiledPattern.anyCharMask[nextWord] |= nextBit;
+			continue;
+		}
+
+		int maskIndex;
+
+		if (ch < compiledPattern.asciiMaskIndexes.size())
+		{
+			maskIndex = compiledPattern.asciiMaskIndexes[ch];
+		}
+		else
+		{
+			auto itr = std::find(otherChars.begin(), otherChars.end(), ch);
+			maskIndex = (itr == otherChars.end())
+				? -1
+				: compiledPattern.otherMaskIndexes[itr - otherChars.begin()].second;
+		}
+
+		if (maskIndex == -1)
+		{
+			maskIndex = static_cast<int>(
+				compiledPattern.charMasks.size() / compiledPattern.numWords);
+			compiledPattern.charMasks.resize(
+				compiledPattern.charMasks.size() + compiledPattern.numWords);
+
+			if (ch < compiledPattern.asciiMaskIndexes.size())
+			{
+				compiledPattern.asciiMaskIndexes[ch] = maskIndex;
+			}
+			else
+			{
+				otherChars.push_back(ch);
+				compiledPattern.otherMaskIndexes.emplace_back(ch, maskIndex);
+			}
+		}
+
+		compiledPattern.charMasks[maskIndex * compiledPattern.numWords + nextWord] |= nextBit;
+	}
+
+	std::sort(compiledPattern.otherMaskIndexes.begin(), compiledPattern.otherMaskIndexes.end());
+
+	return compiledPattern;
+}
+
+bool WildcardMatcher::Matches(std::wstring_view str) const
+{
+	for (const auto &compiledPattern : m_compiledPatterns)
+	{
+		if (MatchesPattern(compiledPattern, str))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool WildcardMatcher::MatchesPattern(
+	const CompiledPattern &compiledPattern, std::wstring_view str) const
+{
+	auto literalMatches = [this, &compiledPattern](std::wstring_view substr)
+	{
+		return std::equal(substr.begin(), substr.end(), compiledPattern.literal.begin(),
+			compiledPattern.literal.end(),
+			[this](wchar_t ch, wchar_t patternCh) { return FoldCase(ch) == patternCh; });
+	};
+
+	switch (compiledPattern.type)
+	{
+	case MatchType::All:
+		return true;
+
+	case MatchType::Exact:
+		return literalMatches(str);
+
+	case MatchType::Prefix:
+		return str.size() >= compiledPattern.literal.size()
+			&& literalMatches(str.substr(0, compiledPattern.literal.size()));
+
+	case MatchType::Suffix:
+		return str.size() >= compiledPattern.literal.size()
+			&& literalMatches(str.substr(str.size() - compiledPattern.literal.size()));
+
+	case MatchType::Automaton:
+		if (compiledPattern.numWords == 1)
+		{
+			return MatchesAutomatonSingleWord(compiledPattern, str);
+		}
+
+		return MatchesAutomaton(compiledPattern, str);
+	}
+
+	return false;
+}
+
+// After each character, any active star state also activates the state that follows it, since
+// a star can match an empty sequence. Consecutive stars have been collapsed, so a single step is
+// always enough.
+bool WildcardMatcher::MatchesAutomatonSingleWord(
+	const CompiledPattern &compiledPattern, std::wstring_view str) const
+{
+	const std::uint64_t starMask = compiledPattern.starMask[0];
+	const std::uint64_t anyCharMask = compiledPattern.anyCharMask[0];
+
+	std::uint64_t states = 1;
+	states |= (states & starMask) << 1;
+
+	for (wchar_t ch : str)
+	{
+		std::uint64_t charMask = anyCharMask;
+		int maskIndex = GetMaskIndex(compiledPattern, FoldCase(ch));
+
+		if (maskIndex != -1)
+		{
+			charMask |= compiledPattern.charMasks[maskIndex];
+		}
+
+		states = ((states << 1) & charMask) | (states & starMask);
+		states |= (states & starMask) << 1;
+
+		if (states == 0)
+		{
+			return false;
+		}
+	}
+
+	return (states >> compiledPattern.acceptBit) & 1;
+}
+
+bool WildcardMatcher::MatchesAutomaton(
+	const CompiledPattern &compiledPattern, std::wstring_view str) const
+{
+	const std::size_t numWords = compiledPattern.numWords;
+
+	std::vector<std::uint64_t> states(numWords);
+	std::vector<std::uint64_t> starStates(numWords);
+	states[0] = 1;
+
+	auto followStars = [&]()
+	{
+		for (std::size_t i = 0; i < numWords; i++)
+		{
+			starStates[i] = states[i] & compiledPattern.starMask[i];
+		}
+
+		ShiftLeftByOne(starStates);
+
+		for (std::size_t i = 0; i < numWords; i++)
+		{
+			states[i] |= starStates[i];
+		}
+	};
+
+	followStars();
+
+	for (wchar_t ch : str)
+	{
+		int maskIndex = GetMaskIndex(compiledPattern, FoldCase(ch));
+		const std::uint64_t *charMask = (maskIndex == -1)
+			? nullptr
+			: &compiledPattern.charMasks[maskIndex * numWords];
+
+		for (std::size_t i = 0; i < numWords; i++)
+		{
+			starStates[i] = states[i] & compiledPattern.starMask[i];
+		}
+
+		ShiftLeftByOne(states);
+
+		bool anyActive = false;
+
+		for (std::size_t i = 0; i < numWords; i++)
+		{
+			std::uint64_t mask = compiledPattern.anyCharMask[i] | (charMask ? charMask[i] : 0);
+			states[i] = (states[i] & mask) | starStates[i];
+			anyActive |= (states[i] != 0);
+		}
+
+		if (!anyActive)
+		{
+			return false;
+		}
+
+		followStars();
+	}
+
+	return (states[compiledPattern.acceptBit / BITS_PER_WORD]
+			   >> (compiledPattern.acceptBit % BITS_PER_WORD))
+		& 1;
+}
+
+int WildcardMatcher::GetMaskIndex(const CompiledPattern &compiledPattern, wchar_t ch) const
+{
+	if (ch < compiledPattern.asciiMaskIndexes.size())
+	{
+		return compiledPattern.asciiMaskIndexes[ch];
+	}
+
+	auto itr = std::lower_bound(compiledPattern.otherMaskIndexes.begin(),
+		compiledPattern.otherMaskIndexes.end(), ch,
+		[](const auto &entry, wchar_t value) { return entry.first < value; });
+
+	if (itr == compiledPattern.otherMaskIndexes.end() || itr->first != ch)
+	{
+		return -1;
+	}
+
+	return itr->second;
+}
+
+const std::wstring &WildcardMatcher::GetPattern() const
+{
+	return m_pattern;
+}
+
+bool WildcardMatcher::IsCaseSensitive() const
+{
+	return m_caseSensitive;
+}
@@ -0,0 +1,96 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Matches strings against a wildcard pattern, where '*' matches any sequence of characters
+// (including an empty sequence) and '?' matches exactly one character.
+//
+// The pattern can contain multiple alternatives, separated by ':'. For example, "*.h: *.cpp" will
+// match against both "*.h" and "*.cpp". Leading and trailing spaces are removed from each
+// alternative and empty alternatives are ignored. A pattern that doesn't contain ':' is used as-is,
+// without any spaces being removed.
+//
+// The pattern is compiled once, on construction. Matching a string is then linear in the length
+// of the string, no matter how many stars the pattern contains. A pattern is always compiled to
+// one of:
+//
+// - A simple comparison, if the pattern contains no wildcards, or its only star is at the start
+//   or end (e.g. "*.txt" or "Report*").
+// - A bit-parallel automaton, with one bit per position in the pattern.
+//
+// Instances are immutable once constructed, so they can be shared between threads.
+class WildcardMatcher
+{
+public:
+	WildcardMatcher(std::wstring_view pattern, bool caseSensitive);
+
+	bool Matches(std::wstring_view str) const;
+
+	const std::wstring &GetPattern() const;
+	bool IsCaseSensitive() const;
+
+private:
+	enum class MatchType
+	{
+		All,
+		Exact,
+		Prefix,
+		Suffix,
+		Automaton
+	};
+
+	// Each character that appears literally in the pattern has its own mask, with a bit set for
+	// each position it can advance to. The masks are stored contiguously, numWords at a time.
+	struct CompiledPattern
+	{
+		MatchType type;
+
+		// For the simple match types, the literal portion of the pattern (case-folded if
+		// necessary).
+		std::wstring literal;
+
+		std::size_t numWords = 0;
+		std::size_t acceptBit = 0;
+		std::vector<std::uint64_t> starMask;
+		std::vector<std::uint64_t> anyCharMask;
+		std::vector<std::uint64_t> charMasks;
+
+		// Maps an ASCII character to the index of its mask, or -1 if it doesn't appear in the
+		// pattern.
+		std::array<int, 128> asciiMaskIndexes;
+
+		// The same, for the remaining characters, sorted by character.
+		std::vector<std::pair<wchar_t, int>> otherMaskIndexes;
+	};
+
+	CompiledPattern Compile(std::wstring_view pattern) const;
+	static CompiledPattern CompileAutomaton(const std::wstring &pattern);
+
+	bool MatchesPattern(const CompiledPattern &compiledPattern, std::wstring_view str) const;
+	bool MatchesAutomaton(const CompiledPattern &compiledPattern, std::wstring_view str) const;
+	bool MatchesAutomatonSingleWord(
+		const CompiledPattern &compiledPattern, std::wstring_view str) const;
+	int GetMaskIndex(const CompiledPattern &compiledPattern, wchar_t ch) const;
+
+	wchar_t FoldCase(wchar_t ch) const
+	{
+		return m_lowercaseTable ? m_lowercaseTable[ch] : ch;
+	}
+
+	const std::wstring m_pattern;
+	const bool m_caseSensitive;
+
+	// Only set if the match is case-insensitive. Maps each UTF-16 code unit to its lowercase
+	// equivalent.
+	const wchar_t *const m_lowercaseTable;
+
+	std::vector<CompiledPattern> m_compiledPatterns;
+};
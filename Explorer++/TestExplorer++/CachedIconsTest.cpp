@@ -85,4 +85,26 @@ TEST(CachedIconsTest, TestReplace)
 	// The replaced item should still exist.
 	itr = cachedIcons.findByPath(L"C:\\file1");
 	EXPECT_TRUE(itr != cachedIcons.end());
+}
+
+TEST(CachedIconsTest, ClassIcons)
+{
+	CachedIcons cachedIcons(1);
+
+	EXPECT_EQ(cachedIcons.findByClass(L".txt"), std::nullopt);
+
+	cachedIcons.addOrUpdateClassIcon(L".txt", 5);
+	cachedIcons.addOrUpdateClassIcon(L".log", 6);
+	EXPECT_EQ(cachedIcons.findByClass(L".txt"), 5);
+	EXPECT_EQ(cachedIcons.findByClass(L".log"), 6);
+
+	cachedIcons.addOrUpdateClassIcon(L".txt", 7);
+	EXPECT_EQ(cachedIcons.findByClass(L".txt"), 7);
+
+	// Class icons are separate from the per-file icons and aren't subject to the maximum size.
+	cachedIcons.addOrUpdateFileIcon(L"C:\\file1.txt", 1);
+	cachedIcons.addOrUpdateFileIcon(L"C:\\file2.txt", 2);
+	EXPECT_EQ(cachedIcons.findByClass(L".txt"), 7);
+	EXPECT_EQ(cachedIcons.findByClass(L".log"), 6);
+	EXPECT_TRUE(cachedIcons.findByPath(L"C:\\file1.txt") == cachedIcons.end());
 }
\ No newline at end of file
@@ -0,0 +1,78 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "../Explorer++/ColorRuleSet.h"
+#include <gtest/gtest.h>
+
+namespace
+{
+	NColorRuleHelper::ColorRule BuildColorRule(const std::wstring &pattern, BOOL caseInsensitive,
+		DWORD attributes, COLORREF color)
+	{
+		NColorRuleHelper::ColorRule colorRule;
+		colorRule.strDescription = L"Test rule";
+		colorRule.strFilterPattern = pattern;
+		colorRule.caseInsensitive = caseInsensitive;
+		colorRule.dwFilterAttributes = attributes;
+		colorRule.rgbColour = color;
+		return colorRule;
+	}
+}
+
+TEST(ColorRuleSetTest, FirstMatchingRule)
+{
+	ColorRuleSet colorRuleSet;
+	colorRuleSet.SetRules({ BuildColorRule(L"*.txt", TRUE, 0, RGB(255, 0, 0)),
+		BuildColorRule(L"", TRUE, FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_SYSTEM, RGB(0, 255, 0)),
+		BuildColorRule(L"*.TXT: *.md", FALSE, 0, RGB(0, 0, 255)),
+		BuildColorRule(L"*.log", TRUE, FILE_ATTRIBUTE_COMPRESSED, RGB(0, 0, 0)) });
+
+	EXPECT_EQ(colorRuleSet.GetMatchingRuleIndex(L"readme.TXT", FILE_ATTRIBUTE_HIDDEN), 0);
+	EXPECT_EQ(colorRuleSet.GetMatchingRuleIndex(L"readme.md", FILE_ATTRIBUTE_SYSTEM), 1);
+	EXPECT_EQ(colorRuleSet.GetMatchingRuleIndex(L"readme.md", FILE_ATTRIBUTE_ARCHIVE), 2);
+
+	// The third rule is case-sensitive.
+	EXPECT_EQ(colorRuleSet.GetMatchingRuleIndex(L"readme.MD", FILE_ATTRIBUTE_ARCHIVE),
+		std::nullopt);
+
+	// Both the filename and attributes need to match.
+	EXPECT_EQ(colorRuleSet.GetMatchingRuleIndex(L"app.log", FILE_ATTRIBUTE_COMPRESSED), 3);
+	EXPECT_EQ(colorRuleSet.GetMatchingRuleIndex(L"app.log", FILE_ATTRIBUTE_ARCHIVE), std::nullopt);
+	EXPECT_EQ(colorRuleSet.GetMatchingRuleIndex(L"app.bin", FILE_ATTRIBUTE_COMPRESSED),
+		std::nullopt);
+
+	EXPECT_EQ(colorRuleSet.GetRuleColor(1), RGB(0, 255, 0));
+	EXPECT_EQ(colorRuleSet.GetRuleColor(3), RGB(0, 0, 0));
+}
+
+TEST(ColorRuleSetTest, NoRules)
+{
+	ColorRuleSet colorRuleSet;
+	EXPECT_EQ(colorRuleSet.GetMatchingRuleIndex(L"file.txt", FILE_ATTRIBUTE_ARCHIVE),
+		std::nullopt);
+}
+
+TEST(ColorRuleSetTest, ObserversNotifiedWhenRulesChange)
+{
+	ColorRuleSet colorRuleSet;
+	int numNotifications = 0;
+
+	// Observers should be able to query the updated rules when they're notified.
+	std::optional<int> ruleIndex;
+	colorRuleSet.AddRulesChangedObserver(
+		[&]
+		{
+			numNotifications++;
+			ruleIndex = colorRuleSet.GetMatchingRuleIndex(L"file.txt", FILE_ATTRIBUTE_ARCHIVE);
+		});
+
+	colorRuleSet.SetRules({ BuildColorRule(L"*.bin", TRUE, 0, RGB(255, 0, 0)) });
+	EXPECT_EQ(numNotifications, 1);
+	EXPECT_EQ(ruleIndex, std::nullopt);
+
+	colorRuleSet.SetRules({ BuildColorRule(L"*.bin", TRUE, 0, RGB(255, 0, 0)),
+		BuildColorRule(L"*.txt", TRUE, 0, RGB(0, 255, 0)) });
+	EXPECT_EQ(numNotifications, 2);
+	EXPECT_EQ(ruleIndex, 1);
+}
@@ -0,0 +1,177 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "TemporaryDirectory.h"
+#include "../Helper/FileSystemItemSource.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <map>
+
+namespace
+{
+	const wchar_t TEMPORARY_DIRECTORY_PREFIX[] = L"FileSystemItemSourceTest";
+
+	std::vector<FileSystemItem> ReadAllItems(ItemSource &itemSource, std::size_t batchSize)
+	{
+		std::vector<FileSystemItem> items;
+
+		while (itemSource.ReadBatch(items, batchSize))
+		{
+		}
+
+		return items;
+	}
+}
+
+TEST(FileSystemItemSourceTest, ReadsAllItems)
+{
+	TemporaryDirectory directory(TEMPORARY_DIRECTORY_PREFIX);
+	directory.AddFile(L"empty.txt", 0);
+	directory.AddFile(L"small.txt", 10);
+	directory.AddFile(L"large.bin", 5000);
+	std::filesystem::create_directory(directory.GetPath() / L"subfolder");
+
+	auto itemSource = CreateFileSystemItemSource(directory.GetPath().wstring());
+	ASSERT_NE(itemSource, nullptr);
+
+	// A batch size smaller than the number of items is used, so that items have to be read across
+	// multiple calls.
+	auto items = ReadAllItems(*itemSource, 2);
+	ASSERT_EQ(items.size(), 4U);
+	EXPECT_FALSE(itemSource->GetError());
+
+	std::map<std::wstring, FileSystemItem> itemsByName;
+
+	for (const auto &item : items)
+	{
+		itemsByName.insert({ item.name, item });
+	}
+
+	ASSERT_EQ(itemsByName.size(), 4U);
+
+	EXPECT_EQ(itemsByName.at(L"empty.txt").size, 0U);
+	EXPECT_FALSE(itemsByName.at(L"empty.txt").IsDirectory());
+
+	EXPECT_EQ(itemsByName.at(L"small.txt").size, 10U);
+	EXPECT_EQ(itemsByName.at(L"large.bin").size, 5000U);
+
+	EXPECT_TRUE(itemsByName.at(L"subfolder").IsDirectory());
+
+	for (const auto &item : items)
+	{
+		EXPECT_NE(item.lastWriteTime, 0U);
+	}
+}
+
+TEST(FileSystemItemSourceTest, EmptyDirectory)
+{
+	TemporaryDirectory directory(TEMPORARY_DIRECTORY_PREFIX);
+
+	auto itemSource = CreateFileSystemItemSource(directory.GetPath().wstring());
+	ASSERT_NE(itemSource, nullptr);
+
+	auto items = ReadAllItems(*itemSource, 100);
+	EXPECT_TRUE(items.empty());
+	EXPECT_FALSE(itemSource->GetError());
+}
+
+TEST(FileSystemItemSourceTest, MissingDirectory)
+{
+	TemporaryDirectory directory(TEMPORARY_DIRECTORY_PREFIX);
+
+	auto itemSource = CreateFileSystemItemSource((directory.GetPath() / L"missing").wstring());
+	EXPECT_EQ(itemSource, nullptr);
+}
+
+#ifndef _WIN32
+
+// The POSIX implementation derives the attributes that Windows stores directly.
+TEST(FileSystemItemSourceTest, PosixAttributes)
+{
+	TemporaryDirectory directory(TEMPORARY_DIRECTORY_PREFIX);
+	directory.AddFile(L".hidden", 0);
+	directory.AddFile(L"target.txt", 20);
+	std::filesystem::create_symlink(
+		directory.GetPath() / L"target.txt", directory.GetPath() / L"link.txt");
+	std::filesystem::create_directory_symlink(
+		directory.GetPath() / L"missing", directory.GetPath() / L"brokenlink");
+
+	auto itemSource = CreateFileSystemItemSource(directory.GetPath().wstring());
+	ASSERT_NE(itemSource, nullptr);
+
+	auto items = ReadAllItems(*itemSource, 100);
+	EXPECT_FALSE(itemSource->GetError());
+
+	std::map<std::wstring, FileSystemItem> itemsByName;
+
+	for (const auto &item : items)
+	{
+		itemsByName.insert({ item.name, item });
+	}
+
+	ASSERT_EQ(itemsByName.size(), 4U);
+
+	EXPECT_NE(itemsByName.at(L".hidden").attributes & FileSystemItemAttributes::HIDDEN, 0U);
+	EXPECT_EQ(itemsByName.at(L"target.txt").attributes, FileSystemItemAttributes::NORMAL);
+
+	// The size of a link is the size of its target.
+	const auto &link = itemsByName.at(L"link.txt");
+	EXPECT_NE(link.attributes & FileSystemItemAttributes::REPARSE_POINT, 0U);
+	EXPECT_EQ(link.size, 20U);
+
+	// A link whose target doesn't exist is still returned.
+	EXPECT_NE(itemsByName.at(L"brokenlink").attributes & FileSystemItemAttributes::REPARSE_POINT,
+		0U);
+}
+
+#endif
+
+// Compares the item source with a directory_iterator loop that retrieves the size of each file
+// separately. Run with --gtest_also_run_disabled_tests.
+TEST(FileSystemItemSourceTest, DISABLED_Benchmark)
+{
+	const int NUM_FILES = 20000;
+
+	TemporaryDirectory directory(TEMPORARY_DIRECTORY_PREFIX);
+
+	for (int i = 0; i < NUM_FILES; i++)
+	{
+		directory.AddFile(L"file" + std::to_wstring(i) + L".txt", i % 100);
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	auto itemSource = CreateFileSystemItemSource(directory.GetPath().wstring());
+	ASSERT_NE(itemSource, nullptr);
+	auto items = ReadAllItems(*itemSource, 512);
+
+	auto itemSourceDuration = std::chrono::steady_clock::now() - start;
+
+	ASSERT_EQ(items.size(), static_cast<std::size_t>(NUM_FILES));
+
+	start = std::chrono::steady_clock::now();
+
+	std::size_t numItems = 0;
+	std::uintmax_t totalSize = 0;
+
+	for (const auto &entry : std::filesystem::directory_iterator(directory.GetPath()))
+	{
+		std::error_code error;
+		totalSize += std::filesystem::file_size(entry.path(), error);
+		numItems++;
+	}
+
+	auto iteratorDuration = std::chrono::steady_clock::now() - start;
+
+	ASSERT_EQ(numItems, static_cast<std::size_t>(NUM_FILES));
+
+	using std::chrono::microseconds;
+	std::cout << "Item source: "
+			  << std::chrono::duration_cast<microseconds>(itemSourceDuration).count() << "us, "
+			  << "directory_iterator + file_size: "
+			  << std::chrono::duration_cast<microseconds>(iteratorDuration).count() << "us"
+			  << std::endl;
+}
@@ -0,0 +1,200 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "../Helper/FilterExpression.h"
+#include "../Helper/TimeHelper.h"
+#include <gtest/gtest.h>
+#include <windows.h>
+
+namespace
+{
+	constexpr ULONGLONG TICKS_PER_DAY = 10000000ULL * 60 * 60 * 24;
+
+	// 2024-06-15 12:00:00 UTC.
+	constexpr ULONGLONG CURRENT_TIME = 133629264000000000ULL;
+
+	WIN32_FIND_DATA CreateFindData(const std::wstring &fileName, ULONGLONG size = 0,
+		ULONGLONG lastWriteTime = CURRENT_TIME, DWORD attributes = FILE_ATTRIBUTE_ARCHIVE)
+	{
+		WIN32_FIND_DATA findData = {};
+		fileName.copy(findData.cFileName, fileName.size());
+		findData.nFileSizeLow = static_cast<DWORD>(size & 0xFFFFFFFF);
+		findData.nFileSizeHigh = static_cast<DWORD>(size >> 32);
+		findData.ftLastWriteTime = UInt64ToFileTime(lastWriteTime);
+		findData.ftCreationTime = UInt64ToFileTime(lastWriteTime);
+		findData.ftLastAccessTime = UInt64ToFileTime(lastWriteTime);
+		findData.dwFileAttributes = attributes;
+		return findData;
+	}
+
+	bool Matches(const std::wstring &filter, const WIN32_FIND_DATA &findData,
+		bool caseSensitive = false)
+	{
+		return FilterExpression(filter, caseSensitive, CURRENT_TIME)
+			.Matches(findData.cFileName, findData);
+	}
+
+	ULONGLONG LocalDateToFileTime(WORD year, WORD month, WORD day)
+	{
+		SYSTEMTIME localTime = {};
+		localTime.wYear = year;
+		localTime.wMonth = month;
+		localTime.wDay = day;
+
+		FILETIME fileTime;
+		EXPECT_TRUE(LocalSystemTimeToFileTime(&localTime, &fileTime));
+		return FileTimeToUInt64(fileTime);
+	}
+}
+
+TEST(FilterExpressionTest, WildcardPatterns)
+{
+	// Filters that don't use any expression features should behave exactly as they always have.
+	for (const auto &filter : { L"*.txt", L"*.h: *.cpp", L"my file*", L"file (1)*", L"" })
+	{
+		EXPECT_FALSE(FilterExpression(filter, false, CURRENT_TIME).IsExpression()) << filter;
+	}
+
+	// Keywords on their own don't turn a filter into an expression; a comparison is needed.
+	for (const auto &filter : { L"Rock and Roll*", L"*.txt or *.md", L"not *.tmp" })
+	{
+		EXPECT_FALSE(FilterExpression(filter, false, CURRENT_TIME).IsExpression()) << filter;
+	}
+
+	EXPECT_TRUE(Matches(L"Rock and Roll*", CreateFindData(L"Rock and Roll Hits.mp3")));
+	EXPECT_FALSE(Matches(L"Rock and Roll*", CreateFindData(L"Rock.mp3")));
+
+	EXPECT_TRUE(Matches(L"*.txt", CreateFindData(L"readme.TXT")));
+	EXPECT_FALSE(Matches(L"*.txt", CreateFindData(L"readme.TXT"), true));
+	EXPECT_TRUE(Matches(L"*.h: *.cpp", CreateFindData(L"main.cpp")));
+	EXPECT_TRUE(Matches(L"my file*", CreateFindData(L"my file.txt")));
+	EXPECT_FALSE(Matches(L"my file*", CreateFindData(L"my.txt")));
+	EXPECT_TRUE(Matches(L"file (1)*", CreateFindData(L"file (1).txt")));
+
+	// Invalid expressions are treated as patterns as well.
+	EXPECT_FALSE(FilterExpression(L"size>lots", false, CURRENT_TIME).IsExpression());
+	EXPECT_FALSE(FilterExpression(L"(*.txt or", false, CURRENT_TIME).IsExpression());
+	EXPECT_TRUE(Matches(L"size>lots", CreateFindData(L"size>lots")));
+}
+
+TEST(FilterExpressionTest, Size)
+{
+	const ULONGLONG MB = 1024 * 1024;
+
+	EXPECT_TRUE(Matches(L"size>100MB", CreateFindData(L"large.iso", 101 * MB)));
+	EXPECT_FALSE(Matches(L"size>100MB", CreateFindData(L"small.iso", 100 * MB)));
+	EXPECT_TRUE(Matches(L"size>=100mb", CreateFindData(L"small.iso", 100 * MB)));
+	EXPECT_TRUE(Matches(L"size<1.5k", CreateFindData(L"file", 1535)));
+	EXPECT_FALSE(Matches(L"size<1.5k", CreateFindData(L"file", 1536)));
+	EXPECT_TRUE(Matches(L"size=0", CreateFindData(L"empty")));
+	EXPECT_TRUE(Matches(L"size!=0", CreateFindData(L"file", 1)));
+
+	// Sizes above 4 GB are stored across both size fields.
+	EXPECT_TRUE(Matches(L"size>4GB", CreateFindData(L"huge.vhd", 5 * 1024 * MB)));
+}
+
+TEST(FilterExpressionTest, RelativeTimes)
+{
+	auto recentFile = CreateFindData(L"recent.txt", 0, CURRENT_TIME - 2 * TICKS_PER_DAY);
+	auto oldFile = CreateFindData(L"old.txt", 0, CURRENT_TIME - 30 * TICKS_PER_DAY);
+
+	EXPECT_TRUE(Matches(L"modified<7d", recentFile));
+	EXPECT_FALSE(Matches(L"modified<7d", oldFile));
+	EXPECT_FALSE(Matches(L"modified>7d", recentFile));
+	EXPECT_TRUE(Matches(L"modified>7d", oldFile));
+	EXPECT_TRUE(Matches(L"modified:7d", recentFile));
+	EXPECT_TRUE(Matches(L"modified!=7d", oldFile));
+	EXPECT_TRUE(Matches(L"created<5w", oldFile));
+	EXPECT_FALSE(Matches(L"accessed<48h", oldFile));
+	EXPECT_TRUE(Matches(L"accessed<49h", recentFile));
+}
+
+TEST(FilterExpressionTest, Dates)
+{
+	ULONGLONG startOfDay = LocalDateToFileTime(2024, 3, 10);
+	auto file = CreateFindData(L"file.txt", 0, startOfDay + TICKS_PER_DAY / 2);
+
+	EXPECT_TRUE(Matches(L"modified=2024-03-10", file));
+	EXPECT_FALSE(Matches(L"modified!=2024-03-10", file));
+	EXPECT_FALSE(Matches(L"modified=2024-03-11", file));
+	EXPECT_TRUE(Matches(L"modified>2024-03-09", file));
+	EXPECT_FALSE(Matches(L"modified>2024-03-10", file));
+	EXPECT_TRUE(Matches(L"modified>=2024-03-10", file));
+	EXPECT_TRUE(Matches(L"modified<=2024-03-10", file));
+	EXPECT_FALSE(Matches(L"modified<2024-03-10", file));
+	EXPECT_TRUE(Matches(L"modified<2024-03-11", file));
+
+	EXPECT_FALSE(FilterExpression(L"modified>2024-02-30", false, CURRENT_TIME).IsExpression());
+}
+
+TEST(FilterExpressionTest, NameAndExtension)
+{
+	auto file = CreateFindData(L"Report.Final.DOCX");
+
+	EXPECT_TRUE(Matches(L"ext:docx", file));
+	EXPECT_FALSE(Matches(L"ext:docx", file, true));
+	EXPECT_TRUE(Matches(L"ext:doc?", file));
+	EXPECT_FALSE(Matches(L"ext:final", file));
+	EXPECT_TRUE(Matches(L"ext!=txt", file));
+	EXPECT_TRUE(Matches(L"name:report*", file));
+	EXPECT_TRUE(Matches(L"name!=*.txt", file));
+	EXPECT_TRUE(Matches(L"ext=\"\"", CreateFindData(L"Makefile")));
+
+	// The extension comes from the real filename, even if the name shown doesn't include it.
+	FilterExpression filter(L"ext:docx", false, CURRENT_TIME);
+	EXPECT_TRUE(filter.Matches(L"Report.Final", file));
+
+	EXPECT_TRUE(Matches(L"name:\"my file*\" or ext:txt", CreateFindData(L"my file.bin")));
+}
+
+TEST(FilterExpressionTest, Attributes)
+{
+	auto hiddenSystemFile = CreateFindData(
+		L"desktop.ini", 0, CURRENT_TIME, FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_SYSTEM);
+
+	EXPECT_TRUE(Matches(L"attr:h", hiddenSystemFile));
+	EXPECT_TRUE(Matches(L"attr:HS", hiddenSystemFile));
+	EXPECT_FALSE(Matches(L"attr:hr", hiddenSystemFile));
+	EXPECT_TRUE(Matches(L"attr!=r", hiddenSystemFile));
+	EXPECT_FALSE(FilterExpression(L"attr:x", false, CURRENT_TIME).IsExpression());
+}
+
+TEST(FilterExpressionTest, BooleanOperators)
+{
+	const ULONGLONG MB = 1024 * 1024;
+	const std::wstring FILTER = L"size>100MB modified<7d not *.tmp";
+
+	EXPECT_TRUE(FilterExpression(FILTER, false, CURRENT_TIME).IsExpression());
+	EXPECT_TRUE(Matches(FILTER, CreateFindData(L"video.mp4", 200 * MB)));
+	EXPECT_FALSE(Matches(FILTER, CreateFindData(L"video.tmp", 200 * MB)));
+	EXPECT_FALSE(Matches(FILTER, CreateFindData(L"video.mp4", 50 * MB)));
+	EXPECT_FALSE(Matches(
+		FILTER, CreateFindData(L"video.mp4", 200 * MB, CURRENT_TIME - 8 * TICKS_PER_DAY)));
+
+	// "and" has a higher precedence than "or".
+	EXPECT_TRUE(Matches(L"*.txt or *.md and size>1k", CreateFindData(L"a.txt")));
+	EXPECT_FALSE(Matches(L"(*.txt or *.md) and size>1k", CreateFindData(L"a.txt")));
+	EXPECT_TRUE(Matches(L"(*.txt or *.md) and size>1k", CreateFindData(L"a.md", 2048)));
+	EXPECT_TRUE(Matches(L"not not ext:txt", CreateFindData(L"a.txt")));
+	EXPECT_TRUE(Matches(L"NOT (ext:md OR ext:txt)", CreateFindData(L"a.bin")));
+
+	// A quoted keyword is treated as a pattern.
+	EXPECT_TRUE(Matches(L"\"and\" or size>1", CreateFindData(L"and")));
+}
+
+TEST(FilterExpressionTest, DeeplyNestedExpression)
+{
+	std::wstring filter;
+
+	for (int i = 0; i < 100; i++)
+	{
+		filter += L"(size>1 or ";
+	}
+
+	filter += L"*.txt";
+	filter += std::wstring(100, ')');
+
+	// There are too many nested terms to evaluate, so the filter is treated as a pattern instead.
+	EXPECT_FALSE(FilterExpression(filter, false, CURRENT_TIME).IsExpression());
+}
@@ -0,0 +1,343 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "TemporaryDirectory.h"
+#include "../Helper/FolderSize.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <thread>
+
+namespace
+{
+	// The recursive implementation that was used previously, kept for comparison in the
+	// benchmark below.
+	FolderInfo ReferenceGetFolderInfo(const std::filesystem::path &path)
+	{
+		FolderInfo folderInfo = {};
+		std::error_code error;
+
+		for (const auto &entry : std::filesystem::directory_iterator(path, error))
+		{
+			if (std::filesystem::is_directory(entry.status()))
+			{
+				folderInfo.numFolders++;
+
+				FolderInfo subFolderInfo = ReferenceGetFolderInfo(entry.path());
+
+				folderInfo.size += subFolderInfo.size;
+				folderInfo.numFolders += subFolderInfo.numFolders;
+				folderInfo.numFiles += subFolderInfo.numFiles;
+			}
+			else
+			{
+				std::error_code sizeErrorCode;
+				const auto size = std::filesystem::file_size(entry.path(), sizeErrorCode);
+
+				if (!sizeErrorCode)
+				{
+					folderInfo.size += size;
+					folderInfo.numFiles++;
+				}
+			}
+		}
+
+		return folderInfo;
+	}
+
+	void CreateFileWithSize(const std::filesystem::path &path, std::size_t size)
+	{
+		std::ofstream stream(path, std::ios::binary);
+		stream << std::string(size, 'x');
+	}
+}
+
+class FolderSizeTest : public testing::Test
+{
+protected:
+	FolderSizeTest() : m_directory(L"FolderSizeTest"), m_root(m_directory.GetPath())
+	{
+	}
+
+	// Creates the following tree, returning the expected totals for each directory:
+	//
+	// root
+	//   a.txt (100 bytes)
+	//   empty
+	//   sub1
+	//     b.txt (2000 bytes)
+	//     c.txt (0 bytes)
+	//     sub2
+	//       d.txt (30 bytes)
+	std::map<std::filesystem::path, std::tuple<std::uintmax_t, int, int>> CreateTestTree()
+	{
+		std::filesystem::create_directories(m_root / L"empty");
+		std::filesystem::create_directories(m_root / L"sub1" / L"sub2");
+
+		CreateFileWithSize(m_root / L"a.txt", 100);
+		CreateFileWithSize(m_root / L"sub1" / L"b.txt", 2000);
+		CreateFileWithSize(m_root / L"sub1" / L"c.txt", 0);
+		CreateFileWithSize(m_root / L"sub1" / L"sub2" / L"d.txt", 30);
+
+		return { { m_root, { 2130, 3, 4 } }, { m_root / L"empty", { 0, 0, 0 } },
+			{ m_root / L"sub1", { 2030, 1, 3 } }, { m_root / L"sub1" / L"sub2", { 30, 0, 1 } } };
+	}
+
+	// Creates a tree with the specified number of subdirectories at each level, each containing
+	// the specified number of files. Returns the expected totals for the root.
+	FolderInfo CreateWideTree(const std::filesystem::path &directory, int depth,
+		int numSubdirectories, int numFiles)
+	{
+		FolderInfo folderInfo = {};
+
+		for (int i = 0; i < numFiles; i++)
+		{
+			CreateFileWithSize(directory / (L"file" + std::to_wstring(i)), i);
+			folderInfo.size += i;
+			folderInfo.numFiles++;
+		}
+
+		if (depth == 0)
+		{
+			return folderInfo;
+		}
+
+		for (int i = 0; i < numSubdirectories; i++)
+		{
+			auto subdirectory = directory / (L"dir" + std::to_wstring(i));
+			std::filesystem::create_directory(subdirectory);
+
+			auto subfolderInfo =
+				CreateWideTree(subdirectory, depth - 1, numSubdirectories, numFiles);
+			folderInfo.size += subfolderInfo.size;
+			folderInfo.numFolders += subfolderInfo.numFolders + 1;
+			folderInfo.numFiles += subfolderInfo.numFiles;
+		}
+
+		return folderInfo;
+	}
+
+	TemporaryDirectory m_directory;
+	const std::filesystem::path m_root;
+};
+
+TEST_F(FolderSizeTest, EmptyFolder)
+{
+	auto folderInfo = GetFolderInfo(m_root.wstring());
+	EXPECT_EQ(folderInfo.size, 0U);
+	EXPECT_EQ(folderInfo.numFolders, 0);
+	EXPECT_EQ(folderInfo.numFiles, 0);
+}
+
+TEST_F(FolderSizeTest, MissingFolder)
+{
+	auto folderInfo = GetFolderInfo((m_root / L"missing").wstring());
+	EXPECT_EQ(folderInfo.size, 0U);
+	EXPECT_EQ(folderInfo.numFolders, 0);
+	EXPECT_EQ(folderInfo.numFiles, 0);
+}
+
+TEST_F(FolderSizeTest, FilesAndFolders)
+{
+	CreateTestTree();
+
+	for (unsigned int numThreads : { 0U, 1U, 2U, 8U })
+	{
+		FolderSizeOptions options;
+		options.numThreads = numThreads;
+
+		auto folderInfo = CalculateFolderInfo(m_root, options);
+		ASSERT_TRUE(folderInfo.has_value()) << numThreads;
+		EXPECT_EQ(folderInfo->size, 2130U) << numThreads;
+		EXPECT_EQ(folderInfo->numFolders, 3) << numThreads;
+		EXPECT_EQ(folderInfo->numFiles, 4) << numThreads;
+	}
+}
+
+TEST_F(FolderSizeTest, DirectoryResults)
+{
+	auto expectedResults = CreateTestTree();
+
+	for (unsigned int numThreads : { 1U, 4U })
+	{
+		std::map<std::filesystem::path, std::tuple<std::uintmax_t, int, int>> results;
+		std::vector<std::filesystem::path> order;
+
+		FolderSizeOptions options;
+		options.numThreads = numThreads;
+		options.directoryCallback =
+			[&](const std::filesystem::path &directory, const FolderInfo &folderInfo)
+		{
+			results[directory] = { folderInfo.size, folderInfo.numFolders, folderInfo.numFiles };
+			order.push_back(directory);
+		};
+
+		ASSERT_TRUE(CalculateFolderInfo(m_root, options).has_value());
+		EXPECT_EQ(results, expectedResults) << numThreads;
+
+		// A directory should only be reported once everything within it has been walked.
+		ASSERT_EQ(order.size(), 4U);
+		EXPECT_EQ(order.back(), m_root);
+
+		auto sub1Position = std::find(order.begin(), order.end(), m_root / L"sub1");
+		auto sub2Position = std::find(order.begin(), order.end(), m_root / L"sub1" / L"sub2");
+		EXPECT_LT(sub2Position, sub1Position);
+	}
+}
+
+TEST_F(FolderSizeTest, Progress)
+{
+	auto expectedTotals = CreateWideTree(m_root, 2, 3, 5);
+
+	for (unsigned int numThreads : { 1U, 4U })
+	{
+		std::vector<FolderInfo> progressUpdates;
+		auto callingThread = std::this_thread::get_id();
+
+		FolderSizeOptions options;
+		options.numThreads = numThreads;
+		options.progressInterval = std::chrono::milliseconds(0);
+		options.progressCallback = [&](const FolderInfo &totals)
+		{
+			EXPECT_EQ(std::this_thread::get_id(), callingThread);
+			progressUpdates.push_back(totals);
+		};
+
+		auto folderInfo = CalculateFolderInfo(m_root, options);
+		ASSERT_TRUE(folderInfo.has_value());
+		EXPECT_EQ(folderInfo->size, expectedTotals.size);
+		EXPECT_EQ(folderInfo->numFolders, expectedTotals.numFolders);
+		EXPECT_EQ(folderInfo->numFiles, expectedTotals.numFiles);
+
+		// With multiple threads, the other threads may walk the entire tree before the calling
+		// thread has a chance to report anything.
+		if (numThreads == 1)
+		{
+			EXPECT_FALSE(progressUpdates.empty());
+		}
+
+		for (std::size_t i = 1; i < progressUpdates.size(); i++)
+		{
+			EXPECT_GE(progressUpdates[i].size, progressUpdates[i - 1].size);
+			EXPECT_GE(progressUpdates[i].numFiles, progressUpdates[i - 1].numFiles);
+		}
+
+		for (const auto &progressUpdate : progressUpdates)
+		{
+			EXPECT_LE(progressUpdate.size, expectedTotals.size);
+			EXPECT_LE(progressUpdate.numFiles, expectedTotals.numFiles);
+		}
+	}
+}
+
+TEST_F(FolderSizeTest, Cancellation)
+{
+	CreateWideTree(m_root, 2, 4, 4);
+
+	std::atomic<bool> cancelled = true;
+	bool directoryReported = false;
+
+	FolderSizeOptions options;
+	options.numThreads = 4;
+	options.cancelled = &cancelled;
+	options.directoryCallback = [&](const std::filesystem::path &, const FolderInfo &)
+	{
+		directoryReported = true;
+	};
+
+	EXPECT_FALSE(CalculateFolderInfo(m_root, options).has_value());
+	EXPECT_FALSE(directoryReported);
+
+	// Cancelling partway through.
+	cancelled = false;
+	int numDirectoriesReported = 0;
+	options.directoryCallback = [&](const std::filesystem::path &, const FolderInfo &)
+	{
+		if (++numDirectoriesReported == 3)
+		{
+			cancelled = true;
+		}
+	};
+
+	EXPECT_FALSE(CalculateFolderInfo(m_root, options).has_value());
+	EXPECT_EQ(numDirectoriesReported, 3);
+}
+
+TEST_F(FolderSizeTest, DeepTree)
+{
+	// Kept short enough to remain within MAX_PATH.
+	const int DEPTH = 60;
+	auto directory = m_root;
+
+	for (int i = 0; i < DEPTH; i++)
+	{
+		directory /= L"d";
+	}
+
+	std::filesystem::create_directories(directory);
+	CreateFileWithSize(directory / L"f", 10);
+
+	for (unsigned int numThreads : { 1U, 4U })
+	{
+		FolderSizeOptions options;
+		options.numThreads = numThreads;
+
+		auto folderInfo = CalculateFolderInfo(m_root, options);
+		ASSERT_TRUE(folderInfo.has_value());
+		EXPECT_EQ(folderInfo->size, 10U);
+		EXPECT_EQ(folderInfo->numFolders, DEPTH);
+		EXPECT_EQ(folderInfo->numFiles, 1);
+	}
+}
+
+TEST_F(FolderSizeTest, DirectoryLinksNotFollowed)
+{
+	CreateTestTree();
+
+	// Creating a symbolic link may require additional privileges on Windows.
+	std::error_code error;
+	std::filesystem::create_directory_symlink(m_root, m_root / L"sub1" / L"loop", error);
+
+	if (error)
+	{
+		GTEST_SKIP() << "Symbolic links can't be created";
+	}
+
+	auto folderInfo = GetFolderInfo(m_root.wstring());
+	EXPECT_EQ(folderInfo.size, 2130U);
+	EXPECT_EQ(folderInfo.numFolders, 4);
+	EXPECT_EQ(folderInfo.numFiles, 4);
+}
+
+TEST_F(FolderSizeTest, DISABLED_Benchmark)
+{
+	auto expectedTotals = CreateWideTree(m_root, 3, 8, 40);
+
+	auto measure = [](auto &&calculate)
+	{
+		auto start = std::chrono::steady_clock::now();
+		FolderInfo folderInfo = calculate();
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		return std::make_pair(folderInfo,
+			std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+	};
+
+	auto [referenceInfo, referenceMs] = measure([this] { return ReferenceGetFolderInfo(m_root); });
+	EXPECT_EQ(referenceInfo.size, expectedTotals.size);
+	std::cout << "Recursive: " << referenceMs << " ms" << std::endl;
+
+	for (unsigned int numThreads : { 1U, 2U, 4U, 8U })
+	{
+		FolderSizeOptions options;
+		options.numThreads = numThreads;
+
+		auto [folderInfo, elapsedMs] =
+			measure([this, &options] { return *CalculateFolderInfo(m_root, options); });
+		EXPECT_EQ(folderInfo.size, expectedTotals.size);
+		EXPECT_EQ(folderInfo.numFiles, expectedTotals.numFiles);
+		std::cout << numThreads << " thread(s): " << elapsedMs << " ms" << std::endl;
+	}
+}
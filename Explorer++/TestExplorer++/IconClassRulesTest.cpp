@@ -0,0 +1,98 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "../Helper/IconClassRules.h"
+#include <gtest/gtest.h>
+
+TEST(IconClassRulesTest, ClassIsLowercaseExtension)
+{
+	IconClassRules rules;
+
+	EXPECT_EQ(rules.GetIconClass(L"C:\\Logs\\app.log", false), L".log");
+	EXPECT_EQ(rules.GetIconClass(L"C:\\Logs\\APP.LOG", false), L".log");
+	EXPECT_EQ(rules.GetIconClass(L"C:\\archive.tar.gz", false), L".gz");
+	EXPECT_EQ(rules.GetIconClass(L"C:\\folder.name\\file", false), L"");
+	EXPECT_EQ(rules.GetIconClass(L"C:\\.gitignore", false), L".gitignore");
+}
+
+TEST(IconClassRulesTest, FoldersHaveNoClass)
+{
+	IconClassRules rules;
+
+	EXPECT_EQ(rules.GetIconClass(L"C:\\Folder", true), std::nullopt);
+	EXPECT_EQ(rules.GetIconClass(L"C:\\Folder.txt", true), std::nullopt);
+}
+
+TEST(IconClassRulesTest, DefaultPerFileExtensions)
+{
+	IconClassRules rules;
+
+	EXPECT_EQ(rules.GetIconClass(L"C:\\app.exe", false), std::nullopt);
+	EXPECT_EQ(rules.GetIconClass(L"C:\\APP.EXE", false), std::nullopt);
+	EXPECT_EQ(rules.GetIconClass(L"C:\\image.ico", false), std::nullopt);
+	EXPECT_EQ(rules.GetIconClass(L"C:\\shortcut.lnk", false), std::nullopt);
+	EXPECT_EQ(rules.GetIconClass(L"C:\\site.url", false), std::nullopt);
+}
+
+TEST(IconClassRulesTest, SetPerFileExtensions)
+{
+	IconClassRules rules;
+	rules.SetPerFileExtensions(IconClassRules::ParseExtensionList(L"doc;.XLS"));
+
+	EXPECT_EQ(rules.GetIconClass(L"C:\\document.doc", false), std::nullopt);
+	EXPECT_EQ(rules.GetIconClass(L"C:\\sheet.xls", false), std::nullopt);
+	EXPECT_EQ(rules.GetIconClass(L"C:\\app.exe", false), L".exe");
+
+	std::vector<std::wstring> expectedExtensions = { L".doc", L".xls" };
+	EXPECT_EQ(rules.GetPerFileExtensions(), expectedExtensions);
+}
+
+TEST(IconClassRulesTest, Disabled)
+{
+	IconClassRules rules;
+	rules.SetEnabled(false);
+
+	EXPECT_FALSE(rules.IsEnabled());
+	EXPECT_EQ(rules.GetIconClass(L"C:\\file.txt", false), std::nullopt);
+
+	rules.SetEnabled(true);
+
+	EXPECT_EQ(rules.GetIconClass(L"C:\\file.txt", false), L".txt");
+}
+
+TEST(IconClassRulesTest, CustomIconCheck)
+{
+	int numChecks = 0;
+
+	IconClassRules rules([&numChecks](const std::wstring &extension) {
+		numChecks++;
+		return extension == L".dll";
+	});
+
+	EXPECT_EQ(rules.GetIconClass(L"C:\\library.dll", false), std::nullopt);
+	EXPECT_EQ(rules.GetIconClass(L"C:\\file.txt", false), L".txt");
+	EXPECT_EQ(numChecks, 2);
+
+	// The result for each extension should be cached.
+	EXPECT_EQ(rules.GetIconClass(L"C:\\other.DLL", false), std::nullopt);
+	EXPECT_EQ(rules.GetIconClass(L"C:\\other.txt", false), L".txt");
+	EXPECT_EQ(numChecks, 2);
+
+	// The check doesn't apply to files without an extension, or to per-file extensions.
+	EXPECT_EQ(rules.GetIconClass(L"C:\\file", false), L"");
+	EXPECT_EQ(rules.GetIconClass(L"C:\\app.exe", false), std::nullopt);
+	EXPECT_EQ(numChecks, 2);
+}
+
+TEST(IconClassRulesTest, ParseExtensionList)
+{
+	std::vector<std::wstring> expectedExtensions = { L".exe", L".ico", L".lnk", L".url" };
+	EXPECT_EQ(IconClassRules::ParseExtensionList(IconClassRules::DEFAULT_PER_FILE_EXTENSIONS),
+		expectedExtensions);
+
+	expectedExtensions = { L".exe", L".txt", L".log" };
+	EXPECT_EQ(IconClassRules::ParseExtensionList(L" EXE ;;.txt; . ;log;"), expectedExtensions);
+
+	EXPECT_TRUE(IconClassRules::ParseExtensionList(L"").empty());
+}
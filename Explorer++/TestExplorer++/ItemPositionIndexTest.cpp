@@ -0,0 +1,117 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "../Helper/ItemPositionIndex.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+
+namespace
+{
+	void ExpectPositions(const ItemPositionIndex &index, const std::vector<int> &items)
+	{
+		ASSERT_EQ(index.GetSize(), items.size());
+
+		for (size_t i = 0; i < items.size(); i++)
+		{
+			EXPECT_EQ(index.GetPosition(items[i]), static_cast<int>(i));
+		}
+	}
+}
+
+TEST(ItemPositionIndexTest, Assign)
+{
+	ItemPositionIndex index;
+	std::vector<int> items = { 7, 3, 12, 0, 5 };
+	index.Assign(items);
+	ExpectPositions(index, items);
+
+	EXPECT_EQ(index.GetPosition(1), std::nullopt);
+
+	// Assigning again should replace the existing items.
+	std::vector<int> updatedItems = { 4, 9 };
+	index.Assign(updatedItems);
+	ExpectPositions(index, updatedItems);
+	EXPECT_EQ(index.GetPosition(7), std::nullopt);
+}
+
+TEST(ItemPositionIndexTest, Insert)
+{
+	ItemPositionIndex index;
+	index.Insert(0, 10);
+	index.Insert(1, 20);
+	index.Insert(0, 30);
+	index.Insert(1, 40);
+
+	// Positions past the end should result in the item being appended.
+	index.Insert(100, 50);
+
+	ExpectPositions(index, { 30, 40, 10, 20, 50 });
+}
+
+TEST(ItemPositionIndexTest, InsertExistingItem)
+{
+	ItemPositionIndex index;
+	index.Assign({ 1, 2, 3, 4 });
+
+	index.Insert(0, 3);
+	ExpectPositions(index, { 3, 1, 2, 4 });
+}
+
+TEST(ItemPositionIndexTest, Remove)
+{
+	ItemPositionIndex index;
+	index.Assign({ 1, 2, 3, 4, 5 });
+
+	index.Remove(3);
+	ExpectPositions(index, { 1, 2, 4, 5 });
+
+	index.Remove(1);
+	ExpectPositions(index, { 2, 4, 5 });
+
+	// Removing an item that isn't present should have no effect.
+	index.Remove(100);
+	ExpectPositions(index, { 2, 4, 5 });
+
+	index.Clear();
+	EXPECT_EQ(index.GetSize(), 0U);
+	EXPECT_EQ(index.GetPosition(2), std::nullopt);
+}
+
+TEST(ItemPositionIndexTest, MatchesVector)
+{
+	std::mt19937 generator(1);
+	std::vector<int> items;
+
+	for (int i = 0; i < 1000; i++)
+	{
+		items.push_back(i);
+	}
+
+	std::shuffle(items.begin(), items.end(), generator);
+
+	ItemPositionIndex index;
+	index.Assign(items);
+
+	int nextItem = static_cast<int>(items.size());
+
+	for (int i = 0; i < 2000; i++)
+	{
+		if (!items.empty() && generator() % 2 == 0)
+		{
+			auto itr = items.begin() + generator() % items.size();
+			index.Remove(*itr);
+			items.erase(itr);
+		}
+		else
+		{
+			auto position = static_cast<int>(generator() % (items.size() + 1));
+			index.Insert(position, nextItem);
+			items.insert(items.begin() + position, nextItem);
+			nextItem++;
+		}
+	}
+
+	ExpectPositions(index, items);
+}
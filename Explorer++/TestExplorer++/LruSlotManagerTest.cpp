@@ -0,0 +1,148 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "../Helper/LruSlotManager.h"
+#include <gtest/gtest.h>
+
+namespace
+{
+	bool EvictAny(int)
+	{
+		return true;
+	}
+
+	bool EvictNone(int)
+	{
+		return false;
+	}
+}
+
+TEST(LruSlotManagerTest, SlotsAreCreatedContiguously)
+{
+	LruSlotManager slotManager(3);
+
+	EXPECT_EQ(slotManager.Acquire(10, EvictAny).slot, 0);
+	EXPECT_EQ(slotManager.Acquire(20, EvictAny).slot, 1);
+	EXPECT_EQ(slotManager.Acquire(30, EvictAny).slot, 2);
+
+	auto counters = slotManager.GetCounters();
+	EXPECT_EQ(counters.numSlots, 3U);
+	EXPECT_EQ(counters.numAssigned, 3U);
+	EXPECT_EQ(counters.numEvictions, 0U);
+}
+
+TEST(LruSlotManagerTest, ExistingSlotIsReturned)
+{
+	LruSlotManager slotManager(2);
+
+	slotManager.Acquire(10, EvictAny);
+	slotManager.Acquire(20, EvictAny);
+
+	auto allocation = slotManager.Acquire(10, EvictAny);
+	EXPECT_EQ(allocation.slot, 0);
+	EXPECT_FALSE(allocation.evictedKey);
+
+	EXPECT_EQ(slotManager.Find(20), 1);
+	EXPECT_EQ(slotManager.Find(30), std::nullopt);
+}
+
+TEST(LruSlotManagerTest, LeastRecentlyUsedKeyIsEvicted)
+{
+	LruSlotManager slotManager(3);
+
+	slotManager.Acquire(10, EvictAny);
+	slotManager.Acquire(20, EvictAny);
+	slotManager.Acquire(30, EvictAny);
+
+	// 20 is now the least recently used key.
+	slotManager.Touch(10);
+
+	auto allocation = slotManager.Acquire(40, EvictAny);
+	EXPECT_EQ(allocation.slot, 1);
+	EXPECT_EQ(allocation.evictedKey, 20);
+	EXPECT_EQ(slotManager.Find(20), std::nullopt);
+	EXPECT_EQ(slotManager.Find(40), 1);
+
+	allocation = slotManager.Acquire(50, EvictAny);
+	EXPECT_EQ(allocation.slot, 2);
+	EXPECT_EQ(allocation.evictedKey, 30);
+
+	auto counters = slotManager.GetCounters();
+	EXPECT_EQ(counters.numSlots, 3U);
+	EXPECT_EQ(counters.numEvictions, 2U);
+}
+
+TEST(LruSlotManagerTest, KeysCanBeProtectedFromEviction)
+{
+	LruSlotManager slotManager(3);
+
+	slotManager.Acquire(10, EvictAny);
+	slotManager.Acquire(20, EvictAny);
+	slotManager.Acquire(30, EvictAny);
+
+	// Keys below 25 might be visible, for example.
+	auto allocation = slotManager.Acquire(40, [](int key) { return key > 25; });
+	EXPECT_EQ(allocation.slot, 2);
+	EXPECT_EQ(allocation.evictedKey, 30);
+	EXPECT_EQ(slotManager.Find(10), 0);
+	EXPECT_EQ(slotManager.Find(20), 1);
+}
+
+TEST(LruSlotManagerTest, CapacityIsExceededWhenNothingCanBeEvicted)
+{
+	LruSlotManager slotManager(2);
+
+	slotManager.Acquire(10, EvictNone);
+	slotManager.Acquire(20, EvictNone);
+
+	auto allocation = slotManager.Acquire(30, EvictNone);
+	EXPECT_EQ(allocation.slot, 2);
+	EXPECT_FALSE(allocation.evictedKey);
+
+	auto counters = slotManager.GetCounters();
+	EXPECT_EQ(counters.numSlots, 3U);
+	EXPECT_EQ(counters.numOverCapacity, 1U);
+}
+
+TEST(LruSlotManagerTest, ReleasedSlotsAreReused)
+{
+	LruSlotManager slotManager(0);
+
+	slotManager.Acquire(10, EvictAny);
+	slotManager.Acquire(20, EvictAny);
+	slotManager.Release(10);
+
+	EXPECT_EQ(slotManager.Find(10), std::nullopt);
+	EXPECT_EQ(slotManager.GetCounters().numAssigned, 1U);
+
+	auto allocation = slotManager.Acquire(30, EvictAny);
+	EXPECT_EQ(allocation.slot, 0);
+	EXPECT_FALSE(allocation.evictedKey);
+	EXPECT_EQ(slotManager.GetCounters().numSlots, 2U);
+}
+
+TEST(LruSlotManagerTest, NoLimit)
+{
+	LruSlotManager slotManager(0);
+
+	for (int i = 0; i < 1000; i++)
+	{
+		EXPECT_EQ(slotManager.Acquire(i, EvictAny).slot, i);
+	}
+
+	EXPECT_EQ(slotManager.GetCounters().numEvictions, 0U);
+}
+
+TEST(LruSlotManagerTest, Clear)
+{
+	LruSlotManager slotManager(2);
+
+	slotManager.Acquire(10, EvictAny);
+	slotManager.Acquire(20, EvictAny);
+	slotManager.Clear();
+
+	EXPECT_EQ(slotManager.Find(10), std::nullopt);
+	EXPECT_EQ(slotManager.Acquire(30, EvictAny).slot, 0);
+	EXPECT_EQ(slotManager.GetCounters().numSlots, 1U);
+}
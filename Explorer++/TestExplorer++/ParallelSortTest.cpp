@@ -0,0 +1,90 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "../Helper/ParallelSort.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <utility>
+
+namespace
+{
+	// Each item is a key and the original position of the item, so that the stability of the
+	// sort can be checked.
+	std::vector<std::pair<int, int>> BuildItems(int numItems, int maxKey)
+	{
+		std::mt19937 generator(numItems);
+		std::uniform_int_distribution<int> distribution(0, maxKey);
+
+		std::vector<std::pair<int, int>> items;
+
+		for (int i = 0; i < numItems; i++)
+		{
+			items.emplace_back(distribution(generator), i);
+		}
+
+		return items;
+	}
+
+	bool CompareKeys(const std::pair<int, int> &item1, const std::pair<int, int> &item2)
+	{
+		return item1.first < item2.first;
+	}
+
+	void CheckSort(int numItems, int maxKey, unsigned int numThreads)
+	{
+		auto items = BuildItems(numItems, maxKey);
+
+		auto expected = items;
+		std::stable_sort(expected.begin(), expected.end(), CompareKeys);
+
+		std::atomic<bool> cancelled = false;
+		bool res =
+			ParallelMergeSort(items.begin(), items.end(), CompareKeys, cancelled, numThreads);
+
+		EXPECT_TRUE(res);
+		EXPECT_EQ(items, expected);
+	}
+}
+
+TEST(ParallelMergeSortTest, Empty)
+{
+	CheckSort(0, 10, 4);
+}
+
+TEST(ParallelMergeSortTest, SmallRange)
+{
+	CheckSort(100, 10, 4);
+}
+
+TEST(ParallelMergeSortTest, LargeRange)
+{
+	CheckSort(100000, 1000000, 4);
+}
+
+TEST(ParallelMergeSortTest, OddNumberOfThreads)
+{
+	CheckSort(100000, 1000000, 3);
+	CheckSort(100000, 1000000, 7);
+}
+
+TEST(ParallelMergeSortTest, Stable)
+{
+	// A small key range results in many items with the same key.
+	CheckSort(100000, 10, 4);
+}
+
+TEST(ParallelMergeSortTest, SingleThread)
+{
+	CheckSort(100000, 1000000, 1);
+}
+
+TEST(ParallelMergeSortTest, Cancelled)
+{
+	auto items = BuildItems(100000, 1000000);
+
+	std::atomic<bool> cancelled = true;
+	bool res = ParallelMergeSort(items.begin(), items.end(), CompareKeys, cancelled, 4);
+
+	EXPECT_FALSE(res);
+}
@@ -0,0 +1,132 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "../Helper/PersistentItemCacheFormat.h"
+#include <gtest/gtest.h>
+
+using namespace PersistentItemCacheFormat;
+
+namespace
+{
+	Record CreateRecord(const std::wstring &path, std::uint64_t size, std::uint64_t lastWriteTime,
+		const Fields &fields)
+	{
+		Record record;
+		record.key = { path, size, lastWriteTime };
+		record.fields = fields;
+		return record;
+	}
+
+	std::vector<std::uint8_t> BuildFileData(const std::vector<Record> &records)
+	{
+		std::vector<std::uint8_t> data;
+		WriteHeader(data);
+
+		for (const auto &record : records)
+		{
+			WriteRecord(data, record);
+		}
+
+		return data;
+	}
+}
+
+TEST(PersistentItemCacheFormatTest, RoundTrip)
+{
+	std::vector<Record> records = {
+		CreateRecord(L"C:\\Projects\\readme.txt", 1024, 132000000000000000,
+			{ { 1, L"Text Document" }, { 0x100 + 26, L"" } }),
+		CreateRecord(L"C:\\Projects\\app.exe", 0, 0, {}),
+		CreateRecord(L"C:\\Projects\\\x00e9t\x00e9.mp3", 5000000, 1,
+			{ { 2, L"Artist" }, { 7, L"Album" }, { 9, L"2010" } })
+	};
+
+	auto data = BuildFileData(records);
+	auto scanResult = Scan(data.data(), data.size());
+
+	EXPECT_TRUE(scanResult.validHeader);
+	EXPECT_EQ(scanResult.validLength, data.size());
+	ASSERT_EQ(scanResult.records.size(), records.size());
+
+	for (std::size_t i = 0; i < records.size(); i++)
+	{
+		const auto &location = scanResult.records[i];
+		EXPECT_EQ(location.key, records[i].key);
+		EXPECT_EQ(ReadFields(data.data(), location.offset), records[i].fields);
+
+		for (const auto &[fieldId, value] : records[i].fields)
+		{
+			EXPECT_EQ(ReadField(data.data(), location.offset, fieldId), value);
+		}
+
+		EXPECT_EQ(ReadField(data.data(), location.offset, 1000), std::nullopt);
+	}
+}
+
+TEST(PersistentItemCacheFormatTest, EmptyAndInvalidHeader)
+{
+	auto scanResult = Scan(nullptr, 0);
+	EXPECT_FALSE(scanResult.validHeader);
+
+	auto data = BuildFileData({});
+	scanResult = Scan(data.data(), data.size());
+	EXPECT_TRUE(scanResult.validHeader);
+	EXPECT_EQ(scanResult.validLength, HEADER_SIZE);
+	EXPECT_TRUE(scanResult.records.empty());
+
+	data[0] ^= 0xFF;
+	scanResult = Scan(data.data(), data.size());
+	EXPECT_FALSE(scanResult.validHeader);
+}
+
+TEST(PersistentItemCacheFormatTest, TruncatedRecord)
+{
+	auto data = BuildFileData({ CreateRecord(L"C:\\file1", 1, 2, { { 1, L"value1" } }),
+		CreateRecord(L"C:\\file2", 3, 4, { { 1, L"value2" } }) });
+	std::size_t fullSize = data.size();
+
+	auto scanResult = Scan(data.data(), data.size());
+	ASSERT_EQ(scanResult.records.size(), 2U);
+	std::size_t secondRecordOffset = scanResult.records[1].offset;
+
+	// Every possible partial write of the second record should leave the first record intact.
+	for (std::size_t size = secondRecordOffset; size < fullSize; size++)
+	{
+		scanResult = Scan(data.data(), size);
+		ASSERT_EQ(scanResult.records.size(), 1U);
+		EXPECT_EQ(scanResult.records[0].key.path, L"C:\\file1");
+		EXPECT_EQ(scanResult.validLength, secondRecordOffset);
+	}
+}
+
+TEST(PersistentItemCacheFormatTest, CorruptRecord)
+{
+	auto data = BuildFileData({ CreateRecord(L"C:\\file1", 1, 2, { { 1, L"value1" } }),
+		CreateRecord(L"C:\\file2", 3, 4, { { 1, L"value2" } }),
+		CreateRecord(L"C:\\file3", 5, 6, { { 1, L"value3" } }) });
+
+	auto scanResult = Scan(data.data(), data.size());
+	ASSERT_EQ(scanResult.records.size(), 3U);
+	std::size_t secondRecordOffset = scanResult.records[1].offset;
+
+	// Flip a bit in the value stored in the second record. That record, and everything after it,
+	// should be discarded.
+	data[scanResult.records[2].offset - 2] ^= 0x01;
+
+	scanResult = Scan(data.data(), data.size());
+	ASSERT_EQ(scanResult.records.size(), 1U);
+	EXPECT_EQ(scanResult.validLength, secondRecordOffset);
+}
+
+TEST(PersistentItemCacheFormatTest, LaterRecordsAreReturnedInOrder)
+{
+	auto data = BuildFileData({ CreateRecord(L"C:\\file", 1, 1, { { 1, L"old" } }),
+		CreateRecord(L"C:\\file", 2, 2, { { 1, L"new" } }) });
+
+	auto scanResult = Scan(data.data(), data.size());
+	ASSERT_EQ(scanResult.records.size(), 2U);
+	EXPECT_EQ(ReadField(data.data(), scanResult.records[0].offset, 1), L"old");
+	EXPECT_EQ(ReadField(data.data(), scanResult.records[1].offset, 1), L"new");
+	EXPECT_LT(scanResult.records[0].offset, scanResult.records[1].offset);
+}
@@ -0,0 +1,214 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "TemporaryDirectory.h"
+#include "../Helper/PersistentItemCache.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+class PersistentItemCacheTest : public testing::Test
+{
+protected:
+	PersistentItemCacheTest() :
+		m_directory(L"PersistentItemCacheTest"),
+		m_filePath(m_directory.GetPath() / L"items.cache")
+	{
+	}
+
+	std::unique_ptr<PersistentItemCache> CreateCache(std::uint64_t maxFileSize = 1024 * 1024)
+	{
+		return std::make_unique<PersistentItemCache>(m_filePath.wstring(), maxFileSize);
+	}
+
+	// The existing cache has to be destroyed first, since only one instance can have the file
+	// open at a time.
+	void ReopenCache(
+		std::unique_ptr<PersistentItemCache> &cache, std::uint64_t maxFileSize = 1024 * 1024)
+	{
+		cache.reset();
+		cache = CreateCache(maxFileSize);
+	}
+
+	static PersistentItemCache::ItemKey CreateKey(int index, std::uint64_t lastWriteTime = 1)
+	{
+		return { L"C:\\Projects\\file" + std::to_wstring(index) + L".txt", 100, lastWriteTime };
+	}
+
+	const TemporaryDirectory m_directory;
+	const std::filesystem::path m_filePath;
+};
+
+TEST_F(PersistentItemCacheTest, ValuesPersistBetweenSessions)
+{
+	auto cache = CreateCache();
+	EXPECT_EQ(cache->GetValue(CreateKey(1), 1), std::nullopt);
+
+	cache->SetValue(CreateKey(1), 1, L"Text Document");
+	cache->SetValue(CreateKey(1), 2, L"1.0");
+	cache->SetValue(CreateKey(2), 1, L"Text Document");
+	EXPECT_EQ(cache->GetValue(CreateKey(1), 1), L"Text Document");
+
+	// The values should be written when the cache is destroyed.
+	ReopenCache(cache);
+	EXPECT_EQ(cache->GetValue(CreateKey(1), 1), L"Text Document");
+	EXPECT_EQ(cache->GetValue(CreateKey(1), 2), L"1.0");
+	EXPECT_EQ(cache->GetValue(CreateKey(2), 1), L"Text Document");
+	EXPECT_EQ(cache->GetValue(CreateKey(2), 2), std::nullopt);
+
+	// Adding a value to an item that was loaded from the file should retain its existing values.
+	cache->SetValue(CreateKey(1), 3, L"Explorer++");
+	cache->Flush();
+
+	ReopenCache(cache);
+	EXPECT_EQ(cache->GetValue(CreateKey(1), 1), L"Text Document");
+	EXPECT_EQ(cache->GetValue(CreateKey(1), 3), L"Explorer++");
+
+	auto counters = cache->GetCounters();
+	EXPECT_EQ(counters.numItems, 2U);
+	EXPECT_EQ(counters.numHits, 2U);
+}
+
+TEST_F(PersistentItemCacheTest, ModifiedItem)
+{
+	auto cache = CreateCache();
+	cache->SetValue(CreateKey(1, 1), 1, L"Old value");
+	cache->SetValue(CreateKey(1, 1), 2, L"Other value");
+	ReopenCache(cache);
+
+	EXPECT_EQ(cache->GetValue(CreateKey(1, 2), 1), std::nullopt);
+
+	// Once the modified item is stored, none of the values for the original item should remain.
+	cache->SetValue(CreateKey(1, 2), 1, L"New value");
+	EXPECT_EQ(cache->GetValue(CreateKey(1, 2), 2), std::nullopt);
+	ReopenCache(cache);
+
+	EXPECT_EQ(cache->GetValue(CreateKey(1, 2), 1), L"New value");
+	EXPECT_EQ(cache->GetValue(CreateKey(1, 2), 2), std::nullopt);
+	EXPECT_EQ(cache->GetValue(CreateKey(1, 1), 1), std::nullopt);
+}
+
+TEST_F(PersistentItemCacheTest, PartialWriteIsDiscarded)
+{
+	auto cache = CreateCache();
+	cache->SetValue(CreateKey(1), 1, L"Value 1");
+	cache.reset();
+
+	{
+		std::ofstream file(m_filePath, std::ios::binary | std::ios::app);
+		file.write("\x40\x00\x00\x00\x12\x34", 6);
+	}
+
+	ReopenCache(cache);
+	EXPECT_EQ(cache->GetValue(CreateKey(1), 1), L"Value 1");
+
+	// The partial record should have been removed, so that new records can be read back.
+	cache->SetValue(CreateKey(2), 1, L"Value 2");
+	ReopenCache(cache);
+	EXPECT_EQ(cache->GetValue(CreateKey(1), 1), L"Value 1");
+	EXPECT_EQ(cache->GetValue(CreateKey(2), 1), L"Value 2");
+}
+
+TEST_F(PersistentItemCacheTest, SizeIsCapped)
+{
+	const std::uint64_t MAX_FILE_SIZE = 16 * 1024;
+	const int NUM_ITEMS = 1000;
+
+	auto cache = CreateCache(MAX_FILE_SIZE);
+
+	for (int i = 0; i < NUM_ITEMS; i++)
+	{
+		cache->SetValue(CreateKey(i), 1, L"Text Document");
+	}
+
+	// Using the first item should stop it from being dropped.
+	EXPECT_EQ(cache->GetValue(CreateKey(0), 1), L"Text Document");
+
+	cache->Flush();
+
+	auto counters = cache->GetCounters();
+	EXPECT_LE(counters.fileSize, MAX_FILE_SIZE);
+	EXPECT_GE(counters.numCompactions, 1U);
+	EXPECT_LT(counters.numItems, static_cast<std::size_t>(NUM_ITEMS));
+
+	ReopenCache(cache, MAX_FILE_SIZE);
+	EXPECT_LE(std::filesystem::file_size(m_filePath), MAX_FILE_SIZE);
+
+	// The most recently used items should have been kept.
+	EXPECT_EQ(cache->GetValue(CreateKey(0), 1), L"Text Document");
+	EXPECT_EQ(cache->GetValue(CreateKey(NUM_ITEMS - 1), 1), L"Text Document");
+	EXPECT_EQ(cache->GetValue(CreateKey(1), 1), std::nullopt);
+}
+
+TEST_F(PersistentItemCacheTest, SupersededRecordsAreCompacted)
+{
+	auto cache = CreateCache(64 * 1024 * 1024);
+	std::uint64_t lastWriteTime = 1;
+
+	// Repeatedly updating the same small set of items results in a file made up almost entirely
+	// of superseded records.
+	for (int i = 0; i < 100; i++)
+	{
+		for (int j = 0; j < 100; j++)
+		{
+			cache->SetValue(CreateKey(j, lastWriteTime), 1, std::wstring(50, L'x'));
+		}
+
+		cache->Flush();
+		lastWriteTime++;
+	}
+
+	EXPECT_GE(cache->GetCounters().numCompactions, 1U);
+	EXPECT_LT(std::filesystem::file_size(m_filePath), 1024U * 1024U);
+
+	ReopenCache(cache, 64 * 1024 * 1024);
+	EXPECT_EQ(cache->GetCounters().numItems, 100U);
+	EXPECT_EQ(cache->GetValue(CreateKey(0, lastWriteTime - 1), 1), std::wstring(50, L'x'));
+}
+
+TEST_F(PersistentItemCacheTest, ValuesSetDuringFlushAreKept)
+{
+	const int NUM_ITEMS = 100;
+	const int NUM_ROUNDS = 200;
+
+	auto cache = CreateCache(64 * 1024 * 1024);
+
+	// The file is written (and compacted) with the cache unlocked, so values set by another thread
+	// in the meantime need to be retained.
+	std::atomic<bool> stop = false;
+	std::thread flushThread([&cache, &stop]() {
+		while (!stop)
+		{
+			cache->Flush();
+		}
+	});
+
+	for (int i = 1; i <= NUM_ROUNDS; i++)
+	{
+		for (int j = 0; j < NUM_ITEMS; j++)
+		{
+			cache->SetValue(CreateKey(j, i), 1, std::wstring(50, L'a' + (i % 26)));
+		}
+
+		// Each round supersedes every existing record, so flushing here ensures the file is
+		// eventually compacted.
+		cache->Flush();
+	}
+
+	stop = true;
+	flushThread.join();
+
+	EXPECT_GE(cache->GetCounters().numCompactions, 1U);
+
+	ReopenCache(cache, 64 * 1024 * 1024);
+	EXPECT_EQ(cache->GetCounters().numItems, static_cast<std::size_t>(NUM_ITEMS));
+
+	for (int j = 0; j < NUM_ITEMS; j++)
+	{
+		EXPECT_EQ(cache->GetValue(CreateKey(j, NUM_ROUNDS), 1),
+			std::wstring(50, L'a' + (NUM_ROUNDS % 26)));
+	}
+}
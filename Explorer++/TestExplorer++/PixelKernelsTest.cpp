@@ -0,0 +1,313 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "../Helper/PixelKernels.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace PixelKernels;
+
+namespace
+{
+	struct TestImage
+	{
+		TestImage(int width, int height, int stride) :
+			width(width),
+			height(height),
+			stride(stride),
+			pixels(static_cast<std::size_t>(stride) * height)
+		{
+		}
+
+		PixelBuffer GetBuffer()
+		{
+			return { pixels.data(), width, height, stride };
+		}
+
+		ConstPixelBuffer GetConstBuffer() const
+		{
+			return { pixels.data(), width, height, stride };
+		}
+
+		int width;
+		int height;
+		int stride;
+		std::vector<std::uint32_t> pixels;
+	};
+
+	TestImage CreateRandomImage(int width, int height, int stride, unsigned int seed)
+	{
+		TestImage image(width, height, stride);
+		std::mt19937 generator(seed);
+
+		for (auto &pixel : image.pixels)
+		{
+			pixel = generator();
+		}
+
+		return image;
+	}
+
+	std::vector<InstructionSet> GetSupportedInstructionSets()
+	{
+		std::vector<InstructionSet> instructionSets;
+
+		for (auto instructionSet :
+			{ InstructionSet::Scalar, InstructionSet::SSE2, InstructionSet::AVX2 })
+		{
+			if (IsInstructionSetSupported(instructionSet))
+			{
+				instructionSets.push_back(instructionSet);
+			}
+		}
+
+		return instructionSets;
+	}
+
+	const char *GetInstructionSetName(InstructionSet instructionSet)
+	{
+		switch (instructionSet)
+		{
+		case InstructionSet::SSE2:
+			return "SSE2";
+
+		case InstructionSet::AVX2:
+			return "AVX2";
+
+		case InstructionSet::Scalar:
+		default:
+			return "Scalar";
+		}
+	}
+
+	// Widths that exercise both the vectorized part of each row and the remaining pixels.
+	const int TEST_WIDTHS[] = { 1, 3, 4, 7, 8, 15, 16, 17, 33 };
+}
+
+class PixelKernelsTest : public testing::TestWithParam<InstructionSet>
+{
+};
+
+TEST_P(PixelKernelsTest, HasAlpha)
+{
+	for (int width : TEST_WIDTHS)
+	{
+		TestImage image(width, 5, width + 3);
+
+		for (auto &pixel : image.pixels)
+		{
+			pixel = 0x00FFFFFF;
+		}
+
+		EXPECT_FALSE(HasAlpha(image.GetConstBuffer(), GetParam()));
+
+		// Pixels outside the width of the image (i.e. in the padding at the end of a row) should
+		// be ignored.
+		image.pixels[width] = 0xFF000000;
+		EXPECT_FALSE(HasAlpha(image.GetConstBuffer(), GetParam()));
+
+		image.pixels[4 * image.stride + width - 1] = 0x01000000;
+		EXPECT_TRUE(HasAlpha(image.GetConstBuffer(), GetParam()));
+	}
+}
+
+TEST_P(PixelKernelsTest, ApplyMaskToAlpha)
+{
+	for (int width : TEST_WIDTHS)
+	{
+		auto image = CreateRandomImage(width, 4, width + 1, width);
+		auto mask = CreateRandomImage(width, 4, width, width + 100);
+
+		// Clear roughly half of the mask.
+		for (auto &pixel : mask.pixels)
+		{
+			if (pixel & 1)
+			{
+				pixel = 0;
+			}
+		}
+
+		auto original = image;
+		ApplyMaskToAlpha(image.GetBuffer(), mask.GetConstBuffer(), GetParam());
+
+		for (int y = 0; y < image.height; y++)
+		{
+			for (int x = 0; x < image.width; x++)
+			{
+				std::uint32_t originalPixel = original.pixels[y * image.stride + x];
+				std::uint32_t maskPixel = mask.pixels[y * mask.stride + x];
+				std::uint32_t expected = maskPixel ? 0 : (originalPixel | 0xFF000000);
+				EXPECT_EQ(image.pixels[y * image.stride + x], expected);
+			}
+
+			// The padding should be left untouched.
+			EXPECT_EQ(image.pixels[y * image.stride + width],
+				original.pixels[y * image.stride + width]);
+		}
+	}
+}
+
+TEST_P(PixelKernelsTest, Premultiply)
+{
+	for (int width : TEST_WIDTHS)
+	{
+		auto image = CreateRandomImage(width, 3, width, width);
+		auto original = image;
+
+		Premultiply(image.GetBuffer(), GetParam());
+
+		for (std::size_t i = 0; i < image.pixels.size(); i++)
+		{
+			std::uint32_t originalPixel = original.pixels[i];
+			std::uint32_t alpha = originalPixel >> 24;
+			std::uint32_t expected = alpha << 24;
+
+			for (int shift = 0; shift < 24; shift += 8)
+			{
+				std::uint32_t channel = (originalPixel >> shift) & 0xFF;
+				auto premultiplied =
+					static_cast<std::uint32_t>(channel * alpha / 255.0 + 0.5);
+				expected |= premultiplied << shift;
+			}
+
+			EXPECT_EQ(image.pixels[i], expected);
+		}
+	}
+}
+
+TEST_P(PixelKernelsTest, PremultiplyOpaqueAndTransparent)
+{
+	TestImage image(8, 1, 8);
+	image.pixels = { 0xFF123456, 0xFFFFFFFF, 0x00FFFFFF, 0x00123456, 0xFF000000, 0x80FFFFFF,
+		0x80808080, 0x01FFFFFF };
+
+	Premultiply(image.GetBuffer(), GetParam());
+
+	std::vector<std::uint32_t> expected = { 0xFF123456, 0xFFFFFFFF, 0x00000000, 0x00000000,
+		0xFF000000, 0x80808080, 0x80404040, 0x01010101 };
+	EXPECT_EQ(image.pixels, expected);
+}
+
+TEST_P(PixelKernelsTest, BoxDownscaleAveragesPixels)
+{
+	TestImage source(4, 2, 4);
+	source.pixels = { 0x00000000, 0x02020202, 0x10203040, 0x10203040, 0x04040404, 0x06060606,
+		0x10203040, 0x10203041 };
+
+	TestImage destination(2, 1, 2);
+	BoxDownscale(source.GetConstBuffer(), destination.GetBuffer(), GetParam());
+
+	// The second pixel has a blue channel that averages to 0x40.25, which is rounded down.
+	std::vector<std::uint32_t> expected = { 0x03030303, 0x10203040 };
+	EXPECT_EQ(destination.pixels, expected);
+}
+
+TEST_P(PixelKernelsTest, BoxDownscaleMatchesScalar)
+{
+	struct Size
+	{
+		int width;
+		int height;
+	};
+
+	const std::pair<Size, Size> sizes[] = { { { 256, 256 }, { 120, 120 } },
+		{ { 37, 19 }, { 5, 3 } }, { { 100, 50 }, { 100, 50 } }, { { 33, 33 }, { 1, 1 } },
+		{ { 640, 480 }, { 120, 90 } } };
+
+	for (const auto &[sourceSize, destinationSize] : sizes)
+	{
+		auto source =
+			CreateRandomImage(sourceSize.width, sourceSize.height, sourceSize.width + 2, 1);
+
+		TestImage expected(destinationSize.width, destinationSize.height, destinationSize.width);
+		BoxDownscale(source.GetConstBuffer(), expected.GetBuffer(), InstructionSet::Scalar);
+
+		TestImage destination(
+			destinationSize.width, destinationSize.height, destinationSize.width);
+		BoxDownscale(source.GetConstBuffer(), destination.GetBuffer(), GetParam());
+
+		EXPECT_EQ(destination.pixels, expected.pixels);
+	}
+}
+
+TEST_P(PixelKernelsTest, BoxDownscaleSameSizeCopies)
+{
+	auto source = CreateRandomImage(17, 9, 17, 5);
+
+	TestImage destination(17, 9, 17);
+	BoxDownscale(source.GetConstBuffer(), destination.GetBuffer(), GetParam());
+
+	EXPECT_EQ(destination.pixels, source.pixels);
+}
+
+INSTANTIATE_TEST_SUITE_P(InstructionSets, PixelKernelsTest,
+	testing::ValuesIn(GetSupportedInstructionSets()),
+	[](const testing::TestParamInfo<InstructionSet> &info) {
+		return GetInstructionSetName(info.param);
+	});
+
+TEST(PixelKernelsBenchmark, DISABLED_Throughput)
+{
+	const int NUM_ITERATIONS = 200;
+
+	// A thumbnail sized image, plus a larger image (e.g. a screenshot of the main window) for
+	// downscaling.
+	auto thumbnail = CreateRandomImage(256, 256, 256, 1);
+	auto largeImage = CreateRandomImage(1920, 1080, 1920, 2);
+
+	// Only pixels without alpha are used here, so that HasAlpha() has to check every pixel.
+	auto opaqueThumbnail = thumbnail;
+
+	for (auto &pixel : opaqueThumbnail.pixels)
+	{
+		pixel &= 0x00FFFFFF;
+	}
+
+	for (auto instructionSet : GetSupportedInstructionSets())
+	{
+		auto measure = [](auto operation) {
+			auto start = std::chrono::steady_clock::now();
+
+			for (int i = 0; i < NUM_ITERATIONS; i++)
+			{
+				operation();
+			}
+
+			return std::chrono::duration_cast<std::chrono::microseconds>(
+					   std::chrono::steady_clock::now() - start)
+					   .count()
+				/ NUM_ITERATIONS;
+		};
+
+		bool hasAlpha = false;
+		auto hasAlphaTime = measure([&]() {
+			hasAlpha |= HasAlpha(opaqueThumbnail.GetConstBuffer(), instructionSet);
+		});
+		EXPECT_FALSE(hasAlpha);
+
+		auto maskTime = measure([&]() {
+			auto image = opaqueThumbnail;
+			ApplyMaskToAlpha(image.GetBuffer(), thumbnail.GetConstBuffer(), instructionSet);
+		});
+
+		auto premultiplyTime = measure([&]() {
+			auto image = thumbnail;
+			Premultiply(image.GetBuffer(), instructionSet);
+		});
+
+		TestImage destination(320, 180, 320);
+		auto downscaleTime = measure([&]() {
+			BoxDownscale(largeImage.GetConstBuffer(), destination.GetBuffer(), instructionSet);
+		});
+
+		std::cout << GetInstructionSetName(instructionSet) << ": HasAlpha " << hasAlphaTime
+				  << "us, ApplyMaskToAlpha " << maskTime << "us, Premultiply " << premultiplyTime
+				  << "us, BoxDownscale (1920x1080 -> 320x180) " << downscaleTime << "us"
+				  << std::endl;
+	}
+}
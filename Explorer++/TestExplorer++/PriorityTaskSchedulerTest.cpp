@@ -0,0 +1,404 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "../Helper/PriorityTaskScheduler.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+	// Blocks the scheduler's worker thread until Release() is called, so that the order in
+	// which the remaining tasks run can be checked.
+	class WorkerBlocker
+	{
+	public:
+		explicit WorkerBlocker(PriorityTaskScheduler<int> &scheduler)
+		{
+			std::promise<void> started;
+			auto startedFuture = started.get_future();
+
+			scheduler.Queue(-1, 0, [this, &started]() {
+				started.set_value();
+				m_releaseFuture.wait();
+			});
+
+			startedFuture.wait();
+		}
+
+		void Release()
+		{
+			m_release.set_value();
+		}
+
+	private:
+		std::promise<void> m_release;
+		std::shared_future<void> m_releaseFuture = m_release.get_future().share();
+	};
+
+	class TaskRecorder
+	{
+	public:
+		PriorityTaskScheduler<int>::Task CreateTask(int id)
+		{
+			return [this, id]() {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_completedTasks.push_back(id);
+			};
+		}
+
+		std::vector<int> GetCompletedTasks()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_completedTasks;
+		}
+
+	private:
+		std::mutex m_mutex;
+		std::vector<int> m_completedTasks;
+	};
+
+	void WaitForIdle(PriorityTaskScheduler<int> &scheduler)
+	{
+		std::promise<void> finished;
+		auto finishedFuture = finished.get_future();
+
+		// This task has the lowest possible priority, so it will only run once every other task
+		// has finished.
+		scheduler.Queue(
+			-2, (std::numeric_limits<int>::max)(), [&finished]() { finished.set_value(); });
+		finishedFuture.wait();
+	}
+
+	// Unlike WaitForIdle(), this doesn't rely on tasks running one at a time in priority order.
+	void WaitForCompletedTasks(PriorityTaskScheduler<int> &scheduler, std::uint64_t numTasks)
+	{
+		while (scheduler.GetCounters().numCompleted < numTasks)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+TEST(PriorityTaskSchedulerTest, RunsInPriorityOrder)
+{
+	TaskRecorder recorder;
+	PriorityTaskScheduler<int> scheduler(1);
+
+	WorkerBlocker blocker(scheduler);
+	scheduler.Queue(1, 5, recorder.CreateTask(1));
+	scheduler.Queue(2, 1, recorder.CreateTask(2));
+	scheduler.Queue(3, 3, recorder.CreateTask(3));
+	scheduler.Queue(4, 1, recorder.CreateTask(4));
+	blocker.Release();
+
+	WaitForIdle(scheduler);
+
+	// Tasks with the same priority should run in the order they were queued.
+	EXPECT_EQ(recorder.GetCompletedTasks(), (std::vector<int>{ 2, 4, 3, 1 }));
+}
+
+TEST(PriorityTaskSchedulerTest, Deduplicates)
+{
+	TaskRecorder recorder;
+	PriorityTaskScheduler<int> scheduler(1);
+
+	WorkerBlocker blocker(scheduler);
+	EXPECT_TRUE(scheduler.Queue(1, 5, recorder.CreateTask(1)));
+	EXPECT_TRUE(scheduler.Queue(2, 3, recorder.CreateTask(2)));
+
+	// This should update the priority of the existing task, rather than adding a new task.
+	EXPECT_FALSE(scheduler.Queue(1, 1, recorder.CreateTask(100)));
+	blocker.Release();
+
+	WaitForIdle(scheduler);
+
+	EXPECT_EQ(recorder.GetCompletedTasks(), (std::vector<int>{ 1, 2 }));
+
+	auto counters = scheduler.GetCounters();
+	EXPECT_EQ(counters.numDeduplicated, 1U);
+}
+
+TEST(PriorityTaskSchedulerTest, Reprioritize)
+{
+	TaskRecorder recorder;
+	PriorityTaskScheduler<int> scheduler(1);
+
+	WorkerBlocker blocker(scheduler);
+
+	for (int i = 1; i <= 6; i++)
+	{
+		scheduler.Queue(i, i, recorder.CreateTask(i));
+	}
+
+	// Odd tasks are dropped, while the order of the remaining tasks is reversed.
+	auto droppedKeys = scheduler.Reprioritize([](int key) -> std::optional<int> {
+		if (key % 2 == 1)
+		{
+			return std::nullopt;
+		}
+
+		return -key;
+	});
+	blocker.Release();
+
+	WaitForIdle(scheduler);
+
+	std::sort(droppedKeys.begin(), droppedKeys.end());
+	EXPECT_EQ(droppedKeys, (std::vector<int>{ 1, 3, 5 }));
+	EXPECT_EQ(recorder.GetCompletedTasks(), (std::vector<int>{ 6, 4, 2 }));
+}
+
+TEST(PriorityTaskSchedulerTest, Clear)
+{
+	TaskRecorder recorder;
+	PriorityTaskScheduler<int> scheduler(1);
+
+	WorkerBlocker blocker(scheduler);
+	scheduler.Queue(1, 1, recorder.CreateTask(1));
+	scheduler.Queue(2, 2, recorder.CreateTask(2));
+	scheduler.Clear();
+
+	// A task can be queued again once it's been cleared.
+	scheduler.Queue(2, 2, recorder.CreateTask(2));
+	blocker.Release();
+
+	WaitForIdle(scheduler);
+
+	EXPECT_EQ(recorder.GetCompletedTasks(), (std::vector<int>{ 2 }));
+}
+
+TEST(PriorityTaskSchedulerTest, Counters)
+{
+	TaskRecorder recorder;
+	PriorityTaskScheduler<int> scheduler(1);
+
+	WorkerBlocker blocker(scheduler);
+	scheduler.Queue(1, 1, recorder.CreateTask(1));
+	scheduler.Queue(2, 2, recorder.CreateTask(2));
+	scheduler.Queue(3, 3, recorder.CreateTask(3));
+	scheduler.Queue(3, 3, recorder.CreateTask(3));
+
+	auto counters = scheduler.GetCounters();
+	EXPECT_EQ(counters.queueDepth, 3U);
+	EXPECT_EQ(counters.maxQueueDepth, 3U);
+
+	scheduler.Reprioritize([](int key) -> std::optional<int> {
+		if (key == 3)
+		{
+			return std::nullopt;
+		}
+
+		return key;
+	});
+	blocker.Release();
+
+	WaitForIdle(scheduler);
+
+	counters = scheduler.GetCounters();
+
+	// The counts include the tasks queued by WorkerBlocker and WaitForIdle.
+	EXPECT_EQ(counters.queueDepth, 0U);
+	EXPECT_EQ(counters.numQueued, 5U);
+	EXPECT_EQ(counters.numDeduplicated, 1U);
+	EXPECT_EQ(counters.numDropped, 1U);
+	EXPECT_GE(counters.numCompleted, 3U);
+	EXPECT_GE(counters.maxLatency, counters.GetAverageLatency());
+}
+
+TEST(PriorityTaskSchedulerTest, MultipleThreads)
+{
+	const int NUM_TASKS = 1000;
+
+	std::atomic<int> numCompleted = 0;
+
+	{
+		PriorityTaskScheduler<int> scheduler(4);
+
+		for (int i = 0; i < NUM_TASKS; i++)
+		{
+			scheduler.Queue(i, i % 10, [&numCompleted]() { numCompleted++; });
+		}
+
+		while (scheduler.GetCounters().numCompleted < NUM_TASKS)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	EXPECT_EQ(numCompleted, NUM_TASKS);
+}
+
+TEST(PriorityTaskSchedulerTest, RunsOnTaskQueue)
+{
+	TaskRecorder recorder;
+	TaskExecutor executor(1);
+	PriorityTaskScheduler<int> scheduler(
+		executor.CreateQueue(L"Test", TaskPriorityClass::Foreground));
+
+	WorkerBlocker blocker(scheduler);
+	scheduler.Queue(1, 5, recorder.CreateTask(1));
+	scheduler.Queue(2, 1, recorder.CreateTask(2));
+	scheduler.Queue(3, 3, recorder.CreateTask(3));
+	scheduler.Queue(3, 0, recorder.CreateTask(3));
+	blocker.Release();
+
+	WaitForIdle(scheduler);
+
+	EXPECT_EQ(recorder.GetCompletedTasks(), (std::vector<int>{ 3, 2, 1 }));
+}
+
+TEST(PriorityTaskSchedulerTest, ConcurrencyLimit)
+{
+	const int NUM_TASKS = 200;
+	const int CONCURRENCY_LIMIT = 2;
+
+	TaskExecutor executor(8);
+	PriorityTaskScheduler<int> scheduler(
+		executor.CreateQueue(L"Test", TaskPriorityClass::Foreground));
+	scheduler.SetConcurrencyLimit(CONCURRENCY_LIMIT);
+
+	std::atomic<int> numRunning = 0;
+	std::atomic<int> maxRunning = 0;
+	std::atomic<int> numCompleted = 0;
+
+	for (int i = 0; i < NUM_TASKS; i++)
+	{
+		scheduler.Queue(i, i, [&numRunning, &maxRunning, &numCompleted]() {
+			int running = ++numRunning;
+			int max = maxRunning;
+
+			while (running > max && !maxRunning.compare_exchange_weak(max, running))
+			{
+			}
+
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+			numRunning--;
+			numCompleted++;
+		});
+	}
+
+	WaitForCompletedTasks(scheduler, NUM_TASKS);
+
+	EXPECT_EQ(numCompleted, NUM_TASKS);
+	EXPECT_LE(maxRunning, CONCURRENCY_LIMIT);
+	EXPECT_LE(scheduler.GetCounters().maxRunning, static_cast<std::size_t>(CONCURRENCY_LIMIT));
+}
+
+TEST(PriorityTaskSchedulerTest, ConcurrencyLimitRaised)
+{
+	const int NUM_THREADS = 4;
+
+	TaskExecutor executor(NUM_THREADS);
+	PriorityTaskScheduler<int> scheduler(
+		executor.CreateQueue(L"Test", TaskPriorityClass::Foreground));
+	scheduler.SetConcurrencyLimit(1);
+
+	// Each task waits until every task has started, which is only possible once the limit has
+	// been raised.
+	std::atomic<int> numStarted = 0;
+	std::vector<std::future<void>> results;
+
+	for (int i = 0; i < NUM_THREADS; i++)
+	{
+		auto task = std::make_shared<std::packaged_task<void()>>([&numStarted]() {
+			numStarted++;
+
+			while (numStarted < NUM_THREADS)
+			{
+				std::this_thread::yield();
+			}
+		});
+		results.push_back(task->get_future());
+		scheduler.Queue(i, 0, [task]() { (*task)(); });
+	}
+
+	scheduler.SetConcurrencyLimit(std::nullopt);
+
+	for (auto &result : results)
+	{
+		result.wait();
+	}
+
+	EXPECT_EQ(numStarted, NUM_THREADS);
+}
+
+TEST(PriorityTaskSchedulerTest, ConcurrencyLimitWithOwnThreads)
+{
+	const int NUM_TASKS = 100;
+
+	std::atomic<int> numCompleted = 0;
+	PriorityTaskScheduler<int> scheduler(4);
+	scheduler.SetConcurrencyLimit(1);
+
+	for (int i = 0; i < NUM_TASKS; i++)
+	{
+		scheduler.Queue(i, 0, [&numCompleted]() { numCompleted++; });
+	}
+
+	WaitForCompletedTasks(scheduler, NUM_TASKS);
+
+	EXPECT_EQ(numCompleted, NUM_TASKS);
+	EXPECT_EQ(scheduler.GetCounters().maxRunning, 1U);
+}
+
+// Measures the throughput of a set of synthetic items, each of which simulates a column lookup
+// that spends most of its time waiting on I/O. Run with --gtest_also_run_disabled_tests.
+TEST(PriorityTaskSchedulerTest, DISABLED_ThroughputBenchmark)
+{
+	const int NUM_ITEMS = 2000;
+	const auto ITEM_IO_TIME = std::chrono::microseconds(500);
+
+	// A fixed number of threads is used, so that the effect of the concurrency limit can be seen
+	// regardless of the number of processors.
+	TaskExecutor executor(8);
+
+	for (std::optional<int> concurrencyLimit :
+		{ std::optional<int>(1), std::optional<int>(2), std::optional<int>(4),
+			std::optional<int>() })
+	{
+		PriorityTaskScheduler<int> scheduler(
+			executor.CreateQueue(L"Benchmark", TaskPriorityClass::Foreground));
+		scheduler.SetConcurrencyLimit(concurrencyLimit);
+
+		std::atomic<std::uint64_t> checksum = 0;
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < NUM_ITEMS; i++)
+		{
+			scheduler.Queue(i, i, [i, &checksum, ITEM_IO_TIME]() {
+				std::this_thread::sleep_for(ITEM_IO_TIME);
+
+				// A small amount of processing, standing in for formatting the column text.
+				std::uint64_t value = i;
+
+				for (int j = 0; j < 1000; j++)
+				{
+					value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+				}
+
+				checksum += value;
+			});
+		}
+
+		WaitForCompletedTasks(scheduler, NUM_ITEMS);
+
+		auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - start);
+		auto itemsPerSecond =
+			(NUM_ITEMS * 1000000LL) / std::max<long long>(duration.count(), 1);
+
+		std::cout << "Concurrency limit "
+				  << (concurrencyLimit ? std::to_string(*concurrencyLimit) : "none") << " ("
+				  << executor.GetNumThreads() << " threads): " << duration.count() << "us, "
+				  << itemsPerSecond << " items/s" << std::endl;
+	}
+}
@@ -0,0 +1,170 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "../Helper/RequestCoalescer.h"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace
+{
+	class FakeClock
+	{
+	public:
+		using duration = std::chrono::steady_clock::duration;
+		using time_point = std::chrono::steady_clock::time_point;
+
+		static time_point now()
+		{
+			return currentTime;
+		}
+
+		static inline time_point currentTime;
+	};
+
+	using Callback = std::function<void(int)>;
+	using TestCoalescer = RequestCoalescer<std::wstring, Callback, FakeClock>;
+	using AddResult = TestCoalescer::AddResult;
+
+	constexpr auto FAILURE_TIMEOUT = std::chrono::seconds(5);
+}
+
+class RequestCoalescerTest : public testing::Test
+{
+protected:
+	RequestCoalescerTest()
+	{
+		FakeClock::currentTime = FakeClock::time_point();
+	}
+};
+
+TEST_F(RequestCoalescerTest, ConcurrentRequestsShareJob)
+{
+	TestCoalescer coalescer(FAILURE_TIMEOUT, 100);
+	std::vector<int> results;
+	auto callback = [&results](int value) { results.push_back(value); };
+
+	EXPECT_EQ(coalescer.AddRequest(L"C:\\", callback), AddResult::NewRequest);
+	EXPECT_EQ(coalescer.AddRequest(L"C:\\", callback), AddResult::Coalesced);
+	EXPECT_EQ(coalescer.AddRequest(L"C:\\", callback), AddResult::Coalesced);
+	EXPECT_EQ(coalescer.AddRequest(L"D:\\", callback), AddResult::NewRequest);
+	EXPECT_TRUE(coalescer.IsInFlight(L"C:\\"));
+
+	auto callbacks = coalescer.CompleteRequest(L"C:\\", true);
+	ASSERT_EQ(callbacks.size(), 3U);
+
+	for (const auto &currentCallback : callbacks)
+	{
+		currentCallback(1);
+	}
+
+	EXPECT_EQ(results, (std::vector<int>{ 1, 1, 1 }));
+	EXPECT_FALSE(coalescer.IsInFlight(L"C:\\"));
+	EXPECT_TRUE(coalescer.IsInFlight(L"D:\\"));
+
+	// Once the request has completed, a later request should start a new job.
+	EXPECT_EQ(coalescer.AddRequest(L"C:\\", callback), AddResult::NewRequest);
+
+	auto counters = coalescer.GetCounters();
+	EXPECT_EQ(counters.numMisses, 3U);
+	EXPECT_EQ(counters.numCoalesced, 2U);
+	EXPECT_EQ(counters.numFailureHits, 0U);
+}
+
+TEST_F(RequestCoalescerTest, FailuresAreRememberedTemporarily)
+{
+	TestCoalescer coalescer(FAILURE_TIMEOUT, 100);
+
+	EXPECT_EQ(coalescer.AddRequest(L"C:\\missing", {}), AddResult::NewRequest);
+	EXPECT_EQ(coalescer.CompleteRequest(L"C:\\missing", false).size(), 1U);
+
+	FakeClock::currentTime += std::chrono::seconds(1);
+	EXPECT_EQ(coalescer.AddRequest(L"C:\\missing", {}), AddResult::RecentlyFailed);
+	EXPECT_FALSE(coalescer.IsInFlight(L"C:\\missing"));
+
+	FakeClock::currentTime += FAILURE_TIMEOUT;
+	EXPECT_EQ(coalescer.AddRequest(L"C:\\missing", {}), AddResult::NewRequest);
+
+	// A success shouldn't be remembered.
+	coalescer.CompleteRequest(L"C:\\missing", true);
+	EXPECT_EQ(coalescer.AddRequest(L"C:\\missing", {}), AddResult::NewRequest);
+
+	EXPECT_EQ(coalescer.GetCounters().numFailureHits, 1U);
+}
+
+TEST_F(RequestCoalescerTest, FailedKeysAreBounded)
+{
+	const std::size_t MAX_FAILED_KEYS = 10;
+	TestCoalescer coalescer(FAILURE_TIMEOUT, MAX_FAILED_KEYS);
+
+	for (std::size_t i = 0; i < MAX_FAILED_KEYS * 3; i++)
+	{
+		auto key = std::to_wstring(i);
+		coalescer.AddRequest(key, {});
+		coalescer.CompleteRequest(key, false);
+	}
+
+	std::size_t numRemembered = 0;
+
+	for (std::size_t i = 0; i < MAX_FAILED_KEYS * 3; i++)
+	{
+		if (coalescer.AddRequest(std::to_wstring(i), {}) == AddResult::RecentlyFailed)
+		{
+			numRemembered++;
+		}
+	}
+
+	EXPECT_GT(numRemembered, 0U);
+	EXPECT_LE(numRemembered, MAX_FAILED_KEYS);
+}
+
+TEST_F(RequestCoalescerTest, Clear)
+{
+	TestCoalescer coalescer(FAILURE_TIMEOUT, 100);
+
+	coalescer.AddRequest(L"C:\\", {});
+	coalescer.AddRequest(L"D:\\", {});
+	coalescer.CompleteRequest(L"D:\\", false);
+
+	coalescer.Clear();
+	EXPECT_FALSE(coalescer.IsInFlight(L"C:\\"));
+	EXPECT_EQ(coalescer.AddRequest(L"C:\\", {}), AddResult::NewRequest);
+
+	// Failures should be retained.
+	EXPECT_EQ(coalescer.AddRequest(L"D:\\", {}), AddResult::RecentlyFailed);
+}
+
+TEST_F(RequestCoalescerTest, RemoveCallbacks)
+{
+	using OwnedCallback = std::pair<int, Callback>;
+	using OwnedCoalescer = RequestCoalescer<std::wstring, OwnedCallback, FakeClock>;
+	OwnedCoalescer coalescer(FAILURE_TIMEOUT, 100);
+
+	std::vector<int> results;
+	auto makeCallback = [&results](int owner) {
+		return OwnedCallback(owner, [&results, owner](int) { results.push_back(owner); });
+	};
+
+	coalescer.AddRequest(L"C:\\", makeCallback(1));
+	coalescer.AddRequest(L"C:\\", makeCallback(2));
+	coalescer.AddRequest(L"D:\\", makeCallback(2));
+
+	coalescer.RemoveCallbacks([](const OwnedCallback &callback) { return callback.first == 2; });
+
+	// The requests are still in flight, even if every callback has been removed.
+	EXPECT_TRUE(coalescer.IsInFlight(L"C:\\"));
+	EXPECT_TRUE(coalescer.IsInFlight(L"D:\\"));
+
+	for (const auto &callback : coalescer.CompleteRequest(L"C:\\", true))
+	{
+		callback.second(0);
+	}
+
+	EXPECT_TRUE(coalescer.CancelRequest(L"D:\\").empty());
+	EXPECT_FALSE(coalescer.IsInFlight(L"D:\\"));
+	EXPECT_EQ(results, std::vector<int>{ 1 });
+
+	// A cancelled request isn't treated as having failed.
+	EXPECT_EQ(
+		coalescer.AddRequest(L"D:\\", makeCallback(1)), OwnedCoalescer::AddResult::NewRequest);
+}
@@ -0,0 +1,116 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "../Helper/ResultBatcher.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST(ResultBatcherTest, SingleNotificationPerBatch)
+{
+	int numNotifications = 0;
+	ResultBatcher<int> batcher([&numNotifications]() { numNotifications++; });
+
+	batcher.AddResult(1);
+	batcher.AddResult(2);
+	batcher.AddResult(3);
+	EXPECT_EQ(numNotifications, 1);
+
+	std::vector<int> processed;
+	auto numProcessed = batcher.ProcessBatch([&processed](int result) {
+		processed.push_back(result);
+	});
+
+	EXPECT_EQ(numProcessed, 3U);
+	EXPECT_EQ(processed, (std::vector<int>{ 1, 2, 3 }));
+
+	// Once the batch has been processed, the next result should start a new batch.
+	batcher.AddResult(4);
+	EXPECT_EQ(numNotifications, 2);
+}
+
+TEST(ResultBatcherTest, TimeBudget)
+{
+	int numNotifications = 0;
+	ResultBatcher<int> batcher([&numNotifications]() { numNotifications++; });
+
+	for (int i = 0; i < 10; i++)
+	{
+		batcher.AddResult(i);
+	}
+
+	std::vector<int> processed;
+	auto processResult = [&processed](int result) { processed.push_back(result); };
+
+	// With no time available, a single result should still be processed and the remaining
+	// results should be left for the next batch.
+	auto numProcessed = batcher.ProcessBatch(processResult, std::chrono::milliseconds(0));
+	EXPECT_EQ(numProcessed, 1U);
+	EXPECT_EQ(numNotifications, 2);
+
+	batcher.AddResult(10);
+	EXPECT_EQ(numNotifications, 2);
+
+	numProcessed = batcher.ProcessBatch(processResult, std::chrono::hours(1));
+	EXPECT_EQ(numProcessed, 10U);
+
+	std::vector<int> expected;
+
+	for (int i = 0; i <= 10; i++)
+	{
+		expected.push_back(i);
+	}
+
+	EXPECT_EQ(processed, expected);
+}
+
+TEST(ResultBatcherTest, Clear)
+{
+	ResultBatcher<int> batcher([]() {});
+
+	batcher.AddResult(1);
+	batcher.AddResult(2);
+	batcher.Clear();
+
+	int numProcessed = 0;
+	batcher.ProcessBatch([&numProcessed](int) { numProcessed++; });
+	EXPECT_EQ(numProcessed, 0);
+}
+
+TEST(ResultBatcherTest, MultipleThreads)
+{
+	const int NUM_THREADS = 4;
+	const int RESULTS_PER_THREAD = 1000;
+
+	std::atomic<int> numNotifications = 0;
+	ResultBatcher<int> batcher([&numNotifications]() { numNotifications++; });
+
+	std::vector<std::thread> threads;
+
+	for (int i = 0; i < NUM_THREADS; i++)
+	{
+		threads.emplace_back([&batcher]() {
+			for (int j = 0; j < RESULTS_PER_THREAD; j++)
+			{
+				batcher.AddResult(j);
+			}
+		});
+	}
+
+	int numProcessed = 0;
+
+	while (numProcessed < NUM_THREADS * RESULTS_PER_THREAD)
+	{
+		numProcessed += static_cast<int>(batcher.ProcessBatch([](int) {}));
+	}
+
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+
+	EXPECT_EQ(numProcessed, NUM_THREADS * RESULTS_PER_THREAD);
+	EXPECT_LE(numNotifications, NUM_THREADS * RESULTS_PER_THREAD);
+}
@@ -0,0 +1,136 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "../Helper/SortKey.h"
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <Shlwapi.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace
+{
+	int Sign(int value)
+	{
+		return (value > 0) - (value < 0);
+	}
+
+	void CheckOrderMatchesStringComparison(
+		const std::vector<std::wstring> &strings, bool naturalSort)
+	{
+		for (const auto &str1 : strings)
+		{
+			for (const auto &str2 : strings)
+			{
+				int expected = naturalSort ? StrCmpLogicalW(str1.c_str(), str2.c_str())
+										   : StrCmpIW(str1.c_str(), str2.c_str());
+				int actual = CompareSortKeys(
+					CreateSortKey(str1, naturalSort), CreateSortKey(str2, naturalSort));
+
+				EXPECT_EQ(Sign(actual), Sign(expected)) << str1 << L" " << str2;
+			}
+		}
+	}
+
+	const std::vector<std::wstring> TEST_STRINGS = { L"", L"a", L"A", L"b", L"abc", L"ABD",
+		L"file1.txt", L"file2.txt", L"file10.txt", L"File3.txt", L"test", L"test 2", L"test 10",
+		L"zzz", L"\u00e9t\u00e9" };
+}
+
+TEST(SortKeyTest, NaturalSort)
+{
+	CheckOrderMatchesStringComparison(TEST_STRINGS, true);
+
+	EXPECT_LT(CompareSortKeys(CreateSortKey(L"file2", true), CreateSortKey(L"file10", true)), 0);
+}
+
+TEST(SortKeyTest, StandardSort)
+{
+	CheckOrderMatchesStringComparison(TEST_STRINGS, false);
+
+	EXPECT_GT(CompareSortKeys(CreateSortKey(L"file2", false), CreateSortKey(L"file10", false)), 0);
+}
+
+TEST(SortKeyTest, IgnoresCase)
+{
+	EXPECT_EQ(CompareSortKeys(CreateSortKey(L"Readme.TXT", true),
+				  CreateSortKey(L"README.txt", true)),
+		0);
+	EXPECT_EQ(CompareSortKeys(CreateSortKey(L"Readme.TXT", false),
+				  CreateSortKey(L"README.txt", false)),
+		0);
+}
+
+// Compares sorting a set of names by building the strings and calling StrCmpLogicalW on each
+// comparison (as the listview sort used to) against building a key for each name once and
+// comparing the keys. Run with --gtest_also_run_disabled_tests.
+TEST(SortKeyTest, DISABLED_Benchmark)
+{
+	const int NUM_NAMES = 1000000;
+
+	std::mt19937 generator(1);
+	std::uniform_int_distribution<int> numberDistribution(0, 100000);
+	std::uniform_int_distribution<int> letterDistribution(L'a', L'z');
+
+	std::vector<std::wstring> names;
+	names.reserve(NUM_NAMES);
+
+	for (int i = 0; i < NUM_NAMES; i++)
+	{
+		std::wstring name;
+
+		for (int j = 0; j < 6; j++)
+		{
+			name += static_cast<wchar_t>(letterDistribution(generator));
+		}
+
+		name += std::to_wstring(numberDistribution(generator)) + L".txt";
+		names.push_back(name);
+	}
+
+	std::vector<int> indexes(NUM_NAMES);
+	std::iota(indexes.begin(), indexes.end(), 0);
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<int> sortedByString = indexes;
+	std::sort(sortedByString.begin(), sortedByString.end(), [&names](int index1, int index2) {
+		std::wstring name1 = names[index1];
+		std::wstring name2 = names[index2];
+		return StrCmpLogicalW(name1.c_str(), name2.c_str()) < 0;
+	});
+
+	auto stringDuration = std::chrono::steady_clock::now() - start;
+
+	start = std::chrono::steady_clock::now();
+
+	std::vector<std::string> keys;
+	keys.reserve(NUM_NAMES);
+
+	for (const auto &name : names)
+	{
+		keys.push_back(CreateSortKey(name, true));
+	}
+
+	auto keyCreationDuration = std::chrono::steady_clock::now() - start;
+
+	std::vector<int> sortedByKey = indexes;
+	std::sort(sortedByKey.begin(), sortedByKey.end(), [&keys](int index1, int index2) {
+		return CompareSortKeys(keys[index1], keys[index2]) < 0;
+	});
+
+	auto keyDuration = std::chrono::steady_clock::now() - start;
+
+	using std::chrono::milliseconds;
+	std::cout << "StrCmpLogicalW: "
+			  << std::chrono::duration_cast<milliseconds>(stringDuration).count() << "ms, "
+			  << "sort keys: " << std::chrono::duration_cast<milliseconds>(keyDuration).count()
+			  << "ms (of which "
+			  << std::chrono::duration_cast<milliseconds>(keyCreationDuration).count()
+			  << "ms was spent building keys)" << std::endl;
+}
@@ -0,0 +1,311 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "../Helper/TaskExecutor.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// Occupies one of the executor's worker threads until Release() is called, so that the order
+	// in which the remaining tasks run can be checked.
+	class WorkerBlocker
+	{
+	public:
+		explicit WorkerBlocker(TaskQueue &queue)
+		{
+			std::promise<void> started;
+			auto startedFuture = started.get_future();
+
+			queue.PushTask([this, &started]() {
+				started.set_value();
+				m_releaseFuture.wait();
+			});
+
+			startedFuture.wait();
+		}
+
+		void Release()
+		{
+			m_release.set_value();
+		}
+
+	private:
+		std::promise<void> m_release;
+		std::shared_future<void> m_releaseFuture = m_release.get_future().share();
+	};
+
+	class TaskRecorder
+	{
+	public:
+		TaskQueue::Task CreateTask(int id)
+		{
+			return [this, id]() {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_completedTasks.push_back(id);
+			};
+		}
+
+		std::vector<int> GetCompletedTasks()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_completedTasks;
+		}
+
+	private:
+		std::mutex m_mutex;
+		std::vector<int> m_completedTasks;
+	};
+}
+
+TEST(TaskExecutorTest, ReturnsResult)
+{
+	TaskExecutor executor(2);
+	auto queue = executor.CreateQueue(L"Test", TaskPriorityClass::Foreground);
+
+	auto result = queue->Push([]() { return 42; });
+	EXPECT_EQ(result.get(), 42);
+}
+
+TEST(TaskExecutorTest, ForegroundBeforeBackground)
+{
+	TaskRecorder recorder;
+	TaskExecutor executor(1);
+	auto backgroundQueue = executor.CreateQueue(L"Background", TaskPriorityClass::Background);
+	auto foregroundQueue = executor.CreateQueue(L"Foreground", TaskPriorityClass::Foreground);
+	auto otherQueue = executor.CreateQueue(L"Other", TaskPriorityClass::Background);
+
+	WorkerBlocker blocker(*backgroundQueue);
+	backgroundQueue->PushTask(recorder.CreateTask(1));
+	backgroundQueue->PushTask(recorder.CreateTask(2));
+	foregroundQueue->PushTask(recorder.CreateTask(3));
+	otherQueue->PushTask(recorder.CreateTask(4));
+
+	// Once this queue becomes a foreground queue, its task should run ahead of the remaining
+	// background tasks.
+	otherQueue->SetPriorityClass(TaskPriorityClass::Foreground);
+	blocker.Release();
+
+	backgroundQueue->Push([]() {}).wait();
+
+	auto completedTasks = recorder.GetCompletedTasks();
+	ASSERT_EQ(completedTasks.size(), 4U);
+	EXPECT_TRUE((completedTasks[0] == 3 && completedTasks[1] == 4)
+		|| (completedTasks[0] == 4 && completedTasks[1] == 3));
+	EXPECT_EQ(completedTasks[2], 1);
+	EXPECT_EQ(completedTasks[3], 2);
+}
+
+TEST(TaskExecutorTest, PrefersSameQueue)
+{
+	TaskRecorder recorder;
+	TaskExecutor executor(1);
+	auto queue1 = executor.CreateQueue(L"Queue 1", TaskPriorityClass::Foreground);
+	auto queue2 = executor.CreateQueue(L"Queue 2", TaskPriorityClass::Foreground);
+
+	WorkerBlocker blocker(*queue2);
+	queue1->PushTask(recorder.CreateTask(1));
+	queue2->PushTask(recorder.CreateTask(2));
+	queue1->PushTask(recorder.CreateTask(3));
+	queue2->PushTask(recorder.CreateTask(4));
+	blocker.Release();
+
+	queue1->Push([]() {}).wait();
+	queue2->Push([]() {}).wait();
+
+	// The worker was last running a task from queue 2, so it should finish the tasks in that
+	// queue before stealing the tasks from queue 1.
+	auto completedTasks = recorder.GetCompletedTasks();
+	EXPECT_EQ(completedTasks, (std::vector<int>{ 2, 4, 1, 3 }));
+
+	EXPECT_GE(queue1->GetStatistics().numStolen, 1U);
+}
+
+TEST(TaskExecutorTest, Clear)
+{
+	TaskRecorder recorder;
+	TaskExecutor executor(1);
+	auto queue = executor.CreateQueue(L"Test", TaskPriorityClass::Foreground);
+
+	WorkerBlocker blocker(*queue);
+	queue->PushTask(recorder.CreateTask(1));
+	auto droppedResult = queue->Push([]() { return 1; });
+	queue->Clear();
+	queue->PushTask(recorder.CreateTask(2));
+	blocker.Release();
+
+	queue->Push([]() {}).wait();
+
+	EXPECT_EQ(recorder.GetCompletedTasks(), (std::vector<int>{ 2 }));
+	EXPECT_THROW(droppedResult.get(), std::future_error);
+
+	auto statistics = queue->GetStatistics();
+	EXPECT_EQ(statistics.numDropped, 2U);
+}
+
+TEST(TaskExecutorTest, ShutdownWaitsForRunningTasks)
+{
+	TaskExecutor executor(2);
+	auto queue = executor.CreateQueue(L"Test", TaskPriorityClass::Foreground);
+
+	std::atomic<bool> finished = false;
+	std::promise<void> started;
+	auto startedFuture = started.get_future();
+
+	queue->PushTask([&finished, &started]() {
+		started.set_value();
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		finished = true;
+	});
+
+	startedFuture.wait();
+	queue->Shutdown();
+	EXPECT_TRUE(finished);
+
+	// Tasks pushed after the queue has been shut down are ignored.
+	auto result = queue->Push([]() { return 1; });
+	EXPECT_THROW(result.get(), std::future_error);
+}
+
+TEST(TaskExecutorTest, ShutdownFromOwnTask)
+{
+	TaskExecutor executor(2);
+	auto queue = executor.CreateQueue(L"Test", TaskPriorityClass::Foreground);
+
+	std::atomic<bool> otherFinished = false;
+	std::promise<void> otherStarted;
+	auto otherStartedFuture = otherStarted.get_future();
+
+	queue->PushTask([&otherFinished, &otherStarted]() {
+		otherStarted.set_value();
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		otherFinished = true;
+	});
+
+	otherStartedFuture.wait();
+
+	// The task shutting down the queue only waits for the other running task.
+	auto result = queue->Push([&queue, &otherFinished]() {
+		queue->Shutdown();
+		return otherFinished.load();
+	});
+
+	EXPECT_TRUE(result.get());
+}
+
+TEST(TaskExecutorTest, RunsInParallel)
+{
+	const int NUM_THREADS = 4;
+
+	TaskExecutor executor(NUM_THREADS);
+	auto queue = executor.CreateQueue(L"Test", TaskPriorityClass::Foreground);
+
+	// Each task waits until every task has started, which can only happen if the tasks in a
+	// single queue are spread across all of the workers.
+	std::atomic<int> numStarted = 0;
+	std::vector<std::future<void>> results;
+
+	for (int i = 0; i < NUM_THREADS; i++)
+	{
+		results.push_back(queue->Push([&numStarted]() {
+			numStarted++;
+
+			while (numStarted < NUM_THREADS)
+			{
+				std::this_thread::yield();
+			}
+		}));
+	}
+
+	for (auto &result : results)
+	{
+		result.wait();
+	}
+
+	EXPECT_EQ(numStarted, NUM_THREADS);
+}
+
+TEST(TaskExecutorTest, Statistics)
+{
+	const int NUM_TASKS = 100;
+
+	TaskExecutor executor(4);
+	auto queue1 = executor.CreateQueue(L"Queue 1", TaskPriorityClass::Foreground);
+	auto queue2 = executor.CreateQueue(L"Queue 2", TaskPriorityClass::Background);
+
+	std::vector<std::future<void>> results;
+
+	for (int i = 0; i < NUM_TASKS; i++)
+	{
+		results.push_back(queue1->Push([]() {}));
+		results.push_back(queue2->Push([]() {}));
+	}
+
+	for (auto &result : results)
+	{
+		result.wait();
+	}
+
+	queue1->Shutdown();
+	queue2->Shutdown();
+
+	auto statistics = executor.GetStatistics();
+	ASSERT_EQ(statistics.size(), 2U);
+
+	for (const auto &queueStatistics : statistics)
+	{
+		EXPECT_EQ(queueStatistics.queueDepth, 0U);
+		EXPECT_EQ(queueStatistics.numQueued, static_cast<std::uint64_t>(NUM_TASKS));
+		EXPECT_EQ(queueStatistics.numCompleted, static_cast<std::uint64_t>(NUM_TASKS));
+		EXPECT_GE(queueStatistics.maxQueueDepth, 1U);
+		EXPECT_GE(queueStatistics.maxLatency, std::chrono::microseconds::zero());
+	}
+
+	EXPECT_EQ(statistics[0].name, L"Queue 1");
+	EXPECT_EQ(statistics[1].priorityClass, TaskPriorityClass::Background);
+}
+
+TEST(TaskExecutorTest, ThreadExitHandlers)
+{
+	std::mutex mutex;
+	std::vector<std::string> events;
+
+	auto addEvent = [&mutex, &events](const std::string &event) {
+		std::lock_guard<std::mutex> lock(mutex);
+		events.push_back(event);
+	};
+
+	{
+		TaskExecutor executor(1, nullptr, [&addEvent]() { addEvent("exit"); });
+		auto queue = executor.CreateQueue(L"Test", TaskPriorityClass::Foreground);
+
+		queue
+			->Push([&addEvent]() {
+				TaskExecutor::AddThreadExitHandler([&addEvent]() { addEvent("handler 1"); });
+				TaskExecutor::AddThreadExitHandler([&addEvent]() { addEvent("handler 2"); });
+			})
+			.wait();
+	}
+
+	EXPECT_EQ(events, (std::vector<std::string>{ "handler 2", "handler 1", "exit" }));
+}
+
+TEST(TaskExecutorTest, QueueOutlivesExecutor)
+{
+	std::unique_ptr<TaskQueue> queue;
+
+	{
+		TaskExecutor executor(1);
+		queue = executor.CreateQueue(L"Test", TaskPriorityClass::Foreground);
+	}
+
+	auto result = queue->Push([]() { return 1; });
+	queue.reset();
+
+	EXPECT_THROW(result.get(), std::future_error);
+}
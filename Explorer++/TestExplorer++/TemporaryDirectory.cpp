@@ -0,0 +1,32 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "TemporaryDirectory.h"
+#include <fstream>
+#include <random>
+
+TemporaryDirectory::TemporaryDirectory(const std::wstring &prefix)
+{
+	std::random_device randomDevice;
+	m_path = std::filesystem::temp_directory_path()
+		/ (prefix + L"-" + std::to_wstring(randomDevice()));
+	std::filesystem::create_directories(m_path);
+}
+
+TemporaryDirectory::~TemporaryDirectory()
+{
+	std::error_code error;
+	std::filesystem::remove_all(m_path, error);
+}
+
+const std::filesystem::path &TemporaryDirectory::GetPath() const
+{
+	return m_path;
+}
+
+void TemporaryDirectory::AddFile(const std::filesystem::path &relativePath, std::size_t size) const
+{
+	std::ofstream stream(m_path / relativePath, std::ios::binary);
+	stream << std::string(size, 'x');
+}
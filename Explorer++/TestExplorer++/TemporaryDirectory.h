@@ -0,0 +1,30 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+
+// Creates a uniquely named directory within the system temporary directory, which is deleted
+// (along with everything in it) when the object is destroyed.
+class TemporaryDirectory
+{
+public:
+	explicit TemporaryDirectory(const std::wstring &prefix);
+	~TemporaryDirectory();
+
+	TemporaryDirectory(const TemporaryDirectory &) = delete;
+	TemporaryDirectory &operator=(const TemporaryDirectory &) = delete;
+
+	const std::filesystem::path &GetPath() const;
+
+	// Creates a file of the specified size, relative to the directory. The parent directory of the
+	// file must already exist.
+	void AddFile(const std::filesystem::path &relativePath, std::size_t size) const;
+
+private:
+	std::filesystem::path m_path;
+};
@@ -0,0 +1,339 @@
+﻿// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "../Helper/WildcardMatcher.h"
+#include "../Helper/Macros.h"
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <Shlwapi.h>
+#include <strsafe.h>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <tchar.h>
+
+namespace
+{
+	BOOL ReferenceWildcardMatchInternal(
+		const TCHAR *szWildcard, const TCHAR *szString, BOOL bCaseSensitive);
+
+	// The recursive implementation WildcardMatcher replaced. It's kept here as a reference, so
+	// that the two implementations can be checked for equivalence.
+	BOOL ReferenceWildcardMatch(const TCHAR *szWildcard, const TCHAR *szString, BOOL bCaseSensitive)
+	{
+		BOOL bMultiplePattern = FALSE;
+
+		for (int i = 0; i < lstrlen(szWildcard); i++)
+		{
+			if (szWildcard[i] == ':')
+			{
+				bMultiplePattern = TRUE;
+				break;
+			}
+		}
+
+		if (!bMultiplePattern)
+		{
+			return ReferenceWildcardMatchInternal(szWildcard, szString, bCaseSensitive);
+		}
+
+		TCHAR szWildcardPattern[512];
+		TCHAR *szRemainingPattern = nullptr;
+
+		StringCchCopy(szWildcardPattern, SIZEOF_ARRAY(szWildcardPattern), szWildcard);
+
+		TCHAR *szSinglePattern = wcstok_s(szWildcardPattern, _T(":"), &szRemainingPattern);
+		PathRemoveBlanks(szSinglePattern);
+
+		while (szSinglePattern != nullptr)
+		{
+			if (ReferenceWildcardMatchInternal(szSinglePattern, szString, bCaseSensitive))
+			{
+				return TRUE;
+			}
+
+			szSinglePattern = wcstok_s(szRemainingPattern, _T(":"), &szRemainingPattern);
+			PathRemoveBlanks(szSinglePattern);
+		}
+
+		return FALSE;
+	}
+
+	BOOL ReferenceWildcardMatchInternal(
+		const TCHAR *szWildcard, const TCHAR *szString, BOOL bCaseSensitive)
+	{
+		BOOL bMatched;
+		BOOL bCurrentMatch = TRUE;
+
+		while (*szWildcard != '\0' && *szString != '\0' && bCurrentMatch)
+		{
+			switch (*szWildcard)
+			{
+			case '*':
+				bMatched = FALSE;
+
+				if (*(szWildcard + 1) != '\0')
+				{
+					bMatched = ReferenceWildcardMatch(++szWildcard, szString, bCaseSensitive);
+				}
+
+				while (*szWildcard != '\0' && *szString != '\0' && !bMatched)
+				{
+					bMatched = ReferenceWildcardMatch(szWildcard, ++szString, bCaseSensitive);
+				}
+
+				if (bMatched)
+				{
+					while (*szWildcard != '\0')
+					{
+						szWildcard++;
+					}
+
+					szWildcard--;
+
+					while (*szString != '\0')
+					{
+						szString++;
+					}
+				}
+
+				bCurrentMatch = bMatched;
+				break;
+
+			case '?':
+				szString++;
+				break;
+
+			default:
+				if (bCaseSensitive)
+				{
+					bCurrentMatch = (*szWildcard == *szString);
+				}
+				else
+				{
+					TCHAR szCharacter1[1];
+					LCMapString(LOCALE_USER_DEFAULT, LCMAP_LOWERCASE, szWildcard, 1, szCharacter1,
+						SIZEOF_ARRAY(szCharacter1));
+
+					TCHAR szCharacter2[1];
+					LCMapString(LOCALE_USER_DEFAULT, LCMAP_LOWERCASE, szString, 1, szCharacter2,
+						SIZEOF_ARRAY(szCharacter2));
+
+					bCurrentMatch = (szCharacter1[0] == szCharacter2[0]);
+				}
+
+				szString++;
+				break;
+			}
+
+			szWildcard++;
+		}
+
+		while (*szWildcard == '*')
+		{
+			szWildcard++;
+		}
+
+		return *szWildcard == '\0' && *szString == '\0' && bCurrentMatch;
+	}
+
+	bool Matches(const std::wstring &pattern, const std::wstring &str, bool caseSensitive)
+	{
+		return WildcardMatcher(pattern, caseSensitive).Matches(str);
+	}
+
+	std::wstring GenerateString(std::mt19937 &generator, const std::wstring &alphabet,
+		std::size_t maxLength)
+	{
+		std::uniform_int_distribution<std::size_t> lengthDistribution(0, maxLength);
+		std::uniform_int_distribution<std::size_t> charDistribution(0, alphabet.size() - 1);
+
+		std::wstring str(lengthDistribution(generator), ' ');
+
+		for (auto &ch : str)
+		{
+			ch = alphabet[charDistribution(generator)];
+		}
+
+		return str;
+	}
+}
+
+TEST(WildcardMatcherTest, SimpleMatches)
+{
+	EXPECT_TRUE(Matches(_T("*.txt"), _T("Test.txt"), true));
+	EXPECT_TRUE(Matches(_T("?.txt"), _T("1.txt"), true));
+	EXPECT_TRUE(Matches(_T("?ab*cd.tx?"), _T("1abefghcd.txt"), true));
+	EXPECT_TRUE(Matches(_T("Test?1*txt"), _T("Test11test.txt"), true));
+
+	EXPECT_FALSE(Matches(_T("*.txt"), _T("Test.txt.bak"), true));
+	EXPECT_FALSE(Matches(_T("?.txt"), _T(".txt"), true));
+	EXPECT_TRUE(Matches(_T("*"), _T(""), true));
+	EXPECT_TRUE(Matches(_T("Test*"), _T("Test"), true));
+	EXPECT_FALSE(Matches(_T("Test*"), _T("Tes"), true));
+	EXPECT_TRUE(Matches(_T("a**b"), _T("ab"), true));
+	EXPECT_TRUE(Matches(_T(""), _T(""), true));
+	EXPECT_FALSE(Matches(_T(""), _T("a"), true));
+}
+
+TEST(WildcardMatcherTest, UnicodeMatches)
+{
+/* Warning C4566 (character represented by universal-character-name
+'char' cannot be represented in the current code page (page)) is given
+here. Using an indirect string variable (rather than passing the
+string directly to the function) seems to make the warning go away.
+Possibly related to the bug raised at
+http://connect.microsoft.com/VisualStudio/feedback/details/431433/unicode-strings-incorrectly-generating-c4566.
+*/
+#pragma warning(push)
+#pragma warning(disable : 4566)
+
+	EXPECT_TRUE(Matches(L"привет", L"Привет", false));
+	EXPECT_TRUE(Matches(L"тестовую строку", L"ТЕСТОВУЮ СТРОКУ", false));
+	EXPECT_FALSE(Matches(L"тестовую строку 2", L"ТЕСТОВУЮ СТРОКУ 2", true));
+	EXPECT_TRUE(Matches(L"Тест?1*txt", L"Тест11Тест.txt", true));
+	EXPECT_TRUE(Matches(L"*стр?ку*", L"ТЕСТОВУЮ СТРОКУ 2", false));
+
+#pragma warning(pop)
+}
+
+TEST(WildcardMatcherTest, CaseSensitivity)
+{
+	EXPECT_FALSE(Matches(_T("*.TXT"), _T("file.txt"), true));
+	EXPECT_TRUE(Matches(_T("*.TXT"), _T("file.txt"), false));
+	EXPECT_FALSE(Matches(_T("READ*"), _T("readme.md"), true));
+	EXPECT_TRUE(Matches(_T("READ*"), _T("readme.md"), false));
+	EXPECT_TRUE(Matches(_T("*A?b*"), _T("xaXBy"), false));
+	EXPECT_FALSE(Matches(_T("*A?b*"), _T("xaXBy"), true));
+}
+
+TEST(WildcardMatcherTest, MultiplePatterns)
+{
+	WildcardMatcher matcher(_T("*.h: *.cpp :: "), true);
+	EXPECT_TRUE(matcher.Matches(_T("file.h")));
+	EXPECT_TRUE(matcher.Matches(_T("file.cpp")));
+	EXPECT_FALSE(matcher.Matches(_T("file.txt")));
+
+	// An alternative made up of only spaces matches an empty string.
+	EXPECT_TRUE(matcher.Matches(_T("")));
+
+	// Whereas empty alternatives are ignored.
+	EXPECT_FALSE(WildcardMatcher(_T("::"), true).Matches(_T("")));
+}
+
+TEST(WildcardMatcherTest, SpacesInSinglePattern)
+{
+	// Spaces are only trimmed when a pattern is split into alternatives.
+	WildcardMatcher matcher(_T(" *.txt "), true);
+	EXPECT_TRUE(matcher.Matches(_T(" file.txt ")));
+	EXPECT_FALSE(matcher.Matches(_T("file.txt")));
+
+	EXPECT_TRUE(Matches(_T("   "), _T("   "), true));
+	EXPECT_FALSE(Matches(_T("   "), _T(""), true));
+
+	EXPECT_TRUE(WildcardMatcher(_T(" *.txt :"), true).Matches(_T("file.txt")));
+}
+
+TEST(WildcardMatcherTest, LongPatterns)
+{
+	// The pattern here requires more than a single 64-bit word to represent.
+	std::wstring prefix(70, 'a');
+	std::wstring pattern = prefix + L"*b?c*" + prefix;
+	WildcardMatcher matcher(pattern, true);
+
+	EXPECT_TRUE(matcher.Matches(prefix + L"bxc" + prefix));
+	EXPECT_TRUE(matcher.Matches(prefix + L"zzbxczz" + prefix));
+	EXPECT_FALSE(matcher.Matches(prefix + L"bc" + prefix));
+	EXPECT_FALSE(matcher.Matches(prefix + L"bxc" + prefix.substr(1)));
+}
+
+TEST(WildcardMatcherTest, PathologicalPattern)
+{
+	// The recursive implementation takes time exponential in the number of stars to reject a
+	// string like this.
+	std::wstring pattern;
+
+	for (int i = 0; i < 30; i++)
+	{
+		pattern += L"*a";
+	}
+
+	pattern += L"*b";
+
+	WildcardMatcher matcher(pattern, false);
+	EXPECT_FALSE(matcher.Matches(std::wstring(5000, 'a')));
+	EXPECT_TRUE(matcher.Matches(std::wstring(5000, 'a') + L"b"));
+}
+
+TEST(WildcardMatcherTest, MatchesReferenceImplementation)
+{
+	const std::wstring PATTERN_ALPHABET = L"abAB.*?: ";
+	const std::wstring STRING_ALPHABET = L"abAB. ";
+
+	std::mt19937 generator(1);
+
+	for (int i = 0; i < 50000; i++)
+	{
+		std::wstring pattern = GenerateString(generator, PATTERN_ALPHABET, 10);
+		std::wstring str = GenerateString(generator, STRING_ALPHABET, 12);
+
+		for (bool caseSensitive : { true, false })
+		{
+			bool expected = ReferenceWildcardMatch(pattern.c_str(), str.c_str(), caseSensitive);
+			ASSERT_EQ(Matches(pattern, str, caseSensitive), expected)
+				<< "Pattern: \"" << testing::PrintToString(pattern) << "\", string: \""
+				<< testing::PrintToString(str) << "\", case-sensitive: " << caseSensitive;
+		}
+	}
+}
+
+TEST(WildcardMatcherTest, DISABLED_Benchmark)
+{
+	const int NUM_NAMES = 1000000;
+	const std::wstring PATTERNS[] = { L"*.txt", L"*.h:*.cpp:*.txt", L"f*1?3*.t?t" };
+
+	std::mt19937 generator(1);
+	std::vector<std::wstring> names;
+	names.reserve(NUM_NAMES);
+
+	for (int i = 0; i < NUM_NAMES; i++)
+	{
+		names.push_back(GenerateString(generator, L"abcdefghijklmnopqrstuvwxyz0123456789", 20)
+			+ L".txt");
+	}
+
+	for (const auto &pattern : PATTERNS)
+	{
+		auto start = std::chrono::steady_clock::now();
+		int numReferenceMatches = 0;
+
+		for (const auto &name : names)
+		{
+			numReferenceMatches += ReferenceWildcardMatch(pattern.c_str(), name.c_str(), FALSE);
+		}
+
+		auto referenceDuration = std::chrono::steady_clock::now() - start;
+
+		start = std::chrono::steady_clock::now();
+		WildcardMatcher matcher(pattern, false);
+		int numMatches = 0;
+
+		for (const auto &name : names)
+		{
+			numMatches += matcher.Matches(name);
+		}
+
+		auto matcherDuration = std::chrono::steady_clock::now() - start;
+
+		EXPECT_EQ(numMatches, numReferenceMatches);
+
+		auto referenceMs =
+			std::chrono::duration_cast<std::chrono::milliseconds>(referenceDuration).count();
+		auto matcherMs =
+			std::chrono::duration_cast<std::chrono::milliseconds>(matcherDuration).count();
+
+		std::wcout << pattern << L": reference " << referenceMs << L"ms, compiled " << matcherMs
+				   << L"ms\n";
+	}
+}